@@ -0,0 +1,314 @@
+// atomic_histogram.cc
+
+// Ourselves:
+#include <snemo/analysis/atomic_histogram.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+#include <mygsl/histogram_pool.h>
+
+namespace analysis {
+
+  // Atomic addition of a floating point value.
+  inline void atomic_add(std::atomic<double> & target_, double value_)
+  {
+    double expected = target_.load(std::memory_order_relaxed);
+    while (! target_.compare_exchange_weak(expected, expected + value_,
+                                           std::memory_order_relaxed,
+                                           std::memory_order_relaxed)) {}
+    return;
+  }
+
+  atomic_histogram_1d::atomic_histogram_1d()
+  {
+    return;
+  }
+
+  void atomic_histogram_1d::initialize(const mygsl::histogram_1d & histogram_)
+  {
+    _axis_.initialize(histogram_);
+    const size_t nbins = _axis_.bins();
+    _counts_.reset(new std::atomic<uint64_t>[nbins]);
+    _sums_.reset(new std::atomic<double>[nbins]);
+    _weighted_fills_.reset(new std::atomic<uint64_t>[nbins]);
+    for (size_t i = 0; i < nbins; ++i)
+      {
+        _counts_[i].store(0, std::memory_order_relaxed);
+        _sums_[i].store(0.0, std::memory_order_relaxed);
+        _weighted_fills_[i].store(0, std::memory_order_relaxed);
+      }
+    _outliers_.clear();
+    return;
+  }
+
+  void atomic_histogram_1d::reset()
+  {
+    _axis_.reset();
+    _counts_.reset();
+    _sums_.reset();
+    _weighted_fills_.reset();
+    _outliers_.clear();
+    return;
+  }
+
+  bool atomic_histogram_1d::is_initialized() const
+  {
+    return _axis_.is_initialized();
+  }
+
+  void atomic_histogram_1d::fill(double x_)
+  {
+    size_t i;
+    if (_axis_.find(x_, i))
+      {
+        _counts_[i].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    // Underflow, overflow and invalid values are rare and left to the generic fill
+    std::lock_guard<std::mutex> lock(_outliers_mutex_);
+    const outlier_type an_outlier = { x_, 1.0 };
+    _outliers_.push_back(an_outlier);
+    return;
+  }
+
+  void atomic_histogram_1d::fill(double x_, double weight_)
+  {
+    size_t i;
+    if (_axis_.find(x_, i))
+      {
+        atomic_add(_sums_[i], weight_);
+        _weighted_fills_[i].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    std::lock_guard<std::mutex> lock(_outliers_mutex_);
+    const outlier_type an_outlier = { x_, weight_ };
+    _outliers_.push_back(an_outlier);
+    return;
+  }
+
+  void atomic_histogram_1d::export_to(mygsl::histogram_1d & histogram_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Atomic histogram is not initialized !");
+    DT_THROW_IF(histogram_.bins() != _axis_.bins(), std::logic_error, "Histogram binning mismatch !");
+    uint64_t fills = 0;
+    for (size_t i = 0; i < _axis_.bins(); ++i)
+      {
+        const uint64_t a_count = _counts_[i].exchange(0, std::memory_order_relaxed);
+        const double a_sum = _sums_[i].exchange(0.0, std::memory_order_relaxed);
+        fills += a_count + _weighted_fills_[i].exchange(0, std::memory_order_relaxed);
+        if (a_count == 0 && a_sum == 0.0) continue;
+        histogram_.set(i, histogram_.get(i) + static_cast<double>(a_count) + a_sum);
+      }
+    add_fill_counts(histogram_, _axis_, fills);
+    std::lock_guard<std::mutex> lock(_outliers_mutex_);
+    for (size_t k = 0; k < _outliers_.size(); ++k)
+      {
+        histogram_.fill(_outliers_[k].x, _outliers_[k].weight);
+      }
+    _outliers_.clear();
+    return;
+  }
+
+  atomic_histogram_2d::atomic_histogram_2d()
+  {
+    return;
+  }
+
+  void atomic_histogram_2d::initialize(const mygsl::histogram_2d & histogram_)
+  {
+    _x_axis_.initialize_x(histogram_);
+    _y_axis_.initialize_y(histogram_);
+    const size_t nbins = _x_axis_.bins() * _y_axis_.bins();
+    _counts_.reset(new std::atomic<uint64_t>[nbins]);
+    _sums_.reset(new std::atomic<double>[nbins]);
+    _weighted_fills_.reset(new std::atomic<uint64_t>[nbins]);
+    for (size_t k = 0; k < nbins; ++k)
+      {
+        _counts_[k].store(0, std::memory_order_relaxed);
+        _sums_[k].store(0.0, std::memory_order_relaxed);
+        _weighted_fills_[k].store(0, std::memory_order_relaxed);
+      }
+    _outliers_.clear();
+    return;
+  }
+
+  void atomic_histogram_2d::reset()
+  {
+    _x_axis_.reset();
+    _y_axis_.reset();
+    _counts_.reset();
+    _sums_.reset();
+    _weighted_fills_.reset();
+    _outliers_.clear();
+    return;
+  }
+
+  bool atomic_histogram_2d::is_initialized() const
+  {
+    return _x_axis_.is_initialized();
+  }
+
+  void atomic_histogram_2d::fill(double x_, double y_)
+  {
+    size_t i, j;
+    if (_x_axis_.find(x_, i) && _y_axis_.find(y_, j))
+      {
+        _counts_[i * _y_axis_.bins() + j].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    std::lock_guard<std::mutex> lock(_outliers_mutex_);
+    const outlier_type an_outlier = { x_, y_, 1.0 };
+    _outliers_.push_back(an_outlier);
+    return;
+  }
+
+  void atomic_histogram_2d::fill(double x_, double y_, double weight_)
+  {
+    size_t i, j;
+    if (_x_axis_.find(x_, i) && _y_axis_.find(y_, j))
+      {
+        const size_t k = i * _y_axis_.bins() + j;
+        atomic_add(_sums_[k], weight_);
+        _weighted_fills_[k].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+    std::lock_guard<std::mutex> lock(_outliers_mutex_);
+    const outlier_type an_outlier = { x_, y_, weight_ };
+    _outliers_.push_back(an_outlier);
+    return;
+  }
+
+  void atomic_histogram_2d::export_to(mygsl::histogram_2d & histogram_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Atomic histogram is not initialized !");
+    const size_t nx = _x_axis_.bins();
+    const size_t ny = _y_axis_.bins();
+    DT_THROW_IF(histogram_.xbins() != nx || histogram_.ybins() != ny,
+                std::logic_error, "Histogram binning mismatch !");
+    uint64_t fills = 0;
+    for (size_t i = 0; i < nx; ++i)
+      for (size_t j = 0; j < ny; ++j)
+        {
+          const uint64_t a_count = _counts_[i * ny + j].exchange(0, std::memory_order_relaxed);
+          const double a_sum = _sums_[i * ny + j].exchange(0.0, std::memory_order_relaxed);
+          fills += a_count + _weighted_fills_[i * ny + j].exchange(0, std::memory_order_relaxed);
+          if (a_count == 0 && a_sum == 0.0) continue;
+          histogram_.set(i, j, histogram_.get(i, j) + static_cast<double>(a_count) + a_sum);
+        }
+    add_fill_counts(histogram_, _x_axis_, _y_axis_, fills);
+    std::lock_guard<std::mutex> lock(_outliers_mutex_);
+    for (size_t k = 0; k < _outliers_.size(); ++k)
+      {
+        histogram_.fill(_outliers_[k].x, _outliers_[k].y, _outliers_[k].weight);
+      }
+    _outliers_.clear();
+    return;
+  }
+
+  atomic_histogram_registry::atomic_histogram_registry()
+  {
+    _pool_ = 0;
+    return;
+  }
+
+  void atomic_histogram_registry::initialize(mygsl::histogram_pool & pool_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    _pool_ = &pool_;
+    _entries_1d_.clear();
+    _entries_2d_.clear();
+    return;
+  }
+
+  void atomic_histogram_registry::reset()
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    _pool_ = 0;
+    _entries_1d_.clear();
+    _entries_2d_.clear();
+    return;
+  }
+
+  bool atomic_histogram_registry::is_initialized() const
+  {
+    return _pool_ != 0;
+  }
+
+  atomic_histogram_1d & atomic_histogram_registry::grab_1d(const std::string & name_,
+                                                           const builder_1d_type & builder_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    DT_THROW_IF(_pool_ == 0, std::logic_error, "Atomic histogram registry is not initialized !");
+    std::map<std::string, entry_1d_type>::iterator found = _entries_1d_.find(name_);
+    if (found == _entries_1d_.end())
+      {
+        entry_1d_type & an_entry = _entries_1d_[name_];
+        an_entry.histogram = &builder_(*_pool_);
+        an_entry.atomic.reset(new atomic_histogram_1d);
+        an_entry.atomic->initialize(*an_entry.histogram);
+        return *an_entry.atomic;
+      }
+    return *found->second.atomic;
+  }
+
+  const mygsl::histogram_1d & atomic_histogram_registry::get_histogram_1d(const std::string & name_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    std::map<std::string, entry_1d_type>::const_iterator found = _entries_1d_.find(name_);
+    DT_THROW_IF(found == _entries_1d_.end(), std::logic_error,
+                "No atomic histogram '" << name_ << "' !");
+    return *found->second.histogram;
+  }
+
+  atomic_histogram_2d & atomic_histogram_registry::grab_2d(const std::string & name_,
+                                                           const builder_2d_type & builder_)
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    DT_THROW_IF(_pool_ == 0, std::logic_error, "Atomic histogram registry is not initialized !");
+    std::map<std::string, entry_2d_type>::iterator found = _entries_2d_.find(name_);
+    if (found == _entries_2d_.end())
+      {
+        entry_2d_type & an_entry = _entries_2d_[name_];
+        an_entry.histogram = &builder_(*_pool_);
+        an_entry.atomic.reset(new atomic_histogram_2d);
+        an_entry.atomic->initialize(*an_entry.histogram);
+        return *an_entry.atomic;
+      }
+    return *found->second.atomic;
+  }
+
+  void atomic_histogram_registry::export_histograms()
+  {
+    std::lock_guard<std::mutex> lock(_mutex_);
+    for (std::map<std::string, entry_1d_type>::iterator
+           ientry = _entries_1d_.begin();
+         ientry != _entries_1d_.end(); ++ientry)
+      {
+        ientry->second.atomic->export_to(*ientry->second.histogram);
+      }
+    for (std::map<std::string, entry_2d_type>::iterator
+           ientry = _entries_2d_.begin();
+         ientry != _entries_2d_.end(); ++ientry)
+      {
+        ientry->second.atomic->export_to(*ientry->second.histogram);
+      }
+    return;
+  }
+
+} // namespace analysis
+
+// end of atomic_histogram.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
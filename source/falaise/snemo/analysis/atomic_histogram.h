@@ -0,0 +1,219 @@
+/* atomic_histogram.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Histograms with atomic bins filled concurrently by several processing
+ * threads without locks. Unit weight fills are relaxed integer increments
+ * and weighted fills are compare-and-swap floating point additions. The
+ * contents are added back to the mygsl histograms of the pool for output.
+ * The in-range bins are exported directly with the number of in-range
+ * fills added to the fill counter of the mygsl histograms, the out of
+ * range values go through the generic fill.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_ATOMIC_HISTOGRAM_H_
+#define ANALYSIS_ATOMIC_HISTOGRAM_H_ 1
+
+// Standard libraries:
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+// This project:
+#include <snemo/analysis/histogram_filler.h>
+
+namespace mygsl {
+  class histogram;
+  typedef histogram histogram_1d;
+  class histogram_2d;
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  /// \brief 1D histogram with atomic bins
+  class atomic_histogram_1d
+  {
+  public:
+
+    /// Constructor
+    atomic_histogram_1d();
+
+    /// Initialize the binning from a histogram
+    void initialize(const mygsl::histogram_1d & histogram_);
+
+    /// Reset
+    void reset();
+
+    /// Check if the histogram has been initialized
+    bool is_initialized() const;
+
+    /// Fill a value with unit weight
+    void fill(double x_);
+
+    /// Fill a weighted value
+    void fill(double x_, double weight_);
+
+    /// Add the contents and the number of fills to a histogram with the same binning and clear them
+    void export_to(mygsl::histogram_1d & histogram_);
+
+  private:
+
+    /// Value out of the bins
+    struct outlier_type
+    {
+      double x;
+      double weight;
+    };
+
+    histogram_axis                            _axis_;     //!< Binning
+    std::unique_ptr<std::atomic<uint64_t>[] > _counts_;   //!< Unit weight counts per bin
+    std::unique_ptr<std::atomic<double>[] >   _sums_;     //!< Sum of weights per bin
+    std::unique_ptr<std::atomic<uint64_t>[] > _weighted_fills_; //!< Number of weighted fills per bin
+    std::mutex                                _outliers_mutex_; //!< Protection of the outliers
+    std::vector<outlier_type>                 _outliers_; //!< Values out of the bins
+  };
+
+  /// \brief 2D histogram with atomic bins
+  class atomic_histogram_2d
+  {
+  public:
+
+    /// Constructor
+    atomic_histogram_2d();
+
+    /// Initialize the binning from a histogram
+    void initialize(const mygsl::histogram_2d & histogram_);
+
+    /// Reset
+    void reset();
+
+    /// Check if the histogram has been initialized
+    bool is_initialized() const;
+
+    /// Fill a pair of values with unit weight
+    void fill(double x_, double y_);
+
+    /// Fill a weighted pair of values
+    void fill(double x_, double y_, double weight_);
+
+    /// Add the contents and the number of fills to a histogram with the same binning and clear them
+    void export_to(mygsl::histogram_2d & histogram_);
+
+  private:
+
+    /// Pair of values out of the bins
+    struct outlier_type
+    {
+      double x;
+      double y;
+      double weight;
+    };
+
+    histogram_axis                            _x_axis_;   //!< Binning of the X axis
+    histogram_axis                            _y_axis_;   //!< Binning of the Y axis
+    std::unique_ptr<std::atomic<uint64_t>[] > _counts_;   //!< Unit weight counts per bin
+    std::unique_ptr<std::atomic<double>[] >   _sums_;     //!< Sum of weights per bin
+    std::unique_ptr<std::atomic<uint64_t>[] > _weighted_fills_; //!< Number of weighted fills per bin
+    std::mutex                                _outliers_mutex_; //!< Protection of the outliers
+    std::vector<outlier_type>                 _outliers_; //!< Values out of the bins
+  };
+
+  /// \brief Atomic histograms attached to the histograms of a pool
+  class atomic_histogram_registry
+  {
+  public:
+
+    /// Build the pool histogram of a new atomic histogram
+    typedef std::function<mygsl::histogram_1d & (mygsl::histogram_pool &)> builder_1d_type;
+
+    /// Build the pool histogram of a new atomic histogram
+    typedef std::function<mygsl::histogram_2d & (mygsl::histogram_pool &)> builder_2d_type;
+
+    /// Constructor
+    atomic_histogram_registry();
+
+    /// Initialize with the pool receiving the contents
+    void initialize(mygsl::histogram_pool & pool_);
+
+    /// Reset and drop the contents not exported yet
+    void reset();
+
+    /// Check if the registry has been initialized
+    bool is_initialized() const;
+
+    /// Return the atomic histogram of a name, the builder is called under lock when it does not exist yet
+    atomic_histogram_1d & grab_1d(const std::string & name_, const builder_1d_type & builder_);
+
+    /// Return the atomic histogram of a name, the builder is called under lock when it does not exist yet
+    atomic_histogram_2d & grab_2d(const std::string & name_, const builder_2d_type & builder_);
+
+    /// Return the pool histogram of an atomic histogram, its auxiliaries are only set by the builder
+    const mygsl::histogram_1d & get_histogram_1d(const std::string & name_);
+
+    /// Add the contents of all atomic histograms to the pool histograms, in name order
+    void export_histograms();
+
+  private:
+
+    /// Atomic histogram attached to a 1D histogram of the pool
+    struct entry_1d_type
+    {
+      mygsl::histogram_1d *                histogram;
+      std::unique_ptr<atomic_histogram_1d> atomic;
+    };
+
+    /// Atomic histogram attached to a 2D histogram of the pool
+    struct entry_2d_type
+    {
+      mygsl::histogram_2d *                histogram;
+      std::unique_ptr<atomic_histogram_2d> atomic;
+    };
+
+    mygsl::histogram_pool *              _pool_;       //!< Pool receiving the contents
+    std::mutex                           _mutex_;      //!< Protection of the pool and of the entries
+    std::map<std::string, entry_1d_type> _entries_1d_; //!< 1D entries indexed by name
+    std::map<std::string, entry_2d_type> _entries_2d_; //!< 2D entries indexed by name
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_ATOMIC_HISTOGRAM_H_
+
+// end of atomic_histogram.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
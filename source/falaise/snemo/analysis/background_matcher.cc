@@ -0,0 +1,144 @@
+// background_matcher.cc
+
+// Ourselves:
+#include <snemo/analysis/background_matcher.h>
+
+// Standard library:
+#include <deque>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  const size_t background_matcher::ALPHABET_SIZE;
+
+  background_matcher::background_matcher()
+  {
+    reset();
+    return;
+  }
+
+  void background_matcher::reset()
+  {
+    _compiled_ = false;
+    _patterns_.clear();
+    _transitions_.clear();
+    _outputs_.clear();
+    return;
+  }
+
+  size_t background_matcher::add_pattern(const std::string & pattern_)
+  {
+    DT_THROW_IF(_compiled_, std::logic_error, "Matcher is already compiled !");
+    DT_THROW_IF(pattern_.empty(), std::logic_error, "Empty pattern !");
+    _patterns_.push_back(pattern_);
+    return _patterns_.size() - 1;
+  }
+
+  bool background_matcher::is_compiled() const
+  {
+    return _compiled_;
+  }
+
+  size_t background_matcher::size() const
+  {
+    return _patterns_.size();
+  }
+
+  const std::string & background_matcher::get_pattern(size_t id_) const
+  {
+    return _patterns_.at(id_);
+  }
+
+  void background_matcher::compile()
+  {
+    DT_THROW_IF(_compiled_, std::logic_error, "Matcher is already compiled !");
+
+    // Trie of the patterns, -1 for a missing transition
+    _transitions_.assign(ALPHABET_SIZE, -1);
+    _outputs_.assign(1, std::vector<size_t>());
+    for (size_t id = 0; id < _patterns_.size(); ++id)
+      {
+        const std::string & a_pattern = _patterns_[id];
+        int32_t state = 0;
+        for (size_t i = 0; i < a_pattern.size(); ++i)
+          {
+            const size_t c = static_cast<unsigned char>(a_pattern[i]);
+            if (_transitions_[state * ALPHABET_SIZE + c] < 0)
+              {
+                _transitions_[state * ALPHABET_SIZE + c] = _outputs_.size();
+                _transitions_.resize(_transitions_.size() + ALPHABET_SIZE, -1);
+                _outputs_.push_back(std::vector<size_t>());
+              }
+            state = _transitions_[state * ALPHABET_SIZE + c];
+          }
+        _outputs_[state].push_back(id);
+      }
+
+    // Failure links in breadth-first order, turning the trie into a full
+    // transition table and merging the outputs of the suffix states
+    std::vector<int32_t> failures(_outputs_.size(), 0);
+    std::deque<int32_t> queue;
+    for (size_t c = 0; c < ALPHABET_SIZE; ++c)
+      {
+        int32_t & next = _transitions_[c];
+        if (next < 0) next = 0;
+        else queue.push_back(next);
+      }
+    while (! queue.empty())
+      {
+        const int32_t state = queue.front();
+        queue.pop_front();
+        std::vector<size_t> & outputs = _outputs_[state];
+        const std::vector<size_t> & suffix_outputs = _outputs_[failures[state]];
+        outputs.insert(outputs.end(), suffix_outputs.begin(), suffix_outputs.end());
+        std::sort(outputs.begin(), outputs.end());
+        for (size_t c = 0; c < ALPHABET_SIZE; ++c)
+          {
+            int32_t & next = _transitions_[state * ALPHABET_SIZE + c];
+            const int32_t fallback = _transitions_[failures[state] * ALPHABET_SIZE + c];
+            if (next < 0)
+              {
+                next = fallback;
+              }
+            else
+              {
+                failures[next] = fallback;
+                queue.push_back(next);
+              }
+          }
+      }
+    _compiled_ = true;
+    return;
+  }
+
+  void background_matcher::match(const std::string & text_, std::vector<size_t> & ids_) const
+  {
+    DT_THROW_IF(! _compiled_, std::logic_error, "Matcher is not compiled !");
+    ids_.clear();
+    int32_t state = 0;
+    for (size_t i = 0; i < text_.size(); ++i)
+      {
+        state = _transitions_[state * ALPHABET_SIZE + static_cast<unsigned char>(text_[i])];
+        const std::vector<size_t> & outputs = _outputs_[state];
+        ids_.insert(ids_.end(), outputs.begin(), outputs.end());
+      }
+    std::sort(ids_.begin(), ids_.end());
+    ids_.erase(std::unique(ids_.begin(), ids_.end()), ids_.end());
+    return;
+  }
+
+} // namespace analysis
+
+// end of background_matcher.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
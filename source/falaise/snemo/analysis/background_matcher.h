@@ -0,0 +1,99 @@
+/* background_matcher.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Multi-pattern substring matcher (Aho-Corasick automaton) associating
+ * histogram names with background components.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_BACKGROUND_MATCHER_H_
+#define ANALYSIS_BACKGROUND_MATCHER_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace analysis {
+
+  /// \brief Aho-Corasick automaton over a set of patterns
+  ///
+  /// Patterns are added then compiled into a deterministic automaton with a
+  /// full transition table, so that all the patterns contained in a text
+  /// are found in a single pass over the text.
+  class background_matcher
+  {
+  public:
+
+    /// Constructor
+    background_matcher();
+
+    /// Add a pattern and return its identifier
+    size_t add_pattern(const std::string & pattern_);
+
+    /// Build the automaton
+    void compile();
+
+    /// Check if the automaton is built
+    bool is_compiled() const;
+
+    /// Reset
+    void reset();
+
+    /// Return the number of patterns
+    size_t size() const;
+
+    /// Return a pattern
+    const std::string & get_pattern(size_t id_) const;
+
+    /// Collect the identifiers of the patterns contained in a text, in increasing order
+    void match(const std::string & text_, std::vector<size_t> & ids_) const;
+
+  private:
+
+    /// Number of transitions per state
+    static const size_t ALPHABET_SIZE = 256;
+
+    bool                             _compiled_;    //!< Compilation flag
+    std::vector<std::string>         _patterns_;    //!< Patterns
+    std::vector<int32_t>             _transitions_; //!< Transition table indexed by state and byte
+    std::vector<std::vector<size_t> > _outputs_;    //!< Patterns ending at each state
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_BACKGROUND_MATCHER_H_
+
+// end of background_matcher.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
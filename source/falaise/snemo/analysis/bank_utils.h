@@ -0,0 +1,64 @@
+/* bank_utils.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Helpers to access the banks of a data record.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_BANK_UTILS_H_
+#define ANALYSIS_BANK_UTILS_H_ 1
+
+// Standard libraries:
+#include <string>
+
+// - Bayeux/datatools:
+#include <datatools/things.h>
+
+namespace analysis {
+
+  /// Return the bank of a given label and type, or a null pointer if the
+  /// record has no bank with this label. A bank of another type makes
+  /// datatools::things::get throw.
+  template <class Bank>
+  const Bank * try_get_bank(const datatools::things & record_, const std::string & label_)
+  {
+    if (! record_.has(label_)) return 0;
+    return &record_.get<Bank>(label_);
+  }
+
+} // namespace analysis
+
+#endif // ANALYSIS_BANK_UTILS_H_
+
+// end of bank_utils.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,124 @@
+// calorimeter_block_set.cc
+
+// Ourselves:
+#include <snemo/analysis/calorimeter_block_set.h>
+
+// Standard library:
+#include <algorithm>
+
+// Third party:
+// - Falaise
+#include <falaise/snemo/datamodels/particle_track.h>
+#include <falaise/snemo/datamodels/particle_track_data.h>
+
+namespace analysis {
+
+  namespace {
+
+    // Offsets of the dense indexes of each wall
+    const size_t MAIN_WALL_OFFSET  = 0;
+    const size_t X_WALL_OFFSET     = MAIN_WALL_OFFSET + 2 * 20 * 13;
+    const size_t GAMMA_VETO_OFFSET = X_WALL_OFFSET + 2 * 2 * 2 * 16;
+
+  }
+
+  const size_t calorimeter_block_set::NUMBER_OF_BLOCKS;
+  const size_t calorimeter_block_set::INVALID_INDEX;
+
+  size_t calorimeter_block_set::dense_index(const geomtools::geom_id & gid_)
+  {
+    // Addresses are unsigned so that any/invalid addresses fail the range checks
+    switch (gid_.get_type())
+      {
+      case MAIN_WALL_TYPE:
+        {
+          if (gid_.get_depth() < 4) break;
+          const uint32_t side = gid_.get(1), column = gid_.get(2), row = gid_.get(3);
+          if (gid_.get(0) != 0 || side >= 2 || column >= 20 || row >= 13) break;
+          return MAIN_WALL_OFFSET + (side * 20 + column) * 13 + row;
+        }
+      case X_WALL_TYPE:
+        {
+          if (gid_.get_depth() < 5) break;
+          const uint32_t side = gid_.get(1), wall = gid_.get(2), column = gid_.get(3), row = gid_.get(4);
+          if (gid_.get(0) != 0 || side >= 2 || wall >= 2 || column >= 2 || row >= 16) break;
+          return X_WALL_OFFSET + ((side * 2 + wall) * 2 + column) * 16 + row;
+        }
+      case GAMMA_VETO_TYPE:
+        {
+          if (gid_.get_depth() < 4) break;
+          const uint32_t side = gid_.get(1), wall = gid_.get(2), column = gid_.get(3);
+          if (gid_.get(0) != 0 || side >= 2 || wall >= 2 || column >= 16) break;
+          return GAMMA_VETO_OFFSET + (side * 2 + wall) * 16 + column;
+        }
+      default:
+        break;
+      }
+    return INVALID_INDEX;
+  }
+
+  calorimeter_block_set::calorimeter_block_set()
+    : _generation_(1), _stamps_(NUMBER_OF_BLOCKS, 0)
+  {
+    return;
+  }
+
+  void calorimeter_block_set::clear()
+  {
+    if (++_generation_ == 0)
+      {
+        // Stamps of the previous cycle could be mistaken for current ones
+        std::fill(_stamps_.begin(), _stamps_.end(), 0);
+        _generation_ = 1;
+      }
+    _others_.clear();
+    return;
+  }
+
+  bool calorimeter_block_set::insert(const geomtools::geom_id & gid_)
+  {
+    const size_t index = dense_index(gid_);
+    if (index != INVALID_INDEX)
+      {
+        if (_stamps_[index] == _generation_) return false;
+        _stamps_[index] = _generation_;
+        return true;
+      }
+    if (std::find(_others_.begin(), _others_.end(), gid_) != _others_.end()) return false;
+    _others_.push_back(gid_);
+    return true;
+  }
+
+  double associated_calorimeter_energy(const snemo::datamodel::particle_track_data & ptd_,
+                                       calorimeter_block_set & blocks_)
+  {
+    double energy = 0.0;
+    blocks_.clear();
+    for (snemo::datamodel::particle_track_data::particle_collection_type::const_iterator
+           iparticle = ptd_.get_particles().begin();
+         iparticle != ptd_.get_particles().end();
+         ++iparticle)
+      {
+        const snemo::datamodel::particle_track & a_particle = iparticle->get();
+        if (! a_particle.has_associated_calorimeter_hits()) continue;
+        const snemo::datamodel::calibrated_calorimeter_hit::collection_type &
+          the_calorimeters = a_particle.get_associated_calorimeter_hits();
+        for (size_t i = 0; i < the_calorimeters.size(); ++i)
+          {
+            const snemo::datamodel::calibrated_calorimeter_hit & a_calorimeter = the_calorimeters.at(i).get();
+            if (blocks_.insert(a_calorimeter.get_geom_id())) energy += a_calorimeter.get_energy();
+          }
+      }
+    return energy;
+  }
+
+} // namespace analysis
+
+// end of calorimeter_block_set.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,112 @@
+/* calorimeter_block_set.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Set of calorimeter blocks hit in an event. The SuperNEMO blocks are
+ * mapped to dense indexes and marked with a generation stamp, so that the
+ * set is cleared in constant time and never allocates once set up.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_CALORIMETER_BLOCK_SET_H_
+#define ANALYSIS_CALORIMETER_BLOCK_SET_H_ 1
+
+// Standard libraries:
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Third party:
+// - Bayeux/geomtools:
+#include <geomtools/geom_id.h>
+
+namespace snemo {
+  namespace datamodel {
+    class particle_track_data;
+  }
+}
+
+namespace analysis {
+
+  /// \brief Set of calorimeter blocks
+  ///
+  /// Main wall, X-wall and gamma veto blocks are identified by a dense
+  /// index and marked with the current generation number. The blocks with
+  /// another geometry type or an out of range address are kept in a small
+  /// list searched linearly.
+  class calorimeter_block_set
+  {
+  public:
+
+    /// Geometry types of the calorimeter blocks
+    enum geometry_type {
+      MAIN_WALL_TYPE  = 1302, //!< Main wall block: module, side, column, row
+      X_WALL_TYPE     = 1232, //!< X-wall block: module, side, wall, column, row
+      GAMMA_VETO_TYPE = 1252  //!< Gamma veto block: module, side, wall, column
+    };
+
+    /// Number of dense indexes
+    static const size_t NUMBER_OF_BLOCKS = 2 * 20 * 13 + 2 * 2 * 2 * 16 + 2 * 2 * 16;
+
+    /// Invalid dense index
+    static const size_t INVALID_INDEX = NUMBER_OF_BLOCKS;
+
+    /// Return the dense index of a block, INVALID_INDEX if it is not a known block
+    static size_t dense_index(const geomtools::geom_id & gid_);
+
+    /// Constructor
+    calorimeter_block_set();
+
+    /// Remove all the blocks
+    void clear();
+
+    /// Insert a block, return false if it was already in the set
+    bool insert(const geomtools::geom_id & gid_);
+
+  private:
+
+    uint32_t                        _generation_; //!< Current generation
+    std::vector<uint32_t>           _stamps_;     //!< Generation of the last insertion of each block
+    std::vector<geomtools::geom_id> _others_;     //!< Blocks without dense index
+  };
+
+  /// Return the energy of the calorimeters associated to the particles of
+  /// an event, each block being counted once
+  double associated_calorimeter_energy(const snemo::datamodel::particle_track_data & ptd_,
+                                       calorimeter_block_set & blocks_);
+
+} // namespace analysis
+
+#endif // ANALYSIS_CALORIMETER_BLOCK_SET_H_
+
+// end of calorimeter_block_set.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -1,11 +1,16 @@
 // control_plot_module.cc
 
 // Ourselves:
-#include </home/calvez/nemo/work_dir/Falaise/trunk/modules/PlotModule/source/falaise/snemo/analysis/control_plot_module.h>
+#include <snemo/analysis/control_plot_module.h>
+
+// This project:
+#include <snemo/analysis/bank_utils.h>
+#include <snemo/analysis/histogram_pool_utils.h>
 
 // Standard library:
 #include <stdexcept>
 #include <sstream>
+#include <functional>
 #include <algorithm>
 
 // Third party:
@@ -67,15 +72,91 @@ namespace analysis {
 
   void control_plot_module::_set_defaults()
   {
+    _PTD_label_ = snemo::datamodel::data_info::default_particle_track_data_label();
+    _TD_label_ = snemo::datamodel::data_info::default_topology_data_label();
+    _fill_buffer_size_ = 0;
+    _sharded_ = false;
     _histogram_pool_ = 0;
+    _contexts_.reset();
+    _checkpoint_.reset();
+    _cut_flow_.reset();
+    _booking_.clear();
+    _topologies_.reset();
 
     return;
   }
 
+  const control_plot_module::observable_accessor_type &
+  control_plot_module::_observable_accessor(plot_conventions::control_observable observable_)
+  {
+    // Accessors of the 1eNg topology indexed by observable :
+    static const observable_accessor_type accessors[plot_conventions::CO_NUMBER_OF_OBSERVABLES] = {
+      { &snemo::datamodel::topology_1eNg_pattern::has_electron_energy,
+        &snemo::datamodel::topology_1eNg_pattern::get_electron_energy },
+      { &snemo::datamodel::topology_1eNg_pattern::has_gamma_max_energy,
+        &snemo::datamodel::topology_1eNg_pattern::get_gamma_max_energy },
+      { &snemo::datamodel::topology_1eNg_pattern::has_gamma_mid_energy,
+        &snemo::datamodel::topology_1eNg_pattern::get_gamma_mid_energy },
+      { &snemo::datamodel::topology_1eNg_pattern::has_gamma_min_energy,
+        &snemo::datamodel::topology_1eNg_pattern::get_gamma_min_energy },
+      { &snemo::datamodel::topology_1eNg_pattern::has_total_energy,
+        &snemo::datamodel::topology_1eNg_pattern::get_total_energy }
+    };
+    return accessors[observable_];
+  }
+
+  histogram_filler_1d & control_plot_module::_grab_filler(worker_context_type & context_,
+                                                          const std::string & key_,
+                                                          const std::string & group_,
+                                                          const std::string & template_name_)
+  {
+    filler_dict_type::iterator found = context_.fillers.find(key_);
+    if (found == context_.fillers.end())
+      {
+        mygsl::histogram_1d & h
+          = plot_conventions::grab_mimic_1d(*context_.pool, key_, group_, template_name_, *_histogram_pool_);
+        _checkpoint_.own(key_);
+        found = context_.fillers.insert(std::make_pair(key_, histogram_filler_1d())).first;
+        found->second.initialize(h);
+        found->second.set_buffered(_fill_buffer_size_ > 0, _fill_buffer_size_);
+      }
+    return found->second;
+  }
+
+  void control_plot_module::_fill_booked(worker_context_type & context_,
+                                         const snemo::datamodel::topology_1eNg_pattern & pattern_)
+  {
+    const size_t ngammas = pattern_.get_number_of_gammas();
+    if (context_.fill_plan.size() <= ngammas)
+      {
+        context_.fill_plan.resize(ngammas + 1);
+      }
+    std::vector<histogram_filler_1d *> & a_plan = context_.fill_plan[ngammas];
+    if (a_plan.empty())
+      {
+        // Resolve the histograms of this number of gammas once :
+        a_plan.assign(_booking_.size(), 0);
+        for (size_t i = 0; i < _booking_.size(); ++i)
+          {
+            const plot_conventions::control_booking_entry & an_entry = _booking_[i];
+            if (! an_entry.is_booked(ngammas)) continue;
+            a_plan[i] = &_grab_filler(context_, an_entry.histogram_name(ngammas),
+                                      an_entry.group, an_entry.template_name);
+          }
+      }
+    for (size_t i = 0; i < a_plan.size(); ++i)
+      {
+        if (! a_plan[i]) continue;
+        const observable_accessor_type & an_accessor = _observable_accessor(_booking_[i].observable);
+        if ((pattern_.*an_accessor.has)()) a_plan[i]->fill((pattern_.*an_accessor.get)());
+      }
+    return;
+  }
+
   // Initialization :
   void control_plot_module::initialize(const datatools::properties  & config_,
                                        datatools::service_manager   & service_manager_,
-                                       dpp::module_handle_dict_type & module_dict_)
+                                       dpp::module_handle_dict_type & /*module_dict_*/)
   {
     DT_THROW_IF(is_initialized(),
                 std::logic_error,
@@ -83,6 +164,52 @@ namespace analysis {
 
     dpp::base_module::_common_initialize(config_);
 
+    // Labels of the input banks :
+    if (config_.has_key("PTD_label"))
+      {
+        _PTD_label_ = config_.fetch_string("PTD_label");
+      }
+    if (config_.has_key("TD_label"))
+      {
+        _TD_label_ = config_.fetch_string("TD_label");
+      }
+
+    // Fill a private pool shard per processing thread :
+    if (config_.has_key("sharded"))
+      {
+        _sharded_ = config_.fetch_boolean("sharded");
+      }
+    _contexts_.initialize(_sharded_,
+                          std::bind(&control_plot_module::_setup_context, this, std::placeholders::_1));
+
+    // Store the histograms every 'checkpoint.period_events' events or 'checkpoint.period_seconds' seconds :
+    datatools::properties checkpoint_config;
+    config_.export_and_rename_starting_with(checkpoint_config, "checkpoint.", "");
+    _checkpoint_.initialize(checkpoint_config, get_name());
+    DT_THROW_IF(_checkpoint_.is_enabled() && _sharded_, std::logic_error,
+                "Module '" << get_name() << "' cannot checkpoint sharded histograms !");
+
+    // Cuts applied to the topology pattern, none by default :
+    datatools::properties cut_flow_config;
+    config_.export_and_rename_starting_with(cut_flow_config, "cut_flow.", "");
+    register_topology_cuts(_cut_flow_);
+    _cut_flow_.initialize(cut_flow_config);
+
+    // Histograms booked for the 1eNg topology :
+    datatools::properties booking_config;
+    config_.export_and_rename_starting_with(booking_config, "booking.", "");
+    plot_conventions::compile_control_booking(booking_config, _booking_);
+    _topologies_.enable("1eNg");
+
+    // Number of events staged before filling the histograms :
+    if (config_.has_key("fill_buffer_size"))
+      {
+        const int fill_buffer_size = config_.fetch_integer("fill_buffer_size");
+        DT_THROW_IF(fill_buffer_size < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'fill_buffer_size' property !");
+        _fill_buffer_size_ = fill_buffer_size;
+      }
+
     // Service label
     std::string histogram_label;
     if (config_.has_key("Histo_label"))
@@ -98,8 +225,7 @@ namespace analysis {
                     ! service_manager_.is_a<dpp::histogram_service>(histogram_label),
                     std::logic_error,
                     "Module '" << get_name() << "' has no '" << histogram_label << "' service !");
-        dpp::histogram_service & Histo
-          = service_manager_.get<dpp::histogram_service>(histogram_label);
+        dpp::histogram_service & Histo = service_manager_.grab<dpp::histogram_service>(histogram_label);
         set_histogram_pool(Histo.grab_pool());
         if (config_.has_key("Histo_output_files"))
           {
@@ -123,18 +249,84 @@ namespace analysis {
             }
           }
 
+        // Resume from the last checkpoint :
+        _checkpoint_.restore(*_histogram_pool_);
+
         // Tag the module as initialized :
         _set_initialized(true);
         return;
       }
   }
 
+  void control_plot_module::_report_cut_flow()
+  {
+    if (get_logging_priority() < datatools::logger::PRIO_NOTICE) return;
+    topology_cut_flow total = _cut_flow_;
+    total.reset_counters();
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        total.merge(_contexts_.grab(i).cut_flow);
+      }
+    DT_LOG_NOTICE(get_logging_priority(), "Cut flow of module '" << get_name() << "' :");
+    total.print_table(std::clog, "  ");
+    return;
+  }
+
+  void control_plot_module::_setup_context(worker_context_type & context_)
+  {
+    context_.pool = _histogram_pool_;
+    if (_sharded_)
+      {
+        context_.shard.reset(new mygsl::histogram_pool);
+        context_.shard->initialize(datatools::properties());
+        context_.pool = context_.shard.get();
+      }
+    context_.buffered_events = 0;
+    context_.cut_flow = _cut_flow_;
+    context_.fill_plan.clear();
+    return;
+  }
+
+  void control_plot_module::_flush_fillers(worker_context_type & context_)
+  {
+    for (filler_dict_type::iterator
+           ifiller = context_.fillers.begin();
+         ifiller != context_.fillers.end(); ++ifiller)
+      {
+        ifiller->second.flush();
+      }
+    return;
+  }
+
+  void control_plot_module::_merge_contexts()
+  {
+    // The shards are summed in an order that does not depend on the threads
+    std::vector<const mygsl::histogram_pool *> shards;
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        worker_context_type & a_context = _contexts_.grab(i);
+        _flush_fillers(a_context);
+        if (a_context.shard) shards.push_back(a_context.shard.get());
+      }
+    merge_histogram_pools(*_histogram_pool_, shards);
+    return;
+  }
+
   // Reset :
   void control_plot_module::reset()
   {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Fill the histograms with the remaining staged values and merge the shards :
+    _merge_contexts();
+
+    // Report the cut flow
+    _report_cut_flow();
+
+    // The run is complete, the checkpoint is not needed anymore :
+    _checkpoint_.terminate();
+
     // Tag the module as un-initialized :
     _set_initialized(false);
     _set_defaults();
@@ -163,16 +355,27 @@ namespace analysis {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Working context of the calling thread :
+    worker_context_type & a_context = _contexts_.grab_local();
+
+    // Skip the events already counted by the restored checkpoint, store a new one when due
+    // and fill the histograms with the staged values every 'fill_buffer_size' events :
+    if (begin_checkpointed_event(_checkpoint_, *_histogram_pool_, _fill_buffer_size_, a_context.buffered_events,
+                                 [&]() { _flush_fillers(a_context); }))
+      {
+        return dpp::base_module::PROCESS_CONTINUE;
+      }
+
     // Check if some 'topology_data' are available in the data model:
-    const std::string td_label = snemo::datamodel::data_info::default_topology_data_label();
-    if (! data_record_.has(td_label)) {
+    const snemo::datamodel::topology_data * td_bank
+      = try_get_bank<snemo::datamodel::topology_data>(data_record_, _TD_label_);
+    if (! td_bank) {
       DT_LOG_ERROR(get_logging_priority(), "Missing topology data to be processed !");
       return dpp::base_module::PROCESS_ERROR;
     }
 
     // Get the 'topology_data' entry from the data model :
-    const snemo::datamodel::topology_data & td
-      = data_record_.get<snemo::datamodel::topology_data>(td_label);
+    const snemo::datamodel::topology_data & td = *td_bank;
 
     DT_LOG_DEBUG(get_logging_priority(), "Topology data : ");
     if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) td.tree_dump();
@@ -183,7 +386,12 @@ namespace analysis {
     }
     const snemo::datamodel::base_topology_pattern & a_pattern = td.get_pattern();
 
-    const std::string & a_pattern_id = a_pattern.get_pattern_id();
+    // The pattern identifier is interned once for the cuts and the dispatch :
+    const topology_event an_event = { a_pattern, topology_registry::intern(a_pattern) };
+    if (! a_context.cut_flow.select(an_event)) {
+      DT_LOG_DEBUG(get_logging_priority(), "Event rejected by the cut flow !");
+      return dpp::base_module::PROCESS_CONTINUE;
+    }
 
     // if (a_pattern_id != "2e") {
     //   DT_LOG_WARNING(get_logging_priority(), "PlotModule only works for '2e' topology for now !");
@@ -195,258 +403,9 @@ namespace analysis {
     //   return dpp::base_module::PROCESS_SUCCESS;
     // }
 
-    if (a_pattern_id == "1eNg") {
-      const snemo::datamodel::topology_1eNg_pattern * ptr_1eNg_pattern
-        = dynamic_cast<const snemo::datamodel::topology_1eNg_pattern *>(&a_pattern);
-
-      const int ngammas = ptr_1eNg_pattern->get_number_of_gammas();
-
-      if(ngammas >3) {
-        DT_LOG_ERROR(get_logging_priority(), "PlotModule only works for '1eNg' topology  with up to 3 gammas for now !");
-        return dpp::base_module::PROCESS_ERROR;
-      }
-
-      if(ngammas == 1) {
-        std::ostringstream key;
-        key << "1e" << ngammas << "g";
-
-        std::ostringstream key_electron_energy;
-        key_electron_energy << "1e1g" << "_electron_energy";
-
-        // Getting histogram pool
-        mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-        if (! a_pool.has(key_electron_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_electron_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_electron_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_electron_energy = a_pool.grab_1d(key_electron_energy.str ());
-          a_histo_electron_energy.fill(ptr_1eNg_pattern->get_electron_energy());
-        }
-
-        std::ostringstream key_gamma_energy;
-        key_gamma_energy << "1e1g"<< "_gamma_max_energy";
-
-        if (! a_pool.has(key_gamma_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_gamma_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_gamma_max_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_gamma_energy = a_pool.grab_1d(key_gamma_energy.str ());
-          a_histo_gamma_energy.fill(ptr_1eNg_pattern->get_gamma_max_energy());
-        }
-
-        std::ostringstream key_tot_energy;
-        key_tot_energy << "1e1g"<< "_tot_energy";
-
-        if (! a_pool.has(key_tot_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_tot_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_total_energy()) {
-          // std::cout << "DEBUG has total energy " << ptr_1eNg_pattern->get_total_energy() << std::endl;
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_tot_energy = a_pool.grab_1d(key_tot_energy.str ());
-          a_histo_tot_energy.fill(ptr_1eNg_pattern->get_total_energy());
-        }
-      }
-
-      if(ngammas == 3) {
-        std::ostringstream key;
-        key << "1e" << ngammas << "g";
-
-        std::ostringstream key_electron_energy;
-        key_electron_energy  << "1e3g" << "_electron_energy";
-
-        // Getting histogram pool
-        mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-        if (! a_pool.has(key_electron_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_electron_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_electron_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_electron_energy = a_pool.grab_1d(key_electron_energy.str ());
-          a_histo_electron_energy.fill(ptr_1eNg_pattern->get_electron_energy());
-        }
-
-        std::ostringstream key_gamma_max_energy;
-        key_gamma_max_energy  << "1e3g" << "_gamma_max_energy";
-
-        if (! a_pool.has(key_gamma_max_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_gamma_max_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_gamma_max_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_gamma_max_energy = a_pool.grab_1d(key_gamma_max_energy.str ());
-          a_histo_gamma_max_energy.fill(ptr_1eNg_pattern->get_gamma_max_energy());
-        }
-
-        std::ostringstream key_gamma_mid_energy;
-        key_gamma_mid_energy  << "1e3g" << "_gamma_mid_energy";
-
-        if (! a_pool.has(key_gamma_mid_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_gamma_mid_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_gamma_mid_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_gamma_mid_energy = a_pool.grab_1d(key_gamma_mid_energy.str ());
-          a_histo_gamma_mid_energy.fill(ptr_1eNg_pattern->get_gamma_mid_energy());
-        }
-
-        std::ostringstream key_gamma_min_energy;
-        key_gamma_min_energy  << "1e3g" << "_gamma_min_energy";
-
-        if (! a_pool.has(key_gamma_min_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_gamma_min_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_gamma_min_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_gamma_min_energy = a_pool.grab_1d(key_gamma_min_energy.str ());
-          a_histo_gamma_min_energy.fill(ptr_1eNg_pattern->get_gamma_min_energy());
-        }
-
-         std::ostringstream key_tot_energy;
-        key_tot_energy << "1e3g"<< "_tot_energy";
-
-        if (! a_pool.has(key_tot_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_tot_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_total_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_tot_energy = a_pool.grab_1d(key_tot_energy.str ());
-          a_histo_tot_energy.fill(ptr_1eNg_pattern->get_total_energy());
-        }
-
-      }
-      if(ngammas == 2) {
-        std::ostringstream key;
-        key << "1e" << ngammas << "g";
-
-        std::ostringstream key_electron_energy;
-        key_electron_energy  << "1e2g" << "_electron_energy";
-
-        // Getting histogram pool
-        mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-        if (! a_pool.has(key_electron_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_electron_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_electron_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_electron_energy = a_pool.grab_1d(key_electron_energy.str ());
-          a_histo_electron_energy.fill(ptr_1eNg_pattern->get_electron_energy());
-        }
-
-        std::ostringstream key_gamma_max_energy;
-        key_gamma_max_energy  << "1e2g" << "_gamma_max_energy";
-
-        if (! a_pool.has(key_gamma_max_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_gamma_max_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_gamma_max_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_gamma_max_energy = a_pool.grab_1d(key_gamma_max_energy.str ());
-          a_histo_gamma_max_energy.fill(ptr_1eNg_pattern->get_gamma_max_energy());
-        }
-
-        std::ostringstream key_gamma_min_energy;
-        key_gamma_min_energy  << "1e2g" << "_gamma_min_energy";
-
-        if (! a_pool.has(key_gamma_min_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_gamma_min_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_gamma_min_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_gamma_min_energy = a_pool.grab_1d(key_gamma_min_energy.str ());
-          a_histo_gamma_min_energy.fill(ptr_1eNg_pattern->get_gamma_min_energy());
-        }
-
-        std::ostringstream key_tot_energy;
-        key_tot_energy << "1e2g"<< "_tot_energy";
-
-        if (! a_pool.has(key_tot_energy.str()))
-          {
-            mygsl::histogram_1d & h = a_pool.add_1d(key_tot_energy.str(), "", "energy");
-            datatools::properties hconfig;
-            hconfig.store_string("mode", "mimic");
-            hconfig.store_string("mimic.histogram_1d", "energy_template");
-            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-          }
-
-        if(ptr_1eNg_pattern->has_total_energy()) {
-          // Getting the current histogram
-          mygsl::histogram_1d & a_histo_tot_energy = a_pool.grab_1d(key_tot_energy.str ());
-          a_histo_tot_energy.fill(ptr_1eNg_pattern->get_total_energy());
-        }
-
-      }
+    // The interned topology guarantees the concrete class of the pattern :
+    if (an_event.kind == TOPOLOGY_1ENG && _topologies_.is_enabled(TOPOLOGY_1ENG)) {
+      _fill_booked(a_context, static_cast<const snemo::datamodel::topology_1eNg_pattern &>(a_pattern));
     }
 
     /* // 2e fill
@@ -570,15 +529,15 @@ namespace analysis {
     //-----Energy plots
 
     // Check if the 'particle track' record bank is available :
-    const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-    if (! data_record_.has(ptd_label))
+    const snemo::datamodel::particle_track_data * ptd_bank
+      = try_get_bank<snemo::datamodel::particle_track_data>(data_record_, _PTD_label_);
+    if (! ptd_bank)
       {
         DT_LOG_ERROR(get_logging_priority (), "Could not find any bank with label '"
-                     << ptd_label << "' !");
+                     << _PTD_label_ << "' !");
         return dpp::base_module::PROCESS_STOP;
       }
-    const snemo::datamodel::particle_track_data & ptd
-      = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
+    const snemo::datamodel::particle_track_data & ptd = *ptd_bank;
 
     const snemo::datamodel::particle_track_data::particle_collection_type & the_particles = ptd.get_particles();
 
@@ -36,14 +36,31 @@
 // Standard libraires:
 #include <set>
 #include <map>
+#include <string>
+#include <memory>
+#include <vector>
 
 // Data processing module abstract base class
 #include <dpp/base_module.h>
 
+// This project:
+#include <snemo/analysis/histogram_filler.h>
+#include <snemo/analysis/thread_context.h>
+#include <snemo/analysis/histogram_checkpoint.h>
+#include <snemo/analysis/topology_cuts.h>
+#include <snemo/analysis/topology_dispatch.h>
+#include <snemo/analysis/plot_conventions.h>
+
 namespace mygsl {
   class histogram_pool;
 }
 
+namespace snemo {
+  namespace datamodel {
+    class topology_1eNg_pattern;
+  }
+}
+
 namespace analysis {
 
   class control_plot_module : public dpp::base_module
@@ -80,9 +97,87 @@ namespace analysis {
 
   private:
 
+    /// Fillers of the resolved histograms indexed by name
+    typedef std::map<std::string, histogram_filler_1d> filler_dict_type;
+
+    /// Check if an observable of the 1eNg topology is available
+    typedef bool (snemo::datamodel::topology_1eNg_pattern::*observable_has_type)() const;
+
+    /// Return an observable of the 1eNg topology
+    typedef double (snemo::datamodel::topology_1eNg_pattern::*observable_get_type)() const;
+
+    /// Accessors of an observable of the 1eNg topology
+    struct observable_accessor_type
+    {
+      observable_has_type has; //!< Availability of the observable
+      observable_get_type get; //!< Accessor of the observable
+    };
+
+    /// Return the accessors of a booked observable
+    static const observable_accessor_type & _observable_accessor(plot_conventions::control_observable observable_);
+
+    /// Working context of a processing thread
+    struct worker_context_type
+    {
+      mygsl::histogram_pool *                pool;            //!< Pool filled by the context
+      std::unique_ptr<mygsl::histogram_pool> shard;           //!< Private pool in sharded mode
+      filler_dict_type                       fillers;         //!< Fillers of the histograms already resolved
+      size_t                                 buffered_events; //!< Number of events staged since the last fill
+      topology_cut_flow                      cut_flow;        //!< Private copy of the cut flow
+      std::vector<std::vector<histogram_filler_1d *> > fill_plan; //!< Fillers indexed by number of gammas and booking entry
+    };
+
+    /// Setup a new working context
+    void _setup_context(worker_context_type & context_);
+
+    /// Return the filler of a histogram, creating it from a template if needed
+    histogram_filler_1d & _grab_filler(worker_context_type & context_,
+                                       const std::string & key_,
+                                       const std::string & group_,
+                                       const std::string & template_name_);
+
+    /// Fill the booked histograms of a 1eNg topology
+    void _fill_booked(worker_context_type & context_, const snemo::datamodel::topology_1eNg_pattern & pattern_);
+
+    /// Fill the histograms of a context with the staged values
+    void _flush_fillers(worker_context_type & context_);
+
+    /// Print the cut flow table summed over the working contexts
+    void _report_cut_flow();
+
+    /// Flush all the contexts and merge the shards into the histogram pool
+    void _merge_contexts();
+
+    // The label of the particle track data bank :
+    std::string _PTD_label_;
+
+    // The label of the topology data bank :
+    std::string _TD_label_;
+
     // The histogram pool :
     mygsl::histogram_pool * _histogram_pool_;
 
+    // Number of events staged before filling the histograms :
+    size_t _fill_buffer_size_;
+
+    // Flag to fill a private pool shard per thread :
+    bool _sharded_;
+
+    // The working contexts :
+    thread_context_set<worker_context_type> _contexts_;
+
+    // The checkpoint of the accumulated histograms :
+    histogram_checkpoint _checkpoint_;
+
+    // The cut flow applied to the topology pattern :
+    topology_cut_flow _cut_flow_;
+
+    // The booking table of the 1eNg histograms :
+    std::vector<plot_conventions::control_booking_entry> _booking_;
+
+    // The topologies filled by the module :
+    topology_registry _topologies_;
+
     // Macro to automate the registration of the module :
     DPP_MODULE_REGISTRATION_INTERFACE(control_plot_module);
   };
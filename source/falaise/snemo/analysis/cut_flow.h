@@ -0,0 +1,337 @@
+/* cut_flow.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Event selection made of named cuts configured from properties. Every
+ * cut counts the events it tests and rejects, and the cuts are reordered
+ * during processing so that the cheap and highly rejecting ones run first.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_CUT_FLOW_H_
+#define ANALYSIS_CUT_FLOW_H_ 1
+
+// Standard libraries:
+#include <map>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  /// \brief Sequence of cuts applied to an event
+  ///
+  /// The available cuts are registered with a factory building the
+  /// predicate from the cut parameters, and a relative cost. The
+  /// configuration selects the cuts to apply:
+  ///
+  ///  - 'cuts'           : names of the applied cuts (default: the cuts given to initialize)
+  ///  - '<cut>.<param>'  : parameters passed to the factory of a cut
+  ///  - '<cut>.cost'     : relative cost of a cut, overriding the registered one
+  ///  - 'adaptive'       : reorder the cuts during processing (default: true)
+  ///  - 'reorder_period' : number of events between two reorderings (default: 1000)
+  ///
+  /// Since an event is accepted only when all the cuts pass, the cuts can
+  /// be run in any order. The adaptive mode sorts them by increasing ratio
+  /// of their cost to their measured rejection rate, which minimises the
+  /// mean cost per event for independent cuts.
+  template <class Event>
+  class cut_flow
+  {
+  public:
+
+    /// Predicate of a cut, true if the event passes the cut
+    typedef std::function<bool(Event &)> predicate_type;
+
+    /// Factory of a cut predicate from its parameters
+    typedef std::function<predicate_type(const datatools::properties &)> factory_type;
+
+    /// Constructor
+    cut_flow()
+    {
+      reset();
+      return;
+    }
+
+    /// Register an available cut
+    void register_cut(const std::string & name_, const factory_type & factory_, double cost_ = 1.0)
+    {
+      DT_THROW_IF(_factories_.count(name_), std::logic_error, "Cut '" << name_ << "' is already registered !");
+      DT_THROW_IF(cost_ <= 0.0, std::domain_error, "Cut '" << name_ << "' has an invalid cost !");
+      registered_type & a_registered = _factories_[name_];
+      a_registered.factory = factory_;
+      a_registered.cost = cost_;
+      return;
+    }
+
+    /// Build the applied cuts from a configuration
+    void initialize(const datatools::properties & config_,
+                    const std::vector<std::string> & default_cuts_ = std::vector<std::string>())
+    {
+      _cuts_.clear();
+      _order_.clear();
+      reset_counters();
+      std::vector<std::string> names = default_cuts_;
+      if (config_.has_key("cuts"))
+        {
+          names.clear();
+          config_.fetch("cuts", names);
+        }
+      _adaptive_ = true;
+      if (config_.has_key("adaptive"))
+        {
+          _adaptive_ = config_.fetch_boolean("adaptive");
+        }
+      _reorder_period_ = 1000;
+      if (config_.has_key("reorder_period"))
+        {
+          const int reorder_period = config_.fetch_integer("reorder_period");
+          DT_THROW_IF(reorder_period <= 0, std::domain_error, "Invalid 'reorder_period' property !");
+          _reorder_period_ = reorder_period;
+        }
+      for (size_t i = 0; i < names.size(); ++i)
+        {
+          typename std::map<std::string, registered_type>::const_iterator found = _factories_.find(names[i]);
+          DT_THROW_IF(found == _factories_.end(), std::logic_error, "Unknown cut '" << names[i] << "' !");
+          datatools::properties parameters;
+          config_.export_and_rename_starting_with(parameters, names[i] + ".", "");
+          cut_type a_cut;
+          a_cut.name = names[i];
+          a_cut.cost = found->second.cost;
+          if (parameters.has_key("cost"))
+            {
+              a_cut.cost = parameters.fetch_real("cost");
+              DT_THROW_IF(a_cut.cost <= 0.0, std::domain_error, "Cut '" << names[i] << "' has an invalid cost !");
+            }
+          a_cut.predicate = found->second.factory(parameters);
+          a_cut.tested = 0;
+          a_cut.rejected = 0;
+          _cuts_.push_back(a_cut);
+          _order_.push_back(i);
+        }
+      return;
+    }
+
+    /// Remove the registered and applied cuts
+    void reset()
+    {
+      _factories_.clear();
+      _cuts_.clear();
+      _order_.clear();
+      _adaptive_ = true;
+      _reorder_period_ = 1000;
+      reset_counters();
+      return;
+    }
+
+    /// Reset the counters
+    void reset_counters()
+    {
+      for (size_t i = 0; i < _cuts_.size(); ++i)
+        {
+          _cuts_[i].tested = 0;
+          _cuts_[i].rejected = 0;
+        }
+      _events_ = 0;
+      _accepted_ = 0;
+      _since_reorder_ = 0;
+      return;
+    }
+
+    /// Check if there is no applied cut
+    bool empty() const
+    {
+      return _cuts_.empty();
+    }
+
+    /// Apply the cuts, return true if the event passes all of them
+    bool select(Event & event_)
+    {
+      _events_++;
+      if (_adaptive_ && ++_since_reorder_ >= _reorder_period_)
+        {
+          _reorder();
+          _since_reorder_ = 0;
+        }
+      for (size_t i = 0; i < _order_.size(); ++i)
+        {
+          cut_type & a_cut = _cuts_[_order_[i]];
+          a_cut.tested++;
+          if (! a_cut.predicate(event_))
+            {
+              a_cut.rejected++;
+              return false;
+            }
+        }
+      _accepted_++;
+      return true;
+    }
+
+    /// Add the counters of another cut flow with the same cuts
+    void merge(const cut_flow & other_)
+    {
+      DT_THROW_IF(other_._cuts_.size() != _cuts_.size(), std::logic_error, "Cut flows have different cuts !");
+      for (size_t i = 0; i < _cuts_.size(); ++i)
+        {
+          _cuts_[i].tested += other_._cuts_[i].tested;
+          _cuts_[i].rejected += other_._cuts_[i].rejected;
+        }
+      _events_ += other_._events_;
+      _accepted_ += other_._accepted_;
+      return;
+    }
+
+    /// Return the number of selected events
+    uint64_t get_number_of_events() const
+    {
+      return _events_;
+    }
+
+    /// Return the number of accepted events
+    uint64_t get_number_of_accepted_events() const
+    {
+      return _accepted_;
+    }
+
+    /// Return the number of applied cuts
+    size_t size() const
+    {
+      return _cuts_.size();
+    }
+
+    /// Return the name of an applied cut, cuts in configuration order
+    const std::string & get_cut_name(size_t index_) const
+    {
+      return _cuts_.at(index_).name;
+    }
+
+    /// Return the number of events tested by an applied cut
+    uint64_t get_number_of_tested_events(size_t index_) const
+    {
+      return _cuts_.at(index_).tested;
+    }
+
+    /// Return the number of events rejected by an applied cut
+    uint64_t get_number_of_rejected_events(size_t index_) const
+    {
+      return _cuts_.at(index_).rejected;
+    }
+
+    /// Print the cut flow table, cuts in configuration order
+    void print_table(std::ostream & out_, const std::string & indent_ = "") const
+    {
+      const std::ios::fmtflags flags = out_.flags();
+      const std::streamsize precision = out_.precision();
+      out_ << indent_ << std::left << std::setw(24) << "cut"
+           << std::right << std::setw(8) << "cost"
+           << std::setw(14) << "tested"
+           << std::setw(14) << "rejected"
+           << std::setw(12) << "rejection" << std::endl;
+      for (size_t i = 0; i < _cuts_.size(); ++i)
+        {
+          const cut_type & a_cut = _cuts_[i];
+          const double rejection = a_cut.tested > 0 ? double(a_cut.rejected) / a_cut.tested : 0.0;
+          out_ << indent_ << std::left << std::setw(24) << a_cut.name
+               << std::right << std::setw(8) << a_cut.cost
+               << std::setw(14) << a_cut.tested
+               << std::setw(14) << a_cut.rejected
+               << std::setw(12) << std::fixed << std::setprecision(4) << rejection << std::endl;
+          out_.flags(flags);
+          out_.precision(precision);
+        }
+      out_ << indent_ << "events: " << _events_ << ", accepted: " << _accepted_ << std::endl;
+      out_.flags(flags);
+      return;
+    }
+
+  private:
+
+    /// Sort the cuts by increasing cost per rejected event
+    void _reorder()
+    {
+      std::vector<double> ranks(_cuts_.size());
+      for (size_t i = 0; i < _cuts_.size(); ++i)
+        {
+          // The prior of one rejection and one pass avoids dividing by zero
+          const double rejection = (_cuts_[i].rejected + 1.0) / (_cuts_[i].tested + 2.0);
+          ranks[i] = _cuts_[i].cost / rejection;
+        }
+      std::stable_sort(_order_.begin(), _order_.end(),
+                       [&ranks](size_t a_, size_t b_) { return ranks[a_] < ranks[b_]; });
+      return;
+    }
+
+  private:
+
+    /// Registered cut
+    struct registered_type
+    {
+      factory_type factory; //!< Factory of the predicate
+      double       cost;    //!< Default relative cost
+    };
+
+    /// Applied cut
+    struct cut_type
+    {
+      std::string    name;      //!< Name of the cut
+      predicate_type predicate; //!< Predicate
+      double         cost;      //!< Relative cost
+      uint64_t       tested;    //!< Number of tested events
+      uint64_t       rejected;  //!< Number of rejected events
+    };
+
+    std::map<std::string, registered_type> _factories_;      //!< Registered cuts
+    std::vector<cut_type>                  _cuts_;           //!< Applied cuts in configuration order
+    std::vector<size_t>                    _order_;          //!< Evaluation order of the applied cuts
+    bool                                   _adaptive_;       //!< Adaptive ordering flag
+    uint64_t                               _reorder_period_; //!< Number of events between two reorderings
+    uint64_t                               _events_;         //!< Number of selected events
+    uint64_t                               _accepted_;       //!< Number of accepted events
+    uint64_t                               _since_reorder_;  //!< Number of events since the last reordering
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_CUT_FLOW_H_
+
+// end of cut_flow.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,453 @@
+// feature_cache.cc
+
+// Ourselves:
+#include <snemo/analysis/feature_cache.h>
+
+// Standard library:
+#include <cstring>
+#include <stdexcept>
+
+// System:
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+#include <datatools/logger.h>
+
+namespace analysis {
+
+  // Magic word at the beginning of a feature cache file.
+  const char FEATURE_CACHE_MAGIC[8] = { 'S', 'N', 'F', 'C', 'A', 'C', 'H', 'E' };
+
+  // Magic word at the end of a feature cache file.
+  const char FEATURE_CACHE_END_MAGIC[8] = { 'S', 'N', 'F', 'C', 'F', 'O', 'O', 'T' };
+
+  // Version of the file layout.
+  const uint32_t FEATURE_CACHE_VERSION = 1;
+
+  // Size of a column of 32-bit integers padded to 8 bytes.
+  inline size_t integer_column_size(size_t rows_)
+  {
+    return (rows_ * sizeof(int32_t) + 7) & ~static_cast<size_t>(7);
+  }
+
+  const size_t feature_cache_writer::DEFAULT_ROW_GROUP_SIZE;
+
+  feature_cache_writer::feature_cache_writer()
+  {
+    _row_group_size_ = DEFAULT_ROW_GROUP_SIZE;
+    _buffered_rows_ = 0;
+    _rows_ = 0;
+    return;
+  }
+
+  feature_cache_writer::~feature_cache_writer()
+  {
+    if (! is_open()) return;
+    try
+      {
+        close();
+      }
+    catch (std::exception & error)
+      {
+        DT_LOG_ERROR(datatools::logger::PRIO_ERROR, "Cannot close feature cache '" << _path_ << "' : " << error.what());
+      }
+    return;
+  }
+
+  size_t feature_cache_writer::add_real_column(const std::string & name_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Feature cache '" << _path_ << "' is already open !");
+    _real_names_.push_back(name_);
+    return _real_names_.size() - 1;
+  }
+
+  size_t feature_cache_writer::add_integer_column(const std::string & name_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Feature cache '" << _path_ << "' is already open !");
+    _integer_names_.push_back(name_);
+    return _integer_names_.size() - 1;
+  }
+
+  void feature_cache_writer::_align()
+  {
+    static const char zeros[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    const size_t position = _out_.tellp();
+    if (position % 8) _out_.write(zeros, 8 - position % 8);
+    return;
+  }
+
+  void feature_cache_writer::open(const std::string & path_, size_t row_group_size_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Feature cache '" << _path_ << "' is already open !");
+    DT_THROW_IF(row_group_size_ == 0, std::domain_error, "Invalid row group size !");
+    _out_.open(path_.c_str(), std::ios::binary | std::ios::trunc);
+    DT_THROW_IF(! _out_, std::runtime_error, "Cannot open feature cache file '" << path_ << "' !");
+    _path_ = path_;
+    _row_group_size_ = row_group_size_;
+    _reals_.assign(_real_names_.size(), std::vector<double>());
+    _integers_.assign(_integer_names_.size(), std::vector<int32_t>());
+    for (size_t c = 0; c < _reals_.size(); ++c) _reals_[c].reserve(_row_group_size_);
+    for (size_t c = 0; c < _integers_.size(); ++c) _integers_[c].reserve(_row_group_size_);
+    _buffered_rows_ = 0;
+    _rows_ = 0;
+    _group_offsets_.clear();
+    _group_rows_.clear();
+    _strings_.clear();
+    _string_ids_.clear();
+
+    // Header
+    _out_.write(FEATURE_CACHE_MAGIC, sizeof(FEATURE_CACHE_MAGIC));
+    const uint32_t header[4] = { FEATURE_CACHE_VERSION,
+                                 static_cast<uint32_t>(_real_names_.size()),
+                                 static_cast<uint32_t>(_integer_names_.size()),
+                                 0 };
+    _out_.write(reinterpret_cast<const char *>(header), sizeof(header));
+    std::vector<std::string> names(_real_names_);
+    names.insert(names.end(), _integer_names_.begin(), _integer_names_.end());
+    for (size_t c = 0; c < names.size(); ++c)
+      {
+        const uint32_t length = names[c].size();
+        _out_.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        _out_.write(names[c].data(), length);
+      }
+    _align();
+    return;
+  }
+
+  bool feature_cache_writer::is_open() const
+  {
+    return _out_.is_open();
+  }
+
+  int32_t feature_cache_writer::intern(const std::string & value_)
+  {
+    std::unordered_map<std::string, int32_t>::const_iterator found = _string_ids_.find(value_);
+    if (found != _string_ids_.end()) return found->second;
+    const int32_t id = _strings_.size();
+    _strings_.push_back(value_);
+    _string_ids_.insert(std::make_pair(value_, id));
+    return id;
+  }
+
+  void feature_cache_writer::append_row(const double * reals_, const int32_t * integers_)
+  {
+    DT_THROW_IF(! is_open(), std::logic_error, "Feature cache is not open !");
+    for (size_t c = 0; c < _reals_.size(); ++c) _reals_[c].push_back(reals_[c]);
+    for (size_t c = 0; c < _integers_.size(); ++c) _integers_[c].push_back(integers_[c]);
+    ++_rows_;
+    if (++_buffered_rows_ >= _row_group_size_) _write_row_group();
+    return;
+  }
+
+  size_t feature_cache_writer::get_number_of_rows() const
+  {
+    return _rows_;
+  }
+
+  void feature_cache_writer::_write_row_group()
+  {
+    if (_buffered_rows_ == 0) return;
+    _group_offsets_.push_back(_out_.tellp());
+    _group_rows_.push_back(_buffered_rows_);
+    for (size_t c = 0; c < _reals_.size(); ++c)
+      {
+        _out_.write(reinterpret_cast<const char *>(&_reals_[c][0]), _buffered_rows_ * sizeof(double));
+        _reals_[c].clear();
+      }
+    for (size_t c = 0; c < _integers_.size(); ++c)
+      {
+        _out_.write(reinterpret_cast<const char *>(&_integers_[c][0]), _buffered_rows_ * sizeof(int32_t));
+        _align();
+        _integers_[c].clear();
+      }
+    _buffered_rows_ = 0;
+    DT_THROW_IF(! _out_, std::runtime_error, "Cannot write feature cache file '" << _path_ << "' !");
+    return;
+  }
+
+  void feature_cache_writer::close()
+  {
+    DT_THROW_IF(! is_open(), std::logic_error, "Feature cache is not open !");
+    _write_row_group();
+
+    // Footer
+    const uint64_t footer_offset = _out_.tellp();
+    const uint64_t ngroups = _group_offsets_.size();
+    _out_.write(reinterpret_cast<const char *>(&ngroups), sizeof(ngroups));
+    for (size_t g = 0; g < ngroups; ++g)
+      {
+        _out_.write(reinterpret_cast<const char *>(&_group_offsets_[g]), sizeof(uint64_t));
+        _out_.write(reinterpret_cast<const char *>(&_group_rows_[g]), sizeof(uint64_t));
+      }
+    const uint64_t nstrings = _strings_.size();
+    _out_.write(reinterpret_cast<const char *>(&nstrings), sizeof(nstrings));
+    for (size_t s = 0; s < nstrings; ++s)
+      {
+        const uint32_t length = _strings_[s].size();
+        _out_.write(reinterpret_cast<const char *>(&length), sizeof(length));
+        _out_.write(_strings_[s].data(), length);
+      }
+    _align();
+    _out_.write(reinterpret_cast<const char *>(&footer_offset), sizeof(footer_offset));
+    _out_.write(FEATURE_CACHE_END_MAGIC, sizeof(FEATURE_CACHE_END_MAGIC));
+    DT_THROW_IF(! _out_, std::runtime_error, "Cannot write feature cache file '" << _path_ << "' !");
+    _out_.close();
+    return;
+  }
+
+  void feature_cache_writer::reset()
+  {
+    if (is_open()) close();
+    _path_.clear();
+    _row_group_size_ = DEFAULT_ROW_GROUP_SIZE;
+    _real_names_.clear();
+    _integer_names_.clear();
+    _reals_.clear();
+    _integers_.clear();
+    _buffered_rows_ = 0;
+    _rows_ = 0;
+    _group_offsets_.clear();
+    _group_rows_.clear();
+    _strings_.clear();
+    _string_ids_.clear();
+    return;
+  }
+
+  // Bounded sequential reading of the mapped file.
+  class mapped_cursor
+  {
+  public:
+
+    mapped_cursor(const char * data_, size_t size_, size_t position_)
+      : _data_(data_), _size_(size_), _position_(position_)
+    {
+      return;
+    }
+
+    template <class T> T read()
+    {
+      T value;
+      std::memcpy(&value, _take(sizeof(T)), sizeof(T));
+      return value;
+    }
+
+    std::string read_string()
+    {
+      const uint32_t length = read<uint32_t>();
+      const char * bytes = _take(length);
+      return std::string(bytes, length);
+    }
+
+    void align()
+    {
+      _position_ = (_position_ + 7) & ~static_cast<size_t>(7);
+      return;
+    }
+
+  private:
+
+    const char * _take(size_t n_)
+    {
+      DT_THROW_IF(_position_ + n_ > _size_, std::runtime_error, "Truncated feature cache file !");
+      const char * bytes = _data_ + _position_;
+      _position_ += n_;
+      return bytes;
+    }
+
+    const char * _data_;
+    size_t _size_;
+    size_t _position_;
+  };
+
+  feature_cache_reader::feature_cache_reader()
+  {
+    _data_ = 0;
+    _size_ = 0;
+    return;
+  }
+
+  feature_cache_reader::~feature_cache_reader()
+  {
+    if (is_open()) close();
+    return;
+  }
+
+  void feature_cache_reader::open(const std::string & path_)
+  {
+    DT_THROW_IF(is_open(), std::logic_error, "Feature cache reader is already open !");
+    const int fd = ::open(path_.c_str(), O_RDONLY);
+    DT_THROW_IF(fd < 0, std::runtime_error, "Cannot open feature cache file '" << path_ << "' !");
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0)
+      {
+        ::close(fd);
+        DT_THROW(std::runtime_error, "Cannot stat feature cache file '" << path_ << "' !");
+      }
+    const size_t size = file_stat.st_size;
+    const size_t min_size = sizeof(FEATURE_CACHE_MAGIC) + 4 * sizeof(uint32_t)
+      + sizeof(uint64_t) + sizeof(FEATURE_CACHE_END_MAGIC);
+    if (size < min_size)
+      {
+        ::close(fd);
+        DT_THROW(std::runtime_error, "File '" << path_ << "' is not a feature cache !");
+      }
+    void * data = ::mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    DT_THROW_IF(data == MAP_FAILED, std::runtime_error, "Cannot map feature cache file '" << path_ << "' !");
+    // Columns are read sequentially row group by row group
+    ::madvise(data, size, MADV_SEQUENTIAL);
+    _data_ = static_cast<const char *>(data);
+    _size_ = size;
+
+    try
+      {
+        DT_THROW_IF(std::memcmp(_data_, FEATURE_CACHE_MAGIC, sizeof(FEATURE_CACHE_MAGIC)) != 0 ||
+                    std::memcmp(_data_ + _size_ - sizeof(FEATURE_CACHE_END_MAGIC),
+                                FEATURE_CACHE_END_MAGIC, sizeof(FEATURE_CACHE_END_MAGIC)) != 0,
+                    std::runtime_error, "File '" << path_ << "' is not a complete feature cache !");
+
+        // Header
+        mapped_cursor header(_data_, _size_, sizeof(FEATURE_CACHE_MAGIC));
+        const uint32_t version = header.read<uint32_t>();
+        DT_THROW_IF(version != FEATURE_CACHE_VERSION, std::runtime_error,
+                    "Unsupported feature cache version " << version << " !");
+        const uint32_t nreals = header.read<uint32_t>();
+        const uint32_t nintegers = header.read<uint32_t>();
+        header.read<uint32_t>();
+        for (uint32_t c = 0; c < nreals; ++c) _real_names_.push_back(header.read_string());
+        for (uint32_t c = 0; c < nintegers; ++c) _integer_names_.push_back(header.read_string());
+
+        // Footer
+        uint64_t footer_offset;
+        std::memcpy(&footer_offset, _data_ + _size_ - sizeof(FEATURE_CACHE_END_MAGIC) - sizeof(uint64_t),
+                    sizeof(footer_offset));
+        mapped_cursor footer(_data_, _size_ - sizeof(FEATURE_CACHE_END_MAGIC) - sizeof(uint64_t),
+                             footer_offset);
+        const uint64_t ngroups = footer.read<uint64_t>();
+        for (uint64_t g = 0; g < ngroups; ++g)
+          {
+            const uint64_t offset = footer.read<uint64_t>();
+            const uint64_t rows = footer.read<uint64_t>();
+            const uint64_t group_size = rows * sizeof(double) * nreals + integer_column_size(rows) * nintegers;
+            DT_THROW_IF(offset % 8 != 0 || offset + group_size > footer_offset, std::runtime_error,
+                        "Corrupted row group " << g << " in feature cache '" << path_ << "' !");
+            _group_offsets_.push_back(offset);
+            _group_rows_.push_back(rows);
+          }
+        const uint64_t nstrings = footer.read<uint64_t>();
+        for (uint64_t s = 0; s < nstrings; ++s) _strings_.push_back(footer.read_string());
+      }
+    catch (std::exception &)
+      {
+        close();
+        throw;
+      }
+    return;
+  }
+
+  bool feature_cache_reader::is_open() const
+  {
+    return _data_ != 0;
+  }
+
+  void feature_cache_reader::close()
+  {
+    if (_data_) ::munmap(const_cast<char *>(_data_), _size_);
+    _data_ = 0;
+    _size_ = 0;
+    _real_names_.clear();
+    _integer_names_.clear();
+    _group_offsets_.clear();
+    _group_rows_.clear();
+    _strings_.clear();
+    return;
+  }
+
+  size_t feature_cache_reader::get_number_of_rows() const
+  {
+    size_t rows = 0;
+    for (size_t g = 0; g < _group_rows_.size(); ++g) rows += _group_rows_[g];
+    return rows;
+  }
+
+  size_t feature_cache_reader::get_number_of_row_groups() const
+  {
+    return _group_offsets_.size();
+  }
+
+  size_t feature_cache_reader::get_row_group_size(size_t group_) const
+  {
+    return _group_rows_.at(group_);
+  }
+
+  const std::vector<std::string> & feature_cache_reader::get_real_column_names() const
+  {
+    return _real_names_;
+  }
+
+  const std::vector<std::string> & feature_cache_reader::get_integer_column_names() const
+  {
+    return _integer_names_;
+  }
+
+  int feature_cache_reader::find_real_column(const std::string & name_) const
+  {
+    for (size_t c = 0; c < _real_names_.size(); ++c)
+      {
+        if (_real_names_[c] == name_) return c;
+      }
+    return -1;
+  }
+
+  int feature_cache_reader::find_integer_column(const std::string & name_) const
+  {
+    for (size_t c = 0; c < _integer_names_.size(); ++c)
+      {
+        if (_integer_names_[c] == name_) return c;
+      }
+    return -1;
+  }
+
+  const double * feature_cache_reader::get_real_column(size_t group_, size_t column_) const
+  {
+    DT_THROW_IF(column_ >= _real_names_.size(), std::range_error, "Invalid real column " << column_ << " !");
+    const size_t rows = _group_rows_.at(group_);
+    return reinterpret_cast<const double *>(_data_ + _group_offsets_[group_] + column_ * rows * sizeof(double));
+  }
+
+  const int32_t * feature_cache_reader::get_integer_column(size_t group_, size_t column_) const
+  {
+    DT_THROW_IF(column_ >= _integer_names_.size(), std::range_error, "Invalid integer column " << column_ << " !");
+    const size_t rows = _group_rows_.at(group_);
+    return reinterpret_cast<const int32_t *>(_data_ + _group_offsets_[group_]
+                                             + _real_names_.size() * rows * sizeof(double)
+                                             + column_ * integer_column_size(rows));
+  }
+
+  const std::vector<std::string> & feature_cache_reader::get_strings() const
+  {
+    return _strings_;
+  }
+
+  const std::string & feature_cache_reader::get_string(int32_t id_) const
+  {
+    static const std::string empty;
+    if (id_ < 0 || static_cast<size_t>(id_) >= _strings_.size()) return empty;
+    return _strings_[id_];
+  }
+
+} // namespace analysis
+
+// end of feature_cache.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,196 @@
+/* feature_cache.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Column-oriented cache of the event features used by the plot modules.
+ * The writer stores the rows by groups of fixed size, each column of a group
+ * being a contiguous array, and ends the file with the row group index and
+ * the table of the interned strings. The reader maps the file in memory and
+ * gives direct access to the column arrays of each row group.
+ *
+ * File layout (native byte order, 8-byte aligned sections):
+ *   header    : magic, version, numbers of real and integer columns, names
+ *   row group : one array of doubles per real column then one array of
+ *               32-bit integers per integer column
+ *   footer    : row group offsets and sizes, string table, footer offset,
+ *               end magic
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_FEATURE_CACHE_H_
+#define ANALYSIS_FEATURE_CACHE_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <unordered_map>
+
+namespace analysis {
+
+  /// \brief Writer of a feature cache file
+  class feature_cache_writer
+  {
+  public:
+
+    /// Default number of rows per row group
+    static const size_t DEFAULT_ROW_GROUP_SIZE = 65536;
+
+    /// Constructor
+    feature_cache_writer();
+
+    /// Destructor, close the file if needed and log the errors
+    ~feature_cache_writer();
+
+    /// Add a column of real values, return its index among the real columns
+    size_t add_real_column(const std::string & name_);
+
+    /// Add a column of integer values, return its index among the integer columns
+    size_t add_integer_column(const std::string & name_);
+
+    /// Open the file and write the header
+    void open(const std::string & path_, size_t row_group_size_ = DEFAULT_ROW_GROUP_SIZE);
+
+    /// Check if the file is open
+    bool is_open() const;
+
+    /// Return the identifier of a string in the string table, adding it if needed
+    int32_t intern(const std::string & value_);
+
+    /// Append a row given the values of the real and of the integer columns
+    void append_row(const double * reals_, const int32_t * integers_);
+
+    /// Return the number of rows appended so far
+    size_t get_number_of_rows() const;
+
+    /// Write the last row group and the footer, then close the file
+    void close();
+
+    /// Close the file if needed and remove the columns
+    void reset();
+
+  private:
+
+    /// Write the buffered rows as a row group
+    void _write_row_group();
+
+    /// Write padding bytes up to the next 8-byte boundary
+    void _align();
+
+  private:
+
+    std::ofstream            _out_;            //!< Output stream
+    std::string              _path_;           //!< Path of the file
+    size_t                   _row_group_size_; //!< Number of rows per row group
+    std::vector<std::string> _real_names_;     //!< Names of the real columns
+    std::vector<std::string> _integer_names_;  //!< Names of the integer columns
+    std::vector<std::vector<double> >  _reals_;    //!< Buffered real columns
+    std::vector<std::vector<int32_t> > _integers_; //!< Buffered integer columns
+    size_t                   _buffered_rows_;  //!< Number of buffered rows
+    size_t                   _rows_;           //!< Number of rows appended
+    std::vector<uint64_t>    _group_offsets_;  //!< Offsets of the row groups
+    std::vector<uint64_t>    _group_rows_;     //!< Number of rows of the row groups
+    std::vector<std::string> _strings_;        //!< String table
+    std::unordered_map<std::string, int32_t> _string_ids_; //!< String identifiers
+  };
+
+  /// \brief Memory-mapped reader of a feature cache file
+  class feature_cache_reader
+  {
+  public:
+
+    /// Constructor
+    feature_cache_reader();
+
+    /// Destructor, unmap the file if needed
+    ~feature_cache_reader();
+
+    /// Map a file in memory and read its header and footer
+    void open(const std::string & path_);
+
+    /// Check if a file is mapped
+    bool is_open() const;
+
+    /// Unmap the file
+    void close();
+
+    /// Return the total number of rows
+    size_t get_number_of_rows() const;
+
+    /// Return the number of row groups
+    size_t get_number_of_row_groups() const;
+
+    /// Return the number of rows of a row group
+    size_t get_row_group_size(size_t group_) const;
+
+    /// Return the names of the real columns
+    const std::vector<std::string> & get_real_column_names() const;
+
+    /// Return the names of the integer columns
+    const std::vector<std::string> & get_integer_column_names() const;
+
+    /// Return the index of a real column, -1 if it does not exist
+    int find_real_column(const std::string & name_) const;
+
+    /// Return the index of an integer column, -1 if it does not exist
+    int find_integer_column(const std::string & name_) const;
+
+    /// Return the values of a real column in a row group
+    const double * get_real_column(size_t group_, size_t column_) const;
+
+    /// Return the values of an integer column in a row group
+    const int32_t * get_integer_column(size_t group_, size_t column_) const;
+
+    /// Return the string table
+    const std::vector<std::string> & get_strings() const;
+
+    /// Return a string given its identifier
+    const std::string & get_string(int32_t id_) const;
+
+  private:
+
+    const char *             _data_;           //!< Mapped file
+    size_t                   _size_;           //!< Size of the mapped file
+    std::vector<std::string> _real_names_;     //!< Names of the real columns
+    std::vector<std::string> _integer_names_;  //!< Names of the integer columns
+    std::vector<uint64_t>    _group_offsets_;  //!< Offsets of the row groups
+    std::vector<uint64_t>    _group_rows_;     //!< Number of rows of the row groups
+    std::vector<std::string> _strings_;        //!< String table
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_FEATURE_CACHE_H_
+
+// end of feature_cache.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,343 @@
+// feature_extraction_module.cc
+
+// Ourselves:
+#include <snemo/analysis/feature_extraction_module.h>
+
+// This project:
+#include <snemo/analysis/bank_utils.h>
+
+// Standard library:
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/service_manager.h>
+// - Bayeux/mctools
+#include <mctools/utils.h>
+
+// - Falaise
+#include <falaise/snemo/datamodels/data_model.h>
+#include <falaise/snemo/datamodels/event_header.h>
+#include <falaise/snemo/datamodels/particle_track.h>
+#include <falaise/snemo/datamodels/particle_track_data.h>
+#include <falaise/snemo/datamodels/topology_data.h>
+#include <falaise/snemo/datamodels/topology_1e_pattern.h>
+#include <falaise/snemo/datamodels/topology_1eNg_pattern.h>
+#include <falaise/snemo/datamodels/vertex_measurement.h>
+
+namespace analysis {
+
+  // Registration instantiation macro :
+  DPP_MODULE_REGISTRATION_IMPLEMENT(feature_extraction_module,
+                                    "analysis::feature_extraction_module");
+
+  // Indexes of the real columns.
+  enum real_column_index
+    {
+      RC_ELECTRON_ENERGY = 0,
+      RC_GAMMA_MAX_ENERGY,
+      RC_GAMMA_MID_ENERGY,
+      RC_GAMMA_MIN_ENERGY,
+      RC_TOTAL_ENERGY,
+      RC_VERTEX_Y,
+      RC_VERTEX_Z,
+      RC_CALORIMETER_ENERGY,
+      RC_ASSOCIATED_ENERGY,
+      RC_GENBB_WEIGHT,
+      RC_NUMBER_OF_COLUMNS
+    };
+
+  // Indexes of the integer columns, followed by the key field columns.
+  enum integer_column_index
+    {
+      IC_TOPOLOGY = 0,
+      IC_NUMBER_OF_GAMMAS,
+      IC_NUMBER_OF_ELECTRONS,
+      IC_NUMBER_OF_POSITRONS,
+      IC_NUMBER_OF_UNDEFINED,
+      IC_ISOLATED_CALORIMETERS,
+      IC_GENBB_LABEL,
+      IC_VERTEX_ORIGIN,
+      IC_NUMBER_OF_COLUMNS
+    };
+
+  void feature_extraction_module::_set_defaults()
+  {
+    _EH_label_ = snemo::datamodel::data_info::default_event_header_label();
+    _PTD_label_ = snemo::datamodel::data_info::default_particle_track_data_label();
+    _TD_label_ = "TD";
+    _key_fields_.clear();
+    _key_plan_.reset();
+    _output_file_.clear();
+    _first_key_column_ = IC_NUMBER_OF_COLUMNS;
+    _contexts_.reset();
+    return;
+  }
+
+  void feature_extraction_module::_setup_context(worker_context_type & context_)
+  {
+    const size_t nintegers = _first_key_column_ + _key_fields_.size();
+    context_.reals.assign(RC_NUMBER_OF_COLUMNS, 0.0);
+    context_.integers.assign(nintegers, -1);
+    context_.strings.assign(nintegers, std::string());
+    context_.has_string.assign(nintegers, false);
+    return;
+  }
+
+  // Initialization :
+  void feature_extraction_module::initialize(const datatools::properties  & config_,
+                                             datatools::service_manager   & /*service_manager_*/,
+                                             dpp::module_handle_dict_type & /*module_dict_*/)
+  {
+    DT_THROW_IF(is_initialized(),
+                std::logic_error,
+                "Module '" << get_name() << "' is already initialized ! ");
+
+    dpp::base_module::_common_initialize(config_);
+
+    // Labels of the input banks :
+    if (config_.has_key("EH_label"))
+      {
+        _EH_label_ = config_.fetch_string("EH_label");
+      }
+    if (config_.has_key("PTD_label"))
+      {
+        _PTD_label_ = config_.fetch_string("PTD_label");
+      }
+    if (config_.has_key("TD_label"))
+      {
+        _TD_label_ = config_.fetch_string("TD_label");
+      }
+
+    // Get the keys from 'Event Header' bank
+    if (config_.has_key("key_fields"))
+      {
+        config_.fetch("key_fields", _key_fields_);
+      }
+    _key_plan_.initialize(_key_fields_, get_logging_priority());
+
+    // Output file
+    DT_THROW_IF(! config_.has_key("output_file"), std::logic_error,
+                "Module '" << get_name() << "' has no 'output_file' property !");
+    _output_file_ = config_.fetch_string("output_file");
+    size_t row_group_size = feature_cache_writer::DEFAULT_ROW_GROUP_SIZE;
+    if (config_.has_key("row_group_size"))
+      {
+        const int a_size = config_.fetch_integer("row_group_size");
+        DT_THROW_IF(a_size <= 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'row_group_size' property !");
+        row_group_size = a_size;
+      }
+
+    // Columns, in the order of the column indexes
+    _writer_.add_real_column(feature_columns::ELECTRON_ENERGY);
+    _writer_.add_real_column(feature_columns::GAMMA_MAX_ENERGY);
+    _writer_.add_real_column(feature_columns::GAMMA_MID_ENERGY);
+    _writer_.add_real_column(feature_columns::GAMMA_MIN_ENERGY);
+    _writer_.add_real_column(feature_columns::TOTAL_ENERGY);
+    _writer_.add_real_column(feature_columns::VERTEX_Y);
+    _writer_.add_real_column(feature_columns::VERTEX_Z);
+    _writer_.add_real_column(feature_columns::CALORIMETER_ENERGY);
+    _writer_.add_real_column(feature_columns::ASSOCIATED_ENERGY);
+    _writer_.add_real_column(feature_columns::GENBB_WEIGHT);
+    _writer_.add_integer_column(feature_columns::TOPOLOGY);
+    _writer_.add_integer_column(feature_columns::NUMBER_OF_GAMMAS);
+    _writer_.add_integer_column(feature_columns::NUMBER_OF_ELECTRONS);
+    _writer_.add_integer_column(feature_columns::NUMBER_OF_POSITRONS);
+    _writer_.add_integer_column(feature_columns::NUMBER_OF_UNDEFINED);
+    _writer_.add_integer_column(feature_columns::ISOLATED_CALORIMETERS);
+    _writer_.add_integer_column(feature_columns::GENBB_LABEL);
+    _writer_.add_integer_column(feature_columns::VERTEX_ORIGIN);
+    _first_key_column_ = IC_NUMBER_OF_COLUMNS;
+    for (size_t i = 0; i < _key_fields_.size(); ++i)
+      {
+        _writer_.add_integer_column(feature_columns::KEY_FIELD_PREFIX + _key_fields_[i]);
+      }
+    _writer_.open(_output_file_, row_group_size);
+
+    // Working buffers of each processing thread :
+    _contexts_.initialize(true, std::bind(&feature_extraction_module::_setup_context, this, std::placeholders::_1));
+
+    // Tag the module as initialized :
+    _set_initialized(true);
+    return;
+  }
+
+  // Reset :
+  void feature_extraction_module::reset()
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error,
+                "Module '" << get_name() << "' is not initialized !");
+
+    DT_LOG_NOTICE(get_logging_priority(), "Module '" << get_name() << "' has stored "
+                  << _writer_.get_number_of_rows() << " events in '" << _output_file_ << "'");
+    _writer_.reset();
+
+    // Tag the module as un-initialized :
+    _set_initialized(false);
+    _set_defaults();
+    return;
+  }
+
+  // Constructor :
+  feature_extraction_module::feature_extraction_module(datatools::logger::priority logging_priority_)
+    : dpp::base_module(logging_priority_)
+  {
+    _set_defaults();
+    return;
+  }
+
+  // Destructor :
+  feature_extraction_module::~feature_extraction_module()
+  {
+    if (is_initialized()) feature_extraction_module::reset();
+    return;
+  }
+
+  // Processing :
+  dpp::base_module::process_status feature_extraction_module::process(datatools::things & data_record_)
+  {
+    DT_LOG_TRACE(get_logging_priority(), "Entering...");
+    DT_THROW_IF(! is_initialized(), std::logic_error,
+                "Module '" << get_name() << "' is not initialized !");
+
+    // Buffers of the calling thread, reset without reallocation :
+    worker_context_type & a_context = _contexts_.grab_local();
+    std::vector<double> & reals = a_context.reals;
+    std::vector<int32_t> & integers = a_context.integers;
+    std::vector<std::string> & strings = a_context.strings;
+    std::vector<bool> & has_string = a_context.has_string;
+    std::fill(reals.begin(), reals.end(), std::numeric_limits<double>::quiet_NaN());
+    std::fill(integers.begin(), integers.end(), -1);
+    std::fill(has_string.begin(), has_string.end(), false);
+    reals[RC_GENBB_WEIGHT] = 1.0;
+
+    // Event header
+    const snemo::datamodel::event_header * eh_bank
+      = try_get_bank<snemo::datamodel::event_header>(data_record_, _EH_label_);
+    if (eh_bank)
+      {
+        const datatools::properties & eh_properties = eh_bank->get_properties();
+        if (eh_properties.has_key("event.genbb_label"))
+          {
+            strings[IC_GENBB_LABEL] = eh_properties.fetch_string("event.genbb_label");
+            has_string[IC_GENBB_LABEL] = true;
+          }
+        if (eh_properties.has_key("analysis.vertex_origin"))
+          {
+            strings[IC_VERTEX_ORIGIN] = eh_properties.fetch_string("analysis.vertex_origin");
+            has_string[IC_VERTEX_ORIGIN] = true;
+          }
+        if (eh_properties.has_key(mctools::event_utils::EVENT_GENBB_WEIGHT))
+          {
+            reals[RC_GENBB_WEIGHT] = eh_properties.fetch_real(mctools::event_utils::EVENT_GENBB_WEIGHT);
+          }
+        for (size_t i = 0; i < _key_fields_.size(); ++i)
+          {
+            has_string[_first_key_column_ + i]
+              = _key_plan_.format_field(eh_properties, i, strings[_first_key_column_ + i]);
+          }
+      }
+    else
+      {
+        DT_LOG_DEBUG(get_logging_priority(), "Could not find any bank with label '" << _EH_label_ << "' !");
+      }
+
+    // Topology data
+    const snemo::datamodel::topology_data * td_bank
+      = try_get_bank<snemo::datamodel::topology_data>(data_record_, _TD_label_);
+    if (td_bank && td_bank->has_pattern())
+      {
+        const snemo::datamodel::base_topology_pattern & a_pattern = td_bank->get_pattern();
+        const std::string & a_pattern_id = a_pattern.get_pattern_id();
+        strings[IC_TOPOLOGY] = a_pattern_id;
+        has_string[IC_TOPOLOGY] = true;
+        if (a_pattern_id == "1e")
+          {
+            const snemo::datamodel::topology_1e_pattern & a_1e_pattern
+              = dynamic_cast<const snemo::datamodel::topology_1e_pattern &>(a_pattern);
+            reals[RC_ELECTRON_ENERGY] = a_1e_pattern.get_electron_energy();
+          }
+        else if (a_pattern_id == "1eNg")
+          {
+            const snemo::datamodel::topology_1eNg_pattern & a_1eNg_pattern
+              = dynamic_cast<const snemo::datamodel::topology_1eNg_pattern &>(a_pattern);
+            integers[IC_NUMBER_OF_GAMMAS] = a_1eNg_pattern.get_number_of_gammas();
+            if (a_1eNg_pattern.has_electron_energy())  reals[RC_ELECTRON_ENERGY]  = a_1eNg_pattern.get_electron_energy();
+            if (a_1eNg_pattern.has_gamma_max_energy()) reals[RC_GAMMA_MAX_ENERGY] = a_1eNg_pattern.get_gamma_max_energy();
+            if (a_1eNg_pattern.has_gamma_mid_energy()) reals[RC_GAMMA_MID_ENERGY] = a_1eNg_pattern.get_gamma_mid_energy();
+            if (a_1eNg_pattern.has_gamma_min_energy()) reals[RC_GAMMA_MIN_ENERGY] = a_1eNg_pattern.get_gamma_min_energy();
+            if (a_1eNg_pattern.has_total_energy())     reals[RC_TOTAL_ENERGY]     = a_1eNg_pattern.get_total_energy();
+          }
+        else if (a_pattern_id == "2e" && a_pattern.has_measurement("vertex_e1_e2"))
+          {
+            const geomtools::vector_3d & a_vertex
+              = dynamic_cast<const snemo::datamodel::vertex_measurement&>(a_pattern.get_measurement("vertex_e1_e2")).get_vertex().get_position();
+            reals[RC_VERTEX_Y] = a_vertex.y();
+            reals[RC_VERTEX_Z] = a_vertex.z();
+          }
+      }
+
+    // Particle track data, with the selection of the halflife limit module
+    const snemo::datamodel::particle_track_data * ptd_bank
+      = try_get_bank<snemo::datamodel::particle_track_data>(data_record_, _PTD_label_);
+    if (ptd_bank)
+      {
+        int32_t nelectron = 0;
+        int32_t npositron = 0;
+        int32_t nundefined = 0;
+        double total_energy = 0.0;
+        calorimeter_block_set & calorimeter_blocks = a_context.calorimeter_blocks;
+        calorimeter_blocks.clear();
+        for (snemo::datamodel::particle_track_data::particle_collection_type::const_iterator
+               iparticle = ptd_bank->get_particles().begin();
+             iparticle != ptd_bank->get_particles().end();
+             ++iparticle)
+          {
+            const snemo::datamodel::particle_track & a_particle = iparticle->get();
+            if (! a_particle.has_associated_calorimeter_hits()) continue;
+            const snemo::datamodel::calibrated_calorimeter_hit::collection_type &
+              the_calorimeters = a_particle.get_associated_calorimeter_hits();
+            if (the_calorimeters.size() > 2) continue;
+            for (size_t i = 0; i < the_calorimeters.size(); ++i)
+              {
+                if (! calorimeter_blocks.insert(the_calorimeters.at(i).get().get_geom_id())) continue;
+                total_energy += the_calorimeters.at(i).get().get_energy();
+              }
+            if      (a_particle.get_charge() == snemo::datamodel::particle_track::negative) nelectron++;
+            else if (a_particle.get_charge() == snemo::datamodel::particle_track::positive) npositron++;
+            else nundefined++;
+          }
+        reals[RC_CALORIMETER_ENERGY] = total_energy;
+        reals[RC_ASSOCIATED_ENERGY] = associated_calorimeter_energy(*ptd_bank, calorimeter_blocks);
+        integers[IC_NUMBER_OF_ELECTRONS] = nelectron;
+        integers[IC_NUMBER_OF_POSITRONS] = npositron;
+        integers[IC_NUMBER_OF_UNDEFINED] = nundefined;
+        integers[IC_ISOLATED_CALORIMETERS] = ptd_bank->get_non_associated_calorimeters().size();
+      }
+
+    // Intern the strings and store the row
+    std::lock_guard<std::mutex> lock(_writer_mutex_);
+    for (size_t i = 0; i < integers.size(); ++i)
+      {
+        if (has_string[i]) integers[i] = _writer_.intern(strings[i]);
+      }
+    _writer_.append_row(&reals[0], &integers[0]);
+
+    DT_LOG_TRACE(get_logging_priority(), "Exiting.");
+    return dpp::base_module::PROCESS_SUCCESS;
+  }
+
+} // namespace analysis
+
+// end of feature_extraction_module.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
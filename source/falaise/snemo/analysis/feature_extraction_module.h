@@ -0,0 +1,170 @@
+/* feature_extraction_module.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Module writing the event features used by the plot modules into a
+ * feature cache file, so that the histograms can be filled again without
+ * running the processing chain nor deserializing the data records.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_FEATURE_EXTRACTION_MODULE_H_
+#define ANALYSIS_FEATURE_EXTRACTION_MODULE_H_ 1
+
+// Standard libraires:
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Data processing module abstract base class
+#include <dpp/base_module.h>
+
+// This project:
+#include <snemo/analysis/key_field_plan.h>
+#include <snemo/analysis/feature_cache.h>
+#include <snemo/analysis/thread_context.h>
+#include <snemo/analysis/calorimeter_block_set.h>
+
+namespace analysis {
+
+  /// Names of the feature cache columns
+  namespace feature_columns {
+
+    // Real columns, NaN when not available
+    const char ELECTRON_ENERGY[]    = "electron_energy";    //!< Electron energy of the 1e and 1eNg topologies
+    const char GAMMA_MAX_ENERGY[]   = "gamma_max_energy";   //!< Highest gamma energy of the 1eNg topology
+    const char GAMMA_MID_ENERGY[]   = "gamma_mid_energy";   //!< Middle gamma energy of the 1eNg topology
+    const char GAMMA_MIN_ENERGY[]   = "gamma_min_energy";   //!< Lowest gamma energy of the 1eNg topology
+    const char TOTAL_ENERGY[]       = "total_energy";       //!< Total energy of the 1eNg topology
+    const char VERTEX_Y[]           = "vertex_y";           //!< Vertex Y of the 2e topology
+    const char VERTEX_Z[]           = "vertex_z";           //!< Vertex Z of the 2e topology
+    const char CALORIMETER_ENERGY[] = "calorimeter_energy"; //!< Energy sum of the calorimeters of the particles with at most 2 of them
+    const char ASSOCIATED_ENERGY[]  = "associated_energy";  //!< Energy sum of all the associated calorimeters (universal 2e energy)
+    const char GENBB_WEIGHT[]       = "genbb_weight";       //!< Generator weight, 1 when not available
+
+    // Integer columns, -1 when not available
+    const char TOPOLOGY[]              = "topology";              //!< Topology pattern identifier (string)
+    const char NUMBER_OF_GAMMAS[]      = "number_of_gammas";      //!< Number of gammas of the 1eNg topology
+    const char NUMBER_OF_ELECTRONS[]   = "number_of_electrons";   //!< Number of negative particles
+    const char NUMBER_OF_POSITRONS[]   = "number_of_positrons";   //!< Number of positive particles
+    const char NUMBER_OF_UNDEFINED[]   = "number_of_undefined";   //!< Number of particles without charge
+    const char ISOLATED_CALORIMETERS[] = "isolated_calorimeters"; //!< Number of non associated calorimeters
+    const char GENBB_LABEL[]           = "genbb_label";           //!< Generator label (string)
+    const char VERTEX_ORIGIN[]         = "vertex_origin";         //!< Vertex origin (string)
+    const char KEY_FIELD_PREFIX[]      = "key.";                  //!< Prefix of the key field columns (string)
+
+  } // namespace feature_columns
+
+  class feature_extraction_module : public dpp::base_module
+  {
+  public:
+
+    /// Constructor
+    feature_extraction_module(datatools::logger::priority = datatools::logger::PRIO_FATAL);
+
+    /// Destructor
+    virtual ~feature_extraction_module();
+
+    /// Initialization
+    virtual void initialize(const datatools::properties  & setup_,
+                            datatools::service_manager   & service_manager_,
+                            dpp::module_handle_dict_type & module_dict_);
+
+    /// Reset
+    virtual void reset();
+
+    /// Data record processing
+    virtual process_status process(datatools::things & data_);
+
+  protected:
+
+    /// Give default values to specific class members.
+    void _set_defaults();
+
+  private:
+
+    /// Working buffers of a processing thread, reused from one event to the next
+    struct worker_context_type
+    {
+      std::vector<double>      reals;              //!< Real values of the row
+      std::vector<int32_t>     integers;           //!< Integer values of the row
+      std::vector<std::string> strings;            //!< Strings to intern into the integer columns
+      std::vector<bool>        has_string;         //!< Flags of the integer columns holding a string
+      calorimeter_block_set    calorimeter_blocks; //!< Calorimeter blocks already counted
+    };
+
+    /// Setup a new working context
+    void _setup_context(worker_context_type & context_);
+
+  private:
+
+    // The label of the event header bank :
+    std::string _EH_label_;
+
+    // The label of the particle track data bank :
+    std::string _PTD_label_;
+
+    // The label of the topology data bank :
+    std::string _TD_label_;
+
+    // The key fields from 'event header' bank to store:
+    std::vector<std::string> _key_fields_;
+
+    // The plan formatting the key fields:
+    key_field_plan _key_plan_;
+
+    // The feature cache file :
+    std::string _output_file_;
+
+    // The feature cache writer :
+    feature_cache_writer _writer_;
+
+    // Index of the first key field integer column :
+    size_t _first_key_column_;
+
+    // Protection of the writer :
+    std::mutex _writer_mutex_;
+
+    // The working contexts, one per processing thread :
+    thread_context_set<worker_context_type> _contexts_;
+
+    // Macro to automate the registration of the module :
+    DPP_MODULE_REGISTRATION_INTERFACE(feature_extraction_module);
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_FEATURE_EXTRACTION_MODULE_H_
+
+// end of feature_extraction_module.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,374 @@
+// feldman_cousins.cc
+
+// Ourselves:
+#include <snemo/analysis/feldman_cousins.h>
+
+// This project:
+#include <snemo/analysis/parallel_for.h>
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  // Magic number of the belt table files.
+  const char FELDMAN_COUSINS_MAGIC[8] = { 'S', 'N', 'F', 'C', 'B', 'E', 'L', 'T' };
+
+  // Format version of the belt table files.
+  const uint32_t FELDMAN_COUSINS_VERSION = 1;
+
+  // Number of points of a background grid from 0 to max_background_.
+  inline size_t background_grid_size(double max_background_, double background_step_)
+  {
+    return static_cast<size_t>(std::ceil(max_background_ / background_step_)) + 1;
+  }
+
+  // Return k * log(x), with 0 * log(0) = 0.
+  inline double k_log(size_t k_, double x_)
+  {
+    return k_ == 0 ? 0.0 : k_ * std::log(x_);
+  }
+
+  // Logarithm of the Poisson probability of k_ at mean lambda_.
+  inline double log_poisson(size_t k_, double lambda_)
+  {
+    return k_log(k_, lambda_) - lambda_ - std::lgamma(k_ + 1.0);
+  }
+
+  // Logarithm of the likelihood ratio ordering the counts in the belt.
+  inline double log_rank(size_t k_, double lambda_, double background_)
+  {
+    const double best = std::max(static_cast<double>(k_), background_);
+    return k_log(k_, lambda_) - lambda_ - k_log(k_, best) + best;
+  }
+
+  // Check if an observed count is in the acceptance interval of a signal
+  // mean. The counts are added by decreasing rank from the peak of the
+  // ratio, which is unimodal, until the confidence level is reached.
+  bool is_accepted(size_t observed_, double signal_, double background_, double confidence_level_)
+  {
+    const double lambda = signal_ + background_;
+    if (lambda <= 0.0) return observed_ == 0;
+    size_t peak = static_cast<size_t>(lambda);
+    if (log_rank(peak + 1, lambda, background_) > log_rank(peak, lambda, background_)) peak++;
+    if (observed_ == peak) return true;
+    size_t left = peak;
+    size_t right = peak;
+    double sum = std::exp(log_poisson(peak, lambda));
+    while (sum < confidence_level_)
+      {
+        const double left_rank = left > 0 ? log_rank(left - 1, lambda, background_)
+          : -std::numeric_limits<double>::infinity();
+        const double right_rank = log_rank(right + 1, lambda, background_);
+        if (left > 0 && left_rank >= right_rank)
+          {
+            --left;
+            if (left == observed_) return true;
+            sum += std::exp(log_poisson(left, lambda));
+          }
+        else
+          {
+            ++right;
+            if (right == observed_) return true;
+            sum += std::exp(log_poisson(right, lambda));
+          }
+      }
+    return false;
+  }
+
+  // Largest signal mean whose acceptance interval contains an observed count.
+  // The acceptance is not monotonic in the signal mean near the physical
+  // boundary, so the scan goes on over a margin after the last acceptance.
+  double compute_upper_limit(size_t observed_, double background_, double confidence_level_)
+  {
+    const double scale = std::max(1.0, std::sqrt(observed_ + background_));
+    const double step = 0.1 * scale;
+    const double margin = 1.0 + scale;
+    double low = std::max(0.0, observed_ - background_);
+    for (double signal = low + step; signal - low < margin; signal += step)
+      {
+        if (is_accepted(observed_, signal, background_, confidence_level_)) low = signal;
+      }
+    double high = low + step;
+    for (size_t i = 0; i < 30; ++i)
+      {
+        const double middle = 0.5 * (low + high);
+        if (is_accepted(observed_, middle, background_, confidence_level_)) low = middle;
+        else high = middle;
+      }
+    return low;
+  }
+
+  double feldman_cousins::polynomial_excluded_events(double background_)
+  {
+    // Continuous FeldmanCousin functions computed by M. Bongrand
+    // <bongrand@lal.in2p3.fr>
+    const double x = background_;
+    if (x < 29.0)
+      {
+        return 2.5617 + x * (0.747661 + x * (-0.0666176 + x * (0.00432457
+                                                               + x * (-0.000139343 + x * 1.71509e-06))));
+      }
+    return 1.64 * std::sqrt(x);
+  }
+
+  feldman_cousins::feldman_cousins()
+  {
+    reset();
+    return;
+  }
+
+  void feldman_cousins::reset()
+  {
+    _mode_ = MODE_POLYNOMIAL;
+    _confidence_level_ = 0.0;
+    _background_step_ = 0.0;
+    _backgrounds_ = 0;
+    _observed_ = 0;
+    _mean_limits_.clear();
+    _upper_limits_.clear();
+    return;
+  }
+
+  void feldman_cousins::initialize(const datatools::properties & config_)
+  {
+    std::string mode = "polynomial";
+    if (config_.has_key("mode"))
+      {
+        mode = config_.fetch_string("mode");
+      }
+    if (mode == "polynomial")
+      {
+        _mode_ = MODE_POLYNOMIAL;
+        return;
+      }
+    DT_THROW_IF(mode != "table", std::logic_error, "Unknown Feldman-Cousins mode '" << mode << "' !");
+
+    double confidence_level = 0.9;
+    if (config_.has_key("confidence_level"))
+      {
+        confidence_level = config_.fetch_real("confidence_level");
+        DT_THROW_IF(confidence_level <= 0.0 || confidence_level >= 1.0, std::domain_error,
+                    "Invalid 'confidence_level' property !");
+      }
+    double max_background = 30.0;
+    if (config_.has_key("max_background"))
+      {
+        max_background = config_.fetch_real("max_background");
+      }
+    double background_step = 0.1;
+    if (config_.has_key("background_step"))
+      {
+        background_step = config_.fetch_real("background_step");
+      }
+    size_t number_of_threads = default_number_of_threads();
+    if (config_.has_key("number_of_threads"))
+      {
+        const int nthreads = config_.fetch_integer("number_of_threads");
+        DT_THROW_IF(nthreads <= 0, std::domain_error, "Invalid 'number_of_threads' property !");
+        number_of_threads = nthreads;
+      }
+    std::string table_file;
+    if (config_.has_key("table_file"))
+      {
+        table_file = config_.fetch_string("table_file");
+      }
+
+    if (! table_file.empty() && std::ifstream(table_file.c_str()).good())
+      {
+        load_table(table_file);
+        DT_THROW_IF(_confidence_level_ != confidence_level, std::logic_error,
+                    "Feldman-Cousins table '" << table_file << "' has a confidence level of "
+                    << _confidence_level_ << " instead of " << confidence_level << " !");
+        // The limits beyond the grid are extrapolated, the table must cover the configured one
+        DT_THROW_IF(_background_step_ != background_step ||
+                    _backgrounds_ != background_grid_size(max_background, background_step),
+                    std::logic_error,
+                    "Feldman-Cousins table '" << table_file << "' has a background grid up to "
+                    << get_max_background() << " by " << _background_step_ << " instead of "
+                    << max_background << " by " << background_step << " !");
+      }
+    else
+      {
+        build_table(confidence_level, max_background, background_step, number_of_threads);
+        if (! table_file.empty()) store_table(table_file);
+      }
+    return;
+  }
+
+  feldman_cousins::mode_type feldman_cousins::get_mode() const
+  {
+    return _mode_;
+  }
+
+  bool feldman_cousins::has_table() const
+  {
+    return ! _mean_limits_.empty();
+  }
+
+  double feldman_cousins::get_max_background() const
+  {
+    return has_table() ? (_backgrounds_ - 1) * _background_step_ : 0.0;
+  }
+
+  size_t feldman_cousins::get_number_of_observed() const
+  {
+    return _observed_;
+  }
+
+  void feldman_cousins::build_table(double confidence_level_,
+                                    double max_background_,
+                                    double background_step_,
+                                    size_t number_of_threads_)
+  {
+    DT_THROW_IF(max_background_ <= 0.0 || background_step_ <= 0.0 || background_step_ > max_background_,
+                std::domain_error, "Invalid Feldman-Cousins background grid !");
+    _mode_ = MODE_TABLE;
+    _confidence_level_ = confidence_level_;
+    _background_step_ = background_step_;
+    _backgrounds_ = background_grid_size(max_background_, background_step_);
+    // Observed counts up to well beyond the Poisson tail of the largest background
+    _observed_ = static_cast<size_t>(std::ceil(max_background_ + 8.0 * std::sqrt(max_background_) + 10.0)) + 1;
+    _mean_limits_.assign(_backgrounds_, 0.0);
+    _upper_limits_.assign(_backgrounds_ * _observed_, 0.0);
+
+    parallel_for(_backgrounds_, number_of_threads_,
+                 [this](size_t first_, size_t last_)
+                 {
+                   for (size_t ib = first_; ib < last_; ++ib)
+                     {
+                       const double background = ib * _background_step_;
+                       double * limits = &_upper_limits_[ib * _observed_];
+                       double mean_limit = 0.0;
+                       for (size_t n = 0; n < _observed_; ++n)
+                         {
+                           limits[n] = compute_upper_limit(n, background, _confidence_level_);
+                           mean_limit += std::exp(log_poisson(n, background)) * limits[n];
+                         }
+                       _mean_limits_[ib] = mean_limit;
+                     }
+                 });
+    return;
+  }
+
+  void feldman_cousins::load_table(const std::string & path_)
+  {
+    std::ifstream in(path_.c_str(), std::ios::binary);
+    DT_THROW_IF(! in, std::runtime_error, "Cannot open Feldman-Cousins table '" << path_ << "' !");
+    char magic[8];
+    uint32_t version = 0;
+    uint32_t padding = 0;
+    uint64_t backgrounds = 0;
+    uint64_t observed = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char *>(&version), sizeof(version));
+    in.read(reinterpret_cast<char *>(&padding), sizeof(padding));
+    DT_THROW_IF(! in || std::memcmp(magic, FELDMAN_COUSINS_MAGIC, sizeof(magic)) != 0
+                || version != FELDMAN_COUSINS_VERSION,
+                std::runtime_error, "File '" << path_ << "' is not a Feldman-Cousins table !");
+    in.read(reinterpret_cast<char *>(&_confidence_level_), sizeof(double));
+    in.read(reinterpret_cast<char *>(&_background_step_), sizeof(double));
+    in.read(reinterpret_cast<char *>(&backgrounds), sizeof(backgrounds));
+    in.read(reinterpret_cast<char *>(&observed), sizeof(observed));
+    DT_THROW_IF(! in || backgrounds < 2 || observed == 0, std::runtime_error,
+                "Invalid Feldman-Cousins table '" << path_ << "' !");
+    _mode_ = MODE_TABLE;
+    _backgrounds_ = backgrounds;
+    _observed_ = observed;
+    _mean_limits_.resize(_backgrounds_);
+    _upper_limits_.resize(_backgrounds_ * _observed_);
+    in.read(reinterpret_cast<char *>(&_mean_limits_[0]), _mean_limits_.size() * sizeof(double));
+    in.read(reinterpret_cast<char *>(&_upper_limits_[0]), _upper_limits_.size() * sizeof(double));
+    DT_THROW_IF(! in, std::runtime_error, "Truncated Feldman-Cousins table '" << path_ << "' !");
+    return;
+  }
+
+  void feldman_cousins::store_table(const std::string & path_) const
+  {
+    DT_THROW_IF(! has_table(), std::logic_error, "No Feldman-Cousins table to store !");
+    std::ofstream out(path_.c_str(), std::ios::binary | std::ios::trunc);
+    DT_THROW_IF(! out, std::runtime_error, "Cannot open Feldman-Cousins table '" << path_ << "' !");
+    const uint32_t padding = 0;
+    const uint64_t backgrounds = _backgrounds_;
+    const uint64_t observed = _observed_;
+    out.write(FELDMAN_COUSINS_MAGIC, sizeof(FELDMAN_COUSINS_MAGIC));
+    out.write(reinterpret_cast<const char *>(&FELDMAN_COUSINS_VERSION), sizeof(FELDMAN_COUSINS_VERSION));
+    out.write(reinterpret_cast<const char *>(&padding), sizeof(padding));
+    out.write(reinterpret_cast<const char *>(&_confidence_level_), sizeof(double));
+    out.write(reinterpret_cast<const char *>(&_background_step_), sizeof(double));
+    out.write(reinterpret_cast<const char *>(&backgrounds), sizeof(backgrounds));
+    out.write(reinterpret_cast<const char *>(&observed), sizeof(observed));
+    out.write(reinterpret_cast<const char *>(&_mean_limits_[0]), _mean_limits_.size() * sizeof(double));
+    out.write(reinterpret_cast<const char *>(&_upper_limits_[0]), _upper_limits_.size() * sizeof(double));
+    DT_THROW_IF(! out, std::runtime_error, "Cannot write Feldman-Cousins table '" << path_ << "' !");
+    return;
+  }
+
+  double feldman_cousins::_table_excluded_events(double background_) const
+  {
+    const double x = std::max(0.0, background_) / _background_step_;
+    const size_t last = _backgrounds_ - 1;
+    if (x >= last)
+      {
+        // Asymptotic square root behaviour beyond the grid
+        return _mean_limits_[last] * std::sqrt(x / last);
+      }
+    const size_t i = static_cast<size_t>(x);
+    const double f = x - i;
+    return _mean_limits_[i] + f * (_mean_limits_[i + 1] - _mean_limits_[i]);
+  }
+
+  double feldman_cousins::excluded_events(double background_) const
+  {
+    if (_mode_ == MODE_TABLE) return _table_excluded_events(background_);
+    return polynomial_excluded_events(background_);
+  }
+
+  void feldman_cousins::excluded_events(const double * backgrounds_, size_t size_, double * excluded_) const
+  {
+    if (_mode_ == MODE_TABLE)
+      {
+        for (size_t i = 0; i < size_; ++i) excluded_[i] = _table_excluded_events(backgrounds_[i]);
+      }
+    else
+      {
+        for (size_t i = 0; i < size_; ++i) excluded_[i] = polynomial_excluded_events(backgrounds_[i]);
+      }
+    return;
+  }
+
+  double feldman_cousins::upper_limit(size_t observed_, double background_) const
+  {
+    DT_THROW_IF(! has_table(), std::logic_error, "No Feldman-Cousins table !");
+    DT_THROW_IF(observed_ >= _observed_, std::domain_error,
+                "Observed count " << observed_ << " is beyond the Feldman-Cousins table !");
+    const double x = std::max(0.0, background_) / _background_step_;
+    DT_THROW_IF(x > _backgrounds_ - 1, std::domain_error,
+                "Background " << background_ << " is beyond the Feldman-Cousins table !");
+    const size_t i = std::min(static_cast<size_t>(x), _backgrounds_ - 2);
+    const double f = x - i;
+    const double low = _upper_limits_[i * _observed_ + observed_];
+    const double high = _upper_limits_[(i + 1) * _observed_ + observed_];
+    return low + f * (high - low);
+  }
+
+} // namespace analysis
+
+// end of feldman_cousins.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,139 @@
+/* feldman_cousins.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Number of signal events excluded by a Feldman-Cousins upper limit,
+ * either from the legacy polynomial fit or from a precomputed belt table.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_FELDMAN_COUSINS_H_
+#define ANALYSIS_FELDMAN_COUSINS_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace datatools {
+  class properties;
+}
+
+namespace analysis {
+
+  /// \brief Feldman-Cousins upper limits
+  ///
+  /// In 'polynomial' mode the number of excluded events at a given expected
+  /// background is the continuous fit computed by M. Bongrand. In 'table'
+  /// mode, the Feldman-Cousins confidence belt is computed once on a grid of
+  /// background levels and observed counts (or loaded from a binary file),
+  /// and the number of excluded events is the mean upper limit over the
+  /// Poisson distribution of the observed counts. Both are interpolated
+  /// linearly in the background level.
+  class feldman_cousins
+  {
+  public:
+
+    /// Evaluation mode
+    enum mode_type
+      {
+        MODE_POLYNOMIAL = 0, //!< Legacy polynomial fit
+        MODE_TABLE      = 1  //!< Interpolated belt table
+      };
+
+    /// Legacy number of excluded events
+    static double polynomial_excluded_events(double background_);
+
+    /// Constructor
+    feldman_cousins();
+
+    /// Initialize from a configuration
+    void initialize(const datatools::properties & config_);
+
+    /// Reset
+    void reset();
+
+    /// Return the evaluation mode
+    mode_type get_mode() const;
+
+    /// Check if a belt table is available
+    bool has_table() const;
+
+    /// Return the largest background level of the belt table
+    double get_max_background() const;
+
+    /// Return the number of observed counts of the belt table
+    size_t get_number_of_observed() const;
+
+    /// Compute the belt table and switch to 'table' mode
+    void build_table(double confidence_level_,
+                     double max_background_,
+                     double background_step_,
+                     size_t number_of_threads_);
+
+    /// Load the belt table from a binary file and switch to 'table' mode
+    void load_table(const std::string & path_);
+
+    /// Store the belt table in a binary file
+    void store_table(const std::string & path_) const;
+
+    /// Return the number of excluded events at a given expected background
+    double excluded_events(double background_) const;
+
+    /// Compute the number of excluded events of many background levels
+    void excluded_events(const double * backgrounds_, size_t size_, double * excluded_) const;
+
+    /// Return the upper limit for an observed count at a given background
+    double upper_limit(size_t observed_, double background_) const;
+
+  private:
+
+    /// Number of excluded events from the belt table
+    double _table_excluded_events(double background_) const;
+
+  private:
+
+    mode_type           _mode_;             //!< Evaluation mode
+    double              _confidence_level_; //!< Confidence level of the belt
+    double              _background_step_;  //!< Step of the background grid
+    size_t              _backgrounds_;      //!< Number of background levels
+    size_t              _observed_;         //!< Number of observed counts
+    std::vector<double> _mean_limits_;      //!< Mean upper limit per background level
+    std::vector<double> _upper_limits_;     //!< Upper limits per background level and observed count
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_FELDMAN_COUSINS_H_
+
+// end of feldman_cousins.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
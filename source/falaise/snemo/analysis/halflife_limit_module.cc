@@ -3,10 +3,21 @@
 // Ourselves:
 #include <snemo/analysis/halflife_limit_module.h>
 
+// This project:
+#include <snemo/analysis/bank_utils.h>
+#include <snemo/analysis/histogram_pool_utils.h>
+#include <snemo/analysis/parallel_for.h>
+#include <snemo/analysis/roi_optimiser.h>
+#include <snemo/analysis/feldman_cousins.h>
+#include <snemo/analysis/toy_sensitivity.h>
+#include <snemo/analysis/sensitivity_grid.h>
+#include <snemo/analysis/plot_conventions.h>
+
 // Standard library:
 #include <stdexcept>
 #include <sstream>
-#include <set>
+#include <fstream>
+#include <functional>
 
 // Third party:
 // - Bayeux/datatools:
@@ -23,9 +34,6 @@
 #include <snemo/datamodels/data_model.h>
 #include <snemo/datamodels/event_header.h>
 #include <snemo/datamodels/particle_track_data.h>
-#include <falaise/snemo/datamodels/base_trajectory_pattern.h>
-#include <falaise/snemo/datamodels/line_trajectory_pattern.h>
-#include <falaise/snemo/datamodels/helix_trajectory_pattern.h>
 
 namespace analysis {
 
@@ -36,26 +44,11 @@ namespace analysis {
   // Character separator between key for histogram dict.
   const char KEY_FIELD_SEPARATOR = '_';
 
-  // Continuous FeldmanCousin functions computed by M. Bongrand
-  // <bongrand@lal.in2p3.fr>
-  double get_number_of_excluded_events(const double number_of_events_)
-  {
-    double number_of_excluded_events = 0.0;
-    if (number_of_events_ < 29.0)
-      {
-        double x = number_of_events_;
-        number_of_excluded_events =
-          2.5617 + 0.747661 * x - 0.0666176 * std::pow(x,2)
-          + 0.00432457 * std::pow(x,3) - 0.000139343 * std::pow(x,4)
-          + 1.71509e-06 * std::pow(x,5);
-      }
-    else
-      {
-        number_of_excluded_events = 1.64 * std::sqrt(number_of_events_);
-      }
-    return number_of_excluded_events;
-  }
+  // Number of indexed values for each charge multiplicity.
+  const size_t CHARGE_SLOTS = 8;
 
+  // Number of indexed charge multiplicities, only the booked ones get a dense slot per key.
+  const size_t CHARGE_CATEGORIES = CHARGE_SLOTS * CHARGE_SLOTS * CHARGE_SLOTS;
 
   void halflife_limit_module::experiment_entry_type::initialize(const datatools::properties & config_)
   {
@@ -101,6 +94,39 @@ namespace analysis {
                           << background_activities[bkgname]/CLHEP::becquerel*CLHEP::kg << " Bq/kg");
           }
       }
+    normalisation_overrides.clear();
+    if (config_.has_key("normalisation_overrides"))
+      {
+        std::vector<std::string> overrides;
+        config_.fetch("normalisation_overrides", overrides);
+        for (std::vector<std::string>::const_iterator iover = overrides.begin();
+             iover != overrides.end(); ++iover)
+          {
+            const std::string prefix = "override." + *iover + ".";
+            DT_THROW_IF(! config_.has_key(prefix + "background") ||
+                        ! config_.has_key(prefix + "histogram") ||
+                        ! config_.has_key(prefix + "mass"), std::logic_error,
+                        "Incomplete normalisation override '" << *iover << "' !");
+            normalisation_override_type an_override;
+            an_override.background = config_.fetch_string(prefix + "background");
+            an_override.histogram = config_.fetch_string(prefix + "histogram");
+            an_override.mass = config_.fetch_real(prefix + "mass");
+            if (! config_.has_explicit_unit(prefix + "mass"))
+              {
+                an_override.mass *= CLHEP::kg;
+              }
+            normalisation_overrides.push_back(an_override);
+          }
+      }
+    else
+      {
+        // Legacy mass of the radon wire background
+        normalisation_override_type an_override;
+        an_override.background = "Rn222";
+        an_override.histogram = "Rn222_wire_2e-0e+0u_efficiency";
+        an_override.mass = 15.2 * CLHEP::kg;
+        normalisation_overrides.push_back(an_override);
+      }
     return;
   }
 
@@ -122,6 +148,13 @@ namespace analysis {
     return flag;
   }
 
+  // Groups of the efficiency, halflife and sensitivity histograms
+  const std::vector<std::string> & halflife_limit_module::derived_groups()
+  {
+    static const std::vector<std::string> groups = { "efficiency", "halflife", "sensitivity" };
+    return groups;
+  }
+
   // Set the histogram pool used by the module :
   void halflife_limit_module::set_histogram_pool(mygsl::histogram_pool & pool_)
   {
@@ -141,9 +174,29 @@ namespace analysis {
 
   void halflife_limit_module::_set_defaults()
   {
+    _EH_label_ = snemo::datamodel::data_info::default_event_header_label();
+    _PTD_label_ = snemo::datamodel::data_info::default_particle_track_data_label();
+    _fill_buffer_size_ = 0;
+    _sharded_ = false;
+    _number_of_threads_ = default_number_of_threads();
+    _feldman_cousins_.reset();
+    _toy_sensitivity_ = toy_sensitivity();
+    _background_matcher_.reset();
+    _background_associations_.clear();
+    _grid_exposure_times_.clear();
+    _grid_isotope_masses_.clear();
+    _grid_background_scales_.clear();
+    _grid_output_file_.clear();
+    _online_period_events_ = 0;
+    _online_period_seconds_ = 0.0;
+    _online_output_file_.clear();
     _key_fields_.clear ();
+    _key_plan_.reset();
 
     _histogram_pool_ = 0;
+    _contexts_.reset();
+    _checkpoint_.reset();
+    _cut_flow_.reset();
     return;
   }
 
@@ -158,16 +211,146 @@ namespace analysis {
 
     dpp::base_module::_common_initialize(config_);
 
+    // Labels of the input banks :
+    if (config_.has_key("EH_label"))
+      {
+        _EH_label_ = config_.fetch_string("EH_label");
+      }
+    if (config_.has_key("PTD_label"))
+      {
+        _PTD_label_ = config_.fetch_string("PTD_label");
+      }
+
+    // Number of events staged before filling the histograms :
+    if (config_.has_key("fill_buffer_size"))
+      {
+        const int fill_buffer_size = config_.fetch_integer("fill_buffer_size");
+        DT_THROW_IF(fill_buffer_size < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'fill_buffer_size' property !");
+        _fill_buffer_size_ = fill_buffer_size;
+      }
+
     // Get the experimental conditions
     datatools::properties exp_config;
     config_.export_and_rename_starting_with(exp_config, "experiment.", "");
     _experiment_conditions_.initialize(exp_config);
 
+    // Compile the background component names into a single matcher
+    _background_matcher_.reset();
+    _background_associations_.clear();
+    const experiment_entry_type::background_dict_type & bkgs = _experiment_conditions_.background_activities;
+    for (experiment_entry_type::background_dict_type::const_iterator
+           ibkg = bkgs.begin();
+         ibkg != bkgs.end(); ++ibkg)
+      {
+        _background_matcher_.add_pattern(ibkg->first);
+      }
+    _background_matcher_.compile();
+
+    // Get the Feldman-Cousins upper limits
+    datatools::properties fc_config;
+    config_.export_and_rename_starting_with(fc_config, "feldman_cousins.", "");
+    if (! fc_config.has_key("number_of_threads") && config_.has_key("number_of_threads"))
+      {
+        fc_config.store_integer("number_of_threads", config_.fetch_integer("number_of_threads"));
+      }
+    _feldman_cousins_.initialize(fc_config);
+
+    // Grid of experiment configurations
+    if (config_.has_key("grid.exposure_times"))
+      {
+        config_.fetch("grid.exposure_times", _grid_exposure_times_);
+      }
+    if (config_.has_key("grid.isotope_masses"))
+      {
+        config_.fetch("grid.isotope_masses", _grid_isotope_masses_);
+        if (! config_.has_explicit_unit("grid.isotope_masses"))
+          {
+            for (size_t i = 0; i < _grid_isotope_masses_.size(); ++i) _grid_isotope_masses_[i] *= CLHEP::kg;
+          }
+      }
+    if (config_.has_key("grid.background_scales"))
+      {
+        config_.fetch("grid.background_scales", _grid_background_scales_);
+      }
+    if (config_.has_key("grid.output_file"))
+      {
+        _grid_output_file_ = config_.fetch_string("grid.output_file");
+      }
+
+    // Online estimate of the halflife limit :
+    if (config_.has_key("online.period_events"))
+      {
+        const int period_events = config_.fetch_integer("online.period_events");
+        DT_THROW_IF(period_events < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'online.period_events' property !");
+        _online_period_events_ = period_events;
+      }
+    if (config_.has_key("online.period_seconds"))
+      {
+        _online_period_seconds_ = config_.fetch_real("online.period_seconds");
+        if (config_.has_explicit_unit("online.period_seconds")) _online_period_seconds_ /= CLHEP::second;
+      }
+    if (config_.has_key("online.output_file"))
+      {
+        _online_output_file_ = config_.fetch_string("online.output_file");
+      }
+
+    // Pseudo-experiments of the background counts
+    if (config_.has_key("toys.number"))
+      {
+        const int number_of_toys = config_.fetch_integer("toys.number");
+        DT_THROW_IF(number_of_toys < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'toys.number' property !");
+        _toy_sensitivity_.set_number_of_toys(number_of_toys);
+      }
+    if (config_.has_key("toys.seed"))
+      {
+        _toy_sensitivity_.set_seed(config_.fetch_integer("toys.seed"));
+      }
+    DT_THROW_IF(_toy_sensitivity_.get_number_of_toys() > 0 && ! _feldman_cousins_.has_table(),
+                std::logic_error,
+                "Module '" << get_name() << "' needs 'feldman_cousins.mode' set to 'table' to run pseudo-experiments !");
+
     // Get the keys from 'Event Header' bank
     if (config_.has_key("key_fields"))
       {
         config_.fetch("key_fields", _key_fields_);
       }
+    _key_plan_.initialize(_key_fields_, get_logging_priority());
+
+    // Fill a private pool shard per processing thread :
+    if (config_.has_key("sharded"))
+      {
+        _sharded_ = config_.fetch_boolean("sharded");
+      }
+    _contexts_.initialize(_sharded_,
+                          std::bind(&halflife_limit_module::_setup_context, this, std::placeholders::_1));
+
+    // Store the histograms every 'checkpoint.period_events' events or 'checkpoint.period_seconds' seconds :
+    datatools::properties checkpoint_config;
+    config_.export_and_rename_starting_with(checkpoint_config, "checkpoint.", "");
+    _checkpoint_.initialize(checkpoint_config, get_name());
+    DT_THROW_IF(_checkpoint_.is_enabled() && _sharded_, std::logic_error,
+                "Module '" << get_name() << "' cannot checkpoint sharded histograms !");
+    DT_THROW_IF(_sharded_ && (_online_period_events_ > 0 || _online_period_seconds_ > 0.0), std::logic_error,
+                "Module '" << get_name() << "' cannot estimate the halflife limit online with sharded histograms !");
+
+    // Cuts applied to the events, the legacy selection by default :
+    datatools::properties cut_flow_config;
+    config_.export_and_rename_starting_with(cut_flow_config, "cut_flow.", "");
+    _register_cuts(_cut_flow_);
+    _cut_flow_.initialize(cut_flow_config, plot_conventions::halflife_default_cuts());
+
+    // Number of threads computing the efficiencies :
+    if (config_.has_key("number_of_threads"))
+      {
+        const int number_of_threads = config_.fetch_integer("number_of_threads");
+        DT_THROW_IF(number_of_threads <= 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'number_of_threads' property !");
+        _number_of_threads_ = number_of_threads;
+      }
+    _toy_sensitivity_.set_number_of_threads(_number_of_threads_);
 
     // Service label
     std::string histogram_label;
@@ -208,11 +391,314 @@ namespace analysis {
             }
           }
       }
+
+    // Resume from the last checkpoint :
+    _checkpoint_.restore(*_histogram_pool_);
+
     // Tag the module as initialized :
     _set_initialized(true);
     return;
   }
 
+  void halflife_limit_module::event_selection_type::start(const snemo::datamodel::particle_track_data & ptd_)
+  {
+    ptd = &ptd_;
+    counted = false;
+    return;
+  }
+
+  void halflife_limit_module::event_selection_type::count()
+  {
+    if (counted) return;
+    counted = true;
+    nelectron  = 0;
+    npositron  = 0;
+    nundefined = 0;
+    total_energy = 0.0;
+
+    // Store calorimeter blocks to avoid double inclusion of energy deposited
+    calorimeter_blocks.clear();
+
+    // Loop over all saved particles
+    for (snemo::datamodel::particle_track_data::particle_collection_type::const_iterator
+           iparticle = ptd->get_particles().begin();
+         iparticle != ptd->get_particles().end();
+         ++iparticle)
+      {
+        const snemo::datamodel::particle_track & a_particle = iparticle->get();
+
+        // Particles without calorimeter or associated to more than 2 calorimeters are ignored
+        if (! a_particle.has_associated_calorimeter_hits()) continue;
+        const snemo::datamodel::calibrated_calorimeter_hit::collection_type &
+          the_calorimeters = a_particle.get_associated_calorimeter_hits ();
+        if (the_calorimeters.size() > 2) continue;
+
+        for (size_t i = 0; i < the_calorimeters.size(); ++i)
+          {
+            const snemo::datamodel::calibrated_calorimeter_hit & a_calorimeter = the_calorimeters.at(i).get();
+            if (! calorimeter_blocks.insert(a_calorimeter.get_geom_id())) continue;
+            total_energy += a_calorimeter.get_energy();
+          }
+
+        if      (a_particle.get_charge() == snemo::datamodel::particle_track::negative) nelectron++;
+        else if (a_particle.get_charge() == snemo::datamodel::particle_track::positive) npositron++;
+        else nundefined++;
+      }
+    return;
+  }
+
+  void halflife_limit_module::_register_cuts(cut_flow_type & cut_flow_)
+  {
+    // Maximum number of calorimeter hits not associated to a particle :
+    cut_flow_.register_cut("isolated_calorimeters", [](const datatools::properties & parameters_)
+      {
+        const size_t max = plot_conventions::halflife_max_isolated_calorimeters(parameters_);
+        return cut_flow_type::predicate_type([max](event_selection_type & event_)
+          {
+            return event_.ptd->get_non_associated_calorimeters().size() <= max;
+          });
+      });
+
+    // Number of electrons, requires counting the particles :
+    cut_flow_.register_cut("electrons", [](const datatools::properties & parameters_)
+      {
+        const size_t number = plot_conventions::halflife_number_of_electrons(parameters_);
+        return cut_flow_type::predicate_type([number](event_selection_type & event_)
+          {
+            event_.count();
+            return event_.nelectron == number;
+          });
+      }, 10.0);
+    return;
+  }
+
+  void halflife_limit_module::_report_cut_flow()
+  {
+    if (get_logging_priority() < datatools::logger::PRIO_NOTICE) return;
+    cut_flow_type total = _cut_flow_;
+    total.reset_counters();
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        total.merge(_contexts_.grab(i).cut_flow);
+      }
+    DT_LOG_NOTICE(get_logging_priority(), "Cut flow of module '" << get_name() << "' :");
+    total.print_table(std::clog, "  ");
+    return;
+  }
+
+  void halflife_limit_module::_setup_context(worker_context_type & context_)
+  {
+    context_.pool = _histogram_pool_;
+    if (_sharded_)
+      {
+        context_.shard.reset(new mygsl::histogram_pool);
+        context_.shard->initialize(datatools::properties());
+        context_.pool = context_.shard.get();
+      }
+    context_.key_plan = _key_plan_;
+    context_.key_indexes.clear();
+    context_.key_names.clear();
+    context_.charge_slots.assign(CHARGE_CATEGORIES, 0);
+    context_.booked_charges = 0;
+    context_.categories.clear();
+    context_.sparse_categories.clear();
+    context_.cache_key.clear();
+    context_.buffered_events = 0;
+    context_.online_background.clear();
+    context_.online_excluded.clear();
+    context_.online_events = 0;
+    context_.processed_events = 0;
+    context_.online_time = std::chrono::steady_clock::now();
+    context_.selection.ptd = 0;
+    context_.selection.counted = false;
+    context_.cut_flow = _cut_flow_;
+    return;
+  }
+
+  void halflife_limit_module::_flush_fillers(worker_context_type & context_)
+  {
+    for (size_t key_index = 0; key_index < context_.categories.size(); ++key_index)
+      {
+        std::vector<category_entry_type> & key_categories = context_.categories[key_index];
+        for (size_t slot = 0; slot < key_categories.size(); ++slot)
+          {
+            histogram_filler_1d & a_filler = key_categories[slot].filler;
+            if (a_filler.is_initialized()) a_filler.flush();
+          }
+      }
+    for (sparse_category_dict_type::iterator
+           icategory = context_.sparse_categories.begin();
+         icategory != context_.sparse_categories.end(); ++icategory)
+      {
+        icategory->second.filler.flush();
+      }
+    return;
+  }
+
+  void halflife_limit_module::_book_category(worker_context_type & context_,
+                                             size_t key_index_,
+                                             size_t nelectron_,
+                                             size_t npositron_,
+                                             size_t nundefined_,
+                                             category_entry_type & category_)
+  {
+    mygsl::histogram_1d & a_histogram = _register_histogram(*context_.pool, context_.key_names[key_index_],
+                                                            nelectron_, npositron_, nundefined_);
+    category_.filler.initialize(a_histogram);
+    category_.filler.set_buffered(_fill_buffer_size_ > 0, _fill_buffer_size_);
+    std::ostringstream a_name;
+    a_name << context_.key_names[key_index_];
+    plot_conventions::append_charge_name(a_name, nelectron_, npositron_, nundefined_);
+    category_.name = a_name.str();
+    category_.online = online_entry_type();
+    return;
+  }
+
+  void halflife_limit_module::_merge_contexts()
+  {
+    // The shards are summed in an order that does not depend on the threads
+    std::vector<const mygsl::histogram_pool *> shards;
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        worker_context_type & a_context = _contexts_.grab(i);
+        _flush_fillers(a_context);
+        if (a_context.shard) shards.push_back(a_context.shard.get());
+      }
+    merge_histogram_pools(*_histogram_pool_, shards);
+    return;
+  }
+
+  void halflife_limit_module::_online_update(worker_context_type & context_,
+                                             category_entry_type & category_,
+                                             size_t & changed_bins_)
+  {
+    histogram_filler_1d & a_filler = category_.filler;
+    if (! a_filler.is_initialized() || ! a_filler.is_dirty()) return;
+    const mygsl::histogram_1d & a_histogram = a_filler.grab_histogram();
+    online_entry_type & an_entry = category_.online;
+    size_t first = a_filler.get_dirty_first();
+    size_t last = a_filler.get_dirty_last();
+    a_filler.clear_dirty();
+    if (an_entry.role == ONLINE_UNKNOWN)
+      {
+        double weight = 1.0;
+        if (a_histogram.get_auxiliaries().has_key("weight"))
+          {
+            weight = a_histogram.get_auxiliaries().fetch_real("weight");
+          }
+        if (context_.online_background.empty())
+          {
+            context_.online_background.assign(a_histogram.bins(), 0.0);
+            context_.online_excluded.assign(a_histogram.bins(), 0.0);
+            changed_bins_ = a_histogram.bins();
+          }
+        an_entry.role = ONLINE_IGNORED;
+        if (a_histogram.bins() == context_.online_background.size())
+          {
+            if (category_.name.find("0nubb") != std::string::npos)
+              {
+                an_entry.role = ONLINE_SIGNAL;
+                an_entry.norm = weight * _bb2nu_decay_factor() * _experiment_conditions_.isotope_bb2nu_halflife;
+              }
+            else
+              {
+                const double norm_factor
+                  = _background_normalisation(category_.name + KEY_FIELD_SEPARATOR + "efficiency");
+                if (datatools::is_valid(norm_factor))
+                  {
+                    an_entry.role = ONLINE_BACKGROUND;
+                    an_entry.norm = weight * norm_factor;
+                  }
+              }
+          }
+        an_entry.contents.assign(a_histogram.bins(), 0.0);
+        an_entry.above.assign(a_histogram.bins(), 0.0);
+        // Contents filled before the first estimate
+        first = 0;
+        last = a_histogram.bins();
+      }
+    if (an_entry.role == ONLINE_IGNORED) return;
+
+    // Only the bins below the last filled bin have a new cumulative content
+    update_contents_above(a_histogram, first, last, an_entry.contents, an_entry.above,
+                          an_entry.role == ONLINE_BACKGROUND ? &context_.online_background : 0, an_entry.norm);
+    if (an_entry.role == ONLINE_BACKGROUND) changed_bins_ = std::max(changed_bins_, last);
+    return;
+  }
+
+  void halflife_limit_module::_online_estimate(worker_context_type & context_)
+  {
+    _flush_fillers(context_);
+    context_.online_events = 0;
+    context_.online_time = std::chrono::steady_clock::now();
+
+    // Update the cumulative contents of the histograms filled since the last estimate
+    size_t changed_bins = 0;
+    for (size_t key_index = 0; key_index < context_.categories.size(); ++key_index)
+      {
+        std::vector<category_entry_type> & key_categories = context_.categories[key_index];
+        for (size_t slot = 0; slot < key_categories.size(); ++slot)
+          {
+            _online_update(context_, key_categories[slot], changed_bins);
+          }
+      }
+    for (sparse_category_dict_type::iterator
+           icategory = context_.sparse_categories.begin();
+         icategory != context_.sparse_categories.end(); ++icategory)
+      {
+        _online_update(context_, icategory->second, changed_bins);
+      }
+    if (changed_bins > 0)
+      {
+        _feldman_cousins_.excluded_events(&context_.online_background[0], changed_bins, &context_.online_excluded[0]);
+      }
+
+    // Best limit over the signal histograms and energy thresholds
+    std::vector<category_entry_type *> signal_categories;
+    for (size_t key_index = 0; key_index < context_.categories.size(); ++key_index)
+      {
+        std::vector<category_entry_type> & key_categories = context_.categories[key_index];
+        for (size_t slot = 0; slot < key_categories.size(); ++slot)
+          {
+            if (key_categories[slot].online.role == ONLINE_SIGNAL) signal_categories.push_back(&key_categories[slot]);
+          }
+      }
+    for (sparse_category_dict_type::iterator
+           icategory = context_.sparse_categories.begin();
+         icategory != context_.sparse_categories.end(); ++icategory)
+      {
+        if (icategory->second.online.role == ONLINE_SIGNAL) signal_categories.push_back(&icategory->second);
+      }
+    double best_halflife = 0.0;
+    size_t best_bin = 0;
+    histogram_filler_1d * best_filler = 0;
+    for (size_t k = 0; k < signal_categories.size(); ++k)
+      {
+        const online_entry_type & an_entry = signal_categories[k]->online;
+        for (size_t i = 0; i < an_entry.above.size(); ++i)
+          {
+            const double halflife = an_entry.above[i] * an_entry.norm / context_.online_excluded[i];
+            if (halflife > best_halflife)
+              {
+                best_halflife = halflife;
+                best_bin = i;
+                best_filler = &signal_categories[k]->filler;
+              }
+          }
+      }
+    const double threshold = best_filler ? best_filler->grab_histogram().get_range(best_bin).first : 0.0;
+    DT_LOG_NOTICE(get_logging_priority(), "Online halflife limit after " << context_.processed_events
+                  << " events is " << best_halflife << " yr above " << threshold / CLHEP::MeV << " MeV");
+    if (! _online_output_file_.empty())
+      {
+        std::ofstream out(_online_output_file_.c_str(), std::ios::app);
+        DT_THROW_IF(! out, std::runtime_error,
+                    "Module '" << get_name() << "' cannot open online output file '" << _online_output_file_ << "' !");
+        out << context_.processed_events << ' ' << best_halflife << ' ' << threshold / CLHEP::MeV << std::endl;
+      }
+    return;
+  }
+
   // Reset :
   void halflife_limit_module::reset()
   {
@@ -220,6 +706,12 @@ namespace analysis {
                 std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Fill the histograms with the remaining staged values and merge the shards :
+    _merge_contexts();
+
+    // Report the cut flow
+    _report_cut_flow();
+
     // Compute efficiency
     _compute_efficiency();
 
@@ -233,6 +725,9 @@ namespace analysis {
         dump_result();
       }
 
+    // The run is complete, the checkpoint is not needed anymore :
+    _checkpoint_.terminate();
+
     // Tag the module as un-initialized :
     _set_initialized(false);
     _set_defaults();
@@ -260,28 +755,52 @@ namespace analysis {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Working context of the calling thread :
+    worker_context_type & a_context = _contexts_.grab_local();
+
+    // Skip the events already counted by the restored checkpoint, store a new one when due
+    // and fill the histograms with the staged values every 'fill_buffer_size' events :
+    if (begin_checkpointed_event(_checkpoint_, *_histogram_pool_, _fill_buffer_size_, a_context.buffered_events,
+                                 [&]() { _flush_fillers(a_context); }))
+      {
+        return dpp::base_module::PROCESS_CONTINUE;
+      }
+
+    // Estimate the halflife limit every 'online.period_events' events or 'online.period_seconds' seconds :
+    if (_online_period_events_ > 0 || _online_period_seconds_ > 0.0)
+      {
+        a_context.processed_events++;
+        bool due = _online_period_events_ > 0 && ++a_context.online_events >= _online_period_events_;
+        if (! due && _online_period_seconds_ > 0.0)
+          {
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - a_context.online_time;
+            due = elapsed.count() >= _online_period_seconds_;
+          }
+        if (due) _online_estimate(a_context);
+      }
+
     // Check if the 'event header' record bank is available :
-    const std::string eh_label = snemo::datamodel::data_info::default_event_header_label();
-    if (! data_record_.has(eh_label))
+    const snemo::datamodel::event_header * eh_bank
+      = try_get_bank<snemo::datamodel::event_header>(data_record_, _EH_label_);
+    if (! eh_bank)
       {
         DT_LOG_ERROR(get_logging_priority(), "Could not find any bank with label '"
-                     << eh_label << "' !");
+                     << _EH_label_ << "' !");
         return dpp::base_module::PROCESS_STOP;
       }
-    const snemo::datamodel::event_header & eh
-      = data_record_.get<snemo::datamodel::event_header>(eh_label);
+    const snemo::datamodel::event_header & eh = *eh_bank;
 
 
     // Check if the 'particle track' record bank is available :
-    const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-    if (! data_record_.has(ptd_label))
+    const snemo::datamodel::particle_track_data * ptd_bank
+      = try_get_bank<snemo::datamodel::particle_track_data>(data_record_, _PTD_label_);
+    if (! ptd_bank)
       {
         DT_LOG_ERROR(get_logging_priority (), "Could not find any bank with label '"
-                     << ptd_label << "' !");
+                     << _PTD_label_ << "' !");
         return dpp::base_module::PROCESS_STOP;
       }
-    const snemo::datamodel::particle_track_data & ptd
-      = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
+    const snemo::datamodel::particle_track_data & ptd = *ptd_bank;
 
     if (get_logging_priority() >= datatools::logger::PRIO_DEBUG)
       {
@@ -291,161 +810,101 @@ namespace analysis {
         ptd.tree_dump();
       }
 
-    // Particle Counters
-    size_t nelectron  = 0;
-    size_t npositron  = 0;
-    size_t nundefined = 0;
-
-    // Calibrated energies
-    double total_energy = 0.0;
-
-    double electron_energy = 0.0;
-
-    double gamma_energy = 0.0;
-
-    // Store geom_id to avoid double inclusion of energy deposited
-    std::set<geomtools::geom_id> gids;
-
-    /* for Gui*/
-    const size_t n_calos_non_associated = ptd.get_non_associated_calorimeters().size();
-
-    if(n_calos_non_associated != 0)
-      return dpp::base_module::PROCESS_CONTINUE;
-
-     // gamma_energy = ptd.get_non_associated_calorimeters().at(0).get().get_energy();
-
-    // Loop over all saved particles
-    const snemo::datamodel::particle_track_data::particle_collection_type & the_particles = ptd.get_particles();
-
-    // for (snemo::datamodel::particle_track_data::particle_collection_type::const_iterator
-    //        iparticle = the_particles.begin();
-    //      iparticle != the_particles.end();
-    //      ++iparticle)
-
-    for (snemo::datamodel::particle_track_data::particle_collection_type::const_iterator
-           iparticle = ptd.get_particles().begin();
-         iparticle != ptd.get_particles().end();
-         ++iparticle)
+    // Apply the cuts, the particles are counted only if a cut needs them :
+    event_selection_type & a_selection = a_context.selection;
+    a_selection.start(ptd);
+    if (! a_context.cut_flow.select(a_selection))
       {
-        const snemo::datamodel::particle_track & a_particle = iparticle->get();
-
-        if (! a_particle.has_associated_calorimeter_hits())
-          {
-            DT_LOG_DEBUG(get_logging_priority(),
-                         "Particle track is not associated to any calorimeter block !");
-            continue;
-          }
-
-        const snemo::datamodel::calibrated_calorimeter_hit::collection_type &
-          the_calorimeters = a_particle.get_associated_calorimeter_hits ();
-
-        if (the_calorimeters.size() > 2)
-          {
-            DT_LOG_DEBUG(get_logging_priority(),
-                         "The particle is associated to more than 2 calorimeters !");
-            continue;
-          }
-
-        for (size_t i = 0; i < the_calorimeters.size(); ++i)
-          {
-            const geomtools::geom_id & gid = the_calorimeters.at(i).get().get_geom_id();
-            if (gids.find(gid) != gids.end()) continue;
-            gids.insert(gid);
-            total_energy += the_calorimeters.at(i).get().get_energy();
-
-            // Look first if trajectory pattern is an helix or not
-            const snemo::datamodel::tracker_trajectory & a_trajectory = a_particle.get_trajectory();
-            const snemo::datamodel::base_trajectory_pattern & a_track_pattern = a_trajectory.get_pattern();
-
-            const std::string & a_pattern_id = a_track_pattern.get_pattern_id();
-          }
-
-        if      (a_particle.get_charge() == snemo::datamodel::particle_track::negative) nelectron++;
-        else if (a_particle.get_charge() == snemo::datamodel::particle_track::positive) npositron++;
-        else nundefined++;
-
+        DT_LOG_DEBUG(get_logging_priority(), "Event rejected by the cut flow !");
+        return dpp::base_module::PROCESS_CONTINUE;
       }
-    // if(nelectron == 1)
-      // electron_energy = total_energy;
+    a_selection.count();
+    const size_t nelectron  = a_selection.nelectron;
+    const size_t npositron  = a_selection.npositron;
+    const size_t nundefined = a_selection.nundefined;
+    const double total_energy = a_selection.total_energy;
 
-    // Build unique key for histogram map:
-    std::ostringstream key;
+    DT_LOG_TRACE(get_logging_priority(), "Total energy = " << total_energy / CLHEP::keV << " keV");
+    DT_LOG_TRACE(get_logging_priority(), "Number of electrons = " << nelectron);
+    DT_LOG_TRACE(get_logging_priority(), "Number of positrons = " << npositron);
+    DT_LOG_TRACE(get_logging_priority(), "Number of undefined = " << nundefined);
 
-    // Retrieving info from header bank:
+    // Dense index of the key fields tuple:
     const datatools::properties & eh_properties = eh.get_properties();
-    for (std::vector<std::string>::const_iterator
-           ifield = _key_fields_.begin();
-         ifield != _key_fields_.end(); ++ifield)
+    size_t key_index = 0;
+    if (! a_context.key_plan.empty())
       {
-        const std::string & a_field = *ifield;
-        if (! eh_properties.has_key(a_field))
-          {
-            DT_LOG_WARNING(get_logging_priority(),
-                           "No properties with key '" << a_field << "' "
-                           << "has been found in event header !");
-            continue;
-          }
-
-        if (eh_properties.is_vector(a_field))
+        a_context.cache_key.clear();
+        a_context.key_plan.build_key(eh_properties, a_context.cache_key);
+        key_index_dict_type::const_iterator found = a_context.key_indexes.find(a_context.cache_key);
+        if (found == a_context.key_indexes.end())
           {
-            DT_LOG_WARNING(get_logging_priority (),
-                           "Stored properties '" << a_field << "' " << "must be scalar !");
-            continue;
+            found = a_context.key_indexes.insert(std::make_pair(a_context.cache_key,
+                                                                a_context.key_names.size())).first;
+            std::ostringstream key_name;
+            a_context.key_plan.build_name(eh_properties, key_name);
+            a_context.key_names.push_back(key_name.str());
           }
-        if (eh_properties.is_boolean(a_field))      key << eh_properties.fetch_boolean(a_field);
-        else if (eh_properties.is_integer(a_field)) key << eh_properties.fetch_integer(a_field);
-        else if (eh_properties.is_real(a_field))    key << eh_properties.fetch_real(a_field);
-        else if (eh_properties.is_string(a_field))  key << eh_properties.fetch_string(a_field);
-
-        // Add a underscore separator between fields
-        key << KEY_FIELD_SEPARATOR;
+        key_index = found->second;
       }
-
-    //key << "Bi214radon" << KEY_FIELD_SEPARATOR;
-
-    // Add charge multiplicity
-    key << nelectron << "e-" << npositron << "e+" << nundefined << "u";
-
-    // std::cout<< nelectron << "e-" << npositron << "e+" << nundefined << "u"<<std::endl;
-
-    DT_LOG_TRACE(get_logging_priority(), "Total energy = " << total_energy / CLHEP::keV << " keV");
-    DT_LOG_TRACE(get_logging_priority(), "Number of electrons = " << nelectron);
-    DT_LOG_TRACE(get_logging_priority(), "Number of positrons = " << npositron);
-    DT_LOG_TRACE(get_logging_priority(), "Number of undefined = " << nundefined);
-    DT_LOG_TRACE(get_logging_priority(), "Key = " << key.str());
-
-
-    // // Arbitrary selection of "two-particles" channel
-    // if (nelectron != 1 && n_calos_non_associated != 1)
-    //   {
-    //     //DT_LOG_WARNING(get_logging_priority(), "Selecting only two-electrons events!");
-    //     return dpp::base_module::PROCESS_CONTINUE;
-    //   }
-
-    // Arbitrary selection of "two-particles" channel
-    if (nelectron != 2)
+    else if (a_context.key_names.empty())
       {
-        DT_LOG_WARNING(get_logging_priority(), "Selecting only two-electrons events!");
-        return dpp::base_module::PROCESS_CONTINUE;
+        a_context.key_names.push_back("");
       }
 
-    // Getting histogram pool
-    mygsl::histogram_pool & a_pool = grab_histogram_pool();
-    if (! a_pool.has(key.str()))
+    // Dense slot of the charge multiplicity, booked on first use:
+    category_entry_type * a_category = 0;
+    if (nelectron < CHARGE_SLOTS && npositron < CHARGE_SLOTS && nundefined < CHARGE_SLOTS)
+      {
+        const size_t charge_index = (nelectron * CHARGE_SLOTS + npositron) * CHARGE_SLOTS + nundefined;
+        unsigned short & a_slot = a_context.charge_slots[charge_index];
+        if (a_slot == 0) a_slot = ++a_context.booked_charges;
+        if (key_index >= a_context.categories.size()) a_context.categories.resize(key_index + 1);
+        std::vector<category_entry_type> & key_categories = a_context.categories[key_index];
+        if (a_slot > key_categories.size()) key_categories.resize(a_context.booked_charges);
+        a_category = &key_categories[a_slot - 1];
+      }
+    else
+      {
+        // Unusual multiplicities are resolved once per context, outside of the dense index
+        const sparse_category_type category(key_index, nelectron, npositron, nundefined);
+        a_category = &a_context.sparse_categories[category];
+      }
+    if (! a_category->filler.is_initialized())
       {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "energy");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d", "energy_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
+        _book_category(a_context, key_index, nelectron, npositron, nundefined, *a_category);
       }
 
     // Getting the current histogram
-    mygsl::histogram_1d & a_histo = a_pool.grab_1d(key.str ());
-    a_histo.fill(total_energy);
+    a_category->filler.fill(total_energy);
 
     // a_histo.fill(electron_energy + gamma_energy);
 
+    return dpp::base_module::PROCESS_SUCCESS;
+  }
+
+  mygsl::histogram_1d & halflife_limit_module::_register_histogram(mygsl::histogram_pool & pool_,
+                                                                   const std::string & key_name_,
+                                                                   size_t nelectron_,
+                                                                   size_t npositron_,
+                                                                   size_t nundefined_)
+  {
+    // Build unique key for histogram map:
+    std::ostringstream key;
+    key << key_name_;
+
+    //key << "Bi214radon" << KEY_FIELD_SEPARATOR;
+
+    // Add charge multiplicity
+    plot_conventions::append_charge_name(key, nelectron_, npositron_, nundefined_);
+    DT_LOG_TRACE(get_logging_priority(), "Key = " << key.str());
+
+    mygsl::histogram_1d & a_histo = plot_conventions::grab_mimic_1d(pool_, key.str(),
+                                                                    plot_conventions::HALFLIFE_GROUP,
+                                                                    plot_conventions::ENERGY_TEMPLATE,
+                                                                    *_histogram_pool_);
+    _checkpoint_.own(key.str());
+
     // Compute normalization factor given the total number of events generated
     // and the weight of each event
     double weight = 1.0;
@@ -463,8 +922,74 @@ namespace analysis {
       {
         a_histo.grab_auxiliaries().update("weight", weight);
       }
+    return a_histo;
+  }
 
-    return dpp::base_module::PROCESS_SUCCESS;
+  double halflife_limit_module::_bb2nu_decay_factor() const
+  {
+    return std::log(2) * _experiment_conditions_.isotope_mass * CLHEP::Avogadro * _experiment_conditions_.exposure_time
+      / _experiment_conditions_.isotope_mass_number / CLHEP::mole / _experiment_conditions_.isotope_bb2nu_halflife;
+  }
+
+  double halflife_limit_module::_background_normalisation(const std::string & name_)
+  {
+    double norm_factor;
+    datatools::invalidate(norm_factor);
+    if (name_.find("2nubb") != std::string::npos)
+      {
+        norm_factor = _bb2nu_decay_factor();
+      }
+    else
+      {
+        const background_association_type & an_association = _associate_background(name_);
+        if (an_association.background >= 0)
+          {
+            const std::string & bkg = _background_matcher_.get_pattern(an_association.background);
+            DT_LOG_TRACE(get_logging_priority(), "Found background element '" << bkg << "'");
+            const double year2sec = 3600 * 24 * 365.25;
+            norm_factor = _experiment_conditions_.background_activities.at(bkg)/CLHEP::becquerel
+              * _experiment_conditions_.exposure_time * year2sec * an_association.mass;
+          }
+      }
+    return norm_factor;
+  }
+
+  const halflife_limit_module::background_association_type &
+  halflife_limit_module::_associate_background(const std::string & name_)
+  {
+    std::unordered_map<std::string, background_association_type>::const_iterator
+      found = _background_associations_.find(name_);
+    if (found != _background_associations_.end()) return found->second;
+
+    // The last background component in name order contained in the
+    // histogram name is associated with it
+    background_association_type an_association;
+    an_association.background = -1;
+    an_association.mass = _experiment_conditions_.isotope_mass;
+    an_association.isotope_source = true;
+    std::vector<size_t> ids;
+    _background_matcher_.match(name_, ids);
+    if (! ids.empty()) an_association.background = ids.back();
+
+    // Explicit source mass for this histogram
+    const experiment_entry_type::override_list_type & overrides = _experiment_conditions_.normalisation_overrides;
+    for (experiment_entry_type::override_list_type::const_iterator
+           iover = overrides.begin();
+         iover != overrides.end(); ++iover)
+      {
+        if (iover->histogram != name_) continue;
+        for (size_t id = 0; id < _background_matcher_.size(); ++id)
+          {
+            if (_background_matcher_.get_pattern(id) != iover->background) continue;
+            if (static_cast<int>(id) >= an_association.background)
+              {
+                an_association.background = id;
+                an_association.mass = iover->mass;
+                an_association.isotope_source = false;
+              }
+          }
+      }
+    return _background_associations_[name_] = an_association;
   }
 
   void halflife_limit_module::_compute_efficiency()
@@ -474,7 +999,7 @@ namespace analysis {
 
     // Get names of all saved 1D histograms belonging to 'energy' group
     std::vector<std::string> hnames;
-    a_pool.names(hnames, "group=energy");
+    a_pool.names(hnames, std::string("group=") + plot_conventions::HALFLIFE_GROUP);
 
     if (hnames.empty())
       {
@@ -482,71 +1007,90 @@ namespace analysis {
         return;
       }
 
-    // Sum of number of events
-    std::map<std::string, double> m_event;
+    // Resolve the histograms once
+    std::vector<const mygsl::histogram_1d *> histograms;
+    histograms.reserve(hnames.size());
     for (std::vector<std::string>::const_iterator iname = hnames.begin();
          iname != hnames.end(); ++iname)
       {
         const std::string & a_name = *iname;
         DT_THROW_IF(! a_pool.has_1d(a_name), std::logic_error,
                     "Histogram '" << a_name << "' is not 1D histogram !");
-        const mygsl::histogram_1d & a_histogram = a_pool.get_1d(a_name);
+        histograms.push_back(&a_pool.get_1d(a_name));
+      }
 
-        // Loop over bin content
-        for (size_t i = 0; i < a_histogram.bins(); ++i)
+    // Fraction of events above each bin, computed as a reverse cumulative
+    // sum. A histogram with a non valid bin has no valid efficiency.
+    std::vector<std::vector<double> > efficiencies(histograms.size());
+    parallel_for(histograms.size(), _number_of_threads_,
+                 [&histograms, &efficiencies](size_t first_, size_t last_)
+                 {
+                   for (size_t ih = first_; ih < last_; ++ih)
+                     {
+                       const mygsl::histogram_1d & a_histogram = *histograms[ih];
+
+                       // Retrieve histogram weight
+                       double weight = 1.0;
+                       if (a_histogram.get_auxiliaries().has_key("weight"))
+                         {
+                           weight = a_histogram.get_auxiliaries().fetch_real("weight");
+                         }
+
+                       std::vector<double> & an_efficiency = efficiencies[ih];
+                       an_efficiency.resize(a_histogram.bins());
+                       double above = 0.0;
+                       for (size_t i = a_histogram.bins(); i-- > 0;)
+                         {
+                           above += a_histogram.get(i);
+                           an_efficiency[i] = above * weight;
+                         }
+                       if (! datatools::is_valid(above)) an_efficiency.clear();
+                     }
+                 });
+
+    // Store the efficiencies
+    for (size_t ih = 0; ih < histograms.size(); ++ih)
+      {
+        const std::string & a_name = hnames[ih];
+        const std::vector<double> & an_efficiency = efficiencies[ih];
+        if (an_efficiency.empty())
           {
-            const double sum   = a_histogram.sum();// + a_histogram.overflow();
-            const double value = a_histogram.get(i);
-
-            if (! datatools::is_valid(value))
-              {
-                DT_LOG_WARNING(get_logging_priority(), "Skipping non valid value !");
-                continue;
-              }
-
-            // Retrieve histogram weight
-            double weight = 1.0;
-            if (a_histogram.get_auxiliaries().has_key("weight"))
+            if (histograms[ih]->bins() > 0)
               {
-                weight = a_histogram.get_auxiliaries().fetch_real("weight");
-              }
-
-            // Compute fraction of event for each histogram bin
-            const double efficiency = (sum - m_event[a_name]) * weight;
-            m_event[a_name] += value;
-
-            if (! datatools::is_valid(efficiency))
-              {
-                DT_LOG_WARNING(get_logging_priority(), "Skipping non valid efficiency computation !");
-                continue;
+                DT_LOG_WARNING(get_logging_priority(),
+                               "Skipping non valid efficiency computation for histogram '" << a_name << "' !");
               }
+            continue;
+          }
 
-            // Adding histogram efficiency
-            const std::string & key_str = a_name + KEY_FIELD_SEPARATOR + "efficiency";
-            if (! a_pool.has(key_str))
-              {
-                mygsl::histogram_1d & h = a_pool.add_1d(key_str, "", "efficiency");
-                datatools::properties hconfig;
-                hconfig.store_string("mode", "mimic");
-                hconfig.store_string("mimic.histogram_1d", "halflife_limit_efficiency_template");
-                mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
-              }
+        // Adding histogram efficiency
+        const std::string & key_str = a_name + KEY_FIELD_SEPARATOR + "efficiency";
+        if (! a_pool.has(key_str))
+          {
+            mygsl::histogram_1d & h = a_pool.add_1d(key_str, "", "efficiency");
+            datatools::properties hconfig;
+            hconfig.store_string("mode", "mimic");
+            hconfig.store_string("mimic.histogram_1d", "halflife_limit_efficiency_template");
+            mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
+          }
 
-            // Getting & updating the current histogram
-            mygsl::histogram_1d & a_new_histogram = a_pool.grab_1d(key_str);
-            a_new_histogram.set(i, efficiency);
+        // Getting & updating the current histogram
+        mygsl::histogram_1d & a_new_histogram = a_pool.grab_1d(key_str);
+        for (size_t i = 0; i < an_efficiency.size(); ++i)
+          {
+            a_new_histogram.set(i, an_efficiency[i]);
+          }
 
-            // Flag signal/background histogram
-            datatools::properties & a_aux = a_new_histogram.grab_auxiliaries();
-            if (a_name.find("0nubb") != std::string::npos)
-              {
-                a_aux.update_flag(halflife_limit_module::signal_flag());
-              }
-            else
-              {
-                a_aux.update_flag(halflife_limit_module::background_flag());
-              }
-          } // end of bin content
+        // Flag signal/background histogram
+        datatools::properties & a_aux = a_new_histogram.grab_auxiliaries();
+        if (a_name.find("0nubb") != std::string::npos)
+          {
+            a_aux.update_flag(halflife_limit_module::signal_flag());
+          }
+        else
+          {
+            a_aux.update_flag(halflife_limit_module::background_flag());
+          }
       }// end of histogram loop
 
     return;
@@ -560,8 +1104,7 @@ namespace analysis {
     const double isotope_bb2nu_halflife = _experiment_conditions_.isotope_bb2nu_halflife; // year;
     const double isotope_mass           = _experiment_conditions_.isotope_mass;
     const double isotope_molar_mass     = _experiment_conditions_.isotope_mass_number;
-    const double kbg = std::log(2) * isotope_mass * CLHEP::Avogadro * exposure_time
-      / isotope_molar_mass / CLHEP::mole / isotope_bb2nu_halflife;
+    const double kbg = _bb2nu_decay_factor();
 
     // Getting histogram pool
     mygsl::histogram_pool & a_pool = grab_histogram_pool();
@@ -587,6 +1130,10 @@ namespace analysis {
     // Loop over 'background' histograms and count the number of background
     // events within the energy window
     std::vector<double> vbkg_counts;
+    // Same counts split per unit of exposure time, for the grid of experiment configurations
+    std::vector<double> vbkg_bb2nu;
+    std::vector<double> vbkg_isotope;
+    std::vector<double> vbkg_fixed;
     for (std::vector<std::string>::const_iterator iname = bkg_names.begin();
          iname != bkg_names.end(); ++iname)
       {
@@ -601,39 +1148,19 @@ namespace analysis {
             continue;
           }
         // Get normalization factor
-        double norm_factor;
-        datatools::invalidate(norm_factor);
-        if (a_name.find("2nubb") != std::string::npos)
-          {
-            //std::cout<<std::endl<<" ---------found 2nu "<< a_name <<std::endl;
-            norm_factor = kbg;
-          }
-        else
+        const double norm_factor = _background_normalisation(a_name);
+        std::vector<double> * vbkg_component = &vbkg_bb2nu;
+        double unit_factor = isotope_mass * exposure_time;
+        if (a_name.find("2nubb") == std::string::npos && datatools::is_valid(norm_factor))
           {
-            const experiment_entry_type::background_dict_type & bkgs = _experiment_conditions_.background_activities;
-            for (experiment_entry_type::background_dict_type::const_iterator
-                   ibkg = bkgs.begin();
-                 ibkg != bkgs.end(); ++ibkg)
+            if (_associate_background(a_name).isotope_source)
               {
-                //std::cout<<std::endl<<" --------- ibkg first "<< ibkg->first <<std::endl;
-                // if (a_name.find("Bi214_Po214_tracker") != std::string::npos)
-                // if (a_name == "Bi214_Po214_tracker_2e-0e+0u_efficiency" && ibkg->first == "Bi214_Po214_tracker")
-                if (a_name == "Rn222_wire_2e-0e+0u_efficiency" && ibkg->first == "Rn222")                  {
-                    // std::cout<<std::endl<<" +++++++ a_name "<< a_name << "   ibkg "<<ibkg->first<<std::endl;
-                    const double year2sec = 3600 * 24 * 365.25;
-                    norm_factor = ibkg->second/CLHEP::becquerel * exposure_time * year2sec * 15.2 * CLHEP::kg;
-                    //std::cout<<std::endl<<" +++++++ norm_factor "<<norm_factor<<std::endl;
-                  }
-                else
-                  if (a_name.find(ibkg->first) != std::string::npos)
-                  {
-                    //std::cout<<std::endl<<" 000000 a_name "<< a_name << "   ibkg "<<ibkg->first<<std::endl;
-                    DT_LOG_TRACE(get_logging_priority(),
-                                 "Found background element '" << ibkg->first << "'");
-                    const double year2sec = 3600 * 24 * 365.25;
-                    norm_factor = ibkg->second/CLHEP::becquerel * exposure_time * year2sec * isotope_mass;
-                    // std::cout<<std::endl<<" 000000 norm_factor "<<norm_factor<<"  for "<<ibkg->first<<std::endl;
-                  }
+                vbkg_component = &vbkg_isotope;
+              }
+            else
+              {
+                vbkg_component = &vbkg_fixed;
+                unit_factor = exposure_time;
               }
           }
         if (! datatools::is_valid(norm_factor)) {
@@ -648,8 +1175,15 @@ namespace analysis {
         for (size_t i = 0; i < a_histogram.bins(); ++i)
           {
             const double value = a_histogram.get(i) * norm_factor;
-            if (vbkg_counts.empty()) vbkg_counts.assign(a_histogram.bins(), 0.0);
+            if (vbkg_counts.empty())
+              {
+                vbkg_counts.assign(a_histogram.bins(), 0.0);
+                vbkg_bb2nu.assign(a_histogram.bins(), 0.0);
+                vbkg_isotope.assign(a_histogram.bins(), 0.0);
+                vbkg_fixed.assign(a_histogram.bins(), 0.0);
+              }
             vbkg_counts.at(i) += value;
+            vbkg_component->at(i) += value / unit_factor;
             // if(i==139) // 2.8 MeV bin
             //   std::cout<<std::endl<<"bkg count  "<<a_name<< "  " <<value<<std::endl<<std::endl;
           }
@@ -669,12 +1203,67 @@ namespace analysis {
         DT_LOG_WARNING(get_logging_priority(), "No 'signal' histograms have been stored !");
         return;
       }
+    // Number of excluded events for each energy bin
+    std::vector<double> vexcluded(vbkg_counts.size());
+    if (! vbkg_counts.empty())
+      {
+        _feldman_cousins_.excluded_events(&vbkg_counts[0], vbkg_counts.size(), &vexcluded[0]);
+      }
+
+    // Two-sided energy window optimiser
+    roi_optimiser a_roi_optimiser;
+    a_roi_optimiser.set_number_of_threads(_number_of_threads_);
+    a_roi_optimiser.set_excluded_events_function([this](const double * backgrounds_,
+                                                        size_t size_,
+                                                        double * excluded_)
+                                                  {
+                                                    _feldman_cousins_.excluded_events(backgrounds_, size_, excluded_);
+                                                  });
+    a_roi_optimiser.set_halflife_factor(kbg * isotope_bb2nu_halflife);
+
+    // Pseudo-experiments of the background counts
+    const bool run_toys = _toy_sensitivity_.get_number_of_toys() > 0;
+    _toy_sensitivity_.set_halflife_factor(kbg * isotope_bb2nu_halflife);
+    _toy_sensitivity_.set_upper_limit_function([this](size_t observed_, double background_)
+                                               {
+                                                 const size_t nmax = _feldman_cousins_.get_number_of_observed() - 1;
+                                                 return _feldman_cousins_.upper_limit(std::min(observed_, nmax), background_);
+                                               });
+    const char * band_names[] = { "minus_2sigma", "minus_1sigma", "median", "plus_1sigma", "plus_2sigma" };
+    const size_t nbands = sizeof(band_names) / sizeof(const char *);
+
+    // Grid of experiment configurations
+    const bool run_grid = ! _grid_exposure_times_.empty() || ! _grid_isotope_masses_.empty()
+      || ! _grid_background_scales_.empty();
+    sensitivity_grid a_grid;
+    std::ofstream grid_output;
+    if (run_grid)
+      {
+        a_grid.set_number_of_threads(_number_of_threads_);
+        a_grid.set_feldman_cousins(_feldman_cousins_);
+        a_grid.set_signal_factor(std::log(2) * CLHEP::Avogadro / isotope_molar_mass / CLHEP::mole);
+        a_grid.set_background_components(vbkg_bb2nu, vbkg_isotope, vbkg_fixed);
+        a_grid.set_grid(_grid_exposure_times_.empty() ? std::vector<double>(1, exposure_time) : _grid_exposure_times_,
+                        _grid_isotope_masses_.empty() ? std::vector<double>(1, isotope_mass) : _grid_isotope_masses_,
+                        _grid_background_scales_.empty() ? std::vector<double>(1, 1.0) : _grid_background_scales_);
+        if (! _grid_output_file_.empty())
+          {
+            grid_output.open(_grid_output_file_.c_str());
+            DT_THROW_IF(! grid_output, std::runtime_error,
+                        "Module '" << get_name() << "' cannot open grid output file '" << _grid_output_file_ << "' !");
+            grid_output << "#histogram exposure_time isotope_mass[kg] background_scale"
+                        << " threshold_energy threshold_halflife"
+                        << " roi_min_energy roi_max_energy roi_halflife" << std::endl;
+          }
+      }
+
     // Loop over 'signal' histograms
     for (std::vector<std::string>::const_iterator iname = signal_names.begin();
          iname != signal_names.end(); ++iname)
       {
         double best_halflife_limit = 0.0;
         const std::string & a_name = *iname;
+        const uint64_t signal_stream = static_cast<uint64_t>(iname - signal_names.begin()) << 32;
         DT_THROW_IF(! a_pool.has_1d(a_name), std::logic_error,
                     "Histogram '" << a_name << "' is not 1D histogram !");
         if (a_pool.get_group(a_name) != "efficiency")
@@ -690,8 +1279,7 @@ namespace analysis {
             const double value = a_histogram.get(i);
 
             // Compute the number of event excluded for the same energy bin
-            const double nbkg = vbkg_counts.at(i);
-            const double nexcluded = analysis::get_number_of_excluded_events(nbkg);
+            const double nexcluded = vexcluded.at(i);
             const double halflife = value / nexcluded * kbg * isotope_bb2nu_halflife;
 
             // Keeping larger limit
@@ -714,6 +1302,116 @@ namespace analysis {
           }
         DT_LOG_NOTICE(get_logging_priority(),
                       "Best halflife limit for bb0nu process is " << best_halflife_limit << " yr");
+
+        // Sensitivity bands of each energy threshold
+        if (run_toys && vbkg_counts.size() == a_histogram.bins())
+          {
+            std::vector<mygsl::histogram_1d *> band_histograms(nbands);
+            for (size_t iband = 0; iband < nbands; ++iband)
+              {
+                const std::string key_str = a_name + KEY_FIELD_SEPARATOR + "halflife" + KEY_FIELD_SEPARATOR + band_names[iband];
+                if (! a_pool.has(key_str))
+                  {
+                    mygsl::histogram_1d & h = a_pool.add_1d(key_str, "", "sensitivity");
+                    datatools::properties hconfig;
+                    hconfig.store_string("mode", "mimic");
+                    hconfig.store_string("mimic.histogram_1d", "halflife_template");
+                    mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
+                  }
+                band_histograms[iband] = &a_pool.grab_1d(key_str);
+              }
+            // The thresholds within the Feldman-Cousins table are run as one batch
+            std::vector<size_t> toy_bins;
+            std::vector<toy_sensitivity::window_type> toy_windows;
+            for (size_t i = 0; i < a_histogram.bins(); ++i)
+              {
+                if (vbkg_counts[i] > _feldman_cousins_.get_max_background()) continue;
+                toy_sensitivity::window_type a_window;
+                a_window.stream = signal_stream | i;
+                a_window.signal_efficiency = a_histogram.get(i);
+                a_window.background_counts = vbkg_counts[i];
+                toy_bins.push_back(i);
+                toy_windows.push_back(a_window);
+              }
+            std::vector<toy_sensitivity::band_type> toy_bands;
+            _toy_sensitivity_.compute(toy_windows, toy_bands);
+            for (size_t k = 0; k < toy_bins.size(); ++k)
+              {
+                const size_t i = toy_bins[k];
+                const toy_sensitivity::band_type & a_band = toy_bands[k];
+                band_histograms[0]->set(i, a_band.minus_2sigma);
+                band_histograms[1]->set(i, a_band.minus_1sigma);
+                band_histograms[2]->set(i, a_band.median);
+                band_histograms[3]->set(i, a_band.plus_1sigma);
+                band_histograms[4]->set(i, a_band.plus_2sigma);
+              }
+          }
+
+        // Best energy window [Emin, Emax]
+        if (vbkg_counts.size() != a_histogram.bins()) continue;
+        std::vector<double> signal_above(a_histogram.bins());
+        for (size_t i = 0; i < a_histogram.bins(); ++i)
+          {
+            signal_above[i] = a_histogram.get(i);
+          }
+
+        // Sensitivity surface
+        if (run_grid && a_histogram.bins() > 0)
+          {
+            std::vector<sensitivity_grid::result_type> grid_results;
+            a_grid.evaluate(signal_above, grid_results);
+            for (size_t ip = 0; ip < grid_results.size(); ++ip)
+              {
+                const sensitivity_grid::result_type & a_result = grid_results[ip];
+                const double roi_min = a_result.window.is_valid()
+                  ? a_histogram.get_range(a_result.window.first_bin).first : 0.0;
+                const double roi_max = a_result.window.is_valid()
+                  ? a_histogram.get_range(a_result.window.last_bin - 1).second : 0.0;
+                std::ostringstream line;
+                line << a_name << ' ' << a_result.point.exposure_time
+                     << ' ' << a_result.point.isotope_mass / CLHEP::kg
+                     << ' ' << a_result.point.background_scale
+                     << ' ' << a_histogram.get_range(a_result.threshold_bin).first
+                     << ' ' << a_result.threshold_halflife
+                     << ' ' << roi_min << ' ' << roi_max << ' ' << a_result.window.halflife;
+                if (grid_output.is_open()) grid_output << line.str() << std::endl;
+                else DT_LOG_INFORMATION(get_logging_priority(), "Sensitivity grid point : " << line.str());
+              }
+          }
+        const roi_optimiser::window_type a_window = a_roi_optimiser.optimise(signal_above, vbkg_counts);
+        if (! a_window.is_valid())
+          {
+            DT_LOG_WARNING(get_logging_priority(), "No energy window with signal for histogram '" << a_name << "' !");
+            continue;
+          }
+        const double min_energy = a_histogram.get_range(a_window.first_bin).first;
+        const double max_energy = a_histogram.get_range(a_window.last_bin - 1).second;
+        datatools::properties & a_aux
+          = a_pool.grab_1d(a_name + KEY_FIELD_SEPARATOR + "halflife").grab_auxiliaries();
+        a_aux.update("roi.min_energy", min_energy);
+        a_aux.update("roi.max_energy", max_energy);
+        a_aux.update("roi.signal_efficiency", a_window.signal_efficiency);
+        a_aux.update("roi.background_counts", a_window.background_counts);
+        a_aux.update("roi.halflife", a_window.halflife);
+        DT_LOG_NOTICE(get_logging_priority(),
+                      "Best energy window for bb0nu process is [" << min_energy << ", " << max_energy
+                      << "] with a halflife limit of " << a_window.halflife << " yr");
+
+        // Sensitivity band of the best energy window
+        if (run_toys && a_window.background_counts <= _feldman_cousins_.get_max_background())
+          {
+            const toy_sensitivity::band_type a_band
+              = _toy_sensitivity_.compute(signal_stream | 0xFFFFFFFF,
+                                          a_window.signal_efficiency, a_window.background_counts);
+            a_aux.update("roi.toys.minus_2sigma", a_band.minus_2sigma);
+            a_aux.update("roi.toys.minus_1sigma", a_band.minus_1sigma);
+            a_aux.update("roi.toys.median", a_band.median);
+            a_aux.update("roi.toys.plus_1sigma", a_band.plus_1sigma);
+            a_aux.update("roi.toys.plus_2sigma", a_band.plus_2sigma);
+            DT_LOG_NOTICE(get_logging_priority(),
+                          "Median sensitivity of the best energy window is " << a_band.median << " yr [-1 sigma: "
+                          << a_band.minus_1sigma << ", +1 sigma: " << a_band.plus_1sigma << "]");
+          }
       }// end of signal loop
   }
 
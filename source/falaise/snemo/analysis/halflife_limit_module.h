@@ -39,8 +39,31 @@
 #include <map>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <memory>
+#include <chrono>
+#include <tuple>
+
+// This project:
+#include <snemo/analysis/key_field_plan.h>
+#include <snemo/analysis/histogram_filler.h>
+#include <snemo/analysis/thread_context.h>
+#include <snemo/analysis/calorimeter_block_set.h>
+#include <snemo/analysis/cut_flow.h>
+#include <snemo/analysis/histogram_checkpoint.h>
+#include <snemo/analysis/background_matcher.h>
+#include <snemo/analysis/feldman_cousins.h>
+#include <snemo/analysis/toy_sensitivity.h>
+
+namespace snemo {
+  namespace datamodel {
+    class particle_track_data;
+  }
+}
 
 namespace mygsl {
+  class histogram;
+  typedef histogram histogram_1d;
   class histogram_pool;
 }
 
@@ -54,11 +77,21 @@ namespace analysis {
     {
       typedef std::map<std::string, double> background_dict_type;
 
+      /// Source mass of a background component for one efficiency histogram
+      struct normalisation_override_type
+      {
+        std::string background; //!< Background component
+        std::string histogram;  //!< Efficiency histogram name
+        double      mass;       //!< Mass replacing the isotope mass
+      };
+      typedef std::vector<normalisation_override_type> override_list_type;
+
       double isotope_mass_number;
       double isotope_mass;
       double isotope_bb2nu_halflife;
       double exposure_time;
       background_dict_type background_activities;
+      override_list_type normalisation_overrides;
 
       void initialize(const datatools::properties & config_);
     };
@@ -71,6 +104,9 @@ namespace analysis {
     /// Return the label of for the boolean property associated to 'background'
     static const std::string & background_flag();
 
+    /// Return the groups of the histograms computed from the energy ones
+    static const std::vector<std::string> & derived_groups();
+
     /// Setting histogram pool
     void set_histogram_pool(mygsl::histogram_pool & pool_);
 
@@ -105,6 +141,13 @@ namespace analysis {
     /// Give default values to specific class members.
     void _set_defaults();
 
+    /// Register the energy histogram of a key and charge multiplicity in a pool
+    mygsl::histogram_1d & _register_histogram(mygsl::histogram_pool & pool_,
+                                              const std::string & key_name_,
+                                              size_t nelectron_,
+                                              size_t npositron_,
+                                              size_t nundefined_);
+
     /// Compute topology channel efficiencies.
     void _compute_efficiency();
 
@@ -113,15 +156,194 @@ namespace analysis {
 
   private:
 
+    /// Dense index of the key fields tuples indexed by compact key
+    typedef std::unordered_map<std::string, size_t> key_index_dict_type;
+
+    /// Key fields index and charge multiplicity of a category outside of the dense index
+    typedef std::tuple<size_t, size_t, size_t, size_t> sparse_category_type;
+
+    /// Role of a histogram in the online estimate
+    enum online_role_type
+      {
+        ONLINE_UNKNOWN    = 0, //!< Not yet classified
+        ONLINE_IGNORED    = 1, //!< Neither signal nor normalised background
+        ONLINE_SIGNAL     = 2, //!< Signal histogram
+        ONLINE_BACKGROUND = 3  //!< Background histogram
+      };
+
+    /// Incremental state of a histogram in the online estimate
+    struct online_entry_type
+    {
+      online_role_type    role;     //!< Role of the histogram
+      double              norm;     //!< Halflife or background counts per unit of contents
+      std::vector<double> contents; //!< Bin contents at the last estimate
+      std::vector<double> above;    //!< Contents above each bin at the last estimate
+
+      online_entry_type() : role(ONLINE_UNKNOWN), norm(0.0) {}
+    };
+
+    /// Histogram of a key fields tuple and charge multiplicity
+    struct category_entry_type
+    {
+      histogram_filler_1d filler; //!< Filler of the histogram
+      std::string         name;   //!< Name of the histogram
+      online_entry_type   online; //!< Online estimate state of the histogram
+    };
+
+    /// Categories outside of the dense index
+    typedef std::map<sparse_category_type, category_entry_type> sparse_category_dict_type;
+
+    /// Event seen by the cuts, the particles are counted on demand
+    struct event_selection_type
+    {
+      const snemo::datamodel::particle_track_data * ptd;                //!< Particle track data of the event
+      bool                                          counted;            //!< Flag for counted particles
+      size_t                                        nelectron;          //!< Number of electrons
+      size_t                                        npositron;          //!< Number of positrons
+      size_t                                        nundefined;         //!< Number of particles of undefined charge
+      double                                        total_energy;       //!< Calorimeter energy of the particles
+      calorimeter_block_set                         calorimeter_blocks; //!< Calorimeter blocks counted in the event
+
+      /// Start the selection of a new event
+      void start(const snemo::datamodel::particle_track_data & ptd_);
+
+      /// Count the particles and their calorimeter energy once
+      void count();
+    };
+
+    /// Cut flow of the events
+    typedef cut_flow<event_selection_type> cut_flow_type;
+
+    /// Register the cuts available to the cut flow
+    static void _register_cuts(cut_flow_type & cut_flow_);
+
+    /// Print the cut flow table summed over the working contexts
+    void _report_cut_flow();
+
+    /// Working context of a processing thread
+    struct worker_context_type
+    {
+      mygsl::histogram_pool *                pool;            //!< Pool filled by the context
+      std::unique_ptr<mygsl::histogram_pool> shard;           //!< Private pool in sharded mode
+      key_field_plan                         key_plan;        //!< Private copy of the extraction plan
+      key_index_dict_type                    key_indexes;     //!< Dense index of the key fields tuples
+      std::vector<std::string>               key_names;       //!< Human readable name of each key fields tuple
+      std::vector<unsigned short>            charge_slots;    //!< Booked slot plus one of each indexed charge multiplicity, 0 if not booked
+      size_t                                 booked_charges;  //!< Number of booked charge multiplicities
+      std::vector<std::vector<category_entry_type> > categories; //!< Categories indexed by key fields tuple and booked slot
+      sparse_category_dict_type              sparse_categories; //!< Categories of the unusual charge multiplicities
+      std::string                            cache_key;       //!< Working buffer for the compact key
+      size_t                                 buffered_events; //!< Number of events staged since the last fill
+      std::vector<double>                    online_background; //!< Online background counts above each bin
+      std::vector<double>                    online_excluded;   //!< Online excluded events above each bin
+      size_t                                 online_events;     //!< Number of events since the last online estimate
+      size_t                                 processed_events;  //!< Number of processed events
+      std::chrono::steady_clock::time_point  online_time;       //!< Time of the last online estimate
+      event_selection_type                   selection;          //!< Event seen by the cuts
+      cut_flow_type                          cut_flow;           //!< Private copy of the cut flow
+    };
+
+    /// Background component and source mass normalising an efficiency histogram
+    struct background_association_type
+    {
+      int    background;     //!< Index of the background component, -1 if none
+      double mass;           //!< Mass of the background source
+      bool   isotope_source; //!< Flag for a source mass equal to the isotope mass
+    };
+
+    /// Return the cached background association of an efficiency histogram
+    const background_association_type & _associate_background(const std::string & name_);
+
+    /// Return the number of bb2nu decays per unit of efficiency
+    double _bb2nu_decay_factor() const;
+
+    /// Return the number of decays of the background normalising an efficiency histogram, invalid if none
+    double _background_normalisation(const std::string & name_);
+
+    /// Setup a new working context
+    void _setup_context(worker_context_type & context_);
+
+    /// Fill the histograms of a context with the staged values
+    void _flush_fillers(worker_context_type & context_);
+
+    /// Flush all the contexts and merge the shards into the histogram pool
+    void _merge_contexts();
+
+    /// Register the histogram of a category and prepare its filler
+    void _book_category(worker_context_type & context_,
+                        size_t key_index_,
+                        size_t nelectron_,
+                        size_t npositron_,
+                        size_t nundefined_,
+                        category_entry_type & category_);
+
+    /// Update the cumulative contents of a category histogram filled since the last online estimate
+    void _online_update(worker_context_type & context_, category_entry_type & category_, size_t & changed_bins_);
+
+    /// Update the online estimate of the halflife limit from the histograms of a context
+    void _online_estimate(worker_context_type & context_);
+
     // The key fields from 'event header' bank to build the histogram key:
     std::vector<std::string> _key_fields_;
 
+    // The compiled extraction plan of the key fields:
+    key_field_plan _key_plan_;
+
+    // The label of the event header bank :
+    std::string _EH_label_;
+
+    // The label of the particle track data bank :
+    std::string _PTD_label_;
+
     // The histogram pool :
     mygsl::histogram_pool * _histogram_pool_;
 
+    // Number of events staged before filling the histograms :
+    size_t _fill_buffer_size_;
+
+    // Flag to fill a private pool shard per thread :
+    bool _sharded_;
+
+    // The working contexts :
+    thread_context_set<worker_context_type> _contexts_;
+
+    // The checkpoint of the accumulated histograms :
+    histogram_checkpoint _checkpoint_;
+
+    // The cut flow applied to the events :
+    cut_flow_type _cut_flow_;
+
+    // Number of threads of the end of run computations :
+    size_t _number_of_threads_;
+
     // The experiment running condition
     experiment_entry_type _experiment_conditions_;
 
+    // The matcher of the background components in the histogram names :
+    background_matcher _background_matcher_;
+
+    // The background associations indexed by efficiency histogram name :
+    std::unordered_map<std::string, background_association_type> _background_associations_;
+
+    // The Feldman-Cousins upper limits
+    feldman_cousins _feldman_cousins_;
+
+    // The pseudo-experiments of the background counts
+    toy_sensitivity _toy_sensitivity_;
+
+    // The period of the online estimate in number of events and in seconds :
+    size_t _online_period_events_;
+    double _online_period_seconds_;
+
+    // The file receiving the online estimates :
+    std::string _online_output_file_;
+
+    // The grid of experiment configurations :
+    std::vector<double> _grid_exposure_times_;
+    std::vector<double> _grid_isotope_masses_;
+    std::vector<double> _grid_background_scales_;
+    std::string _grid_output_file_;
+
     // Macro to automate the registration of the module :
     DPP_MODULE_REGISTRATION_INTERFACE (halflife_limit_module);
 
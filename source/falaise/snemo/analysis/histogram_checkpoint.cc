@@ -0,0 +1,225 @@
+// histogram_checkpoint.cc
+
+// Ourselves:
+#include <snemo/analysis/histogram_checkpoint.h>
+
+// Standard library:
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/io_factory.h>
+#include <datatools/exception.h>
+#include <datatools/clhep_units.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+namespace analysis {
+
+  namespace {
+
+    // Copy a histogram of a pool into another one, replacing an existing histogram
+    void copy_histogram(mygsl::histogram_pool & target_,
+                        const mygsl::histogram_pool & source_,
+                        const std::string & name_)
+    {
+      if (source_.has_1d(name_))
+        {
+          if (! target_.has_1d(name_))
+            {
+              DT_THROW_IF(target_.has(name_), std::logic_error, "Histogram '" << name_ << "' is not 1D histogram !");
+              target_.add_1d(name_, source_.get_title(name_), source_.get_group(name_));
+            }
+          target_.grab_1d(name_) = source_.get_1d(name_);
+        }
+      else if (source_.has_2d(name_))
+        {
+          if (! target_.has_2d(name_))
+            {
+              DT_THROW_IF(target_.has(name_), std::logic_error, "Histogram '" << name_ << "' is not 2D histogram !");
+              target_.add_2d(name_, source_.get_title(name_), source_.get_group(name_));
+            }
+          target_.grab_2d(name_) = source_.get_2d(name_);
+        }
+      return;
+    }
+
+  }
+
+  histogram_checkpoint::histogram_checkpoint()
+  {
+    reset();
+    return;
+  }
+
+  void histogram_checkpoint::reset()
+  {
+    _file_.clear();
+    _owner_.clear();
+    _period_events_ = 0;
+    _period_seconds_ = 0.0;
+    _resume_ = true;
+    _keep_ = false;
+    _skipped_events_ = 0;
+    _events_ = 0;
+    _stored_events_ = 0;
+    _stored_time_ = std::chrono::steady_clock::now();
+    _owned_.clear();
+    return;
+  }
+
+  void histogram_checkpoint::initialize(const datatools::properties & config_, const std::string & owner_)
+  {
+    reset();
+    _owner_ = owner_;
+    if (config_.has_key("file"))
+      {
+        _file_ = config_.fetch_string("file");
+      }
+    if (config_.has_key("period_events"))
+      {
+        const int period_events = config_.fetch_integer("period_events");
+        DT_THROW_IF(period_events < 0, std::domain_error, "Invalid checkpoint 'period_events' property !");
+        _period_events_ = period_events;
+      }
+    if (config_.has_key("period_seconds"))
+      {
+        _period_seconds_ = config_.fetch_real("period_seconds");
+        if (config_.has_explicit_unit("period_seconds")) _period_seconds_ /= CLHEP::second;
+      }
+    if (config_.has_key("resume"))
+      {
+        _resume_ = config_.fetch_boolean("resume");
+      }
+    if (config_.has_key("keep"))
+      {
+        _keep_ = config_.fetch_boolean("keep");
+      }
+    DT_THROW_IF(! _file_.empty() && _period_events_ == 0 && _period_seconds_ <= 0.0, std::logic_error,
+                "Checkpoint file '" << _file_ << "' has no 'period_events' nor 'period_seconds' property !");
+    return;
+  }
+
+  bool histogram_checkpoint::is_enabled() const
+  {
+    return ! _file_.empty();
+  }
+
+  void histogram_checkpoint::own(const std::string & name_)
+  {
+    if (! is_enabled()) return;
+    std::lock_guard<std::mutex> lock(_store_mutex_);
+    _owned_.insert(name_);
+    return;
+  }
+
+  void histogram_checkpoint::restore(mygsl::histogram_pool & pool_)
+  {
+    if (! is_enabled() || ! _resume_) return;
+    if (! std::ifstream(_file_.c_str()).good()) return;
+    datatools::properties metadata;
+    mygsl::histogram_pool owned;
+    {
+      datatools::data_reader reader(_file_, datatools::using_multiple_archives);
+      reader.load(metadata);
+      DT_THROW_IF(! metadata.has_key("owner") || metadata.fetch_string("owner") != _owner_, std::logic_error,
+                  "Checkpoint '" << _file_ << "' does not belong to '" << _owner_ << "' !");
+      reader.load(owned);
+    }
+
+    // Replace the owned histograms, the histograms of other modules are left untouched
+    std::vector<std::string> names;
+    owned.names(names);
+    for (size_t i = 0; i < names.size(); ++i)
+      {
+        copy_histogram(pool_, owned, names[i]);
+        _owned_.insert(names[i]);
+      }
+    _skipped_events_ = static_cast<uint64_t>(metadata.fetch_real("events"));
+    _stored_events_ = _skipped_events_;
+    DT_LOG_NOTICE(datatools::logger::PRIO_NOTICE, "Resuming '" << _owner_ << "' from checkpoint '" << _file_
+                  << "' after " << _skipped_events_ << " events");
+    return;
+  }
+
+  bool histogram_checkpoint::begin_event()
+  {
+    return ++_events_ <= _skipped_events_;
+  }
+
+  bool histogram_checkpoint::is_due() const
+  {
+    if (! is_enabled()) return false;
+    const uint64_t completed = _events_ - 1;
+    if (completed <= _stored_events_) return false;
+    if (_period_events_ > 0 && completed - _stored_events_ >= _period_events_) return true;
+    if (_period_seconds_ > 0.0)
+      {
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _stored_time_;
+        if (elapsed.count() >= _period_seconds_) return true;
+      }
+    return false;
+  }
+
+  void histogram_checkpoint::store(const mygsl::histogram_pool & pool_)
+  {
+    DT_THROW_IF(! is_enabled(), std::logic_error, "Checkpoints are not enabled !");
+    std::lock_guard<std::mutex> lock(_store_mutex_);
+    const uint64_t completed = _events_ - 1;
+    datatools::properties metadata;
+    metadata.store_string("owner", _owner_);
+    metadata.store_real("events", completed);
+    mygsl::histogram_pool owned;
+    owned.initialize(datatools::properties());
+    for (std::set<std::string>::const_iterator iname = _owned_.begin(); iname != _owned_.end(); ++iname)
+      {
+        copy_histogram(owned, pool_, *iname);
+      }
+
+    // Write a temporary file then rename it over the checkpoint, the
+    // temporary file keeps the extensions selecting the archive format
+    // and compression ('run.data.gz' is written as 'run.tmp.data.gz')
+    const std::string::size_type slash = _file_.find_last_of('/');
+    const std::string::size_type dot = _file_.find('.', slash == std::string::npos ? 0 : slash + 1);
+    const std::string tmp_file = dot == std::string::npos ? _file_ + ".tmp"
+      : _file_.substr(0, dot) + ".tmp" + _file_.substr(dot);
+    {
+      datatools::data_writer writer(tmp_file, datatools::using_multiple_archives);
+      writer.store(metadata);
+      writer.store(owned);
+    }
+    DT_THROW_IF(std::rename(tmp_file.c_str(), _file_.c_str()) != 0, std::runtime_error,
+                "Cannot rename checkpoint '" << tmp_file << "' to '" << _file_ << "' !");
+    _stored_events_ = completed;
+    _stored_time_ = std::chrono::steady_clock::now();
+    DT_LOG_INFORMATION(datatools::logger::PRIO_INFORMATION, "Checkpoint of '" << _owner_ << "' stored in '"
+                       << _file_ << "' after " << completed << " events");
+    return;
+  }
+
+  void histogram_checkpoint::terminate()
+  {
+    if (! is_enabled() || _keep_) return;
+    std::remove(_file_.c_str());
+    return;
+  }
+
+  uint64_t histogram_checkpoint::get_skipped_events() const
+  {
+    return _skipped_events_;
+  }
+
+} // namespace analysis
+
+// end of histogram_checkpoint.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
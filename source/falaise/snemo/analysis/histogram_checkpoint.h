@@ -0,0 +1,163 @@
+/* histogram_checkpoint.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Periodic snapshot of a histogram pool with the number of processed
+ * events, used by the plot modules to resume an interrupted run.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_HISTOGRAM_CHECKPOINT_H_
+#define ANALYSIS_HISTOGRAM_CHECKPOINT_H_ 1
+
+// Standard libraries:
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace datatools {
+  class properties;
+}
+
+namespace mygsl {
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  /// \brief Checkpoint of the histograms filled by a module
+  ///
+  /// The histograms owned by the module are stored with the number of
+  /// events it processed so far every 'period_events' events and/or
+  /// 'period_seconds' seconds. Only owned histograms are stored, so that
+  /// several modules sharing a pool keep independent checkpoints, each
+  /// consistent with its own event counter. The checkpoint is written to a
+  /// temporary file which is then renamed over the checkpoint file, so
+  /// that an interruption never leaves a truncated checkpoint. A '.data'
+  /// file name selects the binary archive format, which the temporary
+  /// file 'run.tmp.data' of 'run.data' keeps. When resuming, the owned
+  /// histograms are replaced in the pool by the stored ones and the events
+  /// they already count are skipped.
+  class histogram_checkpoint
+  {
+  public:
+
+    /// Constructor
+    histogram_checkpoint();
+
+    /// Initialize from a configuration, the owner name is checked on restore
+    void initialize(const datatools::properties & config_, const std::string & owner_);
+
+    /// Reset
+    void reset();
+
+    /// Check if checkpoints are enabled
+    bool is_enabled() const;
+
+    /// Declare a histogram filled by the owner module
+    void own(const std::string & name_);
+
+    /// Restore the owned histograms from the checkpoint file if it exists and resuming is enabled
+    void restore(mygsl::histogram_pool & pool_);
+
+    /// Count a new event and return true if it was already counted by the restored checkpoint
+    bool begin_event();
+
+    /// Check if a checkpoint of the events completed before the current one is due
+    bool is_due() const;
+
+    /// Store the owned histograms and the number of events completed before the current one
+    void store(const mygsl::histogram_pool & pool_);
+
+    /// Remove the checkpoint file at the end of a complete run unless it is kept
+    void terminate();
+
+    /// Return the number of events skipped because of the restored checkpoint
+    uint64_t get_skipped_events() const;
+
+  private:
+
+    std::string                           _file_;           //!< Checkpoint file
+    std::string                           _owner_;          //!< Name of the owner module
+    uint64_t                              _period_events_;  //!< Period in number of events
+    double                                _period_seconds_; //!< Period in seconds
+    bool                                  _resume_;         //!< Resume from an existing checkpoint
+    bool                                  _keep_;           //!< Keep the checkpoint file at the end of the run
+    uint64_t                              _skipped_events_; //!< Number of events counted by the restored checkpoint
+    std::atomic<uint64_t>                 _events_;         //!< Number of events seen
+    uint64_t                              _stored_events_;  //!< Number of events of the last checkpoint
+    std::chrono::steady_clock::time_point _stored_time_;    //!< Time of the last checkpoint
+    std::mutex                            _store_mutex_;    //!< Serialization of the stores and owned names
+    std::set<std::string>                 _owned_;          //!< Names of the owned histograms
+  };
+
+  /// Start an event of a plot module with checkpoints and buffered fills
+  ///
+  /// Return true if the event is already counted by the restored
+  /// checkpoint and must be skipped. Otherwise, the values staged by the
+  /// calling thread are filled by flush_ before a due checkpoint of the
+  /// pool is stored, and every fill_buffer_size_ events counted by
+  /// buffered_events_ when the fills are buffered.
+  template <typename Flush>
+  bool begin_checkpointed_event(histogram_checkpoint & checkpoint_,
+                                const mygsl::histogram_pool & pool_,
+                                size_t fill_buffer_size_,
+                                size_t & buffered_events_,
+                                Flush flush_)
+  {
+    if (checkpoint_.is_enabled())
+      {
+        if (checkpoint_.begin_event()) return true;
+        if (checkpoint_.is_due())
+          {
+            flush_();
+            checkpoint_.store(pool_);
+          }
+      }
+    if (fill_buffer_size_ > 0 && ++buffered_events_ >= fill_buffer_size_)
+      {
+        flush_();
+        buffered_events_ = 0;
+      }
+    return false;
+  }
+
+} // namespace analysis
+
+#endif // ANALYSIS_HISTOGRAM_CHECKPOINT_H_
+
+// end of histogram_checkpoint.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,602 @@
+// histogram_filler.cc
+
+// Ourselves:
+#include <snemo/analysis/histogram_filler.h>
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+
+namespace analysis {
+
+  // Relative tolerance on the bin width to consider an axis as uniform.
+  const double UNIFORM_BINNING_TOLERANCE = 1e-9;
+
+  // Maximum number of staged values reserved up front.
+  const size_t MAX_RESERVED_STAGED_VALUES = 65536;
+
+  const size_t histogram_axis::INVALID_BIN;
+
+  histogram_axis::histogram_axis()
+  {
+    reset();
+    return;
+  }
+
+  void histogram_axis::initialize(const std::vector<double> & edges_)
+  {
+    DT_THROW_IF(edges_.size() < 2, std::logic_error, "Axis must have at least one bin !");
+    _edges_ = edges_;
+    const size_t n = _edges_.size() - 1;
+    _min_ = _edges_.front();
+    _max_ = _edges_.back();
+    const double width = (_max_ - _min_) / n;
+    _uniform_ = width > 0.0;
+    for (size_t i = 0; i < n && _uniform_; ++i)
+      {
+        const double a_width = _edges_[i + 1] - _edges_[i];
+        if (std::abs(a_width - width) > UNIFORM_BINNING_TOLERANCE * width) _uniform_ = false;
+      }
+    _inverse_width_ = _uniform_ ? 1.0 / width : 0.0;
+    return;
+  }
+
+  void histogram_axis::initialize(const mygsl::histogram_1d & histogram_)
+  {
+    std::vector<double> edges;
+    edges.reserve(histogram_.bins() + 1);
+    for (size_t i = 0; i < histogram_.bins(); ++i)
+      {
+        edges.push_back(histogram_.get_range(i).first);
+      }
+    edges.push_back(histogram_.get_range(histogram_.bins() - 1).second);
+    initialize(edges);
+    return;
+  }
+
+  void histogram_axis::initialize_x(const mygsl::histogram_2d & histogram_)
+  {
+    std::vector<double> edges;
+    edges.reserve(histogram_.xbins() + 1);
+    for (size_t i = 0; i < histogram_.xbins(); ++i)
+      {
+        edges.push_back(histogram_.get_x_range(i).first);
+      }
+    edges.push_back(histogram_.get_x_range(histogram_.xbins() - 1).second);
+    initialize(edges);
+    return;
+  }
+
+  void histogram_axis::initialize_y(const mygsl::histogram_2d & histogram_)
+  {
+    std::vector<double> edges;
+    edges.reserve(histogram_.ybins() + 1);
+    for (size_t j = 0; j < histogram_.ybins(); ++j)
+      {
+        edges.push_back(histogram_.get_y_range(j).first);
+      }
+    edges.push_back(histogram_.get_y_range(histogram_.ybins() - 1).second);
+    initialize(edges);
+    return;
+  }
+
+  void histogram_axis::reset()
+  {
+    _edges_.clear();
+    _uniform_ = false;
+    _min_ = 0.0;
+    _max_ = 0.0;
+    _inverse_width_ = 0.0;
+    return;
+  }
+
+  bool histogram_axis::is_initialized() const
+  {
+    return ! _edges_.empty();
+  }
+
+  bool histogram_axis::is_uniform() const
+  {
+    return _uniform_;
+  }
+
+  size_t histogram_axis::bins() const
+  {
+    return _edges_.empty() ? 0 : _edges_.size() - 1;
+  }
+
+  bool histogram_axis::find(double x_, size_t & bin_) const
+  {
+    if (_uniform_) return find_uniform(x_, bin_);
+    // Also rejects NaN values
+    if (_edges_.empty() || ! (x_ >= _min_ && x_ < _max_)) return false;
+    bin_ = std::upper_bound(_edges_.begin(), _edges_.end(), x_) - _edges_.begin() - 1;
+    return true;
+  }
+
+  const std::vector<double> & histogram_axis::get_edges() const
+  {
+    return _edges_;
+  }
+
+  // The fill counter of a mygsl histogram is only incremented by fill() and
+  // by the addition of another histogram. An empty histogram counting one
+  // zero weight fill is doubled as many times as needed, and is added to
+  // the target histogram for each bit set in the number of fills.
+  void add_fill_counts(mygsl::histogram_1d & histogram_, const histogram_axis & axis_, size_t counts_)
+  {
+    if (counts_ == 0) return;
+    const std::vector<double> & edges = axis_.get_edges();
+    mygsl::histogram_1d power(edges);
+    power.fill(0.5 * (edges[0] + edges[1]), 0.0);
+    for (size_t n = counts_; ; n >>= 1)
+      {
+        if (n & 1) histogram_ += power;
+        if (n <= 1) break;
+        power += power;
+      }
+    return;
+  }
+
+  void add_fill_counts(mygsl::histogram_2d & histogram_,
+                       const histogram_axis & x_axis_,
+                       const histogram_axis & y_axis_,
+                       size_t counts_)
+  {
+    if (counts_ == 0) return;
+    const std::vector<double> & x_edges = x_axis_.get_edges();
+    const std::vector<double> & y_edges = y_axis_.get_edges();
+    mygsl::histogram_2d power(x_edges, y_edges);
+    power.fill(0.5 * (x_edges[0] + x_edges[1]), 0.5 * (y_edges[0] + y_edges[1]), 0.0);
+    for (size_t n = counts_; ; n >>= 1)
+      {
+        if (n & 1) histogram_ += power;
+        if (n <= 1) break;
+        power += power;
+      }
+    return;
+  }
+
+  void update_contents_above(const mygsl::histogram_1d & histogram_,
+                             size_t first_,
+                             size_t last_,
+                             std::vector<double> & contents_,
+                             std::vector<double> & above_,
+                             std::vector<double> * scaled_above_,
+                             double scale_)
+  {
+    double running = 0.0;
+    for (size_t i = last_; i-- > 0;)
+      {
+        if (i >= first_)
+          {
+            const double content = histogram_.get(i);
+            running += content - contents_[i];
+            contents_[i] = content;
+          }
+        above_[i] += running;
+        if (scaled_above_) (*scaled_above_)[i] += running * scale_;
+      }
+    return;
+  }
+
+  void histogram_axis::find_uniform(const double * x_, size_t n_, size_t * bins_) const
+  {
+    if (! _uniform_)
+      {
+        for (size_t k = 0; k < n_; ++k) bins_[k] = INVALID_BIN;
+        return;
+      }
+    const size_t nbins = _edges_.size() - 1;
+    // First pass without data dependent branches, the range is checked on
+    // the values themselves as x - min may round up to max - min
+    for (size_t k = 0; k < n_; ++k)
+      {
+        const double u = (x_[k] - _min_) * _inverse_width_;
+        const bool inside = x_[k] >= _min_ && x_[k] < _max_;
+        const size_t i = static_cast<size_t>(inside ? u : 0.0);
+        bins_[k] = inside ? (i < nbins ? i : nbins - 1) : INVALID_BIN;
+      }
+    // Second pass to guard against rounding next to the bin edges
+    for (size_t k = 0; k < n_; ++k)
+      {
+        size_t & i = bins_[k];
+        if (i == INVALID_BIN) continue;
+        if (x_[k] < _edges_[i]) --i;
+        else if (x_[k] >= _edges_[i + 1]) ++i;
+      }
+    return;
+  }
+
+  histogram_filler_1d::histogram_filler_1d()
+  {
+    _histogram_ = 0;
+    _sumw2_ = 0;
+    _buffered_ = false;
+    _pending_fills_ = 0;
+    clear_dirty();
+    return;
+  }
+
+  void histogram_filler_1d::initialize(mygsl::histogram_1d & histogram_)
+  {
+    _histogram_ = &histogram_;
+    _axis_.initialize(histogram_);
+    return;
+  }
+
+  void histogram_filler_1d::reset()
+  {
+    _histogram_ = 0;
+    _sumw2_ = 0;
+    _axis_.reset();
+    _buffered_ = false;
+    _staged_x_.clear();
+    _staged_w_.clear();
+    _bins_.clear();
+    _contents_.clear();
+    _contents2_.clear();
+    _pending_fills_ = 0;
+    clear_dirty();
+    return;
+  }
+
+  bool histogram_filler_1d::is_initialized() const
+  {
+    return _histogram_ != 0;
+  }
+
+  mygsl::histogram_1d & histogram_filler_1d::grab_histogram()
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Filler is not initialized !");
+    return *_histogram_;
+  }
+
+  void histogram_filler_1d::set_sumw2(mygsl::histogram_1d & sumw2_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Filler is not initialized !");
+    DT_THROW_IF(sumw2_.bins() != _axis_.bins(), std::logic_error,
+                "Sum of squared weights histogram has not the same binning !");
+    flush();
+    _sumw2_ = &sumw2_;
+    return;
+  }
+
+  bool histogram_filler_1d::has_sumw2() const
+  {
+    return _sumw2_ != 0;
+  }
+
+  void histogram_filler_1d::set_buffered(bool buffered_, size_t capacity_)
+  {
+    if (! buffered_) flush();
+    _buffered_ = buffered_;
+    if (_buffered_) _staged_x_.reserve(std::min(capacity_, MAX_RESERVED_STAGED_VALUES));
+    return;
+  }
+
+  bool histogram_filler_1d::is_buffered() const
+  {
+    return _buffered_;
+  }
+
+  bool histogram_filler_1d::is_dirty() const
+  {
+    return _dirty_first_ < _dirty_last_;
+  }
+
+  size_t histogram_filler_1d::get_dirty_first() const
+  {
+    return _dirty_first_;
+  }
+
+  size_t histogram_filler_1d::get_dirty_last() const
+  {
+    return _dirty_last_;
+  }
+
+  void histogram_filler_1d::clear_dirty()
+  {
+    _dirty_first_ = std::numeric_limits<size_t>::max();
+    _dirty_last_ = 0;
+    return;
+  }
+
+  void histogram_filler_1d::_mark_dirty(size_t bin_)
+  {
+    if (bin_ == histogram_axis::INVALID_BIN)
+      {
+        _dirty_first_ = 0;
+        _dirty_last_ = _axis_.bins();
+        return;
+      }
+    _dirty_first_ = std::min(_dirty_first_, bin_);
+    _dirty_last_ = std::max(_dirty_last_, bin_ + 1);
+    return;
+  }
+
+  void histogram_filler_1d::flush()
+  {
+    if (_staged_x_.empty())
+      {
+        if (_pending_fills_ == 0) return;
+        add_fill_counts(*_histogram_, _axis_, _pending_fills_);
+        if (_sumw2_) add_fill_counts(*_sumw2_, _axis_, _pending_fills_);
+        _pending_fills_ = 0;
+        return;
+      }
+    const size_t n = _staged_x_.size();
+    const bool weighted = ! _staged_w_.empty();
+    _bins_.resize(n);
+    _axis_.find_uniform(&_staged_x_[0], n, &_bins_[0]);
+    for (size_t k = 0; k < n; ++k)
+      {
+        _mark_dirty(_bins_[k]);
+        if (_bins_[k] != histogram_axis::INVALID_BIN) ++_pending_fills_;
+      }
+
+    // Accumulate the in-range values on a copy of the bin contents
+    const size_t nbins = _axis_.bins();
+    _contents_.resize(nbins);
+    for (size_t i = 0; i < nbins; ++i) _contents_[i] = _histogram_->get(i);
+    if (_sumw2_)
+      {
+        _contents2_.resize(nbins);
+        for (size_t i = 0; i < nbins; ++i) _contents2_[i] = _sumw2_->get(i);
+      }
+    if (! weighted)
+      {
+        for (size_t k = 0; k < n; ++k)
+          {
+            const size_t i = _bins_[k];
+            if (i != histogram_axis::INVALID_BIN) _contents_[i] += 1.0;
+          }
+        if (_sumw2_)
+          {
+            for (size_t k = 0; k < n; ++k)
+              {
+                const size_t i = _bins_[k];
+                if (i != histogram_axis::INVALID_BIN) _contents2_[i] += 1.0;
+              }
+          }
+      }
+    else
+      {
+        const double * w = &_staged_w_[0];
+        for (size_t k = 0; k < n; ++k)
+          {
+            const size_t i = _bins_[k];
+            if (i != histogram_axis::INVALID_BIN) _contents_[i] += w[k];
+          }
+        if (_sumw2_)
+          {
+            for (size_t k = 0; k < n; ++k)
+              {
+                const size_t i = _bins_[k];
+                if (i != histogram_axis::INVALID_BIN) _contents2_[i] += w[k] * w[k];
+              }
+          }
+      }
+    for (size_t i = 0; i < nbins; ++i) _histogram_->set(i, _contents_[i]);
+    if (_sumw2_)
+      {
+        for (size_t i = 0; i < nbins; ++i) _sumw2_->set(i, _contents2_[i]);
+      }
+
+    // Generic bin search, underflow and overflow
+    for (size_t k = 0; k < n; ++k)
+      {
+        if (_bins_[k] != histogram_axis::INVALID_BIN) continue;
+        const double w = weighted ? _staged_w_[k] : 1.0;
+        _histogram_->fill(_staged_x_[k], w);
+        if (_sumw2_) _sumw2_->fill(_staged_x_[k], w * w);
+      }
+    _staged_x_.clear();
+    _staged_w_.clear();
+    add_fill_counts(*_histogram_, _axis_, _pending_fills_);
+    if (_sumw2_) add_fill_counts(*_sumw2_, _axis_, _pending_fills_);
+    _pending_fills_ = 0;
+    return;
+  }
+
+  void histogram_filler_1d::fill(double x_)
+  {
+    if (_buffered_)
+      {
+        _staged_x_.push_back(x_);
+        if (! _staged_w_.empty()) _staged_w_.push_back(1.0);
+        return;
+      }
+    size_t i;
+    const bool found = _axis_.find_uniform(x_, i);
+    _mark_dirty(found ? i : histogram_axis::INVALID_BIN);
+    if (found)
+      {
+        _histogram_->set(i, _histogram_->get(i) + 1.0);
+        if (_sumw2_) _sumw2_->set(i, _sumw2_->get(i) + 1.0);
+        ++_pending_fills_;
+        return;
+      }
+    // Generic bin search, underflow and overflow
+    _histogram_->fill(x_);
+    if (_sumw2_) _sumw2_->fill(x_);
+    return;
+  }
+
+  void histogram_filler_1d::fill(double x_, double weight_)
+  {
+    if (_buffered_)
+      {
+        // Unit weights staged so far are made explicit on the first weighted value
+        if (_staged_w_.empty())
+          {
+            _staged_w_.reserve(_staged_x_.capacity());
+            _staged_w_.assign(_staged_x_.size(), 1.0);
+          }
+        _staged_x_.push_back(x_);
+        _staged_w_.push_back(weight_);
+        return;
+      }
+    size_t i;
+    const bool found = _axis_.find_uniform(x_, i);
+    _mark_dirty(found ? i : histogram_axis::INVALID_BIN);
+    if (found)
+      {
+        _histogram_->set(i, _histogram_->get(i) + weight_);
+        if (_sumw2_) _sumw2_->set(i, _sumw2_->get(i) + weight_ * weight_);
+        ++_pending_fills_;
+        return;
+      }
+    // Generic bin search, underflow and overflow
+    _histogram_->fill(x_, weight_);
+    if (_sumw2_) _sumw2_->fill(x_, weight_ * weight_);
+    return;
+  }
+
+  histogram_filler_2d::histogram_filler_2d()
+  {
+    _histogram_ = 0;
+    _buffered_ = false;
+    _pending_fills_ = 0;
+    return;
+  }
+
+  void histogram_filler_2d::initialize(mygsl::histogram_2d & histogram_)
+  {
+    _histogram_ = &histogram_;
+    _x_axis_.initialize_x(histogram_);
+    _y_axis_.initialize_y(histogram_);
+    return;
+  }
+
+  void histogram_filler_2d::reset()
+  {
+    _histogram_ = 0;
+    _x_axis_.reset();
+    _y_axis_.reset();
+    _buffered_ = false;
+    _staged_x_.clear();
+    _staged_y_.clear();
+    _x_bins_.clear();
+    _y_bins_.clear();
+    _contents_.clear();
+    _pending_fills_ = 0;
+    return;
+  }
+
+  bool histogram_filler_2d::is_initialized() const
+  {
+    return _histogram_ != 0;
+  }
+
+  mygsl::histogram_2d & histogram_filler_2d::grab_histogram()
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Filler is not initialized !");
+    return *_histogram_;
+  }
+
+  void histogram_filler_2d::set_buffered(bool buffered_, size_t capacity_)
+  {
+    if (! buffered_) flush();
+    _buffered_ = buffered_;
+    if (_buffered_)
+      {
+        _staged_x_.reserve(std::min(capacity_, MAX_RESERVED_STAGED_VALUES));
+        _staged_y_.reserve(std::min(capacity_, MAX_RESERVED_STAGED_VALUES));
+      }
+    return;
+  }
+
+  bool histogram_filler_2d::is_buffered() const
+  {
+    return _buffered_;
+  }
+
+  void histogram_filler_2d::flush()
+  {
+    if (_staged_x_.empty())
+      {
+        if (_pending_fills_ == 0) return;
+        add_fill_counts(*_histogram_, _x_axis_, _y_axis_, _pending_fills_);
+        _pending_fills_ = 0;
+        return;
+      }
+    const size_t n = _staged_x_.size();
+    _x_bins_.resize(n);
+    _y_bins_.resize(n);
+    _x_axis_.find_uniform(&_staged_x_[0], n, &_x_bins_[0]);
+    _y_axis_.find_uniform(&_staged_y_[0], n, &_y_bins_[0]);
+
+    // Accumulate the in-range values on a copy of the bin contents
+    const size_t nx = _x_axis_.bins();
+    const size_t ny = _y_axis_.bins();
+    _contents_.resize(nx * ny);
+    for (size_t i = 0; i < nx; ++i)
+      for (size_t j = 0; j < ny; ++j)
+        _contents_[i * ny + j] = _histogram_->get(i, j);
+    for (size_t k = 0; k < n; ++k)
+      {
+        const size_t i = _x_bins_[k];
+        const size_t j = _y_bins_[k];
+        if (i != histogram_axis::INVALID_BIN && j != histogram_axis::INVALID_BIN)
+          {
+            _contents_[i * ny + j] += 1.0;
+            ++_pending_fills_;
+          }
+      }
+    for (size_t i = 0; i < nx; ++i)
+      for (size_t j = 0; j < ny; ++j)
+        _histogram_->set(i, j, _contents_[i * ny + j]);
+
+    // Generic bin search, underflow and overflow
+    for (size_t k = 0; k < n; ++k)
+      {
+        if (_x_bins_[k] == histogram_axis::INVALID_BIN || _y_bins_[k] == histogram_axis::INVALID_BIN)
+          _histogram_->fill(_staged_x_[k], _staged_y_[k]);
+      }
+    _staged_x_.clear();
+    _staged_y_.clear();
+    add_fill_counts(*_histogram_, _x_axis_, _y_axis_, _pending_fills_);
+    _pending_fills_ = 0;
+    return;
+  }
+
+  void histogram_filler_2d::fill(double x_, double y_)
+  {
+    if (_buffered_)
+      {
+        _staged_x_.push_back(x_);
+        _staged_y_.push_back(y_);
+        return;
+      }
+    size_t i, j;
+    if (_x_axis_.find_uniform(x_, i) && _y_axis_.find_uniform(y_, j))
+      {
+        _histogram_->set(i, j, _histogram_->get(i, j) + 1.0);
+        ++_pending_fills_;
+        return;
+      }
+    // Generic bin search, underflow and overflow
+    _histogram_->fill(x_, y_);
+    return;
+  }
+
+} // namespace analysis
+
+// end of histogram_filler.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
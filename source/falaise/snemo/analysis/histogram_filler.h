@@ -0,0 +1,280 @@
+/* histogram_filler.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Fill helpers for the mygsl histograms created from the pool templates.
+ * The bin lookup of uniformly binned axes is done with a single multiply
+ * and falls back to the generic histogram fill otherwise. Values can be
+ * staged in a buffer and binned in bulk when the buffer is flushed.
+ * Weighted 1D fills can also accumulate the sum of squared weights in a
+ * sibling histogram with the same binning. In-range values are added to
+ * the bins directly, their number is added to the fill counter of the
+ * mygsl histogram when the filler is flushed, so that a flushed histogram
+ * is the same as one filled value by value.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_HISTOGRAM_FILLER_H_
+#define ANALYSIS_HISTOGRAM_FILLER_H_ 1
+
+// Standard libraries:
+#include <cstddef>
+#include <vector>
+
+namespace mygsl {
+  class histogram;
+  typedef histogram histogram_1d;
+  class histogram_2d;
+}
+
+namespace analysis {
+
+  /// \brief Bin lookup of a histogram axis
+  class histogram_axis
+  {
+  public:
+
+    /// Constructor
+    histogram_axis();
+
+    /// Initialize from the bin edges
+    void initialize(const std::vector<double> & edges_);
+
+    /// Initialize from the binning of a 1D histogram
+    void initialize(const mygsl::histogram_1d & histogram_);
+
+    /// Initialize from the X binning of a 2D histogram
+    void initialize_x(const mygsl::histogram_2d & histogram_);
+
+    /// Initialize from the Y binning of a 2D histogram
+    void initialize_y(const mygsl::histogram_2d & histogram_);
+
+    /// Reset
+    void reset();
+
+    /// Check if the axis has been initialized
+    bool is_initialized() const;
+
+    /// Check if all bins have the same width
+    bool is_uniform() const;
+
+    /// Return the number of bins
+    size_t bins() const;
+
+    /// Find the bin of a value of any axis, return false if out of range
+    bool find(double x_, size_t & bin_) const;
+
+    /// Find the bin of a value of a uniform axis, return false if out of range
+    bool find_uniform(double x_, size_t & bin_) const;
+
+    /// Find the bins of a set of values of a uniform axis, out of range values get INVALID_BIN
+    void find_uniform(const double * x_, size_t n_, size_t * bins_) const;
+
+    /// Return the bin edges
+    const std::vector<double> & get_edges() const;
+
+    /// Bin index of values outside of the axis range
+    static const size_t INVALID_BIN = static_cast<size_t>(-1);
+
+  private:
+
+    std::vector<double> _edges_;  //!< Bin edges
+    bool   _uniform_;             //!< Uniform binning flag
+    double _min_;                 //!< Lower edge
+    double _max_;                 //!< Upper edge
+    double _inverse_width_;       //!< Inverse of the bin width
+  };
+
+  /// \brief Fill helper of a 1D histogram
+  class histogram_filler_1d
+  {
+  public:
+
+    /// Constructor
+    histogram_filler_1d();
+
+    /// Initialize the filler for a given histogram
+    void initialize(mygsl::histogram_1d & histogram_);
+
+    /// Reset
+    void reset();
+
+    /// Check if the filler has been initialized
+    bool is_initialized() const;
+
+    /// Return the filled histogram
+    mygsl::histogram_1d & grab_histogram();
+
+    /// Set the histogram receiving the sum of squared weights
+    void set_sumw2(mygsl::histogram_1d & sumw2_);
+
+    /// Check if the sum of squared weights is accumulated
+    bool has_sumw2() const;
+
+    /// Set the buffered mode with a hint on the number of staged values
+    void set_buffered(bool buffered_, size_t capacity_ = 0);
+
+    /// Check the buffered mode
+    bool is_buffered() const;
+
+    /// Fill a value
+    void fill(double x_);
+
+    /// Fill a weighted value
+    void fill(double x_, double weight_);
+
+    /// Fill the histogram with the staged values and update its fill counter
+    void flush();
+
+    /// Check if bins have been filled since the last call to clear_dirty()
+    bool is_dirty() const;
+
+    /// Return the first bin filled since the last call to clear_dirty()
+    size_t get_dirty_first() const;
+
+    /// Return the bin following the last bin filled since the last call to clear_dirty()
+    size_t get_dirty_last() const;
+
+    /// Forget the filled bins
+    void clear_dirty();
+
+  private:
+
+    /// Record a filled bin, an invalid bin marks the whole histogram
+    void _mark_dirty(size_t bin_);
+
+  private:
+
+    mygsl::histogram_1d * _histogram_; //!< Handle to the filled histogram
+    mygsl::histogram_1d * _sumw2_;     //!< Handle to the sum of squared weights histogram
+    histogram_axis        _axis_;      //!< Binning of the histogram
+    bool                  _buffered_;  //!< Buffered mode flag
+    std::vector<double>   _staged_x_;  //!< Staged values
+    std::vector<double>   _staged_w_;  //!< Staged weights, empty while all weights are one
+    std::vector<size_t>   _bins_;      //!< Working buffer for bin indexes
+    std::vector<double>   _contents_;  //!< Working buffer for bin contents
+    std::vector<double>   _contents2_; //!< Working buffer for sum of squared weights
+    size_t                _dirty_first_; //!< First bin filled since the last clear
+    size_t                _dirty_last_;  //!< Bin following the last bin filled since the last clear
+    size_t                _pending_fills_; //!< In-range values not yet added to the fill counter
+  };
+
+  /// \brief Fill helper of a 2D histogram
+  class histogram_filler_2d
+  {
+  public:
+
+    /// Constructor
+    histogram_filler_2d();
+
+    /// Initialize the filler for a given histogram
+    void initialize(mygsl::histogram_2d & histogram_);
+
+    /// Reset
+    void reset();
+
+    /// Check if the filler has been initialized
+    bool is_initialized() const;
+
+    /// Return the filled histogram
+    mygsl::histogram_2d & grab_histogram();
+
+    /// Set the buffered mode with a hint on the number of staged values
+    void set_buffered(bool buffered_, size_t capacity_ = 0);
+
+    /// Check the buffered mode
+    bool is_buffered() const;
+
+    /// Fill a pair of values
+    void fill(double x_, double y_);
+
+    /// Fill the histogram with the staged values and update its fill counter
+    void flush();
+
+  private:
+
+    mygsl::histogram_2d * _histogram_; //!< Handle to the filled histogram
+    histogram_axis        _x_axis_;    //!< Binning of the X axis
+    histogram_axis        _y_axis_;    //!< Binning of the Y axis
+    bool                  _buffered_;  //!< Buffered mode flag
+    std::vector<double>   _staged_x_;  //!< Staged X values
+    std::vector<double>   _staged_y_;  //!< Staged Y values
+    std::vector<size_t>   _x_bins_;    //!< Working buffer for X bin indexes
+    std::vector<size_t>   _y_bins_;    //!< Working buffer for Y bin indexes
+    std::vector<double>   _contents_;  //!< Working buffer for bin contents
+    size_t                _pending_fills_; //!< In-range values not yet added to the fill counter
+  };
+
+  /// Add fills to the fill counter of a 1D histogram without changing its contents
+  void add_fill_counts(mygsl::histogram_1d & histogram_, const histogram_axis & axis_, size_t counts_);
+
+  /// Add fills to the fill counter of a 2D histogram without changing its contents
+  void add_fill_counts(mygsl::histogram_2d & histogram_,
+                       const histogram_axis & x_axis_,
+                       const histogram_axis & y_axis_,
+                       size_t counts_);
+
+  /// Update the sums of the contents above each bin of a histogram whose bins [first_, last_) changed
+  ///
+  /// contents_ holds the bin contents of the previous update and above_
+  /// the sums of the contents from each bin to the last one. The bins from
+  /// last_ are unchanged, so only the first last_ sums are updated. When
+  /// scaled_above_ is not null, the changes of the sums scaled by scale_
+  /// are also added to it.
+  void update_contents_above(const mygsl::histogram_1d & histogram_,
+                             size_t first_,
+                             size_t last_,
+                             std::vector<double> & contents_,
+                             std::vector<double> & above_,
+                             std::vector<double> * scaled_above_ = 0,
+                             double scale_ = 1.0);
+
+  inline bool histogram_axis::find_uniform(double x_, size_t & bin_) const
+  {
+    // Also rejects NaN values
+    if (! _uniform_ || ! (x_ >= _min_ && x_ < _max_)) return false;
+    size_t i = static_cast<size_t>((x_ - _min_) * _inverse_width_);
+    const size_t n = _edges_.size() - 1;
+    if (i >= n) i = n - 1;
+    // Guard against rounding next to the bin edges
+    if (x_ < _edges_[i]) --i;
+    else if (x_ >= _edges_[i + 1]) ++i;
+    bin_ = i;
+    return true;
+  }
+
+} // namespace analysis
+
+#endif // ANALYSIS_HISTOGRAM_FILLER_H_
+
+// end of histogram_filler.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
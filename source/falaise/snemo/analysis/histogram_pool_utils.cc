@@ -0,0 +1,346 @@
+// histogram_pool_utils.cc
+
+// Ourselves:
+#include <snemo/analysis/histogram_pool_utils.h>
+
+// Standard library:
+#include <string>
+#include <vector>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+#include <datatools/properties.h>
+#include <datatools/io_factory.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/parallel_for.h>
+
+namespace analysis {
+
+  namespace {
+
+    // Relative tolerance on the real auxiliaries of merged histograms.
+    const double AUXILIARY_TOLERANCE = 1e-12;
+
+    // Global weight of the contents of a histogram.
+    double global_weight(const datatools::properties & auxiliaries_)
+    {
+      if (auxiliaries_.has_key("weight")) return auxiliaries_.fetch_real("weight");
+      return 1.0;
+    }
+
+    bool same_real(double a_, double b_)
+    {
+      return std::abs(a_ - b_) <= AUXILIARY_TOLERANCE * std::max(std::abs(a_), std::abs(b_));
+    }
+
+    // Add the auxiliaries of a source histogram missing from a target one,
+    // and check that the auxiliaries found in both have the same values.
+    // The weight auxiliaries are handled by add_histogram.
+    void merge_auxiliaries(datatools::properties & target_,
+                           const datatools::properties & source_,
+                           const std::string & name_)
+    {
+      std::vector<std::string> keys;
+      source_.keys(keys);
+      for (size_t i = 0; i < keys.size(); ++i)
+        {
+          const std::string & a_key = keys[i];
+          if (a_key == "weight" || a_key == "weighted") continue;
+          DT_THROW_IF(source_.is_vector(a_key), std::logic_error,
+                      "Histogram '" << name_ << "' has vector auxiliary '" << a_key << "' !");
+          if (! target_.has_key(a_key))
+            {
+              if      (source_.is_boolean(a_key)) target_.update(a_key, source_.fetch_boolean(a_key));
+              else if (source_.is_integer(a_key)) target_.update(a_key, source_.fetch_integer(a_key));
+              else if (source_.is_real(a_key))    target_.update(a_key, source_.fetch_real(a_key));
+              else if (source_.is_string(a_key))  target_.update_string(a_key, source_.fetch_string(a_key));
+              continue;
+            }
+          bool same = false;
+          if (source_.is_boolean(a_key) && target_.is_boolean(a_key))
+            {
+              same = source_.fetch_boolean(a_key) == target_.fetch_boolean(a_key);
+            }
+          else if (source_.is_integer(a_key) && target_.is_integer(a_key))
+            {
+              same = source_.fetch_integer(a_key) == target_.fetch_integer(a_key);
+            }
+          else if (source_.is_real(a_key) && target_.is_real(a_key))
+            {
+              same = same_real(source_.fetch_real(a_key), target_.fetch_real(a_key));
+            }
+          else if (source_.is_string(a_key) && target_.is_string(a_key))
+            {
+              same = source_.fetch_string(a_key) == target_.fetch_string(a_key);
+            }
+          DT_THROW_IF(! same, std::logic_error,
+                      "Histogram '" << name_ << "' has conflicting '" << a_key << "' auxiliaries !");
+        }
+      return;
+    }
+
+    // Add a source histogram to a target one. Contents with different
+    // global weights cannot share a single 'weight' auxiliary: the weights
+    // are then applied to the contents, which become 'weighted'.
+    template <class Histogram>
+    void add_histogram(Histogram & target_,
+                       const Histogram & source_,
+                       const std::string & name_)
+    {
+      datatools::properties & target_aux = target_.grab_auxiliaries();
+      const datatools::properties & source_aux = source_.get_auxiliaries();
+      merge_auxiliaries(target_aux, source_aux, name_);
+      const bool target_weighted = target_aux.has_key("weighted");
+      const bool source_weighted = source_aux.has_key("weighted");
+      const double target_weight = target_weighted ? 1.0 : global_weight(target_aux);
+      const double source_weight = source_weighted ? 1.0 : global_weight(source_aux);
+      if (target_weighted == source_weighted && same_real(target_weight, source_weight))
+        {
+          if (! target_aux.has_key("weight") && source_aux.has_key("weight"))
+            {
+              target_aux.update("weight", source_weight);
+            }
+          target_ += source_;
+          return;
+        }
+      if (target_weight != 1.0) target_ *= target_weight;
+      if (source_weight != 1.0)
+        {
+          Histogram scaled(source_);
+          scaled *= source_weight;
+          target_ += scaled;
+        }
+      else
+        {
+          target_ += source_;
+        }
+      target_aux.erase("weight");
+      target_aux.update("weighted", true);
+      return;
+    }
+
+    bool is_skipped(const std::string & group_,
+                    const std::vector<std::string> & skipped_groups_)
+    {
+      return std::find(skipped_groups_.begin(), skipped_groups_.end(), group_) != skipped_groups_.end();
+    }
+
+    // Order of the global weights: weighted contents first, then by weight.
+    int compare_weights(const datatools::properties & a_, const datatools::properties & b_)
+    {
+      const bool a_weighted = a_.has_key("weighted");
+      const bool b_weighted = b_.has_key("weighted");
+      if (a_weighted != b_weighted) return a_weighted ? -1 : +1;
+      if (a_weighted) return 0;
+      const double a_weight = global_weight(a_);
+      const double b_weight = global_weight(b_);
+      if (a_weight != b_weight) return a_weight < b_weight ? -1 : +1;
+      return 0;
+    }
+
+    // Order of 1D histograms on their bin contents, then on their global weight.
+    bool precedes(const mygsl::histogram_1d & a_, const mygsl::histogram_1d & b_)
+    {
+      const size_t nbins = std::min(a_.bins(), b_.bins());
+      for (size_t i = 0; i < nbins; ++i)
+        {
+          const double a_content = a_.get(i);
+          const double b_content = b_.get(i);
+          if (a_content != b_content) return a_content < b_content;
+        }
+      return compare_weights(a_.get_auxiliaries(), b_.get_auxiliaries()) < 0;
+    }
+
+    // Order of 2D histograms on their bin contents, then on their global weight.
+    bool precedes(const mygsl::histogram_2d & a_, const mygsl::histogram_2d & b_)
+    {
+      const size_t nx = std::min(a_.xbins(), b_.xbins());
+      const size_t ny = std::min(a_.ybins(), b_.ybins());
+      for (size_t i = 0; i < nx; ++i)
+        for (size_t j = 0; j < ny; ++j)
+          {
+            const double a_content = a_.get(i, j);
+            const double b_content = b_.get(i, j);
+            if (a_content != b_content) return a_content < b_content;
+          }
+      return compare_weights(a_.get_auxiliaries(), b_.get_auxiliaries()) < 0;
+    }
+
+    // Add a histogram of a source pool to a target pool.
+    void merge_histogram(mygsl::histogram_pool & target_,
+                         const mygsl::histogram_pool & source_,
+                         const std::string & name_)
+    {
+      if (source_.has_1d(name_))
+        {
+          const mygsl::histogram_1d & a_histogram = source_.get_1d(name_);
+          if (target_.has_1d(name_))
+            {
+              add_histogram(target_.grab_1d(name_), a_histogram, name_);
+              return;
+            }
+          DT_THROW_IF(target_.has(name_), std::logic_error,
+                      "Histogram '" << name_ << "' is not 1D histogram !");
+          mygsl::histogram_1d & h = target_.add_1d(name_,
+                                                   source_.get_title(name_),
+                                                   source_.get_group(name_));
+          h = a_histogram;
+        }
+      else if (source_.has_2d(name_))
+        {
+          const mygsl::histogram_2d & a_histogram = source_.get_2d(name_);
+          if (target_.has_2d(name_))
+            {
+              add_histogram(target_.grab_2d(name_), a_histogram, name_);
+              return;
+            }
+          DT_THROW_IF(target_.has(name_), std::logic_error,
+                      "Histogram '" << name_ << "' is not 2D histogram !");
+          mygsl::histogram_2d & h = target_.add_2d(name_,
+                                                   source_.get_title(name_),
+                                                   source_.get_group(name_));
+          h = a_histogram;
+        }
+      return;
+    }
+
+    // Order of the source pools of a histogram on the contents of this histogram.
+    struct histogram_precedes
+    {
+      const std::string * name;
+
+      bool operator()(const mygsl::histogram_pool * a_, const mygsl::histogram_pool * b_) const
+      {
+        if (a_->has_1d(*name)) return precedes(a_->get_1d(*name), b_->get_1d(*name));
+        return precedes(a_->get_2d(*name), b_->get_2d(*name));
+      }
+    };
+
+  } // namespace
+
+  void merge_histogram_pool(mygsl::histogram_pool & target_,
+                            const mygsl::histogram_pool & source_,
+                            const std::vector<std::string> & skipped_groups_)
+  {
+    std::vector<std::string> hnames;
+    source_.names(hnames);
+    std::sort(hnames.begin(), hnames.end());
+    for (std::vector<std::string>::const_iterator iname = hnames.begin();
+         iname != hnames.end(); ++iname)
+      {
+        const std::string & a_name = *iname;
+        if (is_skipped(source_.get_group(a_name), skipped_groups_)) continue;
+        merge_histogram(target_, source_, a_name);
+      }
+    return;
+  }
+
+  void merge_histogram_pools(mygsl::histogram_pool & target_,
+                             const std::vector<const mygsl::histogram_pool *> & sources_,
+                             const std::vector<std::string> & skipped_groups_)
+  {
+    std::vector<std::string> hnames;
+    for (size_t s = 0; s < sources_.size(); ++s)
+      {
+        std::vector<std::string> some_names;
+        sources_[s]->names(some_names);
+        hnames.insert(hnames.end(), some_names.begin(), some_names.end());
+      }
+    std::sort(hnames.begin(), hnames.end());
+    hnames.erase(std::unique(hnames.begin(), hnames.end()), hnames.end());
+    std::vector<const mygsl::histogram_pool *> owners;
+    for (std::vector<std::string>::const_iterator iname = hnames.begin();
+         iname != hnames.end(); ++iname)
+      {
+        const std::string & a_name = *iname;
+        owners.clear();
+        for (size_t s = 0; s < sources_.size(); ++s)
+          {
+            const mygsl::histogram_pool & a_source = *sources_[s];
+            if (! a_source.has(a_name) || is_skipped(a_source.get_group(a_name), skipped_groups_)) continue;
+            DT_THROW_IF(! owners.empty() && owners.front()->has_1d(a_name) != a_source.has_1d(a_name),
+                        std::logic_error,
+                        "Histogram '" << a_name << "' has not the same dimension in all the pools !");
+            owners.push_back(&a_source);
+          }
+        // The sum must not depend on the order of the sources
+        const histogram_precedes order = { &a_name };
+        std::sort(owners.begin(), owners.end(), order);
+        for (size_t s = 0; s < owners.size(); ++s)
+          {
+            merge_histogram(target_, *owners[s], a_name);
+          }
+      }
+    return;
+  }
+
+  void reduce_histogram_pools(const std::vector<mygsl::histogram_pool *> & pools_,
+                              size_t number_of_threads_,
+                              const std::vector<std::string> & skipped_groups_)
+  {
+    const size_t npools = pools_.size();
+    for (size_t stride = 1; stride < npools; stride *= 2)
+      {
+        // Pool 2*stride*i receives pool 2*stride*i + stride :
+        const size_t npairs = (npools - stride + 2 * stride - 1) / (2 * stride);
+        parallel_for(npairs, number_of_threads_, [&pools_, &skipped_groups_, stride](size_t first_, size_t last_)
+          {
+            for (size_t i = first_; i < last_; ++i)
+              {
+                const size_t target = 2 * stride * i;
+                merge_histogram_pool(*pools_[target], *pools_[target + stride], skipped_groups_);
+              }
+          });
+      }
+    return;
+  }
+
+  void merge_histogram_files(mygsl::histogram_pool & target_,
+                             const std::vector<std::string> & files_,
+                             size_t number_of_threads_,
+                             const std::vector<std::string> & skipped_groups_)
+  {
+    // The Boost archives are loaded by a single thread, since the
+    // serialization singletons of the archives are not thread safe. The
+    // files are loaded in batches of one pool per thread, each batch being
+    // reduced concurrently into the target pool.
+    const size_t nfiles = files_.size();
+    const size_t batch_size = std::max<size_t>(1, number_of_threads_);
+    for (size_t first = 0; first < nfiles; first += batch_size)
+      {
+        const size_t last = std::min(nfiles, first + batch_size);
+        std::vector<std::unique_ptr<mygsl::histogram_pool> > batch;
+        std::vector<mygsl::histogram_pool *> pools;
+        pools.push_back(&target_);
+        for (size_t f = first; f < last; ++f)
+          {
+            batch.push_back(std::unique_ptr<mygsl::histogram_pool>(new mygsl::histogram_pool));
+            datatools::data_reader reader(files_[f], datatools::using_multiple_archives);
+            DT_THROW_IF(! reader.has_record_tag(), std::logic_error,
+                        "File '" << files_[f] << "' has no histogram pool !");
+            reader.load(*batch.back());
+            pools.push_back(batch.back().get());
+          }
+        reduce_histogram_pools(pools, number_of_threads_, skipped_groups_);
+      }
+    return;
+  }
+
+} // namespace analysis
+
+// end of histogram_pool_utils.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
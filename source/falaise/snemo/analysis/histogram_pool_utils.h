@@ -0,0 +1,104 @@
+/* histogram_pool_utils.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Utilities to combine the histograms of several pools.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_HISTOGRAM_POOL_UTILS_H_
+#define ANALYSIS_HISTOGRAM_POOL_UTILS_H_ 1
+
+// Standard library:
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace mygsl {
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  /// Add the histograms of a source pool to a target pool
+  ///
+  /// Histograms are processed in name order and the ones belonging to
+  /// skipped_groups_, as the histograms computed from the other ones,
+  /// are ignored. Histograms missing from the target pool are registered
+  /// with the title, group and auxiliaries of the source ones. For the
+  /// other ones, the auxiliaries missing from the target histogram are
+  /// copied and the ones found in both histograms must have the same
+  /// values.
+  ///
+  /// The 'weight' and 'weighted' auxiliaries are not compared: when the
+  /// two histograms do not have the same global 'weight' (1 by default),
+  /// or when only one of them has 'weighted' contents, each contents are
+  /// scaled by their global weight and the sum is tagged 'weighted'.
+  void merge_histogram_pool(mygsl::histogram_pool & target_,
+                            const mygsl::histogram_pool & source_,
+                            const std::vector<std::string> & skipped_groups_ = std::vector<std::string>());
+
+  /// Add the histograms of a set of source pools to a target pool
+  ///
+  /// The histograms are merged as with merge_histogram_pool, the ones of
+  /// a given name being added in the order of their bin contents and
+  /// global weights. The sums do not depend on the order of the sources,
+  /// such as the per-thread shards of a module.
+  void merge_histogram_pools(mygsl::histogram_pool & target_,
+                             const std::vector<const mygsl::histogram_pool *> & sources_,
+                             const std::vector<std::string> & skipped_groups_ = std::vector<std::string>());
+
+  /// Add the histograms of all the pools into the first one
+  ///
+  /// The pools are summed pairwise in a tree, the pairs of each level
+  /// being merged concurrently by at most number_of_threads_ threads. The
+  /// order of the additions only depends on the number of pools.
+  void reduce_histogram_pools(const std::vector<mygsl::histogram_pool *> & pools_,
+                              size_t number_of_threads_,
+                              const std::vector<std::string> & skipped_groups_ = std::vector<std::string>());
+
+  /// Add the histogram pools stored in files to a target pool
+  ///
+  /// The files are loaded serially in batches of number_of_threads_
+  /// pools, and each batch is reduced into the target pool with
+  /// reduce_histogram_pools.
+  void merge_histogram_files(mygsl::histogram_pool & target_,
+                             const std::vector<std::string> & files_,
+                             size_t number_of_threads_,
+                             const std::vector<std::string> & skipped_groups_ = std::vector<std::string>());
+
+} // namespace analysis
+
+#endif // ANALYSIS_HISTOGRAM_POOL_UTILS_H_
+
+// end of histogram_pool_utils.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
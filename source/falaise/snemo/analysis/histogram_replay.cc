@@ -0,0 +1,792 @@
+// histogram_replay.cc
+
+// Ourselves:
+#include <snemo/analysis/histogram_replay.h>
+
+// This project:
+#include <snemo/analysis/feature_cache.h>
+#include <snemo/analysis/feature_extraction_module.h>
+#include <snemo/analysis/parallel_for.h>
+
+// Standard library:
+#include <map>
+#include <cmath>
+#include <mutex>
+#include <cstring>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+#include <mygsl/histogram_pool.h>
+
+namespace analysis {
+
+  namespace {
+
+    // Auxiliary property stored into a replayed histogram.
+    enum replay_auxiliary_type
+      {
+        REPLAY_AUX_NONE = 0,     // No auxiliary property
+        REPLAY_AUX_RULE_WEIGHT,  // Rule weight of the events, as universal_plot_module
+        REPLAY_AUX_WEIGHTED,     // Flag of weighted contents, as universal_plot_module
+        REPLAY_AUX_UNIT_WEIGHT   // Unit weight, as halflife_limit_module
+      };
+
+    // Value out of the bins of a replayed histogram.
+    struct replay_outlier
+    {
+      double x;
+      double y;
+      double weight;
+    };
+
+    // Private bins of a replayed histogram.
+    struct replay_accumulator
+    {
+      std::string                 group;
+      std::string                 template_name;
+      replay_auxiliary_type       auxiliary;
+      const histogram_axis *      x_axis;
+      const histogram_axis *      y_axis;
+      std::vector<double>         contents;
+      size_t                      fills;
+      std::vector<replay_outlier> outliers;
+      bool                        has_weight;
+      double                      weight;
+
+      void fill(double x_, double weight_)
+      {
+        size_t i;
+        if (x_axis->find(x_, i))
+          {
+            contents[i] += weight_;
+            ++fills;
+          }
+        else
+          {
+            const replay_outlier an_outlier = { x_, 0.0, weight_ };
+            outliers.push_back(an_outlier);
+          }
+        return;
+      }
+
+      void fill(double x_, double y_, double weight_)
+      {
+        size_t i, j;
+        if (x_axis->find(x_, i) && y_axis->find(y_, j))
+          {
+            contents[i * y_axis->bins() + j] += weight_;
+            ++fills;
+          }
+        else
+          {
+            const replay_outlier an_outlier = { x_, y_, weight_ };
+            outliers.push_back(an_outlier);
+          }
+        return;
+      }
+
+      // Record the rule weight of an event, return false if it differs from the previous ones
+      bool set_weight(double weight_)
+      {
+        if (! has_weight)
+          {
+            has_weight = true;
+            weight = weight_;
+          }
+        return weight == weight_;
+      }
+
+      // Add another accumulator, return false if the rule weights differ
+      bool merge(const replay_accumulator & other_)
+      {
+        for (size_t k = 0; k < contents.size(); ++k) contents[k] += other_.contents[k];
+        fills += other_.fills;
+        outliers.insert(outliers.end(), other_.outliers.begin(), other_.outliers.end());
+        return ! other_.has_weight || set_weight(other_.weight);
+      }
+    };
+
+    // Accumulators of a replay thread indexed by histogram name.
+    typedef std::map<std::string, replay_accumulator> replay_accumulator_dict;
+
+    // Return the accumulator of a histogram, creating it if needed.
+    replay_accumulator & grab_accumulator(replay_accumulator_dict & accumulators_,
+                                          const std::string & name_,
+                                          const std::string & group_,
+                                          const std::string & template_name_,
+                                          replay_auxiliary_type auxiliary_,
+                                          const histogram_axis * x_axis_,
+                                          const histogram_axis * y_axis_ = 0)
+    {
+      replay_accumulator_dict::iterator found = accumulators_.find(name_);
+      if (found != accumulators_.end()) return found->second;
+      replay_accumulator & an_accumulator = accumulators_[name_];
+      an_accumulator.group = group_;
+      an_accumulator.template_name = template_name_;
+      an_accumulator.auxiliary = auxiliary_;
+      an_accumulator.x_axis = x_axis_;
+      an_accumulator.y_axis = y_axis_;
+      an_accumulator.contents.assign(x_axis_->bins() * (y_axis_ ? y_axis_->bins() : 1), 0.0);
+      an_accumulator.fills = 0;
+      an_accumulator.has_weight = false;
+      an_accumulator.weight = 1.0;
+      return an_accumulator;
+    }
+
+    // Append the identifiers of the key columns of a row to a compact tuple.
+    void append_key_tuple(std::string & tuple_,
+                                 const std::vector<const int32_t *> & key_columns_, size_t row_)
+    {
+      for (size_t k = 0; k < key_columns_.size(); ++k)
+        {
+          tuple_.append(reinterpret_cast<const char *>(&key_columns_[k][row_]), sizeof(int32_t));
+        }
+      return;
+    }
+
+    // Build the key prefix of a histogram name as key_field_plan::build_name does.
+    void append_key_name(std::ostream & out_, const feature_cache_reader & reader_,
+                                const std::vector<const int32_t *> & key_columns_, size_t row_)
+    {
+      for (size_t k = 0; k < key_columns_.size(); ++k)
+        {
+          const int32_t id = key_columns_[k][row_];
+          if (id < 0) continue;
+          out_ << reader_.get_string(id) << '_';
+        }
+      return;
+    }
+
+    // Check if a pattern identifier passes a topology selection.
+    template <class Selection>
+    bool accepts(const Selection & selection_, const std::string & pattern_id_)
+    {
+      if (selection_.any) return true;
+      return std::find(selection_.pattern_ids.begin(), selection_.pattern_ids.end(), pattern_id_)
+        != selection_.pattern_ids.end();
+    }
+
+    // Indexes of the energy columns, observables of the control plot module
+    // and energies of the universal plot module.
+    enum energy_column_index
+      {
+        EC_ELECTRON_ENERGY   = plot_conventions::CO_ELECTRON_ENERGY,
+        EC_GAMMA_MAX_ENERGY  = plot_conventions::CO_GAMMA_MAX_ENERGY,
+        EC_GAMMA_MID_ENERGY  = plot_conventions::CO_GAMMA_MID_ENERGY,
+        EC_GAMMA_MIN_ENERGY  = plot_conventions::CO_GAMMA_MIN_ENERGY,
+        EC_TOTAL_ENERGY      = plot_conventions::CO_TOTAL_ENERGY,
+        EC_ASSOCIATED_ENERGY = plot_conventions::CO_NUMBER_OF_OBSERVABLES,
+        EC_NUMBER_OF_COLUMNS
+      };
+
+  } // namespace
+
+  histogram_replay::histogram_replay()
+  {
+    reset();
+    return;
+  }
+
+  void histogram_replay::reset()
+  {
+    _logging_priority_ = datatools::logger::PRIO_FATAL;
+    _pool_ = 0;
+    _number_of_threads_ = 1;
+    _template_axes_.clear();
+    _universal_ = false;
+    _universal_key_fields_.clear();
+    _universal_topologies_.clear();
+    _universal_selection_.any = true;
+    _universal_selection_.pattern_ids.clear();
+    _weighted_fill_ = false;
+    _weight_rules_.reset();
+    _energy_axis_ = 0;
+    _vertices_ = false;
+    _vertices_topologies_.clear();
+    _vertices_selection_.any = true;
+    _vertices_selection_.pattern_ids.clear();
+    _vertex_y_axis_.reset();
+    _vertex_z_axis_.reset();
+    _control_ = false;
+    _control_selection_.any = true;
+    _control_selection_.pattern_ids.clear();
+    _control_booking_.clear();
+    _control_axes_.clear();
+    _halflife_ = false;
+    _halflife_key_fields_.clear();
+    _halflife_max_isolated_ = -1;
+    _halflife_electrons_ = -1;
+    return;
+  }
+
+  bool histogram_replay::is_initialized() const
+  {
+    return _pool_ != 0;
+  }
+
+  void histogram_replay::initialize(const datatools::properties & config_, mygsl::histogram_pool & pool_)
+  {
+    DT_THROW_IF(is_initialized(), std::logic_error, "Replay is already initialized !");
+    _logging_priority_ = datatools::logger::extract_logging_configuration(config_, datatools::logger::PRIO_FATAL);
+
+    // Replayed modules
+    std::vector<std::string> plots;
+    if (config_.has_key("plots"))
+      {
+        config_.fetch("plots", plots);
+      }
+    else
+      {
+        plots.push_back("universal");
+        plots.push_back("vertices");
+        plots.push_back("control");
+        plots.push_back("halflife");
+      }
+    for (size_t i = 0; i < plots.size(); ++i)
+      {
+        if      (plots[i] == "universal") _universal_ = true;
+        else if (plots[i] == "vertices")  _vertices_ = true;
+        else if (plots[i] == "control")   _control_ = true;
+        else if (plots[i] == "halflife")  _halflife_ = true;
+        else DT_THROW(std::logic_error, "Unknown replayed plots '" << plots[i] << "' !");
+      }
+
+    // Threads
+    _number_of_threads_ = default_number_of_threads();
+    if (config_.has_key("number_of_threads"))
+      {
+        const int nthreads = config_.fetch_integer("number_of_threads");
+        DT_THROW_IF(nthreads <= 0, std::domain_error, "Invalid 'number_of_threads' property !");
+        _number_of_threads_ = nthreads;
+      }
+
+    // Universal plot module configuration
+    if (config_.has_key("universal.key_fields"))
+      {
+        config_.fetch("universal.key_fields", _universal_key_fields_);
+      }
+    if (config_.has_key("universal.weighted_fill"))
+      {
+        _weighted_fill_ = config_.fetch_boolean("universal.weighted_fill");
+      }
+    datatools::properties weight_config;
+    config_.export_and_rename_starting_with(weight_config, "universal.weight_rules.", "");
+    _weight_rules_.initialize(weight_config, _logging_priority_);
+    datatools::properties universal_config;
+    config_.export_and_rename_starting_with(universal_config, "universal.", "");
+    _universal_topologies_ = plot_conventions::fetch_topologies(universal_config, "1e");
+    for (size_t i = 0; i < _universal_topologies_.size(); ++i)
+      {
+        const std::string & a_topology = _universal_topologies_[i];
+        DT_THROW_IF(topology_registry::kind_of_id(a_topology) == TOPOLOGY_UNKNOWN, std::logic_error,
+                    "Unknown topology '" << a_topology << "' !");
+      }
+    datatools::properties universal_cut_config;
+    config_.export_and_rename_starting_with(universal_cut_config, "universal.cut_flow.", "");
+    plot_conventions::set_default_pattern_ids(universal_cut_config, _universal_topologies_);
+    _universal_selection_ = _compile_topology_selection(universal_cut_config, "universal",
+                                                        std::vector<std::string>(1, "topology"));
+
+    // Vertices plot module configuration
+    datatools::properties vertices_config;
+    config_.export_and_rename_starting_with(vertices_config, "vertices.", "");
+    _vertices_topologies_ = plot_conventions::fetch_topologies(vertices_config, "2e");
+    for (size_t i = 0; i < _vertices_topologies_.size(); ++i)
+      {
+        // The feature cache only stores the two electrons vertex
+        DT_THROW_IF(_vertices_topologies_[i] != "2e", std::logic_error,
+                    "Replay of the vertices plot module cannot reproduce the '"
+                    << _vertices_topologies_[i] << "' topology !");
+      }
+    datatools::properties vertices_cut_config;
+    config_.export_and_rename_starting_with(vertices_cut_config, "vertices.cut_flow.", "");
+    plot_conventions::set_default_pattern_ids(vertices_cut_config, _vertices_topologies_);
+    _vertices_selection_ = _compile_topology_selection(vertices_cut_config, "vertices",
+                                                       std::vector<std::string>(1, "topology"));
+
+    // Control plot module configuration
+    datatools::properties control_cut_config;
+    config_.export_and_rename_starting_with(control_cut_config, "control.cut_flow.", "");
+    _control_selection_ = _compile_topology_selection(control_cut_config, "control",
+                                                      std::vector<std::string>());
+    if (_control_)
+      {
+        datatools::properties booking_config;
+        config_.export_and_rename_starting_with(booking_config, "control.booking.", "");
+        plot_conventions::compile_control_booking(booking_config, _control_booking_);
+        for (size_t i = 0; i < _control_booking_.size(); ++i)
+          {
+            _control_axes_.push_back(&_template_axis(pool_, _control_booking_[i].template_name));
+          }
+      }
+
+    // Halflife limit module configuration
+    if (config_.has_key("halflife.key_fields"))
+      {
+        config_.fetch("halflife.key_fields", _halflife_key_fields_);
+      }
+    datatools::properties halflife_cut_config;
+    config_.export_and_rename_starting_with(halflife_cut_config, "halflife.cut_flow.", "");
+    _compile_halflife_cuts(halflife_cut_config);
+
+    // Binning of the templates
+    if (_universal_ || _halflife_)
+      {
+        _energy_axis_ = &_template_axis(pool_, plot_conventions::ENERGY_TEMPLATE);
+      }
+    if (_vertices_)
+      {
+        DT_THROW_IF(! pool_.has_2d(plot_conventions::VERTEX_TEMPLATE), std::logic_error,
+                    "Missing '" << plot_conventions::VERTEX_TEMPLATE << "' histogram !");
+        _vertex_y_axis_.initialize_x(pool_.get_2d(plot_conventions::VERTEX_TEMPLATE));
+        _vertex_z_axis_.initialize_y(pool_.get_2d(plot_conventions::VERTEX_TEMPLATE));
+      }
+    _pool_ = &pool_;
+    return;
+  }
+
+  histogram_replay::topology_selection
+  histogram_replay::_compile_topology_selection(const datatools::properties & config_,
+                                                const std::string & module_,
+                                                const std::vector<std::string> & default_cuts_) const
+  {
+    topology_selection a_selection;
+    a_selection.any = true;
+    std::vector<std::string> cuts = default_cuts_;
+    if (config_.has_key("cuts"))
+      {
+        cuts.clear();
+        config_.fetch("cuts", cuts);
+      }
+    for (size_t i = 0; i < cuts.size(); ++i)
+      {
+        // The topology cuts of the plot modules only know the 'topology' cut
+        DT_THROW_IF(cuts[i] != "topology", std::logic_error,
+                    "Replay of the " << module_ << " plot module cannot reproduce the '" << cuts[i] << "' cut !");
+        a_selection.any = false;
+        DT_THROW_IF(! config_.has_key("topology.pattern_ids"), std::logic_error,
+                    "Cut 'topology' of the " << module_ << " plot module has no 'pattern_ids' parameter !");
+        config_.fetch("topology.pattern_ids", a_selection.pattern_ids);
+      }
+    return a_selection;
+  }
+
+  void histogram_replay::_compile_halflife_cuts(const datatools::properties & config_)
+  {
+    std::vector<std::string> cuts = plot_conventions::halflife_default_cuts();
+    if (config_.has_key("cuts"))
+      {
+        cuts.clear();
+        config_.fetch("cuts", cuts);
+      }
+    _halflife_max_isolated_ = -1;
+    _halflife_electrons_ = -1;
+    for (size_t i = 0; i < cuts.size(); ++i)
+      {
+        if (cuts[i] == "isolated_calorimeters")
+          {
+            datatools::properties parameters;
+            config_.export_and_rename_starting_with(parameters, "isolated_calorimeters.", "");
+            _halflife_max_isolated_ = plot_conventions::halflife_max_isolated_calorimeters(parameters);
+          }
+        else if (cuts[i] == "electrons")
+          {
+            datatools::properties parameters;
+            config_.export_and_rename_starting_with(parameters, "electrons.", "");
+            _halflife_electrons_ = plot_conventions::halflife_number_of_electrons(parameters);
+          }
+        else
+          {
+            DT_THROW(std::logic_error,
+                     "Replay of the halflife limit module cannot reproduce the '" << cuts[i] << "' cut !");
+          }
+      }
+    return;
+  }
+
+  const histogram_axis & histogram_replay::_template_axis(mygsl::histogram_pool & pool_,
+                                                          const std::string & template_name_)
+  {
+    std::map<std::string, histogram_axis>::iterator found = _template_axes_.find(template_name_);
+    if (found == _template_axes_.end())
+      {
+        DT_THROW_IF(! pool_.has_1d(template_name_), std::logic_error,
+                    "Missing '" << template_name_ << "' histogram !");
+        found = _template_axes_.insert(std::make_pair(template_name_, histogram_axis())).first;
+        found->second.initialize(pool_.get_1d(template_name_));
+      }
+    return found->second;
+  }
+
+  std::vector<int> histogram_replay::_key_columns(const feature_cache_reader & reader_,
+                                                  const std::vector<std::string> & key_fields_) const
+  {
+    std::vector<int> columns;
+    for (size_t i = 0; i < key_fields_.size(); ++i)
+      {
+        const int column = reader_.find_integer_column(feature_columns::KEY_FIELD_PREFIX + key_fields_[i]);
+        DT_THROW_IF(column < 0, std::logic_error,
+                    "Key field '" << key_fields_[i] << "' is not stored in the feature cache !");
+        columns.push_back(column);
+      }
+    return columns;
+  }
+
+  void histogram_replay::run(const feature_cache_reader & reader_)
+  {
+    DT_THROW_IF(! is_initialized(), std::logic_error, "Replay is not initialized !");
+    DT_THROW_IF(! reader_.is_open(), std::logic_error, "Feature cache is not open !");
+
+    // Columns
+    const char * real_names[] = {
+      feature_columns::ELECTRON_ENERGY, feature_columns::GAMMA_MAX_ENERGY,
+      feature_columns::GAMMA_MID_ENERGY, feature_columns::GAMMA_MIN_ENERGY,
+      feature_columns::TOTAL_ENERGY, feature_columns::ASSOCIATED_ENERGY,
+      feature_columns::VERTEX_Y, feature_columns::VERTEX_Z,
+      feature_columns::CALORIMETER_ENERGY, feature_columns::GENBB_WEIGHT
+    };
+    const char * integer_names[] = {
+      feature_columns::TOPOLOGY, feature_columns::NUMBER_OF_GAMMAS,
+      feature_columns::NUMBER_OF_ELECTRONS, feature_columns::NUMBER_OF_POSITRONS,
+      feature_columns::NUMBER_OF_UNDEFINED, feature_columns::ISOLATED_CALORIMETERS,
+      feature_columns::GENBB_LABEL, feature_columns::VERTEX_ORIGIN
+    };
+    const size_t nreals = sizeof(real_names) / sizeof(const char *);
+    const size_t nintegers = sizeof(integer_names) / sizeof(const char *);
+    std::vector<int> real_columns(nreals);
+    std::vector<int> integer_columns(nintegers);
+    // The caches written before the universal 2e energy was stored can replay the other topologies
+    const bool universal_2e = _universal_ && std::find(_universal_topologies_.begin(), _universal_topologies_.end(), "2e")
+      != _universal_topologies_.end();
+    for (size_t c = 0; c < nreals; ++c)
+      {
+        real_columns[c] = reader_.find_real_column(real_names[c]);
+        if (c == EC_ASSOCIATED_ENERGY && ! universal_2e) continue;
+        DT_THROW_IF(real_columns[c] < 0, std::logic_error, "Missing feature column '" << real_names[c] << "' !");
+      }
+    for (size_t c = 0; c < nintegers; ++c)
+      {
+        integer_columns[c] = reader_.find_integer_column(integer_names[c]);
+        DT_THROW_IF(integer_columns[c] < 0, std::logic_error, "Missing feature column '" << integer_names[c] << "' !");
+      }
+    const std::vector<int> universal_keys = _key_columns(reader_, _universal_ ? _universal_key_fields_ : std::vector<std::string>());
+    const std::vector<int> halflife_keys = _key_columns(reader_, _halflife_ ? _halflife_key_fields_ : std::vector<std::string>());
+
+    // Topologies accepted by each module, indexed by string identifier
+    const std::vector<std::string> & strings = reader_.get_strings();
+    std::vector<int> universal_topologies(strings.size(), -1);
+    std::vector<std::string> universal_names(_universal_topologies_.size());
+    std::vector<size_t> universal_energies(_universal_topologies_.size());
+    for (size_t k = 0; k < _universal_topologies_.size(); ++k)
+      {
+        const topology_kind a_kind = topology_registry::kind_of_id(_universal_topologies_[k]);
+        std::ostringstream name;
+        plot_conventions::append_universal_name(name, a_kind);
+        universal_names[k] = name.str();
+        if      (a_kind == TOPOLOGY_1E) universal_energies[k] = EC_ELECTRON_ENERGY;
+        else if (a_kind == TOPOLOGY_2E) universal_energies[k] = EC_ASSOCIATED_ENERGY;
+        else                            universal_energies[k] = EC_TOTAL_ENERGY;
+      }
+    std::vector<bool> vertices_topologies(strings.size(), false);
+    std::vector<bool> control_topologies(strings.size(), false);
+    for (size_t s = 0; s < strings.size(); ++s)
+      {
+        const std::vector<std::string>::const_iterator found
+          = std::find(_universal_topologies_.begin(), _universal_topologies_.end(), strings[s]);
+        if (found != _universal_topologies_.end() && accepts(_universal_selection_, strings[s]))
+          {
+            universal_topologies[s] = found - _universal_topologies_.begin();
+          }
+        vertices_topologies[s] = std::find(_vertices_topologies_.begin(), _vertices_topologies_.end(), strings[s])
+          != _vertices_topologies_.end() && accepts(_vertices_selection_, strings[s]);
+        control_topologies[s] = strings[s] == "1eNg" && accepts(_control_selection_, strings[s]);
+      }
+
+    // First row of each row group
+    const size_t ngroups = reader_.get_number_of_row_groups();
+    std::vector<uint64_t> first_rows(ngroups + 1, 0);
+    for (size_t g = 0; g < ngroups; ++g) first_rows[g + 1] = first_rows[g] + reader_.get_row_group_size(g);
+
+    // Each thread processes a contiguous range of row groups, the accumulators are indexed by first row group
+    std::map<size_t, replay_accumulator_dict> accumulators;
+    std::mutex accumulators_mutex;
+    parallel_for(ngroups, _number_of_threads_, [&](size_t first_, size_t last_)
+      {
+        replay_accumulator_dict a_dict;
+        std::unordered_map<std::string, replay_accumulator *> universal_categories;
+        std::unordered_map<std::string, replay_accumulator *> universal_sumw2_categories;
+        std::unordered_map<std::string, replay_accumulator *> halflife_categories;
+        std::unordered_map<uint64_t, double> label_weights;
+        std::vector<std::vector<replay_accumulator *> > control_plan;
+        std::string tuple;
+        std::vector<const int32_t *> universal_key_data(universal_keys.size());
+        std::vector<const int32_t *> halflife_key_data(halflife_keys.size());
+
+        for (size_t g = first_; g < last_; ++g)
+          {
+            const size_t nrows = reader_.get_row_group_size(g);
+            const double * energies[EC_NUMBER_OF_COLUMNS];
+            for (size_t c = 0; c < EC_NUMBER_OF_COLUMNS; ++c)
+              {
+                energies[c] = real_columns[c] < 0 ? 0 : reader_.get_real_column(g, real_columns[c]);
+              }
+            const double * vertex_y         = reader_.get_real_column(g, real_columns[6]);
+            const double * vertex_z         = reader_.get_real_column(g, real_columns[7]);
+            const double * calo_energy      = reader_.get_real_column(g, real_columns[8]);
+            const double * genbb_weight     = reader_.get_real_column(g, real_columns[9]);
+            const int32_t * topology        = reader_.get_integer_column(g, integer_columns[0]);
+            const int32_t * ngammas         = reader_.get_integer_column(g, integer_columns[1]);
+            const int32_t * nelectrons      = reader_.get_integer_column(g, integer_columns[2]);
+            const int32_t * npositrons      = reader_.get_integer_column(g, integer_columns[3]);
+            const int32_t * nundefined      = reader_.get_integer_column(g, integer_columns[4]);
+            const int32_t * isolated        = reader_.get_integer_column(g, integer_columns[5]);
+            const int32_t * labels          = reader_.get_integer_column(g, integer_columns[6]);
+            const int32_t * origins         = reader_.get_integer_column(g, integer_columns[7]);
+            for (size_t k = 0; k < universal_keys.size(); ++k)
+              universal_key_data[k] = reader_.get_integer_column(g, universal_keys[k]);
+            for (size_t k = 0; k < halflife_keys.size(); ++k)
+              halflife_key_data[k] = reader_.get_integer_column(g, halflife_keys[k]);
+
+            for (size_t r = 0; r < nrows; ++r)
+              {
+                // Universal plot module
+                const int a_universal_topology = topology[r] >= 0 ? universal_topologies[topology[r]] : -1;
+                if (_universal_ && a_universal_topology >= 0)
+                  {
+                    double rule_weight = 1.0;
+                    if (labels[r] >= 0)
+                      {
+                        const uint64_t pair_id = (static_cast<uint64_t>(labels[r]) << 32)
+                          | static_cast<uint32_t>(origins[r]);
+                        std::unordered_map<uint64_t, double>::const_iterator found = label_weights.find(pair_id);
+                        if (found == label_weights.end())
+                          {
+                            const double a_weight = _weight_rules_.evaluate(reader_.get_string(labels[r]),
+                                                                            reader_.get_string(origins[r]));
+                            found = label_weights.insert(std::make_pair(pair_id, a_weight)).first;
+                          }
+                        rule_weight = found->second;
+                      }
+                    const double weight = rule_weight * genbb_weight[r];
+
+                    tuple.assign(reinterpret_cast<const char *>(&a_universal_topology), sizeof(int));
+                    append_key_tuple(tuple, universal_key_data, r);
+                    std::unordered_map<std::string, replay_accumulator *>::iterator found
+                      = universal_categories.find(tuple);
+                    if (found == universal_categories.end())
+                      {
+                        std::ostringstream name;
+                        append_key_name(name, reader_, universal_key_data, r);
+                        name << universal_names[a_universal_topology];
+                        replay_accumulator & an_accumulator
+                          = grab_accumulator(a_dict, name.str(), plot_conventions::UNIVERSAL_GROUP,
+                                             plot_conventions::ENERGY_TEMPLATE,
+                                             _weighted_fill_ ? REPLAY_AUX_WEIGHTED : REPLAY_AUX_RULE_WEIGHT,
+                                             _energy_axis_);
+                        found = universal_categories.insert(std::make_pair(tuple, &an_accumulator)).first;
+                        if (_weighted_fill_)
+                          {
+                            universal_sumw2_categories[tuple]
+                              = &grab_accumulator(a_dict, name.str() + plot_conventions::SUMW2_SUFFIX,
+                                                  plot_conventions::UNIVERSAL_SUMW2_GROUP,
+                                                  plot_conventions::ENERGY_TEMPLATE, REPLAY_AUX_NONE, _energy_axis_);
+                          }
+                      }
+                    replay_accumulator & an_accumulator = *found->second;
+                    if (! _weighted_fill_ && ! an_accumulator.set_weight(rule_weight))
+                      {
+                        std::ostringstream name;
+                        append_key_name(name, reader_, universal_key_data, r);
+                        name << universal_names[a_universal_topology];
+                        DT_THROW(std::logic_error, "Histogram '" << name.str()
+                                 << "' is filled with events of different weights !");
+                      }
+                    const double energy = energies[universal_energies[a_universal_topology]][r];
+                    if (energy == energy)
+                      {
+                        if (_weighted_fill_)
+                          {
+                            an_accumulator.fill(energy, weight);
+                            universal_sumw2_categories[tuple]->fill(energy, weight * weight);
+                          }
+                        else
+                          {
+                            an_accumulator.fill(energy, 1.0);
+                          }
+                      }
+                  }
+
+                // Vertices plot module
+                if (_vertices_ && topology[r] >= 0 && vertices_topologies[topology[r]] &&
+                    vertex_y[r] == vertex_y[r] && vertex_z[r] == vertex_z[r])
+                  {
+                    grab_accumulator(a_dict, plot_conventions::VERTEX_NAME, plot_conventions::VERTEX_GROUP,
+                                     plot_conventions::VERTEX_TEMPLATE, REPLAY_AUX_NONE, &_vertex_y_axis_, &_vertex_z_axis_)
+                      .fill(vertex_y[r], vertex_z[r], 1.0);
+                  }
+
+                // Control plot module
+                if (_control_ && topology[r] >= 0 && control_topologies[topology[r]] && ngammas[r] >= 0)
+                  {
+                    const size_t ng = ngammas[r];
+                    if (control_plan.size() <= ng) control_plan.resize(ng + 1);
+                    std::vector<replay_accumulator *> & a_plan = control_plan[ng];
+                    if (a_plan.empty())
+                      {
+                        // Resolve the histograms of this number of gammas once
+                        a_plan.assign(_control_booking_.size(), 0);
+                        for (size_t i = 0; i < _control_booking_.size(); ++i)
+                          {
+                            const plot_conventions::control_booking_entry & an_entry = _control_booking_[i];
+                            if (! an_entry.is_booked(ng)) continue;
+                            a_plan[i] = &grab_accumulator(a_dict, an_entry.histogram_name(ng), an_entry.group,
+                                                          an_entry.template_name, REPLAY_AUX_NONE, _control_axes_[i]);
+                          }
+                      }
+                    for (size_t i = 0; i < a_plan.size(); ++i)
+                      {
+                        if (! a_plan[i]) continue;
+                        const double value = energies[_control_booking_[i].observable][r];
+                        if (value == value) a_plan[i]->fill(value, 1.0);
+                      }
+                  }
+
+                // Halflife limit module, the particle columns are negative without particle track data
+                if (_halflife_ && nelectrons[r] >= 0 &&
+                    (_halflife_max_isolated_ < 0 || isolated[r] <= _halflife_max_isolated_) &&
+                    (_halflife_electrons_ < 0 || nelectrons[r] == _halflife_electrons_))
+                  {
+                    tuple.clear();
+                    append_key_tuple(tuple, halflife_key_data, r);
+                    tuple.append(reinterpret_cast<const char *>(&nelectrons[r]), sizeof(int32_t));
+                    tuple.append(reinterpret_cast<const char *>(&npositrons[r]), sizeof(int32_t));
+                    tuple.append(reinterpret_cast<const char *>(&nundefined[r]), sizeof(int32_t));
+                    std::unordered_map<std::string, replay_accumulator *>::iterator found
+                      = halflife_categories.find(tuple);
+                    if (found == halflife_categories.end())
+                      {
+                        std::ostringstream name;
+                        append_key_name(name, reader_, halflife_key_data, r);
+                        plot_conventions::append_charge_name(name, nelectrons[r], npositrons[r], nundefined[r]);
+                        replay_accumulator & an_accumulator
+                          = grab_accumulator(a_dict, name.str(), plot_conventions::HALFLIFE_GROUP,
+                                             plot_conventions::ENERGY_TEMPLATE,
+                                             REPLAY_AUX_UNIT_WEIGHT, _energy_axis_);
+                        found = halflife_categories.insert(std::make_pair(tuple, &an_accumulator)).first;
+                      }
+                    found->second->fill(calo_energy[r], 1.0);
+                  }
+              }
+          }
+        std::lock_guard<std::mutex> lock(accumulators_mutex);
+        accumulators[first_].swap(a_dict);
+      });
+
+    // Reduce the threads in row order, then fill the pool in name order
+    replay_accumulator_dict merged;
+    for (std::map<size_t, replay_accumulator_dict>::iterator
+           ithread = accumulators.begin();
+         ithread != accumulators.end(); ++ithread)
+      {
+        for (replay_accumulator_dict::iterator
+               iacc = ithread->second.begin();
+             iacc != ithread->second.end(); ++iacc)
+          {
+            replay_accumulator_dict::iterator found = merged.find(iacc->first);
+            if (found == merged.end())
+              {
+                merged.insert(*iacc);
+                continue;
+              }
+            DT_THROW_IF(! found->second.merge(iacc->second), std::logic_error,
+                        "Histogram '" << iacc->first << "' is filled with events of different weights !");
+          }
+        ithread->second.clear();
+      }
+
+    mygsl::histogram_pool & a_pool = *_pool_;
+    for (replay_accumulator_dict::const_iterator
+           iacc = merged.begin();
+         iacc != merged.end(); ++iacc)
+      {
+        const std::string & a_name = iacc->first;
+        const replay_accumulator & an_accumulator = iacc->second;
+        datatools::properties * auxiliaries = 0;
+        if (! an_accumulator.y_axis)
+          {
+            mygsl::histogram_1d & h = plot_conventions::grab_mimic_1d(a_pool, a_name, an_accumulator.group,
+                                                                      an_accumulator.template_name, a_pool);
+            DT_THROW_IF(h.bins() != an_accumulator.x_axis->bins(), std::logic_error,
+                        "Histogram '" << a_name << "' has not the binning of its template !");
+            for (size_t i = 0; i < h.bins(); ++i)
+              {
+                if (an_accumulator.contents[i] != 0.0) h.set(i, h.get(i) + an_accumulator.contents[i]);
+              }
+            // The bins are set directly, their fills are counted as mygsl::histogram::fill does
+            add_fill_counts(h, *an_accumulator.x_axis, an_accumulator.fills);
+            for (size_t k = 0; k < an_accumulator.outliers.size(); ++k)
+              {
+                h.fill(an_accumulator.outliers[k].x, an_accumulator.outliers[k].weight);
+              }
+            auxiliaries = &h.grab_auxiliaries();
+          }
+        else
+          {
+            mygsl::histogram_2d & h = plot_conventions::grab_mimic_2d(a_pool, a_name, an_accumulator.group,
+                                                                      an_accumulator.template_name, a_pool);
+            const size_t ny = an_accumulator.y_axis->bins();
+            DT_THROW_IF(h.xbins() != an_accumulator.x_axis->bins() || h.ybins() != ny, std::logic_error,
+                        "Histogram '" << a_name << "' has not the binning of its template !");
+            for (size_t i = 0; i < h.xbins(); ++i)
+              for (size_t j = 0; j < ny; ++j)
+                {
+                  const double a_content = an_accumulator.contents[i * ny + j];
+                  if (a_content != 0.0) h.set(i, j, h.get(i, j) + a_content);
+                }
+            add_fill_counts(h, *an_accumulator.x_axis, *an_accumulator.y_axis, an_accumulator.fills);
+            for (size_t k = 0; k < an_accumulator.outliers.size(); ++k)
+              {
+                h.fill(an_accumulator.outliers[k].x, an_accumulator.outliers[k].y, an_accumulator.outliers[k].weight);
+              }
+            auxiliaries = &h.grab_auxiliaries();
+          }
+
+        switch (an_accumulator.auxiliary)
+          {
+          case REPLAY_AUX_RULE_WEIGHT:
+            if (! auxiliaries->has_key("weight")) auxiliaries->update("weight", an_accumulator.weight);
+            break;
+          case REPLAY_AUX_WEIGHTED:
+            if (! auxiliaries->has_key("weighted")) auxiliaries->update("weighted", true);
+            break;
+          case REPLAY_AUX_UNIT_WEIGHT:
+            if (! auxiliaries->has_key("weight")) auxiliaries->update("weight", 1.0);
+            break;
+          default:
+            break;
+          }
+      }
+    DT_LOG_NOTICE(_logging_priority_, "Replayed " << first_rows[ngroups] << " events into "
+                  << merged.size() << " histograms with " << accumulators.size() << " threads");
+    return;
+  }
+
+} // namespace analysis
+
+// end of histogram_replay.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
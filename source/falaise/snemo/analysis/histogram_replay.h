@@ -0,0 +1,165 @@
+/* histogram_replay.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Replay engine filling the histograms of the plot modules from a feature
+ * cache file instead of the data records. The histograms can be rebuilt with
+ * new templates or with a subset of the stored key fields. The selections
+ * and the booked histograms are read from the configuration of each module,
+ * with the module defaults, and the configurations that the cached features
+ * cannot reproduce are rejected. The row groups of the cache are processed
+ * in parallel, each thread accumulating into private bin arrays merged into
+ * the pool at the end.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_HISTOGRAM_REPLAY_H_
+#define ANALYSIS_HISTOGRAM_REPLAY_H_ 1
+
+// Standard libraries:
+#include <map>
+#include <string>
+#include <vector>
+
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+// This project:
+#include <snemo/analysis/histogram_filler.h>
+#include <snemo/analysis/plot_conventions.h>
+#include <snemo/analysis/weight_rule_table.h>
+
+namespace datatools {
+  class properties;
+}
+
+namespace mygsl {
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  class feature_cache_reader;
+
+  /// \brief Fill the plot module histograms from a feature cache
+  ///
+  /// The configuration of a replayed module is given with its prefix:
+  ///
+  ///  - 'universal.' : 'key_fields', 'weighted_fill', 'weight_rules.', 'topologies' and 'cut_flow.'
+  ///  - 'vertices.'  : 'topologies' and 'cut_flow.'
+  ///  - 'control.'   : 'cut_flow.' and 'booking.'
+  ///  - 'halflife.'  : 'key_fields' and 'cut_flow.'
+  ///
+  /// Only the cuts and the observables stored in the feature cache can be
+  /// replayed, other configurations are rejected at initialization.
+  class histogram_replay
+  {
+  public:
+
+    /// Constructor
+    histogram_replay();
+
+    /// Initialize from a configuration and the pool holding the templates
+    void initialize(const datatools::properties & config_, mygsl::histogram_pool & pool_);
+
+    /// Reset
+    void reset();
+
+    /// Check if the replay has been initialized
+    bool is_initialized() const;
+
+    /// Fill the histograms of the pool from a feature cache
+    void run(const feature_cache_reader & reader_);
+
+  private:
+
+    /// Pattern identifiers accepted by the cut flow of a module on the topology pattern
+    struct topology_selection
+    {
+      bool                     any;         //!< No cut on the topology pattern
+      std::vector<std::string> pattern_ids; //!< Accepted pattern identifiers
+    };
+
+    /// Build the selection of the 'topology' cut from the cut flow configuration of a module
+    topology_selection _compile_topology_selection(const datatools::properties & config_,
+                                                   const std::string & module_,
+                                                   const std::vector<std::string> & default_cuts_) const;
+
+    /// Build the cuts of the halflife limit module
+    void _compile_halflife_cuts(const datatools::properties & config_);
+
+    /// Return the binning of a 1D template, initialized on first use
+    const histogram_axis & _template_axis(mygsl::histogram_pool & pool_, const std::string & template_name_);
+
+    /// Check a list of key fields against the cache and return their columns
+    std::vector<int> _key_columns(const feature_cache_reader & reader_,
+                                  const std::vector<std::string> & key_fields_) const;
+
+  private:
+
+    datatools::logger::priority _logging_priority_;
+    mygsl::histogram_pool *     _pool_;              //!< Pool with the templates and the filled histograms
+    size_t                      _number_of_threads_; //!< Number of threads
+
+    std::map<std::string, histogram_axis> _template_axes_; //!< Binning of the 1D templates
+
+    bool                     _universal_;            //!< Replay of the universal plot module
+    std::vector<std::string> _universal_key_fields_; //!< Key fields of the universal plot module
+    std::vector<std::string> _universal_topologies_; //!< Pattern identifiers filled by the universal plot module
+    topology_selection       _universal_selection_;  //!< Topology cut of the universal plot module
+    bool                     _weighted_fill_;        //!< Fill with the event weights
+    weight_rule_table        _weight_rules_;         //!< Event weight rules
+    const histogram_axis *   _energy_axis_;          //!< Binning of the 'energy_template' histogram
+
+    bool                     _vertices_;             //!< Replay of the vertices plot module
+    std::vector<std::string> _vertices_topologies_;  //!< Pattern identifiers filled by the vertices plot module
+    topology_selection       _vertices_selection_;   //!< Topology cut of the vertices plot module
+    histogram_axis           _vertex_y_axis_;        //!< X binning of the 'vertex_distribution_template' histogram
+    histogram_axis           _vertex_z_axis_;        //!< Y binning of the 'vertex_distribution_template' histogram
+
+    bool                     _control_;              //!< Replay of the control plot module
+    topology_selection       _control_selection_;    //!< Topology cut of the control plot module
+    std::vector<plot_conventions::control_booking_entry> _control_booking_; //!< Booking table of the control plot module
+    std::vector<const histogram_axis *> _control_axes_; //!< Binning of the templates of the booked histograms
+
+    bool                     _halflife_;             //!< Replay of the halflife limit module
+    std::vector<std::string> _halflife_key_fields_;  //!< Key fields of the halflife limit module
+    int                      _halflife_max_isolated_; //!< Maximum number of isolated calorimeters, negative without cut
+    int                      _halflife_electrons_;   //!< Required number of electrons, negative without cut
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_HISTOGRAM_REPLAY_H_
+
+// end of histogram_replay.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,207 @@
+// key_field_plan.cc
+
+// Ourselves:
+#include <snemo/analysis/key_field_plan.h>
+
+// Standard library:
+#include <sstream>
+#include <cstring>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+
+namespace analysis {
+
+  // Character separator between key for histogram dict.
+  const char KEY_FIELD_SEPARATOR = '_';
+
+  // Type tags of the binary key tokens.
+  const char KEY_TOKEN_SKIPPED = 'x';
+  const char KEY_TOKEN_BOOLEAN = 'b';
+  const char KEY_TOKEN_INTEGER = 'i';
+  const char KEY_TOKEN_REAL    = 'r';
+  const char KEY_TOKEN_STRING  = 's';
+
+  key_field_plan::key_field_plan()
+  {
+    _logging_priority_ = datatools::logger::PRIO_FATAL;
+    return;
+  }
+
+  void key_field_plan::initialize(const std::vector<std::string> & fields_,
+                                  datatools::logger::priority logging_priority_)
+  {
+    reset();
+    _logging_priority_ = logging_priority_;
+    _fields_ = fields_;
+    _extractors_.resize(_fields_.size());
+    for (size_t i = 0; i < _fields_.size(); ++i)
+      {
+        extractor_type & an_extractor = _extractors_[i];
+        an_extractor.field = _fields_[i];
+        an_extractor.type  = datatools::properties::data::TYPE_NONE;
+        an_extractor.kind  = FIELD_UNKNOWN;
+      }
+    return;
+  }
+
+  void key_field_plan::reset()
+  {
+    _fields_.clear();
+    _extractors_.clear();
+    return;
+  }
+
+  bool key_field_plan::empty() const
+  {
+    return _extractors_.empty();
+  }
+
+  const std::vector<std::string> & key_field_plan::get_fields() const
+  {
+    return _fields_;
+  }
+
+  void key_field_plan::_append_token(std::string & key_, char tag_, int64_t value_)
+  {
+    char token[TOKEN_SIZE];
+    token[0] = tag_;
+    std::memcpy(token + 1, &value_, sizeof(value_));
+    key_.append(token, TOKEN_SIZE);
+    return;
+  }
+
+  void key_field_plan::build_key(const datatools::properties & properties_, std::string & key_)
+  {
+    for (std::vector<extractor_type>::iterator
+           iextractor = _extractors_.begin();
+         iextractor != _extractors_.end(); ++iextractor)
+      {
+        extractor_type & an_extractor = *iextractor;
+        if (! properties_.has_key(an_extractor.field))
+          {
+            _append_token(key_, KEY_TOKEN_SKIPPED, 0);
+            continue;
+          }
+        const datatools::properties::data & a_data = properties_.get(an_extractor.field);
+
+        // Learn the field type from the first event, only check it afterwards
+        if (a_data.get_type() != an_extractor.type || an_extractor.kind == FIELD_UNKNOWN)
+          {
+            if (an_extractor.kind != FIELD_UNKNOWN)
+              {
+                DT_LOG_WARNING(_logging_priority_, "Key field '" << an_extractor.field
+                               << "' has changed type !");
+              }
+            an_extractor.type = a_data.get_type();
+            if      (a_data.is_boolean()) an_extractor.kind = FIELD_BOOLEAN;
+            else if (a_data.is_integer()) an_extractor.kind = FIELD_INTEGER;
+            else if (a_data.is_real())    an_extractor.kind = FIELD_REAL;
+            else if (a_data.is_string())  an_extractor.kind = FIELD_STRING;
+            else an_extractor.kind = FIELD_UNKNOWN;
+          }
+
+        if (a_data.is_vector())
+          {
+            _append_token(key_, KEY_TOKEN_SKIPPED, 0);
+            continue;
+          }
+
+        switch (an_extractor.kind)
+          {
+          case FIELD_BOOLEAN:
+            _append_token(key_, KEY_TOKEN_BOOLEAN, a_data.get_boolean_value() ? 1 : 0);
+            break;
+          case FIELD_INTEGER:
+            _append_token(key_, KEY_TOKEN_INTEGER, a_data.get_integer_value());
+            break;
+          case FIELD_REAL:
+            {
+              const double value = a_data.get_real_value();
+              int64_t bits;
+              std::memcpy(&bits, &value, sizeof(bits));
+              _append_token(key_, KEY_TOKEN_REAL, bits);
+            }
+            break;
+          case FIELD_STRING:
+            {
+              // Intern string values into a dense identifier
+              const std::string & value = a_data.get_string_value();
+              std::unordered_map<std::string, int64_t>::const_iterator found
+                = an_extractor.strings.find(value);
+              if (found == an_extractor.strings.end())
+                {
+                  const int64_t id = an_extractor.strings.size();
+                  found = an_extractor.strings.insert(std::make_pair(value, id)).first;
+                }
+              _append_token(key_, KEY_TOKEN_STRING, found->second);
+            }
+            break;
+          default:
+            _append_token(key_, KEY_TOKEN_SKIPPED, 0);
+            break;
+          }
+      }
+    return;
+  }
+
+  void key_field_plan::build_name(const datatools::properties & properties_, std::ostream & out_) const
+  {
+    for (std::vector<std::string>::const_iterator
+           ifield = _fields_.begin();
+         ifield != _fields_.end(); ++ifield)
+      {
+        const std::string & a_field = *ifield;
+        if (! properties_.has_key(a_field))
+          {
+            DT_LOG_WARNING(_logging_priority_,
+                           "No properties with key '" << a_field << "' "
+                           << "has been found in event header !");
+            continue;
+          }
+
+        if (properties_.is_vector(a_field))
+          {
+            DT_LOG_WARNING(_logging_priority_,
+                           "Stored properties '" << a_field << "' " << "must be scalar !");
+            continue;
+          }
+        _print_value(properties_, a_field, out_);
+        // Add a underscore separator between fields
+        out_ << KEY_FIELD_SEPARATOR;
+      }
+    return;
+  }
+
+  void key_field_plan::_print_value(const datatools::properties & properties_,
+                                    const std::string & field_, std::ostream & out_)
+  {
+    if (properties_.is_boolean(field_))      out_ << properties_.fetch_boolean(field_);
+    else if (properties_.is_integer(field_)) out_ << properties_.fetch_integer(field_);
+    else if (properties_.is_real(field_))    out_ << properties_.fetch_real(field_);
+    else if (properties_.is_string(field_))  out_ << properties_.fetch_string(field_);
+    return;
+  }
+
+  bool key_field_plan::format_field(const datatools::properties & properties_,
+                                    size_t index_, std::string & value_) const
+  {
+    const std::string & a_field = _fields_.at(index_);
+    if (! properties_.has_key(a_field) || properties_.is_vector(a_field)) return false;
+    std::ostringstream out;
+    _print_value(properties_, a_field, out);
+    value_ = out.str();
+    return true;
+  }
+
+} // namespace analysis
+
+// end of key_field_plan.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
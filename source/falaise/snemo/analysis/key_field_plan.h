@@ -0,0 +1,136 @@
+/* key_field_plan.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * A compiled plan to extract the event header key fields used to build
+ * histogram keys.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_KEY_FIELD_PLAN_H_
+#define ANALYSIS_KEY_FIELD_PLAN_H_ 1
+
+// Standard libraries:
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <unordered_map>
+
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+namespace datatools {
+  class properties;
+}
+
+namespace analysis {
+
+  /// \brief Typed extractors of the event header key fields
+  ///
+  /// The plan is compiled once from the list of key fields. The type of each
+  /// field is learned from the first event and only checked on the following
+  /// ones. Each field contributes a fixed width binary token to the key, string
+  /// values being interned into an integer identifier.
+  class key_field_plan
+  {
+  public:
+
+    /// Size in bytes of the token appended for each field
+    static const size_t TOKEN_SIZE = 1 + sizeof(int64_t);
+
+    /// Constructor
+    key_field_plan();
+
+    /// Compile the plan from the list of key fields
+    void initialize(const std::vector<std::string> & fields_,
+                    datatools::logger::priority logging_priority_ = datatools::logger::PRIO_FATAL);
+
+    /// Reset the plan
+    void reset();
+
+    /// Check if the plan has no field
+    bool empty() const;
+
+    /// Return the list of key fields
+    const std::vector<std::string> & get_fields() const;
+
+    /// Build the binary key from the event header properties
+    void build_key(const datatools::properties & properties_, std::string & key_);
+
+    /// Print the human readable key prefix ('value_' for each field)
+    void build_name(const datatools::properties & properties_, std::ostream & out_) const;
+
+    /// Format the value of a key field as in the key prefix, return false if missing or not scalar
+    bool format_field(const datatools::properties & properties_, size_t index_, std::string & value_) const;
+
+  private:
+
+    /// Learned type of a key field
+    enum field_type
+      {
+        FIELD_UNKNOWN = 0,
+        FIELD_BOOLEAN,
+        FIELD_INTEGER,
+        FIELD_REAL,
+        FIELD_STRING
+      };
+
+    /// Extractor of a single key field
+    struct extractor_type
+    {
+      std::string field;
+      int type;
+      field_type kind;
+      std::unordered_map<std::string, int64_t> strings;
+    };
+
+    /// Append a token to the key
+    static void _append_token(std::string & key_, char tag_, int64_t value_);
+
+    /// Print the value of a scalar field
+    static void _print_value(const datatools::properties & properties_,
+                             const std::string & field_, std::ostream & out_);
+
+  private:
+
+    datatools::logger::priority _logging_priority_;
+    std::vector<std::string>    _fields_;
+    std::vector<extractor_type> _extractors_;
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_KEY_FIELD_PLAN_H_
+
+// end of key_field_plan.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,103 @@
+/* parallel_for.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Static partition of an index range over a pool of threads. The
+ * partition only depends on the range and the number of threads, so that
+ * reductions performed in index order are reproducible.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_PARALLEL_FOR_H_
+#define ANALYSIS_PARALLEL_FOR_H_ 1
+
+// Standard libraries:
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <exception>
+#include <algorithm>
+
+namespace analysis {
+
+  /// Return the default number of worker threads
+  inline size_t default_number_of_threads()
+  {
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  /// Call function_(first, last) on contiguous slices of [0, size_) from
+  /// at most number_of_threads_ threads. The first exception thrown by a
+  /// slice is rethrown once all threads have been joined.
+  template <class Function>
+  void parallel_for(size_t size_, size_t number_of_threads_, Function function_)
+  {
+    if (size_ == 0) return;
+    const size_t nthreads = std::max<size_t>(1, std::min(number_of_threads_, size_));
+    if (nthreads == 1)
+      {
+        function_(0, size_);
+        return;
+      }
+    std::vector<std::exception_ptr> errors(nthreads);
+    std::vector<std::thread> threads;
+    threads.reserve(nthreads);
+    for (size_t t = 0; t < nthreads; ++t)
+      {
+        const size_t first = size_ * t / nthreads;
+        const size_t last  = size_ * (t + 1) / nthreads;
+        threads.push_back(std::thread([&function_, &errors, t, first, last]()
+          {
+            try
+              {
+                function_(first, last);
+              }
+            catch (...)
+              {
+                errors[t] = std::current_exception();
+              }
+          }));
+      }
+    for (size_t t = 0; t < nthreads; ++t) threads[t].join();
+    for (size_t t = 0; t < nthreads; ++t)
+      {
+        if (errors[t]) std::rethrow_exception(errors[t]);
+      }
+    return;
+  }
+
+} // namespace analysis
+
+#endif // ANALYSIS_PARALLEL_FOR_H_
+
+// end of parallel_for.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,242 @@
+// plot_conventions.cc
+
+// Ourselves:
+#include <snemo/analysis/plot_conventions.h>
+
+// Standard library:
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+#include <mygsl/histogram_pool.h>
+
+namespace analysis {
+
+  namespace plot_conventions {
+
+    void append_universal_name(std::ostream & out_, topology_kind topology_)
+    {
+      // Histograms of other topologies than 1e are prefixed by the pattern identifier
+      if (topology_ != TOPOLOGY_1E) out_ << topology_registry::pattern_id(topology_) << '_';
+      out_ << "energy";
+      return;
+    }
+
+    void append_charge_name(std::ostream & out_, size_t nelectron_, size_t npositron_, size_t nundefined_)
+    {
+      out_ << nelectron_ << "e-" << npositron_ << "e+" << nundefined_ << "u";
+      return;
+    }
+
+    std::vector<std::string> fetch_topologies(const datatools::properties & config_,
+                                              const std::string & default_topology_)
+    {
+      std::vector<std::string> topologies(1, default_topology_);
+      if (config_.has_key("topologies"))
+        {
+          topologies.clear();
+          config_.fetch("topologies", topologies);
+        }
+      return topologies;
+    }
+
+    void set_default_pattern_ids(datatools::properties & cut_flow_config_,
+                                 const std::vector<std::string> & pattern_ids_)
+    {
+      if (! cut_flow_config_.has_key("topology.pattern_ids"))
+        {
+          cut_flow_config_.store("topology.pattern_ids", pattern_ids_);
+        }
+      return;
+    }
+
+    const std::vector<std::string> & halflife_default_cuts()
+    {
+      static const std::vector<std::string> cuts = { "isolated_calorimeters", "electrons" };
+      return cuts;
+    }
+
+    size_t halflife_max_isolated_calorimeters(const datatools::properties & parameters_)
+    {
+      if (! parameters_.has_key("max")) return 0;
+      const int max = parameters_.fetch_integer("max");
+      DT_THROW_IF(max < 0, std::domain_error, "Invalid 'max' parameter of the 'isolated_calorimeters' cut !");
+      return max;
+    }
+
+    size_t halflife_number_of_electrons(const datatools::properties & parameters_)
+    {
+      if (! parameters_.has_key("number")) return 2;
+      const int number = parameters_.fetch_integer("number");
+      DT_THROW_IF(number < 0, std::domain_error, "Invalid 'number' parameter of the 'electrons' cut !");
+      return number;
+    }
+
+    bool control_booking_entry::is_booked(size_t ngammas_) const
+    {
+      if (multiplicities.empty()) return true;
+      return ngammas_ < multiplicities.size() && multiplicities[ngammas_];
+    }
+
+    std::string control_booking_entry::histogram_name(size_t ngammas_) const
+    {
+      std::string a_name = name;
+      const size_t wildcard = a_name.find("{N}");
+      if (wildcard != std::string::npos)
+        {
+          std::ostringstream number;
+          number << ngammas_;
+          a_name.replace(wildcard, 3, number.str());
+        }
+      return a_name;
+    }
+
+    void compile_control_booking(const datatools::properties & config_,
+                                 std::vector<control_booking_entry> & booking_)
+    {
+      // Observables of the 1eNg topology :
+      std::map<std::string, control_observable> observables;
+      observables["electron_energy"]  = CO_ELECTRON_ENERGY;
+      observables["gamma_max_energy"] = CO_GAMMA_MAX_ENERGY;
+      observables["gamma_mid_energy"] = CO_GAMMA_MID_ENERGY;
+      observables["gamma_min_energy"] = CO_GAMMA_MIN_ENERGY;
+      observables["total_energy"]     = CO_TOTAL_ENERGY;
+
+      // Legacy plots of the 1, 2 and 3 gammas events :
+      datatools::properties booking_config = config_;
+      if (! booking_config.has_key("plots"))
+        {
+          std::vector<std::string> plots;
+          plots.push_back("electron_energy");
+          plots.push_back("gamma_max_energy");
+          plots.push_back("gamma_mid_energy");
+          plots.push_back("gamma_min_energy");
+          plots.push_back("tot_energy");
+          booking_config.store("plots", plots);
+          booking_config.store_string("tot_energy.observable", "total_energy");
+          std::vector<int> gammas;
+          gammas.push_back(3);
+          booking_config.store("gamma_mid_energy.gammas", gammas);
+          gammas.insert(gammas.begin(), 2);
+          booking_config.store("gamma_min_energy.gammas", gammas);
+          gammas.insert(gammas.begin(), 1);
+          booking_config.store("electron_energy.gammas", gammas);
+          booking_config.store("gamma_max_energy.gammas", gammas);
+          booking_config.store("tot_energy.gammas", gammas);
+        }
+
+      std::vector<std::string> plots;
+      booking_config.fetch("plots", plots);
+      booking_.clear();
+      for (size_t i = 0; i < plots.size(); ++i)
+        {
+          const std::string & a_plot = plots[i];
+          const std::string prefix = a_plot + ".";
+
+          std::string topology = "1eNg";
+          if (booking_config.has_key(prefix + "topology"))
+            {
+              topology = booking_config.fetch_string(prefix + "topology");
+            }
+          DT_THROW_IF(topology != "1eNg", std::logic_error,
+                      "Cannot book control plot '" << a_plot << "' for the '" << topology << "' topology !");
+
+          std::string observable = a_plot;
+          if (booking_config.has_key(prefix + "observable"))
+            {
+              observable = booking_config.fetch_string(prefix + "observable");
+            }
+          std::map<std::string, control_observable>::const_iterator found = observables.find(observable);
+          DT_THROW_IF(found == observables.end(), std::logic_error,
+                      "No '" << observable << "' observable for control plot '" << a_plot << "' !");
+
+          control_booking_entry an_entry;
+          an_entry.name = "1e{N}g_" + a_plot;
+          if (booking_config.has_key(prefix + "name"))
+            {
+              an_entry.name = booking_config.fetch_string(prefix + "name");
+            }
+          an_entry.group = "energy";
+          if (booking_config.has_key(prefix + "group"))
+            {
+              an_entry.group = booking_config.fetch_string(prefix + "group");
+            }
+          an_entry.template_name = ENERGY_TEMPLATE;
+          if (booking_config.has_key(prefix + "template"))
+            {
+              an_entry.template_name = booking_config.fetch_string(prefix + "template");
+            }
+          an_entry.observable = found->second;
+          if (booking_config.has_key(prefix + "gammas"))
+            {
+              std::vector<int> gammas;
+              booking_config.fetch(prefix + "gammas", gammas);
+              for (size_t j = 0; j < gammas.size(); ++j)
+                {
+                  DT_THROW_IF(gammas[j] < 0, std::domain_error,
+                              "Invalid number of gammas for control plot '" << a_plot << "' !");
+                  if (an_entry.multiplicities.size() <= size_t(gammas[j]))
+                    {
+                      an_entry.multiplicities.resize(gammas[j] + 1, false);
+                    }
+                  an_entry.multiplicities[gammas[j]] = true;
+                }
+            }
+          booking_.push_back(an_entry);
+        }
+      return;
+    }
+
+    mygsl::histogram_1d & grab_mimic_1d(mygsl::histogram_pool & pool_,
+                                        const std::string & name_,
+                                        const std::string & group_,
+                                        const std::string & template_name_,
+                                        mygsl::histogram_pool & template_pool_)
+    {
+      if (! pool_.has(name_))
+        {
+          mygsl::histogram_1d & h = pool_.add_1d(name_, "", group_);
+          datatools::properties hconfig;
+          hconfig.store_string("mode", "mimic");
+          hconfig.store_string("mimic.histogram_1d", template_name_);
+          mygsl::histogram_pool::init_histo_1d(h, hconfig, &template_pool_);
+        }
+      return pool_.grab_1d(name_);
+    }
+
+    mygsl::histogram_2d & grab_mimic_2d(mygsl::histogram_pool & pool_,
+                                        const std::string & name_,
+                                        const std::string & group_,
+                                        const std::string & template_name_,
+                                        mygsl::histogram_pool & template_pool_)
+    {
+      if (! pool_.has(name_))
+        {
+          mygsl::histogram_2d & h = pool_.add_2d(name_, "", group_);
+          datatools::properties hconfig;
+          hconfig.store_string("mode", "mimic");
+          hconfig.store_string("mimic.histogram_2d", template_name_);
+          mygsl::histogram_pool::init_histo_2d(h, hconfig, &template_pool_);
+        }
+      return pool_.grab_2d(name_);
+    }
+
+  } // namespace plot_conventions
+
+} // namespace analysis
+
+// end of plot_conventions.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
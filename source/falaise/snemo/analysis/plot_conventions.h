@@ -0,0 +1,159 @@
+/* plot_conventions.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Naming, booking and selection conventions of the plot modules, shared
+ * with the replay of their histograms from a feature cache.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_PLOT_CONVENTIONS_H_
+#define ANALYSIS_PLOT_CONVENTIONS_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <iostream>
+
+// This project:
+#include <snemo/analysis/topology_dispatch.h>
+
+namespace datatools {
+  class properties;
+}
+
+namespace mygsl {
+  class histogram;
+  typedef histogram histogram_1d;
+  class histogram_2d;
+  class histogram_pool;
+}
+
+namespace analysis {
+
+  namespace plot_conventions {
+
+    // Templates of the histograms
+    const char ENERGY_TEMPLATE[] = "energy_template";              //!< Template of the energy histograms
+    const char VERTEX_TEMPLATE[] = "vertex_distribution_template"; //!< Template of the vertex histogram
+
+    // Universal plot module
+    const char UNIVERSAL_GROUP[]       = "energy_distrib";       //!< Group of the energy histograms
+    const char UNIVERSAL_SUMW2_GROUP[] = "energy_distrib_sumw2"; //!< Group of the squared weight histograms
+    const char SUMW2_SUFFIX[]          = "_sumw2";               //!< Suffix of the squared weight histograms
+
+    // Vertices plot module
+    const char VERTEX_NAME[]  = "vertex_distrib"; //!< Name of the vertex histogram
+    const char VERTEX_GROUP[] = "vertices";       //!< Group of the vertex histogram
+
+    // Halflife limit module
+    const char HALFLIFE_GROUP[] = "energy"; //!< Group of the energy histograms
+
+    /// Append the name of a universal histogram to its key prefix
+    void append_universal_name(std::ostream & out_, topology_kind topology_);
+
+    /// Append the name of a halflife histogram to its key prefix
+    void append_charge_name(std::ostream & out_, size_t nelectron_, size_t npositron_, size_t nundefined_);
+
+    /// Return the topologies filled by a module from its 'topologies' property
+    std::vector<std::string> fetch_topologies(const datatools::properties & config_,
+                                              const std::string & default_topology_);
+
+    /// Select only the given pattern identifiers when the 'topology' cut has no 'pattern_ids'
+    void set_default_pattern_ids(datatools::properties & cut_flow_config_,
+                                 const std::vector<std::string> & pattern_ids_);
+
+    /// Return the default cuts of the halflife limit module
+    const std::vector<std::string> & halflife_default_cuts();
+
+    /// Return the 'max' parameter of the 'isolated_calorimeters' cut of the halflife limit module
+    size_t halflife_max_isolated_calorimeters(const datatools::properties & parameters_);
+
+    /// Return the 'number' parameter of the 'electrons' cut of the halflife limit module
+    size_t halflife_number_of_electrons(const datatools::properties & parameters_);
+
+    /// Observables of the 1eNg topology booked by the control plot module
+    enum control_observable
+      {
+        CO_ELECTRON_ENERGY = 0,
+        CO_GAMMA_MAX_ENERGY,
+        CO_GAMMA_MID_ENERGY,
+        CO_GAMMA_MIN_ENERGY,
+        CO_TOTAL_ENERGY,
+        CO_NUMBER_OF_OBSERVABLES
+      };
+
+    /// Histogram booked by the control plot module for the 1eNg topology
+    struct control_booking_entry
+    {
+      std::string        name;           //!< Histogram name, '{N}' stands for the number of gammas
+      std::string        group;          //!< Histogram group
+      std::string        template_name;  //!< Name of the mimicked histogram template
+      control_observable observable;     //!< Filled observable
+      std::vector<bool>  multiplicities; //!< Flags of the booked numbers of gammas, empty for any number
+
+      /// Check if the histogram is booked for a number of gammas
+      bool is_booked(size_t ngammas_) const;
+
+      /// Return the histogram name for a number of gammas
+      std::string histogram_name(size_t ngammas_) const;
+    };
+
+    /// Build the booking table of the control plot module from its
+    /// 'booking.' properties, the legacy plots of the 1, 2 and 3 gammas
+    /// events by default
+    void compile_control_booking(const datatools::properties & config_,
+                                 std::vector<control_booking_entry> & booking_);
+
+    /// Return a histogram of a pool, creating it as a copy of a template of template_pool_ if needed
+    mygsl::histogram_1d & grab_mimic_1d(mygsl::histogram_pool & pool_,
+                                        const std::string & name_,
+                                        const std::string & group_,
+                                        const std::string & template_name_,
+                                        mygsl::histogram_pool & template_pool_);
+
+    /// Same as above for a 2D histogram
+    mygsl::histogram_2d & grab_mimic_2d(mygsl::histogram_pool & pool_,
+                                        const std::string & name_,
+                                        const std::string & group_,
+                                        const std::string & template_name_,
+                                        mygsl::histogram_pool & template_pool_);
+
+  } // namespace plot_conventions
+
+} // namespace analysis
+
+#endif // ANALYSIS_PLOT_CONVENTIONS_H_
+
+// end of plot_conventions.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,126 @@
+// roi_optimiser.cc
+
+// Ourselves:
+#include <snemo/analysis/roi_optimiser.h>
+
+// This project:
+#include <snemo/analysis/parallel_for.h>
+
+// Standard library:
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  bool roi_optimiser::window_type::is_valid() const
+  {
+    return last_bin > first_bin;
+  }
+
+  roi_optimiser::roi_optimiser()
+  {
+    _number_of_threads_ = default_number_of_threads();
+    _halflife_factor_ = 1.0;
+    return;
+  }
+
+  void roi_optimiser::set_number_of_threads(size_t number_of_threads_)
+  {
+    DT_THROW_IF(number_of_threads_ == 0, std::domain_error, "Invalid number of threads !");
+    _number_of_threads_ = number_of_threads_;
+    return;
+  }
+
+  void roi_optimiser::set_excluded_events_function(const excluded_events_function_type & function_)
+  {
+    _excluded_events_ = function_;
+    return;
+  }
+
+  void roi_optimiser::set_halflife_factor(double factor_)
+  {
+    _halflife_factor_ = factor_;
+    return;
+  }
+
+  roi_optimiser::window_type roi_optimiser::optimise(const std::vector<double> & signal_above_,
+                                                     const std::vector<double> & background_above_) const
+  {
+    DT_THROW_IF(! _excluded_events_, std::logic_error, "Missing excluded events function !");
+    DT_THROW_IF(signal_above_.size() != background_above_.size(), std::logic_error,
+                "Signal and background tables have different sizes !");
+    const size_t nbins = signal_above_.size();
+
+    // Best window of each start position
+    window_type no_window;
+    no_window.first_bin = 0;
+    no_window.last_bin = 0;
+    no_window.signal_efficiency = 0.0;
+    no_window.background_counts = 0.0;
+    no_window.halflife = 0.0;
+    std::vector<window_type> best_windows(nbins, no_window);
+
+    // Start position i has nbins - i windows, the positions are dealt
+    // round robin to the threads so that each gets the same share
+    const size_t nstripes = std::max<size_t>(1, std::min(_number_of_threads_, nbins));
+    parallel_for(nstripes, _number_of_threads_,
+                 [&](size_t first_, size_t last_)
+                 {
+                   std::vector<double> signals(nbins);
+                   std::vector<double> backgrounds(nbins);
+                   std::vector<double> excluded(nbins);
+                   for (size_t stripe = first_; stripe < last_; ++stripe)
+                     {
+                       for (size_t i = stripe; i < nbins; i += nstripes)
+                         {
+                           // Windows [i, i + 1 + k) for k in [0, nbins - i)
+                           const size_t nwindows = nbins - i;
+                           for (size_t k = 0; k < nwindows; ++k)
+                             {
+                               const size_t j = i + 1 + k;
+                               signals[k] = signal_above_[i] - (j < nbins ? signal_above_[j] : 0.0);
+                               backgrounds[k] = background_above_[i] - (j < nbins ? background_above_[j] : 0.0);
+                             }
+                           _excluded_events_(&backgrounds[0], nwindows, &excluded[0]);
+                           window_type & a_best = best_windows[i];
+                           for (size_t k = 0; k < nwindows; ++k)
+                             {
+                               if (! (signals[k] > 0.0)) continue;
+                               const double halflife = signals[k] / excluded[k] * _halflife_factor_;
+                               if (halflife > a_best.halflife)
+                                 {
+                                   a_best.first_bin = i;
+                                   a_best.last_bin = i + 1 + k;
+                                   a_best.signal_efficiency = signals[k];
+                                   a_best.background_counts = backgrounds[k];
+                                   a_best.halflife = halflife;
+                                 }
+                             }
+                         }
+                     }
+                 });
+
+    // Reduce in start order so that ties keep the lowest window
+    window_type a_best = no_window;
+    for (size_t i = 0; i < nbins; ++i)
+      {
+        if (best_windows[i].halflife > a_best.halflife) a_best = best_windows[i];
+      }
+    return a_best;
+  }
+
+} // namespace analysis
+
+// end of roi_optimiser.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
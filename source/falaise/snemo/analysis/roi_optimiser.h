@@ -0,0 +1,107 @@
+/* roi_optimiser.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Search of the energy window [Emin, Emax] giving the best limit on the
+ * neutrinoless double beta decay halflife.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_ROI_OPTIMISER_H_
+#define ANALYSIS_ROI_OPTIMISER_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstddef>
+#include <functional>
+
+namespace analysis {
+
+  /// \brief Two-sided energy window optimiser
+  ///
+  /// The signal efficiency and the background counts are given as
+  /// cumulative tables, the value of bin i being the sum over the bins
+  /// above i. The content of a window [i, j) is then the difference of two
+  /// entries, and every window is evaluated in constant time. Window start
+  /// positions are interleaved between the threads, which balances the
+  /// triangular set of windows, and the excluded events of all the windows
+  /// of a start position are evaluated in one batch.
+  class roi_optimiser
+  {
+  public:
+
+    /// Compute the number of events excluded at many numbers of background events
+    typedef std::function<void(const double *, size_t, double *)> excluded_events_function_type;
+
+    /// Energy window and its halflife limit
+    struct window_type
+    {
+      size_t first_bin;         //!< First bin of the window
+      size_t last_bin;          //!< Bin following the last bin of the window
+      double signal_efficiency; //!< Signal efficiency in the window
+      double background_counts; //!< Number of background events in the window
+      double halflife;          //!< Halflife limit
+
+      /// Check if the window is not empty
+      bool is_valid() const;
+    };
+
+    /// Constructor
+    roi_optimiser();
+
+    /// Set the number of threads
+    void set_number_of_threads(size_t number_of_threads_);
+
+    /// Set the function computing the numbers of excluded events
+    void set_excluded_events_function(const excluded_events_function_type & function_);
+
+    /// Set the factor converting efficiency per excluded event into halflife
+    void set_halflife_factor(double factor_);
+
+    /// Return the window with the largest halflife limit, an invalid
+    /// window if no window has a positive signal efficiency
+    window_type optimise(const std::vector<double> & signal_above_,
+                         const std::vector<double> & background_above_) const;
+
+  private:
+
+    size_t                        _number_of_threads_; //!< Number of threads
+    excluded_events_function_type _excluded_events_;   //!< Number of excluded events
+    double                        _halflife_factor_;   //!< Halflife per efficiency and excluded event
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_ROI_OPTIMISER_H_
+
+// end of roi_optimiser.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
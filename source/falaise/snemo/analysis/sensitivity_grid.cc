@@ -0,0 +1,150 @@
+// sensitivity_grid.cc
+
+// Ourselves:
+#include <snemo/analysis/sensitivity_grid.h>
+
+// This project:
+#include <snemo/analysis/parallel_for.h>
+#include <snemo/analysis/feldman_cousins.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  sensitivity_grid::sensitivity_grid()
+  {
+    _number_of_threads_ = default_number_of_threads();
+    _feldman_cousins_ = 0;
+    _signal_factor_ = 1.0;
+    return;
+  }
+
+  void sensitivity_grid::set_number_of_threads(size_t number_of_threads_)
+  {
+    DT_THROW_IF(number_of_threads_ == 0, std::domain_error, "Invalid number of threads !");
+    _number_of_threads_ = number_of_threads_;
+    return;
+  }
+
+  void sensitivity_grid::set_feldman_cousins(const feldman_cousins & feldman_cousins_)
+  {
+    _feldman_cousins_ = &feldman_cousins_;
+    return;
+  }
+
+  void sensitivity_grid::set_signal_factor(double factor_)
+  {
+    _signal_factor_ = factor_;
+    return;
+  }
+
+  void sensitivity_grid::set_background_components(const std::vector<double> & bb2nu_,
+                                                   const std::vector<double> & isotope_,
+                                                   const std::vector<double> & fixed_)
+  {
+    DT_THROW_IF(bb2nu_.size() != isotope_.size() || bb2nu_.size() != fixed_.size(), std::logic_error,
+                "Background components have different sizes !");
+    _bb2nu_ = bb2nu_;
+    _isotope_ = isotope_;
+    _fixed_ = fixed_;
+    return;
+  }
+
+  void sensitivity_grid::set_grid(const std::vector<double> & exposure_times_,
+                                  const std::vector<double> & isotope_masses_,
+                                  const std::vector<double> & background_scales_)
+  {
+    _points_.clear();
+    for (size_t it = 0; it < exposure_times_.size(); ++it)
+      for (size_t im = 0; im < isotope_masses_.size(); ++im)
+        for (size_t is = 0; is < background_scales_.size(); ++is)
+          {
+            point_type a_point;
+            a_point.exposure_time = exposure_times_[it];
+            a_point.isotope_mass = isotope_masses_[im];
+            a_point.background_scale = background_scales_[is];
+            _points_.push_back(a_point);
+          }
+    return;
+  }
+
+  const std::vector<sensitivity_grid::point_type> & sensitivity_grid::get_points() const
+  {
+    return _points_;
+  }
+
+  void sensitivity_grid::evaluate(const std::vector<double> & signal_above_,
+                                  std::vector<result_type> & results_) const
+  {
+    DT_THROW_IF(! _feldman_cousins_, std::logic_error, "Missing Feldman-Cousins upper limits !");
+    DT_THROW_IF(signal_above_.size() != _bb2nu_.size(), std::logic_error,
+                "Signal efficiency and background components have different sizes !");
+    const size_t nbins = signal_above_.size();
+    results_.resize(_points_.size());
+    const feldman_cousins & fc = *_feldman_cousins_;
+
+    parallel_for(_points_.size(), _number_of_threads_,
+                 [&](size_t first_, size_t last_)
+                 {
+                   std::vector<double> background(nbins);
+                   std::vector<double> excluded(nbins);
+                   roi_optimiser an_optimiser;
+                   an_optimiser.set_number_of_threads(1);
+                   an_optimiser.set_excluded_events_function([&fc](const double * backgrounds_,
+                                                                   size_t size_,
+                                                                   double * excluded_)
+                                                             {
+                                                               fc.excluded_events(backgrounds_, size_, excluded_);
+                                                             });
+                   for (size_t ip = first_; ip < last_; ++ip)
+                     {
+                       const point_type & a_point = _points_[ip];
+                       const double mass_time = a_point.isotope_mass * a_point.exposure_time;
+                       const double bb2nu_factor = mass_time;
+                       const double isotope_factor = a_point.background_scale * mass_time;
+                       const double fixed_factor = a_point.background_scale * a_point.exposure_time;
+                       for (size_t i = 0; i < nbins; ++i)
+                         {
+                           background[i] = bb2nu_factor * _bb2nu_[i] + isotope_factor * _isotope_[i]
+                             + fixed_factor * _fixed_[i];
+                         }
+                       if (nbins > 0) fc.excluded_events(&background[0], nbins, &excluded[0]);
+
+                       result_type & a_result = results_[ip];
+                       a_result.point = a_point;
+                       a_result.threshold_bin = 0;
+                       a_result.threshold_halflife = 0.0;
+                       const double factor = _signal_factor_ * mass_time;
+                       for (size_t i = 0; i < nbins; ++i)
+                         {
+                           const double halflife = signal_above_[i] / excluded[i] * factor;
+                           if (halflife > a_result.threshold_halflife)
+                             {
+                               a_result.threshold_bin = i;
+                               a_result.threshold_halflife = halflife;
+                             }
+                         }
+
+                       // Cumulative background above each bin is the summed-area table of the window search
+                       an_optimiser.set_halflife_factor(factor);
+                       a_result.window = an_optimiser.optimise(signal_above_, background);
+                     }
+                 });
+    return;
+  }
+
+} // namespace analysis
+
+// end of sensitivity_grid.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
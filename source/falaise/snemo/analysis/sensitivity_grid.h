@@ -0,0 +1,127 @@
+/* sensitivity_grid.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Halflife limits of a grid of experiment configurations evaluated from
+ * the same efficiency vectors.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_SENSITIVITY_GRID_H_
+#define ANALYSIS_SENSITIVITY_GRID_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstddef>
+
+// This project:
+#include <snemo/analysis/roi_optimiser.h>
+
+namespace analysis {
+
+  class feldman_cousins;
+
+  /// \brief Sensitivity surface over exposure, isotope mass and background scale
+  ///
+  /// The expected background of each energy threshold is split into three
+  /// components per unit of exposure time: the bb2nu decays and the
+  /// backgrounds whose source is the isotope foil scale with the isotope
+  /// mass, the backgrounds with a fixed source mass do not. The radioactive
+  /// backgrounds are also multiplied by the background scale. Each grid
+  /// point then only needs a few vector operations, and the points are
+  /// evaluated in parallel.
+  class sensitivity_grid
+  {
+  public:
+
+    /// Experiment configuration
+    struct point_type
+    {
+      double exposure_time;    //!< Exposure time
+      double isotope_mass;     //!< Isotope mass
+      double background_scale; //!< Scale of the radioactive background activities
+    };
+
+    /// Limits of an experiment configuration
+    struct result_type
+    {
+      point_type               point;              //!< Experiment configuration
+      size_t                   threshold_bin;      //!< Best one-sided energy threshold
+      double                   threshold_halflife; //!< Halflife limit of the best threshold
+      roi_optimiser::window_type window;           //!< Best two-sided energy window
+    };
+
+    /// Constructor
+    sensitivity_grid();
+
+    /// Set the number of threads
+    void set_number_of_threads(size_t number_of_threads_);
+
+    /// Set the Feldman-Cousins upper limits
+    void set_feldman_cousins(const feldman_cousins & feldman_cousins_);
+
+    /// Set the halflife per efficiency and excluded event, per unit of isotope mass and exposure time
+    void set_signal_factor(double factor_);
+
+    /// Set the background components above each threshold, per unit of exposure time
+    void set_background_components(const std::vector<double> & bb2nu_,
+                                   const std::vector<double> & isotope_,
+                                   const std::vector<double> & fixed_);
+
+    /// Build the grid as the product of the three axes
+    void set_grid(const std::vector<double> & exposure_times_,
+                  const std::vector<double> & isotope_masses_,
+                  const std::vector<double> & background_scales_);
+
+    /// Return the grid points
+    const std::vector<point_type> & get_points() const;
+
+    /// Evaluate the limits of the signal efficiency above each threshold on all grid points
+    void evaluate(const std::vector<double> & signal_above_, std::vector<result_type> & results_) const;
+
+  private:
+
+    size_t                   _number_of_threads_; //!< Number of threads
+    const feldman_cousins *  _feldman_cousins_;   //!< Feldman-Cousins upper limits
+    double                   _signal_factor_;     //!< Halflife per efficiency, excluded event, mass and time
+    std::vector<double>      _bb2nu_;             //!< bb2nu background per mass and time
+    std::vector<double>      _isotope_;           //!< Isotope source background per mass and time
+    std::vector<double>      _fixed_;             //!< Fixed source background per time
+    std::vector<point_type>  _points_;            //!< Grid points
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_SENSITIVITY_GRID_H_
+
+// end of sensitivity_grid.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
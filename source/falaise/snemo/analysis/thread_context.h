@@ -0,0 +1,180 @@
+/* thread_context.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Per-thread working contexts of the plot modules. In shared mode a
+ * single context is used by all callers, in per-thread mode each thread
+ * lazily gets its own context. The contexts are visited in creation
+ * order, which depends on the scheduling of the threads: the reductions
+ * over the contexts must not depend on their order.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_THREAD_CONTEXT_H_
+#define ANALYSIS_THREAD_CONTEXT_H_ 1
+
+// Standard libraries:
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+namespace analysis {
+
+  /// \brief Set of working contexts indexed by thread
+  template <class Context>
+  class thread_context_set
+  {
+  public:
+
+    /// Setup function called on each newly created context
+    typedef std::function<void(Context &)> setup_type;
+
+    /// Constructor
+    thread_context_set()
+    {
+      _per_thread_ = false;
+      _id_ = _next_id();
+      return;
+    }
+
+    /// Initialize in shared or per-thread mode
+    void initialize(bool per_thread_, const setup_type & setup_)
+    {
+      std::lock_guard<std::mutex> lock(_mutex_);
+      _per_thread_ = per_thread_;
+      _setup_ = setup_;
+      _contexts_.clear();
+      _index_.clear();
+      _id_ = _next_id();
+      return;
+    }
+
+    /// Reset and destroy all the contexts
+    void reset()
+    {
+      std::lock_guard<std::mutex> lock(_mutex_);
+      _per_thread_ = false;
+      _setup_ = setup_type();
+      _contexts_.clear();
+      _index_.clear();
+      _id_ = _next_id();
+      return;
+    }
+
+    /// Check the per-thread mode
+    bool is_per_thread() const
+    {
+      return _per_thread_;
+    }
+
+    /// Return the number of contexts
+    size_t size() const
+    {
+      return _contexts_.size();
+    }
+
+    /// Return a context given its creation rank
+    Context & grab(size_t index_)
+    {
+      return *_contexts_.at(index_);
+    }
+
+    /// Return the context of the calling thread, creating it if needed
+    Context & grab_local()
+    {
+      if (! _per_thread_)
+        {
+          if (_contexts_.empty()) _add_context(std::thread::id());
+          return *_contexts_.front();
+        }
+      // Avoid locking when the same thread calls again. The last context
+      // is remembered per set, the identifier of the configuration
+      // discarding the entries of a reset or destroyed set.
+      static thread_local std::map<const thread_context_set *, memo_type> memos;
+      memo_type & memo = memos[this];
+      if (memo.id == _id_) return *memo.context;
+      std::lock_guard<std::mutex> lock(_mutex_);
+      const std::thread::id tid = std::this_thread::get_id();
+      typename std::map<std::thread::id, Context *>::const_iterator found = _index_.find(tid);
+      Context * a_context = found != _index_.end() ? found->second : &_add_context(tid);
+      memo.id = _id_;
+      memo.context = a_context;
+      return *a_context;
+    }
+
+  private:
+
+    /// Last context used by a thread
+    struct memo_type
+    {
+      uint64_t  id      = 0;
+      Context * context = 0;
+    };
+
+    /// Return a unique identifier for each configuration of a set
+    static uint64_t _next_id()
+    {
+      static std::atomic<uint64_t> counter(0);
+      return ++counter;
+    }
+
+    /// Create a new context
+    Context & _add_context(const std::thread::id & tid_)
+    {
+      _contexts_.push_back(std::unique_ptr<Context>(new Context));
+      Context & a_context = *_contexts_.back();
+      _index_[tid_] = &a_context;
+      if (_setup_) _setup_(a_context);
+      return a_context;
+    }
+
+  private:
+
+    bool                                  _per_thread_; //!< Per-thread mode flag
+    uint64_t                              _id_;         //!< Identifier of the current configuration
+    setup_type                            _setup_;      //!< Setup of new contexts
+    std::mutex                            _mutex_;      //!< Protection of the context index
+    std::vector<std::unique_ptr<Context> > _contexts_;  //!< Contexts in creation order
+    std::map<std::thread::id, Context *>  _index_;      //!< Contexts indexed by thread
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_THREAD_CONTEXT_H_
+
+// end of thread_context.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
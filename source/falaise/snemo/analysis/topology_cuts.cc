@@ -0,0 +1,54 @@
+// topology_cuts.cc
+
+// Ourselves:
+#include <snemo/analysis/topology_cuts.h>
+
+// Standard library:
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// Third party:
+// - Falaise:
+#include <falaise/snemo/datamodels/base_topology_pattern.h>
+
+namespace analysis {
+
+  void register_topology_cuts(topology_cut_flow & cut_flow_)
+  {
+    cut_flow_.register_cut("topology", [](const datatools::properties & parameters_)
+      {
+        DT_THROW_IF(! parameters_.has_key("pattern_ids"), std::logic_error,
+                    "Cut 'topology' has no 'pattern_ids' parameter !");
+        std::vector<std::string> pattern_ids;
+        parameters_.fetch("pattern_ids", pattern_ids);
+        // Interned topologies are selected by kind, the other ones by identifier
+        unsigned int kinds = 0;
+        std::vector<std::string> other_ids;
+        for (size_t i = 0; i < pattern_ids.size(); ++i)
+          {
+            const topology_kind kind = topology_registry::kind_of_id(pattern_ids[i]);
+            if (kind != TOPOLOGY_UNKNOWN) kinds |= 1u << kind;
+            else other_ids.push_back(pattern_ids[i]);
+          }
+        return topology_cut_flow::predicate_type([kinds, other_ids](const topology_event & event_)
+          {
+            if (event_.kind != TOPOLOGY_UNKNOWN) return (kinds & (1u << event_.kind)) != 0;
+            if (other_ids.empty()) return false;
+            const std::string a_pattern_id = event_.pattern.get_pattern_id();
+            return std::find(other_ids.begin(), other_ids.end(), a_pattern_id) != other_ids.end();
+          });
+      });
+    return;
+  }
+
+} // namespace analysis
+
+// end of topology_cuts.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,67 @@
+/* topology_cuts.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Cuts on the topology pattern shared by the plot modules.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_TOPOLOGY_CUTS_H_
+#define ANALYSIS_TOPOLOGY_CUTS_H_ 1
+
+// This project:
+#include <snemo/analysis/cut_flow.h>
+#include <snemo/analysis/topology_dispatch.h>
+
+namespace analysis {
+
+  /// Topology pattern of an event, interned once per event
+  struct topology_event
+  {
+    const snemo::datamodel::base_topology_pattern & pattern; //!< Topology pattern
+    topology_kind                                   kind;    //!< Interned topology of the pattern
+  };
+
+  /// Cut flow applied to the topology pattern of an event
+  typedef cut_flow<const topology_event> topology_cut_flow;
+
+  /// Register the topology cuts:
+  ///  - 'topology' : the pattern identifier is one of the 'pattern_ids' parameter,
+  ///                 the interned topologies being compared without their identifier
+  void register_topology_cuts(topology_cut_flow & cut_flow_);
+
+} // namespace analysis
+
+#endif // ANALYSIS_TOPOLOGY_CUTS_H_
+
+// end of topology_cuts.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,92 @@
+// topology_dispatch.cc
+
+// Ourselves:
+#include <snemo/analysis/topology_dispatch.h>
+
+// Standard library:
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  namespace {
+
+    // Pattern identifiers indexed by topology
+    const std::string & interned_pattern_id(size_t kind_)
+    {
+      static const std::string ids[NUMBER_OF_TOPOLOGIES + 1] = { "1e", "2e", "1eNg", "" };
+      return ids[std::min<size_t>(kind_, NUMBER_OF_TOPOLOGIES)];
+    }
+
+  }
+
+  const std::string & topology_registry::pattern_id(topology_kind kind_)
+  {
+    return interned_pattern_id(kind_);
+  }
+
+  topology_kind topology_registry::kind_of_id(const std::string & pattern_id_)
+  {
+    for (size_t kind = 0; kind < NUMBER_OF_TOPOLOGIES; ++kind)
+      {
+        if (interned_pattern_id(kind) == pattern_id_) return static_cast<topology_kind>(kind);
+      }
+    return TOPOLOGY_UNKNOWN;
+  }
+
+  topology_registry::topology_registry()
+  {
+    return;
+  }
+
+  void topology_registry::reset()
+  {
+    _enabled_.clear();
+    return;
+  }
+
+  void topology_registry::enable(const std::string & pattern_id_)
+  {
+    const topology_kind kind = kind_of_id(pattern_id_);
+    DT_THROW_IF(kind == TOPOLOGY_UNKNOWN, std::logic_error, "Unsupported topology '" << pattern_id_ << "' !");
+    if (! is_enabled(kind)) _enabled_.push_back(kind);
+    return;
+  }
+
+  bool topology_registry::is_enabled(topology_kind kind_) const
+  {
+    return std::find(_enabled_.begin(), _enabled_.end(), kind_) != _enabled_.end();
+  }
+
+  std::vector<std::string> topology_registry::get_pattern_ids() const
+  {
+    std::vector<std::string> ids;
+    for (size_t i = 0; i < _enabled_.size(); ++i) ids.push_back(pattern_id(_enabled_[i]));
+    return ids;
+  }
+
+  topology_kind topology_registry::intern(const snemo::datamodel::base_topology_pattern & pattern_)
+  {
+    return kind_of_id(pattern_.get_pattern_id());
+  }
+
+  topology_kind topology_registry::kind_of(const snemo::datamodel::base_topology_pattern & pattern_) const
+  {
+    const topology_kind kind = intern(pattern_);
+    return is_enabled(kind) ? kind : TOPOLOGY_UNKNOWN;
+  }
+
+} // namespace analysis
+
+// end of topology_dispatch.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,161 @@
+/* topology_dispatch.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Dispatch of the topology patterns to code specialised for each pattern
+ * class. Pattern identifiers are interned once into integer kinds so that
+ * the dispatch uses neither string keyed maps nor RTTI.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_TOPOLOGY_DISPATCH_H_
+#define ANALYSIS_TOPOLOGY_DISPATCH_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <utility>
+
+// Third party:
+// - Falaise:
+#include <falaise/snemo/datamodels/base_topology_pattern.h>
+#include <falaise/snemo/datamodels/topology_1e_pattern.h>
+#include <falaise/snemo/datamodels/topology_2e_pattern.h>
+#include <falaise/snemo/datamodels/topology_1eNg_pattern.h>
+
+namespace analysis {
+
+  /// Interned topologies
+  enum topology_kind {
+    TOPOLOGY_1E          = 0, //!< One electron
+    TOPOLOGY_2E          = 1, //!< Two electrons
+    TOPOLOGY_1ENG        = 2, //!< One electron and gammas
+    NUMBER_OF_TOPOLOGIES = 3, //!< Number of interned topologies
+    TOPOLOGY_UNKNOWN     = 3  //!< Topology not interned or not enabled
+  };
+
+  /// Compile-time properties of a topology pattern class
+  template <class Pattern>
+  struct topology_traits;
+
+  template <>
+  struct topology_traits<snemo::datamodel::topology_1e_pattern>
+  {
+    static const topology_kind kind = TOPOLOGY_1E;
+  };
+
+  template <>
+  struct topology_traits<snemo::datamodel::topology_2e_pattern>
+  {
+    static const topology_kind kind = TOPOLOGY_2E;
+  };
+
+  template <>
+  struct topology_traits<snemo::datamodel::topology_1eNg_pattern>
+  {
+    static const topology_kind kind = TOPOLOGY_1ENG;
+  };
+
+  /// \brief Registry of the enabled topologies
+  class topology_registry
+  {
+  public:
+
+    /// Return the pattern identifier of a topology
+    static const std::string & pattern_id(topology_kind kind_);
+
+    /// Return the topology of a pattern identifier, TOPOLOGY_UNKNOWN if not interned
+    static topology_kind kind_of_id(const std::string & pattern_id_);
+
+    /// Return the topology of a pattern, TOPOLOGY_UNKNOWN if not interned
+    static topology_kind intern(const snemo::datamodel::base_topology_pattern & pattern_);
+
+    /// Constructor
+    topology_registry();
+
+    /// Disable all the topologies
+    void reset();
+
+    /// Enable a topology given its pattern identifier
+    void enable(const std::string & pattern_id_);
+
+    /// Check if a topology is enabled
+    bool is_enabled(topology_kind kind_) const;
+
+    /// Return the pattern identifiers of the enabled topologies
+    std::vector<std::string> get_pattern_ids() const;
+
+    /// Return the topology of a pattern, TOPOLOGY_UNKNOWN if not enabled
+    topology_kind kind_of(const snemo::datamodel::base_topology_pattern & pattern_) const;
+
+    /// Call visitor_ with the pattern cast to its concrete class, return false if the topology is not enabled
+    template <class Visitor>
+    bool dispatch(const snemo::datamodel::base_topology_pattern & pattern_, Visitor && visitor_) const
+    {
+      return dispatch(pattern_, intern(pattern_), std::forward<Visitor>(visitor_));
+    }
+
+    /// Same as above for a pattern already interned as kind_
+    template <class Visitor>
+    bool dispatch(const snemo::datamodel::base_topology_pattern & pattern_,
+                  topology_kind kind_,
+                  Visitor && visitor_) const
+    {
+      if (! is_enabled(kind_)) return false;
+      // The interned identifier guarantees the concrete class of the pattern
+      switch (kind_)
+        {
+        case TOPOLOGY_1E:
+          visitor_(static_cast<const snemo::datamodel::topology_1e_pattern &>(pattern_));
+          return true;
+        case TOPOLOGY_2E:
+          visitor_(static_cast<const snemo::datamodel::topology_2e_pattern &>(pattern_));
+          return true;
+        case TOPOLOGY_1ENG:
+          visitor_(static_cast<const snemo::datamodel::topology_1eNg_pattern &>(pattern_));
+          return true;
+        default:
+          return false;
+        }
+    }
+
+  private:
+
+    std::vector<topology_kind> _enabled_; //!< Enabled topologies in enabling order
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_TOPOLOGY_DISPATCH_H_
+
+// end of topology_dispatch.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
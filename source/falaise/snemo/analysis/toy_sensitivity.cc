@@ -0,0 +1,209 @@
+// toy_sensitivity.cc
+
+// Ourselves:
+#include <snemo/analysis/toy_sensitivity.h>
+
+// This project:
+#include <snemo/analysis/parallel_for.h>
+
+// Standard library:
+#include <cmath>
+#include <mutex>
+#include <limits>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+#include <datatools/utils.h>
+
+namespace analysis {
+
+  // Number of toys sharing a block of uniform numbers.
+  const size_t TOY_BLOCK_SIZE = 256;
+
+  // SplitMix64 finalizer.
+  inline uint64_t mix64(uint64_t z_)
+  {
+    z_ = (z_ ^ (z_ >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z_ = (z_ ^ (z_ >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z_ ^ (z_ >> 31);
+  }
+
+  double toy_sensitivity::uniform(uint64_t seed_, uint64_t stream_, uint64_t counter_)
+  {
+    const uint64_t key = mix64(seed_ + mix64(stream_ + UINT64_C(0x9E3779B97F4A7C15)));
+    const uint64_t bits = mix64(key + counter_ * UINT64_C(0x9E3779B97F4A7C15));
+    return (bits >> 11) * (1.0 / 9007199254740992.0);
+  }
+
+  toy_sensitivity::toy_sensitivity()
+  {
+    _number_of_toys_ = 0;
+    _seed_ = 0;
+    _number_of_threads_ = default_number_of_threads();
+    _halflife_factor_ = 1.0;
+    return;
+  }
+
+  void toy_sensitivity::set_number_of_toys(size_t number_of_toys_)
+  {
+    _number_of_toys_ = number_of_toys_;
+    return;
+  }
+
+  size_t toy_sensitivity::get_number_of_toys() const
+  {
+    return _number_of_toys_;
+  }
+
+  void toy_sensitivity::set_seed(uint64_t seed_)
+  {
+    _seed_ = seed_;
+    return;
+  }
+
+  void toy_sensitivity::set_number_of_threads(size_t number_of_threads_)
+  {
+    DT_THROW_IF(number_of_threads_ == 0, std::domain_error, "Invalid number of threads !");
+    _number_of_threads_ = number_of_threads_;
+    return;
+  }
+
+  void toy_sensitivity::set_upper_limit_function(const upper_limit_function_type & function_)
+  {
+    _upper_limit_ = function_;
+    return;
+  }
+
+  void toy_sensitivity::set_halflife_factor(double factor_)
+  {
+    _halflife_factor_ = factor_;
+    return;
+  }
+
+  toy_sensitivity::band_type toy_sensitivity::compute(uint64_t stream_,
+                                                      double signal_efficiency_,
+                                                      double background_counts_) const
+  {
+    return _compute(stream_, signal_efficiency_, background_counts_, _number_of_threads_);
+  }
+
+  void toy_sensitivity::compute(const std::vector<window_type> & windows_, std::vector<band_type> & bands_) const
+  {
+    bands_.resize(windows_.size());
+    parallel_for(windows_.size(), _number_of_threads_,
+                 [&](size_t first_, size_t last_)
+                 {
+                   for (size_t i = first_; i < last_; ++i)
+                     {
+                       const window_type & a_window = windows_[i];
+                       bands_[i] = _compute(a_window.stream, a_window.signal_efficiency,
+                                            a_window.background_counts, 1);
+                     }
+                 });
+    return;
+  }
+
+  toy_sensitivity::band_type toy_sensitivity::_compute(uint64_t stream_,
+                                                       double signal_efficiency_,
+                                                       double background_counts_,
+                                                       size_t number_of_threads_) const
+  {
+    DT_THROW_IF(! _upper_limit_, std::logic_error, "Missing upper limit function !");
+    DT_THROW_IF(_number_of_toys_ == 0, std::logic_error, "No pseudo-experiment to run !");
+    band_type a_band;
+    datatools::invalidate(a_band.minus_2sigma);
+    datatools::invalidate(a_band.minus_1sigma);
+    datatools::invalidate(a_band.median);
+    datatools::invalidate(a_band.plus_1sigma);
+    datatools::invalidate(a_band.plus_2sigma);
+    if (! (background_counts_ >= 0.0)) return a_band;
+
+    // Cumulative Poisson distribution of the counts [min_count, max_count]
+    // around the mode, the tails beyond are negligible. The probabilities
+    // are computed in log space, exp(-background) underflows for large
+    // backgrounds.
+    const double background = background_counts_;
+    const double tail = 20.0 * std::sqrt(background) + 30.0;
+    const size_t min_count = background > tail ? static_cast<size_t>(background - tail) : 0;
+    const size_t max_count = static_cast<size_t>(background + tail);
+    std::vector<double> cdf;
+    cdf.reserve(max_count - min_count + 1);
+    const double log_background = background > 0.0 ? std::log(background) : -std::numeric_limits<double>::infinity();
+    double sum = 0.0;
+    for (size_t k = min_count; k <= max_count; ++k)
+      {
+        const double log_probability = (k > 0 ? k * log_background : 0.0) - background - std::lgamma(k + 1.0);
+        sum += std::exp(log_probability);
+        cdf.push_back(sum);
+      }
+    for (size_t n = 0; n < cdf.size(); ++n) cdf[n] /= sum;
+    cdf.back() = 1.0;
+
+    // Number of toys per observed count, offset by min_count
+    std::vector<uint64_t> counts(cdf.size(), 0);
+    std::mutex counts_mutex;
+    const size_t nblocks = (_number_of_toys_ + TOY_BLOCK_SIZE - 1) / TOY_BLOCK_SIZE;
+    parallel_for(nblocks, number_of_threads_,
+                 [&](size_t first_, size_t last_)
+                 {
+                   std::vector<uint64_t> local_counts(cdf.size(), 0);
+                   double u[TOY_BLOCK_SIZE];
+                   for (size_t block = first_; block < last_; ++block)
+                     {
+                       const size_t first_toy = block * TOY_BLOCK_SIZE;
+                       const size_t ntoys = std::min(TOY_BLOCK_SIZE, _number_of_toys_ - first_toy);
+                       for (size_t j = 0; j < ntoys; ++j)
+                         {
+                           u[j] = uniform(_seed_, stream_, first_toy + j);
+                         }
+                       for (size_t j = 0; j < ntoys; ++j)
+                         {
+                           const size_t n = std::upper_bound(cdf.begin(), cdf.end(), u[j]) - cdf.begin();
+                           local_counts[std::min(n, cdf.size() - 1)]++;
+                         }
+                     }
+                   std::lock_guard<std::mutex> lock(counts_mutex);
+                   for (size_t n = 0; n < counts.size(); ++n) counts[n] += local_counts[n];
+                 });
+
+    // Halflife limit of each observed count, sorted by increasing limit
+    std::vector<std::pair<double, uint64_t> > limits;
+    for (size_t n = 0; n < counts.size(); ++n)
+      {
+        if (counts[n] == 0) continue;
+        const double halflife = signal_efficiency_ / _upper_limit_(min_count + n, background) * _halflife_factor_;
+        limits.push_back(std::make_pair(halflife, counts[n]));
+      }
+    std::sort(limits.begin(), limits.end());
+
+    // Quantiles
+    const double quantiles[] = { 0.02275, 0.15866, 0.5, 0.84134, 0.97725 };
+    double * values[] = { &a_band.minus_2sigma, &a_band.minus_1sigma, &a_band.median,
+                          &a_band.plus_1sigma, &a_band.plus_2sigma };
+    uint64_t cumulated = 0;
+    size_t iq = 0;
+    for (size_t i = 0; i < limits.size() && iq < 5; ++i)
+      {
+        cumulated += limits[i].second;
+        while (iq < 5 && cumulated >= quantiles[iq] * _number_of_toys_)
+          {
+            *values[iq++] = limits[i].first;
+          }
+      }
+    return a_band;
+  }
+
+} // namespace analysis
+
+// end of toy_sensitivity.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
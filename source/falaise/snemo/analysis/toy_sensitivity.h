@@ -0,0 +1,137 @@
+/* toy_sensitivity.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Pseudo-experiments of the background counts in an energy window and
+ * the resulting bands of the halflife limit.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_TOY_SENSITIVITY_H_
+#define ANALYSIS_TOY_SENSITIVITY_H_ 1
+
+// Standard libraries:
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace analysis {
+
+  /// \brief Toy Monte Carlo sensitivity of an energy window
+  ///
+  /// Each pseudo-experiment draws a Poisson number of background events
+  /// from the expected background of the window and computes the halflife
+  /// limit from the upper limit at that observed count. Random numbers come
+  /// from a counter-based generator keyed by the seed, the window stream and
+  /// the toy index, so the bands only depend on the seed whatever the number
+  /// of threads. Poisson counts are drawn by inverse cumulative distribution
+  /// on blocks of uniform numbers, the distribution being tabulated in log
+  /// space around its mode so that large backgrounds do not underflow. A
+  /// single window spreads its toys over the threads, a batch of windows
+  /// spreads the windows.
+  class toy_sensitivity
+  {
+  public:
+
+    /// Upper limit on the signal for an observed count and an expected background
+    typedef std::function<double(size_t, double)> upper_limit_function_type;
+
+    /// Quantiles of the halflife limit
+    struct band_type
+    {
+      double minus_2sigma; //!< 2.3% quantile
+      double minus_1sigma; //!< 15.9% quantile
+      double median;       //!< 50% quantile
+      double plus_1sigma;  //!< 84.1% quantile
+      double plus_2sigma;  //!< 97.7% quantile
+    };
+
+    /// Window of a batch of pseudo-experiments
+    struct window_type
+    {
+      uint64_t stream;            //!< Random stream of the window
+      double   signal_efficiency; //!< Signal efficiency in the window
+      double   background_counts; //!< Number of background events in the window
+    };
+
+    /// Return a uniform number in [0, 1) from the counter-based generator
+    static double uniform(uint64_t seed_, uint64_t stream_, uint64_t counter_);
+
+    /// Constructor
+    toy_sensitivity();
+
+    /// Set the number of pseudo-experiments per window
+    void set_number_of_toys(size_t number_of_toys_);
+
+    /// Return the number of pseudo-experiments per window
+    size_t get_number_of_toys() const;
+
+    /// Set the seed
+    void set_seed(uint64_t seed_);
+
+    /// Set the number of threads
+    void set_number_of_threads(size_t number_of_threads_);
+
+    /// Set the upper limit function
+    void set_upper_limit_function(const upper_limit_function_type & function_);
+
+    /// Set the factor converting efficiency per excluded event into halflife
+    void set_halflife_factor(double factor_);
+
+    /// Compute the halflife bands of a window, identified by its random stream
+    band_type compute(uint64_t stream_, double signal_efficiency_, double background_counts_) const;
+
+    /// Compute the halflife bands of many windows, with the same bands as one window at a time
+    void compute(const std::vector<window_type> & windows_, std::vector<band_type> & bands_) const;
+
+  private:
+
+    /// Compute the halflife bands of a window with the toys spread over some threads
+    band_type _compute(uint64_t stream_,
+                       double signal_efficiency_,
+                       double background_counts_,
+                       size_t number_of_threads_) const;
+
+    size_t                    _number_of_toys_;    //!< Number of pseudo-experiments per window
+    uint64_t                  _seed_;              //!< Seed of the generator
+    size_t                    _number_of_threads_; //!< Number of threads
+    upper_limit_function_type _upper_limit_;       //!< Upper limit function
+    double                    _halflife_factor_;   //!< Halflife per efficiency and excluded event
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_TOY_SENSITIVITY_H_
+
+// end of toy_sensitivity.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
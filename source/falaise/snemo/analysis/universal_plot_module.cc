@@ -3,10 +3,17 @@
 // Ourselves:
 #include <snemo/analysis/universal_plot_module.h>
 
+// This project:
+#include <snemo/analysis/bank_utils.h>
+#include <snemo/analysis/histogram_pool_utils.h>
+#include <snemo/analysis/plot_conventions.h>
+
 // Standard library:
 #include <stdexcept>
 #include <sstream>
 #include <algorithm>
+#include <functional>
+#include <type_traits>
 
 // Third party:
 // - Boost:
@@ -37,17 +44,61 @@
 
 #include <falaise/snemo/datamodels/topology_data.h>
 #include <falaise/snemo/datamodels/topology_1e_pattern.h>
+#include <falaise/snemo/datamodels/topology_2e_pattern.h>
+#include <falaise/snemo/datamodels/topology_1eNg_pattern.h>
 #include <falaise/snemo/datamodels/vertex_measurement.h>
 
 namespace analysis {
 
+  namespace {
+
+    /// Energy filled for the events of a topology
+    template <class Pattern>
+    struct topology_energy;
+
+    template <>
+    struct topology_energy<snemo::datamodel::topology_1e_pattern>
+    {
+      static double compute(const snemo::datamodel::topology_1e_pattern & pattern_,
+                            const snemo::datamodel::particle_track_data & /*ptd_*/,
+                            calorimeter_block_set & /*blocks_*/)
+      {
+        return pattern_.get_electron_energy();
+      }
+    };
+
+    template <>
+    struct topology_energy<snemo::datamodel::topology_2e_pattern>
+    {
+      // Calorimeter energy of the particles, each block being counted once
+      static double compute(const snemo::datamodel::topology_2e_pattern & /*pattern_*/,
+                            const snemo::datamodel::particle_track_data & ptd_,
+                            calorimeter_block_set & blocks_)
+      {
+        return associated_calorimeter_energy(ptd_, blocks_);
+      }
+    };
+
+    template <>
+    struct topology_energy<snemo::datamodel::topology_1eNg_pattern>
+    {
+      static double compute(const snemo::datamodel::topology_1eNg_pattern & pattern_,
+                            const snemo::datamodel::particle_track_data & /*ptd_*/,
+                            calorimeter_block_set & /*blocks_*/)
+      {
+        double energy;
+        datatools::invalidate(energy);
+        if (pattern_.has_total_energy()) energy = pattern_.get_total_energy();
+        return energy;
+      }
+    };
+
+  }
+
   // Registration instantiation macro :
   DPP_MODULE_REGISTRATION_IMPLEMENT(universal_plot_module,
                                     "analysis::universal_plot_module");
 
-  // Character separator between key for histogram dict.
-  const char KEY_FIELD_SEPARATOR = '_';
-
   // Set the histogram pool used by the module :
   void universal_plot_module::set_histogram_pool(mygsl::histogram_pool & pool_)
   {
@@ -67,13 +118,128 @@ namespace analysis {
 
   void universal_plot_module::_set_defaults()
   {
+    _EH_label_ = snemo::datamodel::data_info::default_event_header_label();
+    _PTD_label_ = snemo::datamodel::data_info::default_particle_track_data_label();
+    _TD_label_ = "TD";
+    _fill_buffer_size_ = 0;
+    _sharded_ = false;
+    _weighted_fill_ = false;
+    _atomic_backend_ = false;
     _key_fields_.clear ();
+    _key_plan_.reset();
+    _weight_rules_.reset();
 
     _histogram_pool_ = 0;
+    _contexts_.reset();
+    _checkpoint_.reset();
+    _cut_flow_.reset();
+    _topologies_.reset();
+    _atomic_histograms_.reset();
+
+    return;
+  }
 
+  void universal_plot_module::_report_cut_flow()
+  {
+    if (get_logging_priority() < datatools::logger::PRIO_NOTICE) return;
+    topology_cut_flow total = _cut_flow_;
+    total.reset_counters();
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        total.merge(_contexts_.grab(i).cut_flow);
+      }
+    DT_LOG_NOTICE(get_logging_priority(), "Cut flow of module '" << get_name() << "' :");
+    total.print_table(std::clog, "  ");
+    return;
+  }
+
+  void universal_plot_module::_setup_context(worker_context_type & context_)
+  {
+    context_.pool = _histogram_pool_;
+    if (_sharded_)
+      {
+        context_.shard.reset(new mygsl::histogram_pool);
+        context_.shard->initialize(datatools::properties());
+        context_.pool = context_.shard.get();
+      }
+    context_.key_plan = _key_plan_;
+    context_.weight_rules = _weight_rules_;
+    context_.buffered_events = 0;
+    context_.cut_flow = _cut_flow_;
+    return;
+  }
+
+  void universal_plot_module::_flush_fillers(worker_context_type & context_)
+  {
+    for (histogram_cache_type::iterator
+           ientry = context_.histogram_cache.begin();
+         ientry != context_.histogram_cache.end(); ++ientry)
+      {
+        ientry->second.filler.flush();
+      }
     return;
   }
 
+  void universal_plot_module::_merge_contexts()
+  {
+    // The shards are summed in an order that does not depend on the threads
+    std::vector<const mygsl::histogram_pool *> shards;
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        worker_context_type & a_context = _contexts_.grab(i);
+        _flush_fillers(a_context);
+        if (a_context.shard) shards.push_back(a_context.shard.get());
+      }
+    merge_histogram_pools(*_histogram_pool_, shards);
+    if (_atomic_histograms_.is_initialized())
+      {
+        _atomic_histograms_.export_histograms();
+      }
+    return;
+  }
+
+  std::string universal_plot_module::_build_histogram_name(const datatools::properties & eh_properties_,
+                                                           topology_kind topology_) const
+  {
+    std::ostringstream key;
+    _key_plan_.build_name(eh_properties_, key);
+    plot_conventions::append_universal_name(key, topology_);
+    return key.str();
+  }
+
+  mygsl::histogram_1d & universal_plot_module::_register_histogram(mygsl::histogram_pool & pool_,
+                                                                   const std::string & name_,
+                                                                   const std::string & group_)
+  {
+    mygsl::histogram_1d & h
+      = plot_conventions::grab_mimic_1d(pool_, name_, group_, plot_conventions::ENERGY_TEMPLATE, *_histogram_pool_);
+    _checkpoint_.own(name_);
+    return h;
+  }
+
+  void universal_plot_module::_tag_histogram(mygsl::histogram_1d & histogram_, double weight_) const
+  {
+    datatools::properties & aux = histogram_.grab_auxiliaries();
+    if (_weighted_fill_)
+      {
+        // Contents are already weighted, no global weight to apply
+        if (! aux.has_key("weighted")) aux.update("weighted", true);
+      }
+    else if (! aux.has_key("weight"))
+      {
+        // Rule weight of the events, to be applied to the whole histogram
+        aux.update("weight", weight_);
+      }
+    return;
+  }
+
+  double universal_plot_module::_histogram_weight(const mygsl::histogram_1d & histogram_) const
+  {
+    const datatools::properties & aux = histogram_.get_auxiliaries();
+    if (aux.has_key("weight")) return aux.fetch_real("weight");
+    return 1.0;
+  }
+
   // Initialization :
   void universal_plot_module::initialize(const datatools::properties  & config_,
                                        datatools::service_manager   & service_manager_,
@@ -85,11 +251,92 @@ namespace analysis {
 
     dpp::base_module::_common_initialize(config_);
 
+    // Labels of the input banks :
+    if (config_.has_key("EH_label"))
+      {
+        _EH_label_ = config_.fetch_string("EH_label");
+      }
+    if (config_.has_key("PTD_label"))
+      {
+        _PTD_label_ = config_.fetch_string("PTD_label");
+      }
+    if (config_.has_key("TD_label"))
+      {
+        _TD_label_ = config_.fetch_string("TD_label");
+      }
+
+    // Number of events staged before filling the histograms :
+    if (config_.has_key("fill_buffer_size"))
+      {
+        const int fill_buffer_size = config_.fetch_integer("fill_buffer_size");
+        DT_THROW_IF(fill_buffer_size < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'fill_buffer_size' property !");
+        _fill_buffer_size_ = fill_buffer_size;
+      }
+
     // Get the keys from 'Event Header' bank
     if (config_.has_key("key_fields"))
       {
         config_.fetch("key_fields", _key_fields_);
       }
+    _key_plan_.initialize(_key_fields_, get_logging_priority());
+
+    // Get the event weight rules, the legacy ones being used by default
+    datatools::properties weight_config;
+    config_.export_and_rename_starting_with(weight_config, "weight_rules.", "");
+    _weight_rules_.initialize(weight_config, get_logging_priority());
+
+    // Fill a private pool shard per processing thread :
+    if (config_.has_key("sharded"))
+      {
+        _sharded_ = config_.fetch_boolean("sharded");
+      }
+
+    // Fill the histograms with the event weights and their squares :
+    if (config_.has_key("weighted_fill"))
+      {
+        _weighted_fill_ = config_.fetch_boolean("weighted_fill");
+      }
+
+    // Histogram backend :
+    if (config_.has_key("fill_backend"))
+      {
+        const std::string fill_backend = config_.fetch_string("fill_backend");
+        DT_THROW_IF(fill_backend != "default" && fill_backend != "atomic", std::logic_error,
+                    "Module '" << get_name() << "' has an invalid 'fill_backend' property '"
+                    << fill_backend << "' !");
+        _atomic_backend_ = (fill_backend == "atomic");
+      }
+    DT_THROW_IF(_atomic_backend_ && _sharded_, std::logic_error,
+                "Module '" << get_name() << "' can not use the 'atomic' backend with sharded pools !");
+    if (_atomic_backend_ && _fill_buffer_size_ > 0)
+      {
+        DT_LOG_WARNING(get_logging_priority(), "The 'fill_buffer_size' property is ignored by the 'atomic' backend !");
+        _fill_buffer_size_ = 0;
+      }
+    _contexts_.initialize(_sharded_ || _atomic_backend_,
+                          std::bind(&universal_plot_module::_setup_context, this, std::placeholders::_1));
+
+    // Store the histograms every 'checkpoint.period_events' events or 'checkpoint.period_seconds' seconds :
+    datatools::properties checkpoint_config;
+    config_.export_and_rename_starting_with(checkpoint_config, "checkpoint.", "");
+    _checkpoint_.initialize(checkpoint_config, get_name());
+    DT_THROW_IF(_checkpoint_.is_enabled() && (_sharded_ || _atomic_backend_), std::logic_error,
+                "Module '" << get_name() << "' cannot checkpoint sharded or atomic histograms !");
+
+    // Topologies filled in the same pass, the legacy 1e one by default :
+    const std::vector<std::string> topologies = plot_conventions::fetch_topologies(config_, "1e");
+    for (size_t i = 0; i < topologies.size(); ++i)
+      {
+        _topologies_.enable(topologies[i]);
+      }
+
+    // Cuts applied to the topology pattern, only the filled topologies by default :
+    datatools::properties cut_flow_config;
+    config_.export_and_rename_starting_with(cut_flow_config, "cut_flow.", "");
+    plot_conventions::set_default_pattern_ids(cut_flow_config, _topologies_.get_pattern_ids());
+    register_topology_cuts(_cut_flow_);
+    _cut_flow_.initialize(cut_flow_config, std::vector<std::string>(1, "topology"));
 
     // Service label
     std::string histogram_label;
@@ -130,6 +377,11 @@ namespace analysis {
             }
           }
 
+        if (_atomic_backend_) _atomic_histograms_.initialize(*_histogram_pool_);
+
+        // Resume from the last checkpoint :
+        _checkpoint_.restore(*_histogram_pool_);
+
         // Tag the module as initialized :
         _set_initialized(true);
         return;
@@ -142,6 +394,15 @@ namespace analysis {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Fill the histograms with the remaining staged values and merge the shards :
+    _merge_contexts();
+
+    // Report the cut flow
+    _report_cut_flow();
+
+    // The run is complete, the checkpoint is not needed anymore :
+    _checkpoint_.terminate();
+
     // Tag the module as un-initialized :
     _set_initialized(false);
     _set_defaults();
@@ -170,40 +431,50 @@ namespace analysis {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Working context of the calling thread :
+    worker_context_type & a_context = _contexts_.grab_local();
+
+    // Skip the events already counted by the restored checkpoint, store a new one when due
+    // and fill the histograms with the staged values every 'fill_buffer_size' events :
+    if (begin_checkpointed_event(_checkpoint_, *_histogram_pool_, _fill_buffer_size_, a_context.buffered_events,
+                                 [&]() { _flush_fillers(a_context); }))
+      {
+        return dpp::base_module::PROCESS_CONTINUE;
+      }
+
     // Check if the 'event header' record bank is available :
-    const std::string eh_label = snemo::datamodel::data_info::default_event_header_label();
-    if (! data_record_.has(eh_label))
+    const snemo::datamodel::event_header * eh_bank
+      = try_get_bank<snemo::datamodel::event_header>(data_record_, _EH_label_);
+    if (! eh_bank)
       {
         DT_LOG_ERROR(get_logging_priority(), "Could not find any bank with label '"
-                     << eh_label << "' !");
+                     << _EH_label_ << "' !");
         return dpp::base_module::PROCESS_STOP;
       }
-    const snemo::datamodel::event_header & eh
-      = data_record_.get<snemo::datamodel::event_header>(eh_label);
+    const snemo::datamodel::event_header & eh = *eh_bank;
 
     // Check if the 'particle track' record bank is available :
-    const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-    if (! data_record_.has(ptd_label))
+    const snemo::datamodel::particle_track_data * ptd_bank
+      = try_get_bank<snemo::datamodel::particle_track_data>(data_record_, _PTD_label_);
+    if (! ptd_bank)
       {
         DT_LOG_ERROR(get_logging_priority (), "Could not find any bank with label '"
-                     << ptd_label << "' !");
+                     << _PTD_label_ << "' !");
         return dpp::base_module::PROCESS_STOP;
       }
 
-    const snemo::datamodel::particle_track_data & ptd
-      = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
+    const snemo::datamodel::particle_track_data & ptd = *ptd_bank;
 
     // Check if some 'topology_data' are available in the data model:
-    // const std::string td_label = snemo::datamodel::data_info::default_topology_data_label();
-    const std::string td_label = "TD";
-    if (! data_record_.has(td_label)) {
+    const snemo::datamodel::topology_data * td_bank
+      = try_get_bank<snemo::datamodel::topology_data>(data_record_, _TD_label_);
+    if (! td_bank) {
       DT_LOG_ERROR(get_logging_priority(), "Missing topology data to be processed !");
       return dpp::base_module::PROCESS_ERROR;
     }
 
     // Get the 'topology_data' entry from the data model :
-    const snemo::datamodel::topology_data & td
-      = data_record_.get<snemo::datamodel::topology_data>(td_label);
+    const snemo::datamodel::topology_data & td = *td_bank;
 
     DT_LOG_DEBUG(get_logging_priority(), "Topology data : ");
     if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) td.tree_dump();
@@ -214,101 +485,115 @@ namespace analysis {
     }
     const snemo::datamodel::base_topology_pattern & a_pattern = td.get_pattern();
 
-    const std::string & a_pattern_id = a_pattern.get_pattern_id();
+    // The pattern identifier is interned once for the cuts and the dispatch :
+    const topology_event an_event = { a_pattern, topology_registry::intern(a_pattern) };
+    if (! a_context.cut_flow.select(an_event)) {
+      DT_LOG_DEBUG(get_logging_priority(), "Event rejected by the cut flow !");
+      return dpp::base_module::PROCESS_CONTINUE;
+    }
 
-    if (a_pattern_id != "1e") {
-      DT_LOG_WARNING(get_logging_priority(), "PlotModule only works for '2e' topology for now !");
+    // Energy computed by the specialisation of the event topology :
+    const topology_kind topology = an_event.kind;
+    double energy;
+    datatools::invalidate(energy);
+    const bool dispatched = _topologies_.dispatch(a_pattern, topology, [&](const auto & a_topology_pattern)
+      {
+        typedef typename std::decay<decltype(a_topology_pattern)>::type pattern_type;
+        energy = topology_energy<pattern_type>::compute(a_topology_pattern, ptd, a_context.calorimeter_blocks);
+      });
+    if (! dispatched) {
+      DT_LOG_DEBUG(get_logging_priority(), "Topology '" << a_pattern.get_pattern_id() << "' is not filled !");
       return dpp::base_module::PROCESS_CONTINUE;
     }
 
-    const snemo::datamodel::topology_1e_pattern & a_1e_pattern
-      = dynamic_cast<const snemo::datamodel::topology_1e_pattern &>(a_pattern);
+    const datatools::properties & eh_properties = eh.get_properties();
 
-    double energy = a_1e_pattern.get_electron_energy();
+    // Weight from the generator label rules, matched once per label
+    const double rule_weight = a_context.weight_rules.compute_weight(eh_properties);
 
-    // Getting histogram pool
-    mygsl::histogram_pool & a_pool = grab_histogram_pool();
+    // The generator weight changes from event to event, it is only applied to weighted fills
+    double weight = rule_weight;
+    if (eh_properties.has_key(mctools::event_utils::EVENT_GENBB_WEIGHT))
+      {
+        weight *= eh_properties.fetch_real(mctools::event_utils::EVENT_GENBB_WEIGHT);
+      }
 
+    // Build compact key for the histogram cache:
+    a_context.cache_key.assign(1, char('0' + topology));
+    a_context.key_plan.build_key(eh_properties, a_context.cache_key);
 
-    // Build unique key for histogram map:
-    std::ostringstream key;
-    // Retrieving info from header bank:
-    const datatools::properties & eh_properties = eh.get_properties();
-    for (std::vector<std::string>::const_iterator
-           ifield = _key_fields_.begin();
-         ifield != _key_fields_.end(); ++ifield)
+    histogram_cache_type::iterator found = a_context.histogram_cache.find(a_context.cache_key);
+    if (found == a_context.histogram_cache.end())
       {
-        const std::string & a_field = *ifield;
-        if (! eh_properties.has_key(a_field))
+        // Resolve the histogram from the pool only once per key:
+        const std::string key = _build_histogram_name(eh_properties, topology);
+        const std::string sumw2_key = key + plot_conventions::SUMW2_SUFFIX;
+        histogram_entry_type entry;
+        entry.atomic = 0;
+        entry.atomic_sumw2 = 0;
+        if (_atomic_backend_)
           {
-            DT_LOG_WARNING(get_logging_priority(),
-                           "No properties with key '" << a_field << "' "
-                           << "has been found in event header !");
-            continue;
+            // The shared histograms are created and tagged under lock
+            atomic_histogram_registry::builder_1d_type builder
+              = [this, &key, rule_weight](mygsl::histogram_pool & pool_) -> mygsl::histogram_1d &
+              {
+                mygsl::histogram_1d & h = _register_histogram(pool_, key, plot_conventions::UNIVERSAL_GROUP);
+                _tag_histogram(h, rule_weight);
+                return h;
+              };
+            entry.atomic = &_atomic_histograms_.grab_1d(key, builder);
+            entry.rule_weight = _histogram_weight(_atomic_histograms_.get_histogram_1d(key));
+            if (_weighted_fill_)
+              {
+                atomic_histogram_registry::builder_1d_type sumw2_builder
+                  = [this, &sumw2_key](mygsl::histogram_pool & pool_) -> mygsl::histogram_1d &
+                  {
+                    return _register_histogram(pool_, sumw2_key, plot_conventions::UNIVERSAL_SUMW2_GROUP);
+                  };
+                entry.atomic_sumw2 = &_atomic_histograms_.grab_1d(sumw2_key, sumw2_builder);
+              }
           }
-
-        if (eh_properties.is_vector(a_field))
+        else
           {
-            DT_LOG_WARNING(get_logging_priority (),
-                           "Stored properties '" << a_field << "' " << "must be scalar !");
-            continue;
+            mygsl::histogram_1d & h = _register_histogram(*a_context.pool, key, plot_conventions::UNIVERSAL_GROUP);
+            _tag_histogram(h, rule_weight);
+            entry.rule_weight = _histogram_weight(h);
+            entry.filler.initialize(h);
+            if (_weighted_fill_)
+              {
+                entry.filler.set_sumw2(_register_histogram(*a_context.pool, sumw2_key, plot_conventions::UNIVERSAL_SUMW2_GROUP));
+              }
+            entry.filler.set_buffered(_fill_buffer_size_ > 0, _fill_buffer_size_);
           }
-        if (eh_properties.is_boolean(a_field))      key << eh_properties.fetch_boolean(a_field);
-        else if (eh_properties.is_integer(a_field)) key << eh_properties.fetch_integer(a_field);
-        else if (eh_properties.is_real(a_field))    key << eh_properties.fetch_real(a_field);
-        else if (eh_properties.is_string(a_field))  key << eh_properties.fetch_string(a_field);
-        // Add a underscore separator between fields
-        key << KEY_FIELD_SEPARATOR;
-      }
-
-
-    key << "energy";
-
-    if (! a_pool.has(key.str()))
-      {
-        mygsl::histogram_1d & h = a_pool.add_1d(key.str(), "", "energy_distrib");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_1d","energy_template");
-        mygsl::histogram_pool::init_histo_1d(h, hconfig, &a_pool);
+        found = a_context.histogram_cache.insert(std::make_pair(a_context.cache_key, entry)).first;
       }
 
     // Getting the current histogram
-    mygsl::histogram_1d & a_histo = a_pool.grab_1d(key.str());
+    histogram_entry_type & an_entry = found->second;
 
-    if(datatools::is_valid(energy))
-      a_histo.fill(energy);
-
-    double weight = 1.0;
-    if (eh_properties.has_key("event.genbb_label")) {
-      if (eh_properties.fetch_string("event.genbb_label").find("0nubb") != std::string::npos)
-        // weight /= 1e5;
-        weight /= 1e5*(48./50.);
-      // if (eh_properties.fetch_string("event.genbb_label").find("2nubb-2MeV") != std::string::npos)
-      //   weight /= 1e3;
-      if (eh_properties.fetch_string("event.genbb_label").find("2nubb") != std::string::npos)
-        // weight /= 1e5;
-        weight /= 1e7;
-      if (eh_properties.fetch_string("event.genbb_label").find("Tl208") != std::string::npos) {
-        weight /= 1e7;
-      }
-      if (eh_properties.fetch_string("event.genbb_label").find("Bi214_Po214") != std::string::npos &&
-          eh_properties.fetch_string("analysis.vertex_origin").find("source") != std::string::npos)
-        weight /= 1e7;
-      if (eh_properties.fetch_string("event.genbb_label").find("Bi214_Po214") != std::string::npos &&
-          eh_properties.fetch_string("analysis.vertex_origin").find("wire_surface") != std::string::npos)
-        weight /= 1e7;
-    }
-
-    if (eh_properties.has_key(mctools::event_utils::EVENT_GENBB_WEIGHT))
-      {
-        weight *= eh_properties.fetch_real(mctools::event_utils::EVENT_GENBB_WEIGHT);
-      }
+    // A global weight only applies to histograms of events with the same rule weight,
+    // including the histograms shared with other threads or restored from a checkpoint
+    DT_THROW_IF(! _weighted_fill_ && an_entry.rule_weight != rule_weight, std::logic_error,
+                "Module '" << get_name() << "' fills histogram '"
+                << _build_histogram_name(eh_properties, topology)
+                << "' with events of different weights, use 'weighted_fill' or the generator label as key field !");
 
-    // Store the weight into histogram properties
-    if (! a_histo.get_auxiliaries().has_key("weight"))
+    if(datatools::is_valid(energy))
       {
-        a_histo.grab_auxiliaries().update("weight", weight);
+        if (! _weighted_fill_)
+          {
+            if (an_entry.atomic) an_entry.atomic->fill(energy);
+            else an_entry.filler.fill(energy);
+          }
+        else if (an_entry.atomic)
+          {
+            an_entry.atomic->fill(energy, weight);
+            an_entry.atomic_sumw2->fill(energy, weight * weight);
+          }
+        else
+          {
+            an_entry.filler.fill(energy, weight);
+          }
       }
 
     DT_LOG_TRACE(get_logging_priority(), "Exiting.");
@@ -35,11 +35,28 @@
 // Standard libraires:
 #include <set>
 #include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
 
 // Data processing module abstract base class
 #include <dpp/base_module.h>
 
+// This project:
+#include <snemo/analysis/key_field_plan.h>
+#include <snemo/analysis/weight_rule_table.h>
+#include <snemo/analysis/histogram_filler.h>
+#include <snemo/analysis/thread_context.h>
+#include <snemo/analysis/histogram_checkpoint.h>
+#include <snemo/analysis/topology_cuts.h>
+#include <snemo/analysis/topology_dispatch.h>
+#include <snemo/analysis/calorimeter_block_set.h>
+#include <snemo/analysis/atomic_histogram.h>
+
 namespace mygsl {
+  class histogram;
+  typedef histogram histogram_1d;
   class histogram_pool;
 }
 
@@ -77,14 +94,109 @@ namespace analysis {
     /// Give default values to specific class members.
     void _set_defaults();
 
+    /// Build the histogram name registered in the pool, the 1e histograms having no topology prefix
+    std::string _build_histogram_name(const datatools::properties & eh_properties_,
+                                      topology_kind topology_) const;
+
+    /// Return the energy histogram of a given name and group, creating it if needed
+    mygsl::histogram_1d & _register_histogram(mygsl::histogram_pool & pool_,
+                                              const std::string & name_,
+                                              const std::string & group_);
+
+    /// Store the weighting scheme into the histogram auxiliaries
+    void _tag_histogram(mygsl::histogram_1d & histogram_, double weight_) const;
+
+    /// Return the global weight of a histogram
+    double _histogram_weight(const mygsl::histogram_1d & histogram_) const;
+
   private:
 
+    /// Histogram resolved from the pool
+    struct histogram_entry_type
+    {
+      histogram_filler_1d   filler;
+      atomic_histogram_1d * atomic;
+      atomic_histogram_1d * atomic_sumw2;
+      double                rule_weight;
+    };
+
+    /// Cache of resolved histograms indexed by compact key
+    typedef std::unordered_map<std::string, histogram_entry_type> histogram_cache_type;
+
+    /// Working context of a processing thread
+    struct worker_context_type
+    {
+      mygsl::histogram_pool *                pool;            //!< Pool filled by the context
+      std::unique_ptr<mygsl::histogram_pool> shard;           //!< Private pool in sharded mode
+      key_field_plan                         key_plan;        //!< Extraction plan of the key fields
+      weight_rule_table                      weight_rules;    //!< Event weight rules with their cache
+      histogram_cache_type                   histogram_cache; //!< Histograms already resolved from the pool
+      calorimeter_block_set                  calorimeter_blocks; //!< Calorimeter blocks counted in the 2e energy
+      std::string                            cache_key;       //!< Working buffer for the compact cache key
+      size_t                                 buffered_events; //!< Number of events staged since the last fill
+      topology_cut_flow                      cut_flow;        //!< Private copy of the cut flow
+    };
+
+    /// Setup a new working context
+    void _setup_context(worker_context_type & context_);
+
+    /// Fill the histograms of a context with the staged values
+    void _flush_fillers(worker_context_type & context_);
+
+    /// Print the cut flow table summed over the working contexts
+    void _report_cut_flow();
+
+    /// Flush all the contexts and merge the shards and atomic histograms into the histogram pool
+    void _merge_contexts();
+
     // The key fields from 'event header' bank to build the histogram key:
     std::vector<std::string> _key_fields_;
 
+    // The compiled extraction plan of the key fields:
+    key_field_plan _key_plan_;
+
+    // The event weight rules:
+    weight_rule_table _weight_rules_;
+
+    // The label of the event header bank :
+    std::string _EH_label_;
+
+    // The label of the particle track data bank :
+    std::string _PTD_label_;
+
+    // The label of the topology data bank :
+    std::string _TD_label_;
+
     // The histogram pool :
     mygsl::histogram_pool * _histogram_pool_;
 
+    // Number of events staged before filling the histograms :
+    size_t _fill_buffer_size_;
+
+    // Flag to fill a private pool shard per thread :
+    bool _sharded_;
+
+    // Flag to fill the histograms with the event weights :
+    bool _weighted_fill_;
+
+    // Flag to fill shared histograms with atomic bins :
+    bool _atomic_backend_;
+
+    // The histograms with atomic bins :
+    atomic_histogram_registry _atomic_histograms_;
+
+    // The working contexts :
+    thread_context_set<worker_context_type> _contexts_;
+
+    // The checkpoint of the accumulated histograms :
+    histogram_checkpoint _checkpoint_;
+
+    // The cut flow applied to the topology pattern :
+    topology_cut_flow _cut_flow_;
+
+    // The topologies filled by the module :
+    topology_registry _topologies_;
+
     // Macro to automate the registration of the module :
     DPP_MODULE_REGISTRATION_INTERFACE(universal_plot_module);
   };
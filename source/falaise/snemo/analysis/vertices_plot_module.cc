@@ -3,10 +3,17 @@
 // Ourselves:
 #include <snemo/analysis/vertices_plot_module.h>
 
+// This project:
+#include <snemo/analysis/bank_utils.h>
+#include <snemo/analysis/histogram_pool_utils.h>
+#include <snemo/analysis/plot_conventions.h>
+
 // Standard library:
 #include <stdexcept>
 #include <sstream>
+#include <functional>
 #include <algorithm>
+#include <type_traits>
 
 // Third party:
 // - Boost:
@@ -36,11 +43,39 @@
 #include <falaise/snemo/datamodels/particle_track_data.h>
 
 #include <falaise/snemo/datamodels/topology_data.h>
+#include <falaise/snemo/datamodels/topology_1e_pattern.h>
 #include <falaise/snemo/datamodels/topology_2e_pattern.h>
+#include <falaise/snemo/datamodels/topology_1eNg_pattern.h>
 #include <falaise/snemo/datamodels/vertex_measurement.h>
 
 namespace analysis {
 
+  namespace {
+
+    /// Vertex measurement filled for the events of a topology
+    template <class Pattern>
+    struct topology_vertex;
+
+    template <>
+    struct topology_vertex<snemo::datamodel::topology_1e_pattern>
+    {
+      static const char * measurement() { return "vertex_e1"; }
+    };
+
+    template <>
+    struct topology_vertex<snemo::datamodel::topology_2e_pattern>
+    {
+      static const char * measurement() { return "vertex_e1_e2"; }
+    };
+
+    template <>
+    struct topology_vertex<snemo::datamodel::topology_1eNg_pattern>
+    {
+      static const char * measurement() { return "vertex_e1"; }
+    };
+
+  }
+
   // Registration instantiation macro :
   DPP_MODULE_REGISTRATION_IMPLEMENT(vertices_plot_module,
                                     "analysis::vertices_plot_module");
@@ -67,7 +102,17 @@ namespace analysis {
 
   void vertices_plot_module::_set_defaults()
   {
+    _PTD_label_ = snemo::datamodel::data_info::default_particle_track_data_label();
+    _TD_label_ = "TD";
+    _fill_buffer_size_ = 0;
+    _sharded_ = false;
+    _atomic_backend_ = false;
     _histogram_pool_ = 0;
+    _contexts_.reset();
+    _checkpoint_.reset();
+    _cut_flow_.reset();
+    _topologies_.reset();
+    _atomic_histograms_.reset();
 
     return;
   }
@@ -83,6 +128,71 @@ namespace analysis {
 
     dpp::base_module::_common_initialize(config_);
 
+    // Labels of the input banks :
+    if (config_.has_key("PTD_label"))
+      {
+        _PTD_label_ = config_.fetch_string("PTD_label");
+      }
+    if (config_.has_key("TD_label"))
+      {
+        _TD_label_ = config_.fetch_string("TD_label");
+      }
+
+    // Number of events staged before filling the histograms :
+    if (config_.has_key("fill_buffer_size"))
+      {
+        const int fill_buffer_size = config_.fetch_integer("fill_buffer_size");
+        DT_THROW_IF(fill_buffer_size < 0, std::domain_error,
+                    "Module '" << get_name() << "' has an invalid 'fill_buffer_size' property !");
+        _fill_buffer_size_ = fill_buffer_size;
+      }
+
+    // Fill a private pool shard per processing thread :
+    if (config_.has_key("sharded"))
+      {
+        _sharded_ = config_.fetch_boolean("sharded");
+      }
+
+    // Histogram backend :
+    if (config_.has_key("fill_backend"))
+      {
+        const std::string fill_backend = config_.fetch_string("fill_backend");
+        DT_THROW_IF(fill_backend != "default" && fill_backend != "atomic", std::logic_error,
+                    "Module '" << get_name() << "' has an invalid 'fill_backend' property '"
+                    << fill_backend << "' !");
+        _atomic_backend_ = (fill_backend == "atomic");
+      }
+    DT_THROW_IF(_atomic_backend_ && _sharded_, std::logic_error,
+                "Module '" << get_name() << "' can not use the 'atomic' backend with sharded pools !");
+    if (_atomic_backend_ && _fill_buffer_size_ > 0)
+      {
+        DT_LOG_WARNING(get_logging_priority(), "The 'fill_buffer_size' property is ignored by the 'atomic' backend !");
+        _fill_buffer_size_ = 0;
+      }
+    _contexts_.initialize(_sharded_ || _atomic_backend_,
+                          std::bind(&vertices_plot_module::_setup_context, this, std::placeholders::_1));
+
+    // Store the histograms every 'checkpoint.period_events' events or 'checkpoint.period_seconds' seconds :
+    datatools::properties checkpoint_config;
+    config_.export_and_rename_starting_with(checkpoint_config, "checkpoint.", "");
+    _checkpoint_.initialize(checkpoint_config, get_name());
+    DT_THROW_IF(_checkpoint_.is_enabled() && (_sharded_ || _atomic_backend_), std::logic_error,
+                "Module '" << get_name() << "' cannot checkpoint sharded or atomic histograms !");
+
+    // Topologies filled in the same pass, the legacy 2e one by default :
+    const std::vector<std::string> topologies = plot_conventions::fetch_topologies(config_, "2e");
+    for (size_t i = 0; i < topologies.size(); ++i)
+      {
+        _topologies_.enable(topologies[i]);
+      }
+
+    // Cuts applied to the topology pattern, only the filled topologies by default :
+    datatools::properties cut_flow_config;
+    config_.export_and_rename_starting_with(cut_flow_config, "cut_flow.", "");
+    plot_conventions::set_default_pattern_ids(cut_flow_config, _topologies_.get_pattern_ids());
+    register_topology_cuts(_cut_flow_);
+    _cut_flow_.initialize(cut_flow_config, std::vector<std::string>(1, "topology"));
+
     // Service label
     std::string histogram_label;
     if (config_.has_key("Histo_label"))
@@ -122,18 +232,97 @@ namespace analysis {
             }
           }
 
+        if (_atomic_backend_) _atomic_histograms_.initialize(*_histogram_pool_);
+
+        // Resume from the last checkpoint :
+        _checkpoint_.restore(*_histogram_pool_);
+
         // Tag the module as initialized :
         _set_initialized(true);
         return;
       }
   }
 
+  void vertices_plot_module::_report_cut_flow()
+  {
+    if (get_logging_priority() < datatools::logger::PRIO_NOTICE) return;
+    topology_cut_flow total = _cut_flow_;
+    total.reset_counters();
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        total.merge(_contexts_.grab(i).cut_flow);
+      }
+    DT_LOG_NOTICE(get_logging_priority(), "Cut flow of module '" << get_name() << "' :");
+    total.print_table(std::clog, "  ");
+    return;
+  }
+
+  void vertices_plot_module::_setup_context(worker_context_type & context_)
+  {
+    context_.pool = _histogram_pool_;
+    if (_sharded_)
+      {
+        context_.shard.reset(new mygsl::histogram_pool);
+        context_.shard->initialize(datatools::properties());
+        context_.pool = context_.shard.get();
+      }
+    context_.vertex_filler.reset();
+    context_.vertex_atomic = 0;
+    context_.buffered_events = 0;
+    context_.cut_flow = _cut_flow_;
+    return;
+  }
+
+  void vertices_plot_module::_flush_fillers(worker_context_type & context_)
+  {
+    if (context_.vertex_filler.is_initialized()) context_.vertex_filler.flush();
+    return;
+  }
+
+  void vertices_plot_module::_merge_contexts()
+  {
+    // The shards are summed in an order that does not depend on the threads
+    std::vector<const mygsl::histogram_pool *> shards;
+    for (size_t i = 0; i < _contexts_.size(); ++i)
+      {
+        worker_context_type & a_context = _contexts_.grab(i);
+        _flush_fillers(a_context);
+        if (a_context.shard) shards.push_back(a_context.shard.get());
+      }
+    merge_histogram_pools(*_histogram_pool_, shards);
+    if (_atomic_histograms_.is_initialized())
+      {
+        _atomic_histograms_.export_histograms();
+      }
+    return;
+  }
+
+  mygsl::histogram_2d & vertices_plot_module::_register_vertex_histogram(mygsl::histogram_pool & pool_)
+  {
+    mygsl::histogram_2d & h = plot_conventions::grab_mimic_2d(pool_,
+                                                              plot_conventions::VERTEX_NAME,
+                                                              plot_conventions::VERTEX_GROUP,
+                                                              plot_conventions::VERTEX_TEMPLATE,
+                                                              *_histogram_pool_);
+    _checkpoint_.own(plot_conventions::VERTEX_NAME);
+    return h;
+  }
+
   // Reset :
   void vertices_plot_module::reset()
   {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Fill the histograms with the remaining staged values and merge the shards :
+    _merge_contexts();
+
+    // Report the cut flow
+    _report_cut_flow();
+
+    // The run is complete, the checkpoint is not needed anymore :
+    _checkpoint_.terminate();
+
     // Tag the module as un-initialized :
     _set_initialized(false);
     _set_defaults();
@@ -162,28 +351,38 @@ namespace analysis {
     DT_THROW_IF(! is_initialized(), std::logic_error,
                 "Module '" << get_name() << "' is not initialized !");
 
+    // Working context of the calling thread :
+    worker_context_type & a_context = _contexts_.grab_local();
+
+    // Skip the events already counted by the restored checkpoint, store a new one when due
+    // and fill the histograms with the staged values every 'fill_buffer_size' events :
+    if (begin_checkpointed_event(_checkpoint_, *_histogram_pool_, _fill_buffer_size_, a_context.buffered_events,
+                                 [&]() { _flush_fillers(a_context); }))
+      {
+        return dpp::base_module::PROCESS_CONTINUE;
+      }
+
     // Check if the 'particle track' record bank is available :
-    const std::string ptd_label = snemo::datamodel::data_info::default_particle_track_data_label();
-    if (! data_record_.has(ptd_label))
+    const snemo::datamodel::particle_track_data * ptd_bank
+      = try_get_bank<snemo::datamodel::particle_track_data>(data_record_, _PTD_label_);
+    if (! ptd_bank)
       {
         DT_LOG_ERROR(get_logging_priority (), "Could not find any bank with label '"
-                     << ptd_label << "' !");
+                     << _PTD_label_ << "' !");
         return dpp::base_module::PROCESS_STOP;
       }
-    const snemo::datamodel::particle_track_data & ptd
-      = data_record_.get<snemo::datamodel::particle_track_data>(ptd_label);
+    const snemo::datamodel::particle_track_data & ptd = *ptd_bank;
 
     // Check if some 'topology_data' are available in the data model:
-    // const std::string td_label = snemo::datamodel::data_info::default_topology_data_label();
-    const std::string td_label = "TD";
-    if (! data_record_.has(td_label)) {
+    const snemo::datamodel::topology_data * td_bank
+      = try_get_bank<snemo::datamodel::topology_data>(data_record_, _TD_label_);
+    if (! td_bank) {
       DT_LOG_ERROR(get_logging_priority(), "Missing topology data to be processed !");
       return dpp::base_module::PROCESS_ERROR;
     }
 
     // Get the 'topology_data' entry from the data model :
-    const snemo::datamodel::topology_data & td
-      = data_record_.get<snemo::datamodel::topology_data>(td_label);
+    const snemo::datamodel::topology_data & td = *td_bank;
 
     DT_LOG_DEBUG(get_logging_priority(), "Topology data : ");
     if (get_logging_priority() >= datatools::logger::PRIO_DEBUG) td.tree_dump();
@@ -194,13 +393,25 @@ namespace analysis {
     }
     const snemo::datamodel::base_topology_pattern & a_pattern = td.get_pattern();
 
-    const std::string & a_pattern_id = a_pattern.get_pattern_id();
-
-    if (a_pattern_id != "2e") {
-      DT_LOG_WARNING(get_logging_priority(), "PlotModule only works for '2e' topology for now !");
+    // The pattern identifier is interned once for the cuts and the dispatch :
+    const topology_event an_event = { a_pattern, topology_registry::intern(a_pattern) };
+    if (! a_context.cut_flow.select(an_event)) {
+      DT_LOG_DEBUG(get_logging_priority(), "Event rejected by the cut flow !");
       return dpp::base_module::PROCESS_ERROR;
     }
 
+    // Vertex measurement given by the specialisation of the event topology :
+    const char * measurement = 0;
+    _topologies_.dispatch(a_pattern, an_event.kind, [&measurement](const auto & a_topology_pattern)
+      {
+        typedef typename std::decay<decltype(a_topology_pattern)>::type pattern_type;
+        measurement = topology_vertex<pattern_type>::measurement();
+      });
+    if (! measurement || ! a_pattern.has_measurement(measurement)) {
+      DT_LOG_DEBUG(get_logging_priority(), "Topology '" << a_pattern.get_pattern_id() << "' has no vertex to fill !");
+      return dpp::base_module::PROCESS_CONTINUE;
+    }
+
     // std::ostringstream key;
     // key << "vertices_probability";
 
@@ -212,27 +423,33 @@ namespace analysis {
     //   return dpp::base_module::PROCESS_ERROR;
     // }
 
-    // Getting histogram pool
-    mygsl::histogram_pool & a_pool = grab_histogram_pool();
-
-    std::ostringstream key;
-    key << "vertex_distrib";
-
-    if (! a_pool.has(key.str()))
+    histogram_filler_2d & a_filler = a_context.vertex_filler;
+    if (_atomic_backend_)
       {
-        mygsl::histogram_2d & h = a_pool.add_2d(key.str(), "", "vertices");
-        datatools::properties hconfig;
-        hconfig.store_string("mode", "mimic");
-        hconfig.store_string("mimic.histogram_2d", "vertex_distribution_template");
-        mygsl::histogram_pool::init_histo_2d(h, hconfig, &a_pool);
+        if (! a_context.vertex_atomic)
+          {
+            // The shared histogram is created under lock
+            a_context.vertex_atomic
+              = &_atomic_histograms_.grab_2d(plot_conventions::VERTEX_NAME,
+                                             std::bind(&vertices_plot_module::_register_vertex_histogram,
+                                                       this, std::placeholders::_1));
+          }
+      }
+    else if (! a_filler.is_initialized())
+      {
+        a_filler.initialize(_register_vertex_histogram(*a_context.pool));
+        a_filler.set_buffered(_fill_buffer_size_ > 0, _fill_buffer_size_);
       }
-    mygsl::histogram_2d & a_histo = a_pool.grab_2d(key.str ());
     // geomtools::blur_spot tmp = dynamic_cast<const snemo::datamodel::vertex_measurement&> (a_pattern.get_measurement("vertex_e1_e2")).get_vertex();
-    double vertex_y = dynamic_cast<const snemo::datamodel::vertex_measurement&> (a_pattern.get_measurement("vertex_e1_e2")).get_vertex().get_position().y();
-    double vertex_z = dynamic_cast<const snemo::datamodel::vertex_measurement&> (a_pattern.get_measurement("vertex_e1_e2")).get_vertex().get_position().z();
+    const geomtools::vector_3d & a_vertex = dynamic_cast<const snemo::datamodel::vertex_measurement&> (a_pattern.get_measurement(measurement)).get_vertex().get_position();
+    double vertex_y = a_vertex.y();
+    double vertex_z = a_vertex.z();
 
     if(datatools::is_valid(vertex_y) && datatools::is_valid(vertex_z))
-      a_histo.fill(vertex_y,vertex_z);
+      {
+        if (a_context.vertex_atomic) a_context.vertex_atomic->fill(vertex_y,vertex_z);
+        else a_filler.fill(vertex_y,vertex_z);
+      }
 
     DT_LOG_TRACE(get_logging_priority(), "Exiting.");
     return dpp::base_module::PROCESS_SUCCESS;
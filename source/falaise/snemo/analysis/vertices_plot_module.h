@@ -36,10 +36,18 @@
 // Standard libraires:
 #include <set>
 #include <map>
+#include <memory>
 
 // Data processing module abstract base class
 #include <dpp/base_module.h>
 
+// This project:
+#include <snemo/analysis/histogram_filler.h>
+#include <snemo/analysis/thread_context.h>
+#include <snemo/analysis/histogram_checkpoint.h>
+#include <snemo/analysis/topology_cuts.h>
+#include <snemo/analysis/atomic_histogram.h>
+
 namespace mygsl {
   class histogram_pool;
 }
@@ -80,9 +88,65 @@ namespace analysis {
 
   private:
 
+    /// Working context of a processing thread
+    struct worker_context_type
+    {
+      mygsl::histogram_pool *                pool;            //!< Pool filled by the context
+      std::unique_ptr<mygsl::histogram_pool> shard;           //!< Private pool in sharded mode
+      histogram_filler_2d                    vertex_filler;   //!< Filler of the vertex distribution histogram
+      atomic_histogram_2d *                  vertex_atomic;   //!< Vertex distribution histogram of the atomic backend
+      size_t                                 buffered_events; //!< Number of events staged since the last fill
+      topology_cut_flow                      cut_flow;        //!< Private copy of the cut flow
+    };
+
+    /// Setup a new working context
+    void _setup_context(worker_context_type & context_);
+
+    /// Fill the histograms of a context with the staged values
+    void _flush_fillers(worker_context_type & context_);
+
+    /// Print the cut flow table summed over the working contexts
+    void _report_cut_flow();
+
+    /// Flush all the contexts and merge the shards and atomic histograms into the histogram pool
+    void _merge_contexts();
+
+    /// Return the vertex distribution histogram, creating it if needed
+    mygsl::histogram_2d & _register_vertex_histogram(mygsl::histogram_pool & pool_);
+
+    // The label of the particle track data bank :
+    std::string _PTD_label_;
+
+    // The label of the topology data bank :
+    std::string _TD_label_;
+
     // The histogram pool :
     mygsl::histogram_pool * _histogram_pool_;
 
+    // Number of events staged before filling the histograms :
+    size_t _fill_buffer_size_;
+
+    // Flag to fill a private pool shard per thread :
+    bool _sharded_;
+
+    // Flag to fill shared histograms with atomic bins :
+    bool _atomic_backend_;
+
+    // The histograms with atomic bins :
+    atomic_histogram_registry _atomic_histograms_;
+
+    // The working contexts :
+    thread_context_set<worker_context_type> _contexts_;
+
+    // The checkpoint of the accumulated histograms :
+    histogram_checkpoint _checkpoint_;
+
+    // The cut flow applied to the topology pattern :
+    topology_cut_flow _cut_flow_;
+
+    // The topologies filled by the module :
+    topology_registry _topologies_;
+
     // Macro to automate the registration of the module :
     DPP_MODULE_REGISTRATION_INTERFACE(vertices_plot_module);
   };
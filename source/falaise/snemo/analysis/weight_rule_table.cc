@@ -0,0 +1,178 @@
+// weight_rule_table.cc
+
+// Ourselves:
+#include <snemo/analysis/weight_rule_table.h>
+
+// Standard library:
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+
+namespace analysis {
+
+  const std::string & weight_rule_table::default_label_key()
+  {
+    static const std::string key("event.genbb_label");
+    return key;
+  }
+
+  const std::string & weight_rule_table::default_origin_key()
+  {
+    static const std::string key("analysis.vertex_origin");
+    return key;
+  }
+
+  weight_rule_table::weight_rule_table()
+  {
+    reset();
+    return;
+  }
+
+  void weight_rule_table::initialize(const datatools::properties & config_,
+                                     datatools::logger::priority logging_priority_)
+  {
+    reset();
+    _logging_priority_ = logging_priority_;
+    if (config_.has_key("label_key"))
+      {
+        _label_key_ = config_.fetch_string("label_key");
+      }
+    if (config_.has_key("origin_key"))
+      {
+        _origin_key_ = config_.fetch_string("origin_key");
+      }
+    if (! config_.has_key("list"))
+      {
+        set_legacy_rules();
+        return;
+      }
+    std::vector<std::string> names;
+    config_.fetch("list", names);
+    for (std::vector<std::string>::const_iterator
+           iname = names.begin();
+         iname != names.end(); ++iname)
+      {
+        const std::string & a_name = *iname;
+        rule_type a_rule;
+        const std::string label_key = a_name + ".label";
+        DT_THROW_IF(! config_.has_key(label_key), std::logic_error,
+                    "Missing '" << label_key << "' property for weight rule '" << a_name << "' !");
+        a_rule.label_pattern = config_.fetch_string(label_key);
+        const std::string origin_key = a_name + ".origin";
+        if (config_.has_key(origin_key))
+          {
+            a_rule.origin_pattern = config_.fetch_string(origin_key);
+          }
+        const std::string divisor_key = a_name + ".divisor";
+        DT_THROW_IF(! config_.has_key(divisor_key), std::logic_error,
+                    "Missing '" << divisor_key << "' property for weight rule '" << a_name << "' !");
+        a_rule.divisor = config_.fetch_real(divisor_key);
+        DT_THROW_IF(! (a_rule.divisor > 0.0), std::domain_error,
+                    "Invalid divisor for weight rule '" << a_name << "' !");
+        DT_LOG_DEBUG(_logging_priority_, "Adding weight rule '" << a_name << "' : label '"
+                     << a_rule.label_pattern << "', origin '" << a_rule.origin_pattern
+                     << "', divisor " << a_rule.divisor);
+        _rules_.push_back(a_rule);
+      }
+    return;
+  }
+
+  void weight_rule_table::set_legacy_rules()
+  {
+    _rules_.clear();
+    _labels_.clear();
+    const rule_type legacy_rules[] = {
+      { "0nubb",       "",             1e5*(48./50.) },
+      { "2nubb",       "",             1e7 },
+      { "Tl208",       "",             1e7 },
+      { "Bi214_Po214", "source",       1e7 },
+      { "Bi214_Po214", "wire_surface", 1e7 }
+    };
+    _rules_.assign(legacy_rules, legacy_rules + sizeof(legacy_rules) / sizeof(rule_type));
+    return;
+  }
+
+  void weight_rule_table::reset()
+  {
+    _logging_priority_ = datatools::logger::PRIO_FATAL;
+    _label_key_ = default_label_key();
+    _origin_key_ = default_origin_key();
+    _rules_.clear();
+    _labels_.clear();
+    return;
+  }
+
+  const std::vector<weight_rule_table::rule_type> & weight_rule_table::get_rules() const
+  {
+    return _rules_;
+  }
+
+  double weight_rule_table::evaluate(const std::string & label_, const std::string & origin_) const
+  {
+    double weight = 1.0;
+    for (std::vector<rule_type>::const_iterator
+           irule = _rules_.begin();
+         irule != _rules_.end(); ++irule)
+      {
+        if (label_.find(irule->label_pattern) == std::string::npos) continue;
+        if (! irule->origin_pattern.empty() &&
+            origin_.find(irule->origin_pattern) == std::string::npos) continue;
+        weight /= irule->divisor;
+      }
+    return weight;
+  }
+
+  double weight_rule_table::compute_weight(const datatools::properties & properties_)
+  {
+    if (! properties_.has_key(_label_key_)) return 1.0;
+    const std::string label = properties_.fetch_string(_label_key_);
+    std::unordered_map<std::string, label_entry_type>::iterator found = _labels_.find(label);
+    if (found == _labels_.end())
+      {
+        // Match the label once and check if the origin matters
+        label_entry_type an_entry;
+        an_entry.origin_dependent = false;
+        for (std::vector<rule_type>::const_iterator
+               irule = _rules_.begin();
+             irule != _rules_.end(); ++irule)
+          {
+            if (! irule->origin_pattern.empty() &&
+                label.find(irule->label_pattern) != std::string::npos)
+              {
+                an_entry.origin_dependent = true;
+                break;
+              }
+          }
+        an_entry.weight = an_entry.origin_dependent ? 0.0 : evaluate(label, "");
+        found = _labels_.insert(std::make_pair(label, an_entry)).first;
+      }
+    label_entry_type & an_entry = found->second;
+    if (! an_entry.origin_dependent) return an_entry.weight;
+
+    // A missing origin matches no origin pattern
+    std::string origin;
+    if (properties_.has_key(_origin_key_))
+      {
+        origin = properties_.fetch_string(_origin_key_);
+      }
+    std::unordered_map<std::string, double>::const_iterator found_origin = an_entry.origins.find(origin);
+    if (found_origin == an_entry.origins.end())
+      {
+        found_origin = an_entry.origins.insert(std::make_pair(origin, evaluate(label, origin))).first;
+      }
+    return found_origin->second;
+  }
+
+} // namespace analysis
+
+// end of weight_rule_table.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,128 @@
+/* weight_rule_table.h
+ * Author(s)     : agent
+ * Creation date : 2026-10-16
+ * Last modified : 2026-10-16
+ *
+ * Copyright (C) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ *
+ *
+ * Description:
+ *
+ * Table of the event weight rules matched on the generator label and on
+ * the vertex origin stored in the event header. The rules are read from
+ * the module configuration and each distinct label is matched only once.
+ *
+ * History:
+ *
+ */
+
+#ifndef ANALYSIS_WEIGHT_RULE_TABLE_H_
+#define ANALYSIS_WEIGHT_RULE_TABLE_H_ 1
+
+// Standard libraries:
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// - Bayeux/datatools:
+#include <datatools/logger.h>
+
+namespace datatools {
+  class properties;
+}
+
+namespace analysis {
+
+  /// \brief Event weight rules indexed by generator label
+  ///
+  /// The weight of an event starts at 1 and is divided by the divisor of each
+  /// rule whose label pattern is contained in the generator label and whose
+  /// origin pattern, if any, is contained in the vertex origin. Rules are
+  /// applied in the order of the table. The weight of each distinct label
+  /// (and vertex origin when a rule depends on it) is cached.
+  class weight_rule_table
+  {
+  public:
+
+    /// Single weight rule
+    struct rule_type
+    {
+      std::string label_pattern;  //!< Substring of the generator label
+      std::string origin_pattern; //!< Substring of the vertex origin, empty for any origin
+      double      divisor;        //!< Divisor applied to the weight
+    };
+
+    /// Default event header key of the generator label
+    static const std::string & default_label_key();
+
+    /// Default event header key of the vertex origin
+    static const std::string & default_origin_key();
+
+    /// Constructor
+    weight_rule_table();
+
+    /// Initialize from a configuration, the legacy rules are used without a 'list' property
+    void initialize(const datatools::properties & config_,
+                    datatools::logger::priority logging_priority_ = datatools::logger::PRIO_FATAL);
+
+    /// Set the rules hardcoded in former versions
+    void set_legacy_rules();
+
+    /// Reset
+    void reset();
+
+    /// Return the rules
+    const std::vector<rule_type> & get_rules() const;
+
+    /// Return the weight of an event given its event header properties
+    double compute_weight(const datatools::properties & properties_);
+
+    /// Apply the rules to a label and an origin, without cache
+    double evaluate(const std::string & label_, const std::string & origin_) const;
+
+  private:
+
+    /// Cached weights of a generator label
+    struct label_entry_type
+    {
+      bool   origin_dependent; //!< Flag set when a matching rule depends on the origin
+      double weight;           //!< Weight when no matching rule depends on the origin
+      std::unordered_map<std::string, double> origins; //!< Weights indexed by origin
+    };
+
+  private:
+
+    datatools::logger::priority _logging_priority_;
+    std::string                 _label_key_;  //!< Event header key of the generator label
+    std::string                 _origin_key_; //!< Event header key of the vertex origin
+    std::vector<rule_type>      _rules_;      //!< Ordered rules
+    std::unordered_map<std::string, label_entry_type> _labels_; //!< Cached weights per label
+  };
+
+} // namespace analysis
+
+#endif // ANALYSIS_WEIGHT_RULE_TABLE_H_
+
+// end of weight_rule_table.h
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,127 @@
+// plot_merge.cc
+
+// Merge the histogram pools written by many batch jobs and optionally
+// compute the efficiencies and halflife limits on the merged pool.
+//
+// Usage: plot_merge <configuration file> [input files...]
+//
+// The configuration file is a datatools properties file with:
+//  - input_files          : boost files holding the histogram pools to merge,
+//                           completed by the files given on the command line
+//  - output_file          : boost file receiving the merged histogram pool
+//  - number_of_threads    : number of threads loading and merging the pools
+//  - Histo_template_files : histogram templates loaded before merging
+//  - compute_halflife     : run the halflife limit post-processing on the
+//                           merged pool, configured by the 'halflife.' properties
+//                           (see analysis::halflife_limit_module)
+//
+// The efficiency, halflife and sensitivity histograms of the input pools
+// are computed from their energy histograms and cannot be summed: they are
+// not merged, and are only recomputed from the merged energy histograms
+// when 'compute_halflife' is set.
+
+// Standard library:
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/io_factory.h>
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/parallel_for.h>
+#include <snemo/analysis/histogram_pool_utils.h>
+#include <snemo/analysis/halflife_limit_module.h>
+
+int main(int argc_, char ** argv_)
+{
+  int error_code = EXIT_SUCCESS;
+  try
+    {
+      DT_THROW_IF(argc_ < 2, std::logic_error, "Usage: plot_merge <configuration file> [input files...]");
+      datatools::properties config;
+      datatools::properties::read_config(argv_[1], config);
+
+      std::vector<std::string> input_files;
+      if (config.has_key("input_files"))
+        {
+          config.fetch("input_files", input_files);
+        }
+      for (int i = 2; i < argc_; i++) {
+        input_files.push_back(argv_[i]);
+      }
+      DT_THROW_IF(input_files.empty(), std::logic_error, "No input files !");
+      DT_THROW_IF(! config.has_key("output_file"), std::logic_error, "Missing 'output_file' property !");
+      const std::string output_file = config.fetch_string("output_file");
+
+      size_t number_of_threads = analysis::default_number_of_threads();
+      if (config.has_key("number_of_threads"))
+        {
+          const int nthreads = config.fetch_integer("number_of_threads");
+          DT_THROW_IF(nthreads <= 0, std::domain_error, "Invalid 'number_of_threads' property !");
+          number_of_threads = nthreads;
+        }
+
+      mygsl::histogram_pool pool;
+      pool.initialize(datatools::properties());
+      if (config.has_key("Histo_template_files"))
+        {
+          std::vector<std::string> template_files;
+          config.fetch("Histo_template_files", template_files);
+          for (size_t i = 0; i < template_files.size(); i++) {
+            pool.load(template_files[i]);
+          }
+        }
+
+      // Map-reduce of the input pools :
+      analysis::merge_histogram_files(pool, input_files, number_of_threads,
+                                      analysis::halflife_limit_module::derived_groups());
+
+      // Efficiencies and halflife limits of the merged pool :
+      const bool compute_halflife = config.has_key("compute_halflife") && config.fetch_boolean("compute_halflife");
+      if (! compute_halflife)
+        {
+          std::clog << "plot_merge: the efficiency, halflife and sensitivity histograms are not merged,"
+                    << " set 'compute_halflife' to recompute them" << std::endl;
+        }
+      else
+        {
+          datatools::properties halflife_config;
+          config.export_and_rename_starting_with(halflife_config, "halflife.", "");
+          if (! halflife_config.has_key("number_of_threads"))
+            {
+              halflife_config.store_integer("number_of_threads", number_of_threads);
+            }
+          analysis::halflife_limit_module halflife;
+          halflife.set_name("halflife_limit");
+          halflife.set_histogram_pool(pool);
+          halflife.initialize_standalone(halflife_config);
+          halflife.reset();
+        }
+
+      datatools::data_writer writer(output_file, datatools::using_multiple_archives);
+      writer.store(pool);
+    }
+  catch (std::exception & error)
+    {
+      std::cerr << "plot_merge: " << error.what() << std::endl;
+      error_code = EXIT_FAILURE;
+    }
+  return error_code;
+}
+
+// end of plot_merge.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
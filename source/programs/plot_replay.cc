@@ -0,0 +1,83 @@
+// plot_replay.cc
+
+// Fill the analysis histograms from a feature cache written by the
+// feature extraction module, without reprocessing the events.
+//
+// Usage: plot_replay <configuration file>
+//
+// The configuration file is a datatools properties file with:
+//  - input_file           : feature cache to replay
+//  - output_file          : boost file receiving the histogram pool
+//  - Histo_template_files : histogram templates (energy_template...)
+// and the replay configuration (see analysis::histogram_replay).
+
+// Standard library:
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/io_factory.h>
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/feature_cache.h>
+#include <snemo/analysis/histogram_replay.h>
+
+int main(int argc_, char ** argv_)
+{
+  int error_code = EXIT_SUCCESS;
+  try
+    {
+      DT_THROW_IF(argc_ != 2, std::logic_error, "Usage: plot_replay <configuration file>");
+      datatools::properties config;
+      datatools::properties::read_config(argv_[1], config);
+
+      DT_THROW_IF(! config.has_key("input_file"), std::logic_error, "Missing 'input_file' property !");
+      DT_THROW_IF(! config.has_key("output_file"), std::logic_error, "Missing 'output_file' property !");
+      const std::string input_file = config.fetch_string("input_file");
+      const std::string output_file = config.fetch_string("output_file");
+
+      mygsl::histogram_pool pool;
+      pool.initialize(datatools::properties());
+      if (config.has_key("Histo_template_files"))
+        {
+          std::vector<std::string> template_files;
+          config.fetch("Histo_template_files", template_files);
+          for (size_t i = 0; i < template_files.size(); i++) {
+            pool.load(template_files[i]);
+          }
+        }
+
+      analysis::feature_cache_reader reader;
+      reader.open(input_file);
+
+      analysis::histogram_replay replay;
+      replay.initialize(config, pool);
+      replay.run(reader);
+
+      datatools::data_writer writer(output_file, datatools::using_multiple_archives);
+      writer.store(pool);
+    }
+  catch (std::exception & error)
+    {
+      std::cerr << "plot_replay: " << error.what() << std::endl;
+      error_code = EXIT_FAILURE;
+    }
+  return error_code;
+}
+
+// end of plot_replay.cc
+/*
+** Local Variables: --
+** mode: c++ --
+** c-file-style: "gnu" --
+** tab-width: 2 --
+** End: --
+*/
@@ -0,0 +1,266 @@
+// test_atomic_histogram.cxx
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+// - Bayeux/mygsl:
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/atomic_histogram.h>
+
+// Number of concurrent filling threads
+const size_t NTHREADS = 4;
+
+// Number of times each value is filled
+const size_t NREPEATS = 200;
+
+// Values on the bin edges and their neighbours, out of range and invalid.
+std::vector<double> test_values(const mygsl::histogram_1d & histogram_)
+{
+  std::vector<double> values;
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < histogram_.bins(); ++i)
+    {
+      const double edge = histogram_.get_range(i).first;
+      values.push_back(edge);
+      values.push_back(std::nextafter(edge, -infinity));
+      values.push_back(0.5 * (edge + histogram_.get_range(i).second));
+    }
+  const double max = histogram_.get_range(histogram_.bins() - 1).second;
+  values.push_back(max);
+  values.push_back(std::nextafter(max, -infinity));
+  values.push_back(max + 10.0);
+  values.push_back(-infinity);
+  values.push_back(std::numeric_limits<double>::quiet_NaN());
+  return values;
+}
+
+// Weight of the k-th fill, exactly representable so that the sums do not depend on their order.
+double test_weight(size_t k_)
+{
+  return 0.25 + 0.125 * (k_ % 5);
+}
+
+bool same_value(double a_, double b_)
+{
+  return a_ == b_ || (std::isnan(a_) && std::isnan(b_));
+}
+
+// Check that two 1D histograms have the same contents and number of entries.
+void compare(const mygsl::histogram_1d & a_, const mygsl::histogram_1d & b_, const std::string & what_)
+{
+  for (size_t i = 0; i < a_.bins(); ++i)
+    {
+      DT_THROW_IF(! same_value(a_.get(i), b_.get(i)), std::logic_error,
+                  what_ << " : bin " << i << " is " << a_.get(i) << " instead of " << b_.get(i) << " !");
+    }
+  DT_THROW_IF(! same_value(a_.underflow(), b_.underflow()), std::logic_error, what_ << " : wrong underflow !");
+  DT_THROW_IF(! same_value(a_.overflow(), b_.overflow()), std::logic_error, what_ << " : wrong overflow !");
+  DT_THROW_IF(a_.counts() != b_.counts(), std::logic_error,
+              what_ << " : " << a_.counts() << " entries instead of " << b_.counts() << " !");
+  return;
+}
+
+// Check that two 2D histograms have the same contents and number of entries.
+void compare(const mygsl::histogram_2d & a_, const mygsl::histogram_2d & b_, const std::string & what_)
+{
+  for (size_t i = 0; i < a_.xbins(); ++i)
+    for (size_t j = 0; j < a_.ybins(); ++j)
+      {
+        DT_THROW_IF(! same_value(a_.get(i, j), b_.get(i, j)), std::logic_error,
+                    what_ << " : bin (" << i << ", " << j << ") is " << a_.get(i, j)
+                    << " instead of " << b_.get(i, j) << " !");
+      }
+  DT_THROW_IF(a_.counts() != b_.counts(), std::logic_error,
+              what_ << " : " << a_.counts() << " entries instead of " << b_.counts() << " !");
+  return;
+}
+
+// Fill values concurrently, the k-th fill being done by thread k % NTHREADS.
+template <typename Fill>
+void fill_concurrently(size_t fills_, Fill fill_)
+{
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < NTHREADS; ++t)
+    {
+      threads.push_back(std::thread([&fill_, fills_, t]()
+                                    {
+                                      for (size_t k = t; k < fills_; k += NTHREADS) fill_(k);
+                                    }));
+    }
+  for (size_t t = 0; t < threads.size(); ++t) threads[t].join();
+  return;
+}
+
+// Fill a 1D histogram serially and an atomic one concurrently, exported twice.
+void check_atomic_1d(const mygsl::histogram_1d & empty_)
+{
+  const std::vector<double> values = test_values(empty_);
+  const size_t nfills = values.size() * NREPEATS;
+  mygsl::histogram_1d expected(empty_);
+  mygsl::histogram_1d exported(empty_);
+  analysis::atomic_histogram_1d atomic;
+  atomic.initialize(empty_);
+  for (int pass = 0; pass < 2; ++pass)
+    {
+      // Unit weight and weighted fills of the same bins
+      for (size_t k = 0; k < nfills; ++k)
+        {
+          const double x = values[k % values.size()];
+          if (k % 3 == 0) expected.fill(x, test_weight(k));
+          else expected.fill(x);
+        }
+      fill_concurrently(nfills, [&](size_t k_)
+                        {
+                          const double x = values[k_ % values.size()];
+                          if (k_ % 3 == 0) atomic.fill(x, test_weight(k_));
+                          else atomic.fill(x);
+                        });
+      atomic.export_to(exported);
+      compare(exported, expected, "1D atomic fill, pass " + std::to_string(pass));
+    }
+
+  // The contents are cleared by the export
+  atomic.export_to(exported);
+  compare(exported, expected, "1D atomic fill exported twice");
+  return;
+}
+
+// Fill the same bin concurrently with weights, so that the additions of the threads collide.
+void check_contended_bin()
+{
+  const mygsl::histogram_1d empty(4, 0.0, 1.0);
+  mygsl::histogram_1d expected(empty);
+  mygsl::histogram_1d exported(empty);
+  analysis::atomic_histogram_1d atomic;
+  atomic.initialize(empty);
+  const size_t nfills = 400000;
+  for (size_t k = 0; k < nfills; ++k) expected.fill(0.3, test_weight(k));
+  fill_concurrently(nfills, [&](size_t k_) { atomic.fill(0.3, test_weight(k_)); });
+  atomic.export_to(exported);
+  compare(exported, expected, "contended weighted bin");
+  return;
+}
+
+// Fill a 2D histogram serially and an atomic one concurrently.
+void check_atomic_2d()
+{
+  mygsl::histogram_1d x_axis(10, -1.0, 1.0);
+  mygsl::histogram_1d y_axis(4, 0.0, 2.0);
+  const std::vector<double> x_values = test_values(x_axis);
+  const std::vector<double> y_values = test_values(y_axis);
+  std::vector<double> x_edges;
+  std::vector<double> y_edges;
+  for (size_t i = 0; i < x_axis.bins(); ++i) x_edges.push_back(x_axis.get_range(i).first);
+  x_edges.push_back(1.0);
+  for (size_t j = 0; j < y_axis.bins(); ++j) y_edges.push_back(y_axis.get_range(j).first);
+  y_edges.push_back(2.0);
+  const mygsl::histogram_2d empty(x_edges, y_edges);
+  mygsl::histogram_2d expected(empty);
+  mygsl::histogram_2d exported(empty);
+  analysis::atomic_histogram_2d atomic;
+  atomic.initialize(empty);
+  const size_t nfills = x_values.size() * y_values.size() * NREPEATS / 10;
+  for (size_t k = 0; k < nfills; ++k)
+    {
+      const double x = x_values[k % x_values.size()];
+      const double y = y_values[(k / 7) % y_values.size()];
+      if (k % 2 == 0) expected.fill(x, y, test_weight(k));
+      else expected.fill(x, y);
+    }
+  fill_concurrently(nfills, [&](size_t k_)
+                    {
+                      const double x = x_values[k_ % x_values.size()];
+                      const double y = y_values[(k_ / 7) % y_values.size()];
+                      if (k_ % 2 == 0) atomic.fill(x, y, test_weight(k_));
+                      else atomic.fill(x, y);
+                    });
+  atomic.export_to(exported);
+  compare(exported, expected, "2D atomic fill");
+  return;
+}
+
+// Register atomic histograms of a pool concurrently and export them.
+void check_registry()
+{
+  mygsl::histogram_pool pool;
+  analysis::atomic_histogram_registry registry;
+  registry.initialize(pool);
+  const mygsl::histogram_1d empty(20, 0.0, 3.0);
+  const std::vector<double> values = test_values(empty);
+  const size_t nhistograms = 3;
+  mygsl::histogram_1d expected[nhistograms] = { empty, empty, empty };
+  const size_t nfills = values.size() * NREPEATS;
+  for (size_t k = 0; k < nfills; ++k)
+    {
+      expected[k % nhistograms].fill(values[k % values.size()], test_weight(k));
+    }
+  fill_concurrently(nfills, [&](size_t k_)
+                    {
+                      const std::string name = "h" + std::to_string(k_ % nhistograms);
+                      analysis::atomic_histogram_1d & atomic
+                        = registry.grab_1d(name, [&](mygsl::histogram_pool & pool_) -> mygsl::histogram_1d &
+                                           {
+                                             mygsl::histogram_1d & h = pool_.add_1d(name);
+                                             h = empty;
+                                             return h;
+                                           });
+                      atomic.fill(values[k_ % values.size()], test_weight(k_));
+                    });
+  registry.export_histograms();
+  for (size_t n = 0; n < nhistograms; ++n)
+    {
+      const std::string name = "h" + std::to_string(n);
+      compare(pool.get_1d(name), expected[n], "registry histogram '" + name + "'");
+      DT_THROW_IF(&registry.get_histogram_1d(name) != &pool.get_1d(name), std::logic_error,
+                  "Atomic histogram '" << name << "' is not attached to the pool one !");
+    }
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::atomic_histogram_1d/2d' classes." << std::endl;
+
+    // Uniform binning
+    check_atomic_1d(mygsl::histogram_1d(20, 0.0, 3.0));
+    // Non uniform binning
+    std::vector<double> edges;
+    edges.push_back(0.0);
+    edges.push_back(0.1);
+    edges.push_back(0.5);
+    edges.push_back(2.0);
+    edges.push_back(2.25);
+    check_atomic_1d(mygsl::histogram_1d(edges));
+    check_contended_bin();
+    check_atomic_2d();
+    check_registry();
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
@@ -0,0 +1,124 @@
+// test_background_matcher.cxx
+
+// Standard library:
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/background_matcher.h>
+
+// Identifiers of the patterns contained in a text, by direct search.
+std::vector<size_t> naive_match(const std::vector<std::string> & patterns_, const std::string & text_)
+{
+  std::vector<size_t> ids;
+  for (size_t id = 0; id < patterns_.size(); ++id)
+    {
+      if (text_.find(patterns_[id]) != std::string::npos) ids.push_back(id);
+    }
+  return ids;
+}
+
+// Check that a call throws a logic error.
+template <class Function>
+void check_throws(Function function_, const std::string & what_)
+{
+  bool thrown = false;
+  try {
+    function_();
+  }
+  catch (std::logic_error &) {
+    thrown = true;
+  }
+  DT_THROW_IF(! thrown, std::logic_error, "No exception when " << what_ << " !");
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::background_matcher' class." << std::endl;
+
+    {
+      // Example of A. V. Aho and M. J. Corasick, with overlapping and nested patterns
+      analysis::background_matcher matcher;
+      matcher.add_pattern("he");
+      matcher.add_pattern("she");
+      matcher.add_pattern("his");
+      matcher.add_pattern("hers");
+      check_throws([&matcher]() { std::vector<size_t> ids; matcher.match("ushers", ids); },
+                   "matching before compilation");
+      matcher.compile();
+      check_throws([&matcher]() { matcher.add_pattern("her"); }, "adding a pattern after compilation");
+
+      std::vector<size_t> ids;
+      matcher.match("ushers", ids);
+      DT_THROW_IF(ids != std::vector<size_t>({0, 1, 3}), std::logic_error, "Wrong matches in 'ushers' !");
+      matcher.match("hishe", ids);
+      DT_THROW_IF(ids != std::vector<size_t>({0, 1, 2}), std::logic_error, "Wrong matches in 'hishe' !");
+      matcher.match("", ids);
+      DT_THROW_IF(! ids.empty(), std::logic_error, "Matches in an empty text !");
+    }
+
+    {
+      // Background names of the halflife limit module, duplicated patterns are all reported
+      analysis::background_matcher matcher;
+      check_throws([&matcher]() { matcher.add_pattern(""); }, "adding an empty pattern");
+      const std::vector<std::string> patterns = { "Bi214", "Tl208", "Bi214_foil", "Rn222", "Tl208" };
+      for (size_t i = 0; i < patterns.size(); ++i) matcher.add_pattern(patterns[i]);
+      matcher.compile();
+      std::vector<size_t> ids;
+      matcher.match("Bi214_foil_2e-0e+0u", ids);
+      DT_THROW_IF(ids != std::vector<size_t>({0, 2}), std::logic_error, "Wrong matches of 'Bi214_foil' !");
+      matcher.match("Tl208_wire_2e-0e+0u", ids);
+      DT_THROW_IF(ids != std::vector<size_t>({1, 4}), std::logic_error, "Wrong matches of 'Tl208' !");
+      matcher.match("Se82_2e-0e+0u", ids);
+      DT_THROW_IF(! ids.empty(), std::logic_error, "Matches in a signal name !");
+    }
+
+    {
+      // Random patterns and texts over a small alphabet, against a direct search
+      std::mt19937 generator(314159);
+      std::uniform_int_distribution<int> letter('a', 'c');
+      std::uniform_int_distribution<size_t> length(1, 4);
+      for (size_t trial = 0; trial < 50; ++trial)
+        {
+          analysis::background_matcher matcher;
+          std::vector<std::string> patterns(10);
+          for (size_t i = 0; i < patterns.size(); ++i)
+            {
+              const size_t n = length(generator);
+              for (size_t j = 0; j < n; ++j) patterns[i] += static_cast<char>(letter(generator));
+              matcher.add_pattern(patterns[i]);
+            }
+          matcher.compile();
+          std::string text;
+          for (size_t j = 0; j < 30; ++j) text += static_cast<char>(letter(generator));
+          std::vector<size_t> ids;
+          matcher.match(text, ids);
+          DT_THROW_IF(ids != naive_match(patterns, text), std::logic_error,
+                      "Matches in '" << text << "' differ from the direct search !");
+        }
+    }
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
@@ -0,0 +1,213 @@
+// test_cut_flow.cxx
+
+// Standard library:
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/cut_flow.h>
+
+// Event of the test cuts
+struct test_event
+{
+  int value;
+};
+
+typedef analysis::cut_flow<test_event> test_cut_flow;
+
+// Number of calls of each cut predicate
+typedef std::vector<uint64_t> calls_type;
+
+// Register a cut accepting the events whose value modulo 'modulo' is not 'rejected', counting its calls.
+void register_modulo_cut(test_cut_flow & flow_, const std::string & name_, int default_modulo_,
+                         double cost_, std::shared_ptr<calls_type> calls_, size_t index_)
+{
+  flow_.register_cut(name_,
+                     [default_modulo_, calls_, index_](const datatools::properties & parameters_)
+                     {
+                       int modulo = default_modulo_;
+                       if (parameters_.has_key("modulo")) modulo = parameters_.fetch_integer("modulo");
+                       return test_cut_flow::predicate_type([modulo, calls_, index_](test_event & event_)
+                                                            {
+                                                              (*calls_)[index_]++;
+                                                              return event_.value % modulo != 0;
+                                                            });
+                     },
+                     cost_);
+  return;
+}
+
+// Build a cut flow of three cuts, the most rejecting one being configured last.
+void build_flow(test_cut_flow & flow_, std::shared_ptr<calls_type> calls_, bool adaptive_)
+{
+  calls_->assign(3, 0);
+  register_modulo_cut(flow_, "odd", 2, 1.0, calls_, 0);
+  register_modulo_cut(flow_, "not_multiple_of_7", 7, 1.0, calls_, 1);
+  register_modulo_cut(flow_, "rare", 1000, 1.0, calls_, 2);
+  datatools::properties config;
+  std::vector<std::string> cuts;
+  cuts.push_back("not_multiple_of_7");
+  cuts.push_back("odd");
+  cuts.push_back("rare");
+  config.store("cuts", cuts);
+  config.store_boolean("adaptive", adaptive_);
+  config.store_integer("reorder_period", 50);
+  // 'rare' only rejects one event out of a thousand
+  config.store_integer("rare.modulo", 1000);
+  // 'odd' rejects half of the events, make it the cheapest per rejected event
+  config.store_real("odd.cost", 0.5);
+  flow_.initialize(config);
+  return;
+}
+
+// Check the counters of a cut flow against the calls of its predicates.
+void check_counters(const test_cut_flow & flow_, const calls_type & calls_, const std::string & what_)
+{
+  uint64_t rejected = 0;
+  for (size_t i = 0; i < flow_.size(); ++i)
+    {
+      DT_THROW_IF(flow_.get_number_of_rejected_events(i) > flow_.get_number_of_tested_events(i), std::logic_error,
+                  what_ << " : cut '" << flow_.get_cut_name(i) << "' rejects more events than it tests !");
+      rejected += flow_.get_number_of_rejected_events(i);
+    }
+  DT_THROW_IF(rejected + flow_.get_number_of_accepted_events() != flow_.get_number_of_events(), std::logic_error,
+              what_ << " : rejected and accepted events do not add up to the selected events !");
+  // Configuration order is 'not_multiple_of_7', 'odd', 'rare' while the predicates are indexed by registration
+  const size_t predicate_of_cut[] = { 1, 0, 2 };
+  for (size_t i = 0; i < flow_.size(); ++i)
+    {
+      DT_THROW_IF(flow_.get_number_of_tested_events(i) != calls_[predicate_of_cut[i]], std::logic_error,
+                  what_ << " : cut '" << flow_.get_cut_name(i) << "' tested "
+                  << flow_.get_number_of_tested_events(i) << " events for "
+                  << calls_[predicate_of_cut[i]] << " predicate calls !");
+    }
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::cut_flow' class." << std::endl;
+
+    const int nevents = 10000;
+    std::shared_ptr<calls_type> fixed_calls(new calls_type);
+    std::shared_ptr<calls_type> adaptive_calls(new calls_type);
+    test_cut_flow fixed;
+    test_cut_flow adaptive;
+    build_flow(fixed, fixed_calls, false);
+    build_flow(adaptive, adaptive_calls, true);
+    DT_THROW_IF(fixed.size() != 3 || fixed.get_cut_name(0) != "not_multiple_of_7", std::logic_error,
+                "Cuts are not in configuration order !");
+
+    // Reordering the cuts does not change the accepted events
+    uint64_t expected_accepted = 0;
+    for (int value = 0; value < nevents; ++value)
+      {
+        test_event event = { value };
+        const bool expected = value % 7 != 0 && value % 2 != 0 && value % 1000 != 0;
+        if (expected) expected_accepted++;
+        DT_THROW_IF(fixed.select(event) != expected, std::logic_error,
+                    "Fixed cut flow does not select event " << value << " as expected !");
+        DT_THROW_IF(adaptive.select(event) != expected, std::logic_error,
+                    "Adaptive cut flow does not select event " << value << " as expected !");
+      }
+    for (const test_cut_flow * flow : { &fixed, &adaptive })
+      {
+        DT_THROW_IF(flow->get_number_of_events() != uint64_t(nevents)
+                    || flow->get_number_of_accepted_events() != expected_accepted, std::logic_error,
+                    "Wrong number of selected or accepted events !");
+      }
+    check_counters(fixed, *fixed_calls, "fixed cut flow");
+    check_counters(adaptive, *adaptive_calls, "adaptive cut flow");
+
+    // In configuration order, each cut tests the events passing the previous ones
+    DT_THROW_IF(fixed.get_number_of_tested_events(0) != uint64_t(nevents), std::logic_error,
+                "First cut does not test all events !");
+    for (size_t i = 1; i < fixed.size(); ++i)
+      {
+        DT_THROW_IF(fixed.get_number_of_tested_events(i) != fixed.get_number_of_tested_events(i - 1)
+                    - fixed.get_number_of_rejected_events(i - 1), std::logic_error,
+                    "Cut '" << fixed.get_cut_name(i) << "' does not test the events passing the previous cuts !");
+      }
+
+    // The adaptive order runs the cheap rejecting 'odd' cut first after the first reordering
+    DT_THROW_IF(adaptive.get_number_of_tested_events(1) < uint64_t(nevents - 50), std::logic_error,
+                "Adaptive cut flow does not run the 'odd' cut first !");
+    uint64_t fixed_tests = 0;
+    uint64_t adaptive_tests = 0;
+    for (size_t i = 0; i < fixed.size(); ++i)
+      {
+        fixed_tests += fixed.get_number_of_tested_events(i);
+        adaptive_tests += adaptive.get_number_of_tested_events(i);
+      }
+    DT_THROW_IF(adaptive_tests >= fixed_tests, std::logic_error, "Adaptive cut flow does not run fewer tests !");
+
+    // Counters of flows over two halves of the events add up to the counters of one flow over all events
+    std::shared_ptr<calls_type> first_calls(new calls_type);
+    std::shared_ptr<calls_type> second_calls(new calls_type);
+    test_cut_flow first;
+    test_cut_flow second;
+    build_flow(first, first_calls, false);
+    build_flow(second, second_calls, false);
+    for (int value = 0; value < nevents; ++value)
+      {
+        test_event event = { value };
+        if (value < nevents / 2) first.select(event);
+        else second.select(event);
+      }
+    first.merge(second);
+    DT_THROW_IF(first.get_number_of_events() != fixed.get_number_of_events()
+                || first.get_number_of_accepted_events() != fixed.get_number_of_accepted_events(), std::logic_error,
+                "Merged cut flow has wrong numbers of selected or accepted events !");
+    for (size_t i = 0; i < first.size(); ++i)
+      {
+        DT_THROW_IF(first.get_number_of_tested_events(i) != fixed.get_number_of_tested_events(i)
+                    || first.get_number_of_rejected_events(i) != fixed.get_number_of_rejected_events(i),
+                    std::logic_error, "Merged cut '" << first.get_cut_name(i) << "' has wrong counters !");
+      }
+
+    // Resetting the counters keeps the cuts
+    first.reset_counters();
+    DT_THROW_IF(first.size() != 3 || first.get_number_of_events() != 0
+                || first.get_number_of_tested_events(0) != 0, std::logic_error,
+                "Reset cut flow counters are not null !");
+
+    // Cut flows with different cuts cannot be merged
+    std::shared_ptr<calls_type> other_calls(new calls_type(3, 0));
+    test_cut_flow other;
+    register_modulo_cut(other, "odd", 2, 1.0, other_calls, 0);
+    datatools::properties other_config;
+    other.initialize(other_config, std::vector<std::string>(1, "odd"));
+    bool rejected = false;
+    try {
+      first.merge(other);
+    }
+    catch (std::logic_error &) {
+      rejected = true;
+    }
+    DT_THROW_IF(! rejected, std::logic_error, "Cut flows with different cuts are merged !");
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
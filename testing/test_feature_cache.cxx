@@ -0,0 +1,147 @@
+// test_feature_cache.cxx
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/feature_cache.h>
+
+// Real value of a row, NaN for the missing values.
+double real_value(size_t row_, size_t column_)
+{
+  if ((row_ + column_) % 7 == 0) return std::numeric_limits<double>::quiet_NaN();
+  return 0.001 * row_ + 10.0 * column_ - 3.5;
+}
+
+// Write a cache of nrows_ rows with two real and two integer columns.
+void write_cache(const std::string & path_, size_t nrows_, size_t row_group_size_, bool close_)
+{
+  analysis::feature_cache_writer writer;
+  writer.add_real_column("energy");
+  writer.add_real_column("vertex_y");
+  writer.add_integer_column("topology");
+  writer.add_integer_column("number_of_gammas");
+  writer.open(path_, row_group_size_);
+  const char * topologies[] = { "1e", "2e", "1eNg" };
+  for (size_t r = 0; r < nrows_; ++r)
+    {
+      const double reals[] = { real_value(r, 0), real_value(r, 1) };
+      const int32_t integers[] = { r % 5 == 4 ? -1 : writer.intern(topologies[r % 3]), static_cast<int32_t>(r) - 3 };
+      writer.append_row(reals, integers);
+    }
+  DT_THROW_IF(writer.get_number_of_rows() != nrows_, std::logic_error, "Wrong number of appended rows !");
+  // Otherwise the destructor closes the file
+  if (close_) writer.close();
+  return;
+}
+
+// Read back a cache written by write_cache.
+void check_cache(const std::string & path_, size_t nrows_, size_t row_group_size_)
+{
+  analysis::feature_cache_reader reader;
+  reader.open(path_);
+  DT_THROW_IF(reader.get_number_of_rows() != nrows_, std::logic_error, "Wrong number of rows !");
+  DT_THROW_IF(reader.get_number_of_row_groups() != (nrows_ + row_group_size_ - 1) / row_group_size_,
+              std::logic_error, "Wrong number of row groups !");
+  DT_THROW_IF(reader.find_real_column("vertex_y") != 1 || reader.find_integer_column("topology") != 0
+              || reader.find_real_column("topology") != -1, std::logic_error, "Wrong column lookup !");
+  const std::vector<std::string> strings = { "1e", "2e", "1eNg" };
+  DT_THROW_IF(reader.get_strings() != (nrows_ == 0 ? std::vector<std::string>() : strings), std::logic_error,
+              "Wrong string table !");
+  DT_THROW_IF(! reader.get_string(-1).empty(), std::logic_error, "Missing string is not empty !");
+  size_t row = 0;
+  for (size_t g = 0; g < reader.get_number_of_row_groups(); ++g)
+    {
+      const size_t nrows = reader.get_row_group_size(g);
+      DT_THROW_IF(nrows > row_group_size_, std::logic_error, "Row group " << g << " is too large !");
+      const double * energy = reader.get_real_column(g, 0);
+      const double * vertex_y = reader.get_real_column(g, 1);
+      const int32_t * topology = reader.get_integer_column(g, 0);
+      const int32_t * ngammas = reader.get_integer_column(g, 1);
+      for (size_t r = 0; r < nrows; ++r, ++row)
+        {
+          const double expected[] = { real_value(row, 0), real_value(row, 1) };
+          const double read[] = { energy[r], vertex_y[r] };
+          for (size_t c = 0; c < 2; ++c)
+            {
+              const bool same = std::isnan(expected[c]) ? std::isnan(read[c]) : read[c] == expected[c];
+              DT_THROW_IF(! same, std::logic_error, "Wrong real value at row " << row << " !");
+            }
+          const std::string expected_topology = row % 5 == 4 ? "" : strings[row % 3];
+          DT_THROW_IF(reader.get_string(topology[r]) != expected_topology, std::logic_error,
+                      "Wrong topology at row " << row << " !");
+          DT_THROW_IF(ngammas[r] != static_cast<int32_t>(row) - 3, std::logic_error,
+                      "Wrong integer value at row " << row << " !");
+        }
+    }
+  reader.close();
+  DT_THROW_IF(reader.is_open(), std::logic_error, "Reader is still open !");
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::feature_cache_writer/reader' classes." << std::endl;
+    const std::string path = "test_feature_cache.bin";
+
+    // Last row group partially filled, closed explicitly or by the destructor
+    write_cache(path, 103, 16, true);
+    check_cache(path, 103, 16);
+    write_cache(path, 64, 16, false);
+    check_cache(path, 64, 16);
+
+    // Empty cache
+    write_cache(path, 0, 16, true);
+    check_cache(path, 0, 16);
+
+    // A truncated file is rejected
+    write_cache(path, 50, 8, true);
+    std::string content;
+    {
+      std::ifstream in(path.c_str(), std::ios::binary);
+      content.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    {
+      std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+      out.write(content.data(), content.size() / 2);
+    }
+    bool rejected = false;
+    analysis::feature_cache_reader reader;
+    try {
+      reader.open(path);
+    }
+    catch (std::runtime_error &) {
+      rejected = true;
+    }
+    DT_THROW_IF(! rejected || reader.is_open(), std::logic_error, "Truncated feature cache is accepted !");
+    std::remove(path.c_str());
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
@@ -0,0 +1,122 @@
+// test_feldman_cousins.cxx
+
+// Standard library:
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/feldman_cousins.h>
+
+// Check a computed upper limit against the published 90% C.L. value.
+void check_limit(const analysis::feldman_cousins & fc_, size_t observed_, double background_, double expected_)
+{
+  const double limit = fc_.upper_limit(observed_, background_);
+  std::clog << "n0 = " << observed_ << ", b = " << background_ << " : upper limit = " << limit
+            << " (expected " << expected_ << ")" << std::endl;
+  DT_THROW_IF(std::abs(limit - expected_) > 0.01, std::logic_error,
+              "Upper limit " << limit << " for n0 = " << observed_ << " and b = " << background_
+              << " differs from " << expected_ << " !");
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::feldman_cousins' class." << std::endl;
+
+    analysis::feldman_cousins fc;
+    DT_THROW_IF(fc.get_mode() != analysis::feldman_cousins::MODE_POLYNOMIAL, std::logic_error,
+                "Default mode is not 'polynomial' !");
+    DT_THROW_IF(std::abs(fc.excluded_events(0.0) - 2.5617) > 1e-9, std::logic_error,
+                "Polynomial mode does not give the legacy value !");
+
+    fc.build_table(0.9, 5.0, 0.5, 2);
+    DT_THROW_IF(fc.get_mode() != analysis::feldman_cousins::MODE_TABLE, std::logic_error,
+                "Built table is not used !");
+
+    // Table IV of G. J. Feldman and R. D. Cousins, Phys. Rev. D 57 (1998) 3873,
+    // the n0 = 0 limits above b = 1.5 were adjusted by hand by the authors
+    check_limit(fc, 0, 0.0, 2.44);
+    check_limit(fc, 0, 0.5, 1.94);
+    check_limit(fc, 0, 1.0, 1.61);
+    check_limit(fc, 0, 1.5, 1.33);
+    check_limit(fc, 1, 0.0, 4.36);
+    check_limit(fc, 1, 1.0, 3.36);
+    check_limit(fc, 2, 0.0, 5.91);
+    check_limit(fc, 2, 1.0, 4.91);
+    check_limit(fc, 3, 0.0, 7.42);
+
+    // Without background, no event is ever observed
+    DT_THROW_IF(std::abs(fc.excluded_events(0.0) - fc.upper_limit(0, 0.0)) > 1e-9, std::logic_error,
+                "Mean upper limit without background is not the n0 = 0 limit !");
+
+    // The stored table is loaded back unchanged
+    const std::string path = "test_feldman_cousins.bin";
+    fc.store_table(path);
+    analysis::feldman_cousins loaded;
+    loaded.load_table(path);
+    DT_THROW_IF(loaded.get_number_of_observed() != fc.get_number_of_observed()
+                || loaded.get_max_background() != fc.get_max_background(), std::logic_error,
+                "Loaded table has not the stored grid !");
+    for (double b = 0.0; b < 7.0; b += 0.25)
+      {
+        DT_THROW_IF(loaded.excluded_events(b) != fc.excluded_events(b), std::logic_error,
+                    "Loaded table differs from the stored one at b = " << b << " !");
+      }
+
+    // A stored table is only reused with the configured grid
+    datatools::properties config;
+    config.store_string("mode", "table");
+    config.store_real("confidence_level", 0.9);
+    config.store_real("max_background", 5.0);
+    config.store_real("background_step", 0.5);
+    config.store_string("table_file", path);
+    analysis::feldman_cousins configured;
+    configured.initialize(config);
+    DT_THROW_IF(configured.get_max_background() != fc.get_max_background(), std::logic_error,
+                "Configured table has not the stored grid !");
+    config.update_real("max_background", 10.0);
+    bool rejected = false;
+    try {
+      analysis::feldman_cousins extended;
+      extended.initialize(config);
+    }
+    catch (std::logic_error &) {
+      rejected = true;
+    }
+    DT_THROW_IF(! rejected, std::logic_error, "Table with a smaller grid than configured is reused !");
+    config.update_real("max_background", 5.0);
+    config.update_real("background_step", 0.25);
+    rejected = false;
+    try {
+      analysis::feldman_cousins refined;
+      refined.initialize(config);
+    }
+    catch (std::logic_error &) {
+      rejected = true;
+    }
+    DT_THROW_IF(! rejected, std::logic_error, "Table with a coarser grid than configured is reused !");
+    std::remove(path.c_str());
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
@@ -0,0 +1,116 @@
+// test_histogram_axis.cxx
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/histogram_filler.h>
+
+// Bin edges of a uniform axis, computed as GSL does.
+std::vector<double> uniform_edges(double min_, double max_, size_t bins_)
+{
+  std::vector<double> edges(bins_ + 1);
+  for (size_t i = 0; i <= bins_; ++i)
+    {
+      edges[i] = min_ + (static_cast<double>(i) / static_cast<double>(bins_)) * (max_ - min_);
+    }
+  return edges;
+}
+
+// Bin of a value by binary search over the edges.
+size_t reference_bin(const std::vector<double> & edges_, double x_)
+{
+  if (! (x_ >= edges_.front() && x_ < edges_.back())) return analysis::histogram_axis::INVALID_BIN;
+  return std::upper_bound(edges_.begin(), edges_.end(), x_) - edges_.begin() - 1;
+}
+
+// Check the scalar and the batch lookups of a uniform axis on the edges and their neighbours.
+void check_axis(double min_, double max_, size_t bins_)
+{
+  const std::vector<double> edges = uniform_edges(min_, max_, bins_);
+  analysis::histogram_axis axis;
+  axis.initialize(edges);
+  DT_THROW_IF(! axis.is_uniform(), std::logic_error, "Axis [" << min_ << ", " << max_ << "] is not uniform !");
+
+  std::vector<double> values;
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < edges.size(); ++i)
+    {
+      values.push_back(edges[i]);
+      values.push_back(std::nextafter(edges[i], -infinity));
+      values.push_back(std::nextafter(edges[i], +infinity));
+    }
+  values.push_back(std::numeric_limits<double>::quiet_NaN());
+  values.push_back(-infinity);
+  values.push_back(+infinity);
+
+  std::vector<size_t> bins(values.size());
+  axis.find_uniform(&values[0], values.size(), &bins[0]);
+  for (size_t k = 0; k < values.size(); ++k)
+    {
+      const size_t expected = reference_bin(edges, values[k]);
+      size_t bin = analysis::histogram_axis::INVALID_BIN;
+      const bool found = axis.find_uniform(values[k], bin);
+      DT_THROW_IF(found != (expected != analysis::histogram_axis::INVALID_BIN)
+                  || (found && bin != expected), std::logic_error,
+                  "Scalar lookup of " << values[k] << " on [" << min_ << ", " << max_ << "] gives bin "
+                  << bin << " instead of " << expected << " !");
+      DT_THROW_IF(bins[k] != expected, std::logic_error,
+                  "Batch lookup of " << values[k] << " on [" << min_ << ", " << max_ << "] gives bin "
+                  << bins[k] << " instead of " << expected << " !");
+    }
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::histogram_axis' class." << std::endl;
+
+    // Bin widths not representable exactly
+    check_axis(0.0, 3.0, 30);
+    check_axis(0.0, 4.5, 90);
+    check_axis(-1.3, 2.9, 42);
+    check_axis(-2500.0, 2500.0, 333);
+    check_axis(1e-3, 1.0 + 1e-3, 7);
+    check_axis(0.0, 1.0, 1);
+
+    // Non uniform axis: only the binary search is used
+    const std::vector<double> edges = { 0.0, 0.5, 0.7, 2.0 };
+    analysis::histogram_axis axis;
+    axis.initialize(edges);
+    DT_THROW_IF(axis.is_uniform(), std::logic_error, "Non uniform axis is uniform !");
+    size_t bin = 0;
+    DT_THROW_IF(axis.find_uniform(0.6, bin), std::logic_error, "Uniform lookup of a non uniform axis !");
+    DT_THROW_IF(! axis.find(0.7, bin) || bin != 2, std::logic_error, "Wrong bin of a non uniform edge !");
+    DT_THROW_IF(axis.find(2.0, bin), std::logic_error, "Upper edge is in range !");
+    const double x[] = { 0.6, -0.1 };
+    size_t bins[] = { 0, 0 };
+    axis.find_uniform(x, 2, bins);
+    DT_THROW_IF(bins[0] != analysis::histogram_axis::INVALID_BIN || bins[1] != analysis::histogram_axis::INVALID_BIN,
+                std::logic_error, "Batch uniform lookup of a non uniform axis !");
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
@@ -0,0 +1,146 @@
+// test_histogram_checkpoint.cxx
+
+// Standard library:
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+// - Bayeux/mygsl
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/histogram_checkpoint.h>
+
+// Add the histograms of a test pool, 'energy' and 'vertex' being owned by the checkpointed module.
+void book(mygsl::histogram_pool & pool_)
+{
+  pool_.initialize(datatools::properties());
+  pool_.add_1d("energy", "", "energy").initialize(10, 0.0, 5.0);
+  pool_.add_2d("vertex", "", "vertices").initialize(4, -1.0, 1.0, 4, -1.0, 1.0);
+  pool_.add_1d("other", "", "energy").initialize(10, 0.0, 5.0);
+  return;
+}
+
+// Check if a file exists.
+bool exists(const std::string & path_)
+{
+  return std::ifstream(path_.c_str()).good();
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::histogram_checkpoint' class." << std::endl;
+    const std::string path = "test_histogram_checkpoint.data";
+    std::remove(path.c_str());
+    datatools::properties config;
+    config.store_string("file", path);
+    config.store_integer("period_events", 2);
+
+    // Run of 5 events, the checkpoint holds the first 4 ones
+    {
+      mygsl::histogram_pool pool;
+      book(pool);
+      analysis::histogram_checkpoint checkpoint;
+      checkpoint.initialize(config, "plot");
+      DT_THROW_IF(! checkpoint.is_enabled(), std::logic_error, "Checkpoint is not enabled !");
+      checkpoint.restore(pool);
+      DT_THROW_IF(checkpoint.get_skipped_events() != 0, std::logic_error, "Events skipped without checkpoint !");
+      checkpoint.own("energy");
+      checkpoint.own("vertex");
+      for (size_t event = 0; event < 5; ++event)
+        {
+          DT_THROW_IF(checkpoint.begin_event(), std::logic_error, "Event " << event << " is skipped !");
+          // Stored before the event, as the modules do
+          if (checkpoint.is_due()) checkpoint.store(pool);
+          pool.grab_1d("energy").fill(0.5 + event);
+          pool.grab_2d("vertex").fill(-0.9 + 0.4 * event, 0.1);
+          pool.grab_1d("other").fill(0.5 + event);
+        }
+      DT_THROW_IF(! exists(path), std::logic_error, "No checkpoint file '" << path << "' !");
+    }
+
+    // Resumed run: the owned histograms are restored, the other ones are left untouched
+    {
+      mygsl::histogram_pool pool;
+      book(pool);
+      pool.grab_1d("energy").fill(4.5, 10.0);
+      pool.grab_1d("other").fill(4.5, 10.0);
+      analysis::histogram_checkpoint checkpoint;
+      checkpoint.initialize(config, "plot");
+      checkpoint.restore(pool);
+      DT_THROW_IF(checkpoint.get_skipped_events() != 4, std::logic_error,
+                  "Checkpoint skips " << checkpoint.get_skipped_events() << " events instead of 4 !");
+      const mygsl::histogram_1d & energy = pool.get_1d("energy");
+      for (size_t i = 0; i < energy.bins(); ++i)
+        {
+          const double expected = i < 8 && i % 2 == 1 ? 1.0 : 0.0;
+          DT_THROW_IF(energy.get(i) != expected, std::logic_error,
+                      "Restored 'energy' bin " << i << " is " << energy.get(i) << " instead of " << expected << " !");
+        }
+      DT_THROW_IF(pool.get_2d("vertex").sum() != 4.0, std::logic_error, "Restored 'vertex' has not 4 entries !");
+      DT_THROW_IF(pool.get_1d("other").get(9) != 10.0, std::logic_error, "Histogram 'other' is restored !");
+      for (size_t event = 0; event < 5; ++event)
+        {
+          DT_THROW_IF(checkpoint.begin_event() != (event < 4), std::logic_error,
+                      "Wrong skip flag of event " << event << " !");
+        }
+      checkpoint.terminate();
+      DT_THROW_IF(exists(path), std::logic_error, "Checkpoint file is not removed at the end of the run !");
+    }
+
+    // A checkpoint of another module is rejected
+    {
+      mygsl::histogram_pool pool;
+      book(pool);
+      analysis::histogram_checkpoint checkpoint;
+      checkpoint.initialize(config, "plot");
+      checkpoint.own("energy");
+      checkpoint.begin_event();
+      checkpoint.begin_event();
+      checkpoint.begin_event();
+      checkpoint.store(pool);
+      analysis::histogram_checkpoint other;
+      other.initialize(config, "vertices");
+      bool rejected = false;
+      try {
+        other.restore(pool);
+      }
+      catch (std::logic_error &) {
+        rejected = true;
+      }
+      DT_THROW_IF(! rejected, std::logic_error, "Checkpoint of another module is restored !");
+
+      // Without resuming, the checkpoint is ignored
+      datatools::properties no_resume_config = config;
+      no_resume_config.store_boolean("resume", false);
+      analysis::histogram_checkpoint no_resume;
+      no_resume.initialize(no_resume_config, "plot");
+      no_resume.restore(pool);
+      DT_THROW_IF(no_resume.get_skipped_events() != 0, std::logic_error, "Checkpoint restored without resuming !");
+      std::remove(path.c_str());
+    }
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
@@ -0,0 +1,339 @@
+// test_histogram_filler.cxx
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+// - Bayeux/mygsl:
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+
+// This project:
+#include <snemo/analysis/histogram_filler.h>
+
+// Values on the bin edges and their neighbours, out of range and invalid.
+std::vector<double> test_values(const mygsl::histogram_1d & histogram_)
+{
+  std::vector<double> values;
+  const double infinity = std::numeric_limits<double>::infinity();
+  for (size_t i = 0; i < histogram_.bins(); ++i)
+    {
+      const double edge = histogram_.get_range(i).first;
+      values.push_back(edge);
+      values.push_back(std::nextafter(edge, -infinity));
+      values.push_back(std::nextafter(edge, +infinity));
+      values.push_back(0.5 * (edge + histogram_.get_range(i).second));
+    }
+  const double max = histogram_.get_range(histogram_.bins() - 1).second;
+  values.push_back(max);
+  values.push_back(std::nextafter(max, -infinity));
+  values.push_back(std::nextafter(max, +infinity));
+  values.push_back(max + 10.0);
+  values.push_back(-infinity);
+  values.push_back(+infinity);
+  values.push_back(std::numeric_limits<double>::quiet_NaN());
+  // Repeated values
+  const size_t n = values.size();
+  for (size_t k = 0; k < n; k += 3) values.push_back(values[k]);
+  return values;
+}
+
+// Weight of the k-th value.
+double test_weight(size_t k_)
+{
+  return 0.25 + 0.125 * (k_ % 5);
+}
+
+bool same_value(double a_, double b_)
+{
+  return a_ == b_ || (std::isnan(a_) && std::isnan(b_));
+}
+
+// Check that two 1D histograms have the same contents and number of entries.
+void compare(const mygsl::histogram_1d & a_, const mygsl::histogram_1d & b_, const std::string & what_)
+{
+  for (size_t i = 0; i < a_.bins(); ++i)
+    {
+      DT_THROW_IF(! same_value(a_.get(i), b_.get(i)), std::logic_error,
+                  what_ << " : bin " << i << " is " << a_.get(i) << " instead of " << b_.get(i) << " !");
+    }
+  DT_THROW_IF(! same_value(a_.underflow(), b_.underflow()), std::logic_error, what_ << " : wrong underflow !");
+  DT_THROW_IF(! same_value(a_.overflow(), b_.overflow()), std::logic_error, what_ << " : wrong overflow !");
+  DT_THROW_IF(a_.counts() != b_.counts(), std::logic_error,
+              what_ << " : " << a_.counts() << " entries instead of " << b_.counts() << " !");
+  return;
+}
+
+// Fill a histogram with a filler and directly, with and without weights.
+void check_filler_1d(const mygsl::histogram_1d & empty_, bool buffered_, bool weighted_)
+{
+  const std::string what = std::string(buffered_ ? "buffered" : "immediate") + (weighted_ ? " weighted" : "") + " fill";
+  const std::vector<double> values = test_values(empty_);
+  mygsl::histogram_1d expected(empty_);
+  mygsl::histogram_1d expected_sumw2(empty_);
+  mygsl::histogram_1d filled(empty_);
+  mygsl::histogram_1d filled_sumw2(empty_);
+  analysis::histogram_filler_1d filler;
+  filler.initialize(filled);
+  if (weighted_) filler.set_sumw2(filled_sumw2);
+  // Small buffers to flush several times during the fill
+  filler.set_buffered(buffered_, 7);
+  for (size_t k = 0; k < values.size(); ++k)
+    {
+      if (weighted_)
+        {
+          const double w = test_weight(k);
+          expected.fill(values[k], w);
+          expected_sumw2.fill(values[k], w * w);
+          filler.fill(values[k], w);
+        }
+      else
+        {
+          expected.fill(values[k]);
+          filler.fill(values[k]);
+        }
+      if (buffered_ && k % 7 == 6) filler.flush();
+    }
+  filler.flush();
+  compare(filled, expected, what);
+  if (weighted_) compare(filled_sumw2, expected_sumw2, what + " of squared weights");
+
+  // Flushing again changes nothing
+  filler.flush();
+  compare(filled, expected, what + " flushed twice");
+  return;
+}
+
+// Fill a 2D histogram with a filler and directly.
+void check_filler_2d(bool buffered_)
+{
+  const std::string what = std::string(buffered_ ? "buffered" : "immediate") + " 2D fill";
+  mygsl::histogram_1d x_axis(10, -1.0, 1.0);
+  mygsl::histogram_1d y_axis(4, 0.0, 2.0);
+  const std::vector<double> x_values = test_values(x_axis);
+  const std::vector<double> y_values = test_values(y_axis);
+  std::vector<double> x_edges;
+  std::vector<double> y_edges;
+  for (size_t i = 0; i < x_axis.bins(); ++i) x_edges.push_back(x_axis.get_range(i).first);
+  x_edges.push_back(1.0);
+  for (size_t j = 0; j < y_axis.bins(); ++j) y_edges.push_back(y_axis.get_range(j).first);
+  y_edges.push_back(2.0);
+  mygsl::histogram_2d expected(x_edges, y_edges);
+  mygsl::histogram_2d filled(x_edges, y_edges);
+  analysis::histogram_filler_2d filler;
+  filler.initialize(filled);
+  filler.set_buffered(buffered_, 5);
+  for (size_t k = 0; k < x_values.size(); ++k)
+    {
+      const double y = y_values[k % y_values.size()];
+      expected.fill(x_values[k], y);
+      filler.fill(x_values[k], y);
+    }
+  filler.flush();
+  for (size_t i = 0; i < filled.xbins(); ++i)
+    for (size_t j = 0; j < filled.ybins(); ++j)
+      {
+        DT_THROW_IF(! same_value(filled.get(i, j), expected.get(i, j)), std::logic_error,
+                    what << " : bin (" << i << ", " << j << ") is " << filled.get(i, j)
+                    << " instead of " << expected.get(i, j) << " !");
+      }
+  DT_THROW_IF(filled.counts() != expected.counts(), std::logic_error,
+              what << " : " << filled.counts() << " entries instead of " << expected.counts() << " !");
+  return;
+}
+
+// Sums of the contents from each bin to the last one, recomputed from scratch.
+std::vector<double> full_contents_above(const mygsl::histogram_1d & histogram_)
+{
+  std::vector<double> above(histogram_.bins(), 0.0);
+  double sum = 0.0;
+  for (size_t i = histogram_.bins(); i-- > 0;)
+    {
+      sum += histogram_.get(i);
+      above[i] = sum;
+    }
+  return above;
+}
+
+void check_close(double value_, double expected_, const std::string & what_)
+{
+  DT_THROW_IF(std::abs(value_ - expected_) > 1e-12 * std::max(1.0, std::abs(expected_)), std::logic_error,
+              what_ << " is " << value_ << " instead of " << expected_ << " !");
+  return;
+}
+
+// Stand-in for the Feldman-Cousins excluded events of a background.
+double excluded_events(double background_)
+{
+  return 2.44 + 1.3 * std::sqrt(background_);
+}
+
+// Online estimate of the halflife module: the sums above each bin of a
+// signal and of two normalised backgrounds are updated from the bins
+// filled in each period, and the excluded events are only recomputed
+// below the last changed background bin.
+void check_online_estimate()
+{
+  const mygsl::histogram_1d empty(25, 0.0, 5.0);
+  const size_t nbins = empty.bins();
+  const size_t nhistograms = 3;
+  const double norms[nhistograms] = { 3.5, 0.75, 0.1 };
+  mygsl::histogram_1d histograms[nhistograms] = { empty, empty, empty };
+  analysis::histogram_filler_1d fillers[nhistograms];
+  std::vector<double> contents[nhistograms];
+  std::vector<double> above[nhistograms];
+  for (size_t h = 0; h < nhistograms; ++h)
+    {
+      fillers[h].initialize(histograms[h]);
+      fillers[h].set_buffered(h == 1, 16);
+      contents[h].assign(nbins, 0.0);
+      above[h].assign(nbins, 0.0);
+    }
+  std::vector<double> background(nbins, 0.0);
+  std::vector<double> excluded(nbins, excluded_events(0.0));
+
+  for (size_t period = 0; period < 12; ++period)
+    {
+      // Each period fills a different range of values, some periods leave a histogram untouched
+      const double low = 0.37 * (period % 5);
+      const double width = period % 4 == 3 ? 6.0 : 0.9 + 0.2 * period;
+      for (size_t h = 0; h < nhistograms; ++h)
+        {
+          if ((period + h) % 5 == 4) continue;
+          for (size_t k = 0; k < 40 + 7 * h; ++k)
+            {
+              const double x = low + width * std::fmod(0.6180339887 * (k + 13 * period + 101 * h), 1.0);
+              if (h == 2) fillers[h].fill(x, test_weight(k));
+              else fillers[h].fill(x);
+            }
+        }
+
+      // Incremental update from the bins filled during the period
+      std::vector<double> previous_background = background;
+      size_t changed_bins = 0;
+      for (size_t h = 0; h < nhistograms; ++h)
+        {
+          fillers[h].flush();
+          if (! fillers[h].is_dirty()) continue;
+          const size_t first = fillers[h].get_dirty_first();
+          const size_t last = fillers[h].get_dirty_last();
+          fillers[h].clear_dirty();
+          const bool is_background = h > 0;
+          analysis::update_contents_above(histograms[h], first, last, contents[h], above[h],
+                                          is_background ? &background : 0, norms[h]);
+          if (is_background) changed_bins = std::max(changed_bins, last);
+        }
+      for (size_t i = 0; i < changed_bins; ++i) excluded[i] = excluded_events(background[i]);
+      for (size_t i = changed_bins; i < nbins; ++i)
+        {
+          DT_THROW_IF(background[i] != previous_background[i], std::logic_error,
+                      "Background of bin " << i << " changed above the last changed bin !");
+        }
+      double best_halflife = 0.0;
+      size_t best_bin = 0;
+      for (size_t i = 0; i < nbins; ++i)
+        {
+          const double halflife = above[0][i] * norms[0] / excluded[i];
+          if (halflife > best_halflife)
+            {
+              best_halflife = halflife;
+              best_bin = i;
+            }
+        }
+
+      // Full recomputation from the histograms
+      const std::string what = "period " + std::to_string(period);
+      std::vector<double> full_background(nbins, 0.0);
+      std::vector<double> full_above[nhistograms];
+      for (size_t h = 0; h < nhistograms; ++h)
+        {
+          full_above[h] = full_contents_above(histograms[h]);
+          for (size_t i = 0; i < nbins; ++i)
+            {
+              check_close(above[h][i], full_above[h][i], what + " : sum above bin " + std::to_string(i));
+              if (h > 0) full_background[i] += full_above[h][i] * norms[h];
+            }
+        }
+      double full_best_halflife = 0.0;
+      size_t full_best_bin = 0;
+      for (size_t i = 0; i < nbins; ++i)
+        {
+          check_close(background[i], full_background[i], what + " : background above bin " + std::to_string(i));
+          const double halflife = full_above[0][i] * norms[0] / excluded_events(full_background[i]);
+          if (halflife > full_best_halflife)
+            {
+              full_best_halflife = halflife;
+              full_best_bin = i;
+            }
+        }
+      DT_THROW_IF(best_bin != full_best_bin, std::logic_error,
+                  what << " : best threshold bin is " << best_bin << " instead of " << full_best_bin << " !");
+      check_close(best_halflife, full_best_halflife, what + " : best halflife");
+    }
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::histogram_filler_1d/2d' classes." << std::endl;
+
+    // Uniform binning, filled through the bin lookup of the filler
+    mygsl::histogram_1d uniform(20, 0.0, 3.0);
+    // Non uniform binning, filled through the mygsl bin search
+    std::vector<double> edges;
+    edges.push_back(0.0);
+    edges.push_back(0.1);
+    edges.push_back(0.5);
+    edges.push_back(2.0);
+    edges.push_back(2.25);
+    mygsl::histogram_1d variable(edges);
+
+    for (int buffered = 0; buffered < 2; ++buffered)
+      {
+        for (int weighted = 0; weighted < 2; ++weighted)
+          {
+            check_filler_1d(uniform, buffered == 1, weighted == 1);
+            check_filler_1d(variable, buffered == 1, weighted == 1);
+          }
+        check_filler_2d(buffered == 1);
+      }
+
+    // Incremental sums above each bin
+    check_online_estimate();
+
+    // Fill counts added to a histogram without changing its contents
+    analysis::histogram_axis axis;
+    axis.initialize(uniform);
+    for (size_t n = 0; n < 70; n += 3)
+      {
+        mygsl::histogram_1d counted(uniform);
+        counted.fill(1.0, 2.0);
+        analysis::add_fill_counts(counted, axis, n);
+        DT_THROW_IF(static_cast<size_t>(counted.counts()) != n + 1 || counted.sum() != 2.0, std::logic_error,
+                    "Wrong fill counts added to a histogram !");
+      }
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
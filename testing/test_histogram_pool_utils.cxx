@@ -0,0 +1,306 @@
+// test_histogram_pool_utils.cxx
+
+// Standard library:
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/properties.h>
+#include <datatools/exception.h>
+// - Bayeux/mygsl:
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_2d.h>
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/histogram_pool_utils.h>
+
+// Global weight of a histogram: positive for a 'weight' auxiliary, 0 for none and negative for 'weighted' contents.
+void set_weight(datatools::properties & auxiliaries_, double weight_)
+{
+  if (weight_ > 0.0) auxiliaries_.update("weight", weight_);
+  if (weight_ < 0.0) auxiliaries_.update("weighted", true);
+  return;
+}
+
+// Add a 1D histogram with contents depending on a seed.
+mygsl::histogram_1d & add_1d(mygsl::histogram_pool & pool_, const std::string & name_,
+                             double seed_, double weight_, const std::string & group_ = "")
+{
+  mygsl::histogram_1d & h = pool_.add_1d(name_, "title of " + name_, group_);
+  h.initialize(8, 0.0, 4.0);
+  for (size_t i = 0; i < h.bins(); ++i) h.fill(0.5 * i + 0.25, seed_ / (i + 3.0));
+  set_weight(h.grab_auxiliaries(), weight_);
+  return h;
+}
+
+// Add a 2D histogram with contents depending on a seed.
+mygsl::histogram_2d & add_2d(mygsl::histogram_pool & pool_, const std::string & name_,
+                             double seed_, double weight_)
+{
+  mygsl::histogram_2d & h = pool_.add_2d(name_, "title of " + name_, "");
+  h.initialize(3, 0.0, 3.0, 2, 0.0, 2.0);
+  for (size_t i = 0; i < h.xbins(); ++i)
+    for (size_t j = 0; j < h.ybins(); ++j) h.fill(i + 0.5, j + 0.5, seed_ / (i + 2.0 * j + 3.0));
+  set_weight(h.grab_auxiliaries(), weight_);
+  return h;
+}
+
+void check_close(double value_, double expected_, const std::string & what_)
+{
+  DT_THROW_IF(std::abs(value_ - expected_) > 1e-12 * std::max(1.0, std::abs(expected_)), std::logic_error,
+              what_ << " is " << value_ << " instead of " << expected_ << " !");
+  return;
+}
+
+// Check the contents and the weight auxiliaries of a merged 1D histogram.
+void check_1d(const mygsl::histogram_1d & merged_, const mygsl::histogram_1d & a_, double a_factor_,
+              const mygsl::histogram_1d & b_, double b_factor_, double weight_, const std::string & what_)
+{
+  for (size_t i = 0; i < merged_.bins(); ++i)
+    {
+      check_close(merged_.get(i), a_factor_ * a_.get(i) + b_factor_ * b_.get(i), what_ + " bin " + std::to_string(i));
+    }
+  const datatools::properties & aux = merged_.get_auxiliaries();
+  if (weight_ < 0.0)
+    {
+      DT_THROW_IF(! aux.has_key("weighted") || aux.has_key("weight"), std::logic_error,
+                  what_ << " is not tagged 'weighted' without global weight !");
+    }
+  else if (weight_ > 0.0)
+    {
+      DT_THROW_IF(aux.has_key("weighted") || ! aux.has_key("weight"), std::logic_error,
+                  what_ << " has not a global weight !");
+      check_close(aux.fetch_real("weight"), weight_, what_ + " global weight");
+    }
+  return;
+}
+
+// Merge a source histogram into a copy of a target one.
+void check_weight_folding(double target_weight_, double source_weight_,
+                          double target_factor_, double source_factor_, double merged_weight_)
+{
+  const std::string what = "merge of weights " + std::to_string(target_weight_)
+    + " and " + std::to_string(source_weight_);
+  mygsl::histogram_pool target;
+  mygsl::histogram_pool source;
+  const mygsl::histogram_1d t = add_1d(target, "h", 1.0, target_weight_);
+  const mygsl::histogram_1d s = add_1d(source, "h", 0.7, source_weight_);
+  analysis::merge_histogram_pool(target, source);
+  check_1d(target.get_1d("h"), t, target_factor_, s, source_factor_, merged_weight_, what);
+  DT_THROW_IF(target.get_1d("h").counts() != t.counts() + s.counts(), std::logic_error,
+              what << " has not the sum of the entries !");
+  return;
+}
+
+// Check that merging a source pool into a target pool throws.
+bool merge_throws(mygsl::histogram_pool & target_, const mygsl::histogram_pool & source_)
+{
+  try {
+    analysis::merge_histogram_pool(target_, source_);
+  }
+  catch (std::logic_error &) {
+    return true;
+  }
+  return false;
+}
+
+// Check that two pools have exactly the same histograms.
+void check_identical(const mygsl::histogram_pool & a_, const mygsl::histogram_pool & b_, const std::string & what_)
+{
+  std::vector<std::string> names;
+  a_.names(names);
+  for (size_t k = 0; k < names.size(); ++k)
+    {
+      const std::string & a_name = names[k];
+      DT_THROW_IF(! b_.has(a_name), std::logic_error, what_ << " : missing histogram '" << a_name << "' !");
+      const datatools::properties * a_aux;
+      const datatools::properties * b_aux;
+      if (a_.has_1d(a_name))
+        {
+          const mygsl::histogram_1d & a = a_.get_1d(a_name);
+          const mygsl::histogram_1d & b = b_.get_1d(a_name);
+          for (size_t i = 0; i < a.bins(); ++i)
+            {
+              DT_THROW_IF(a.get(i) != b.get(i), std::logic_error,
+                          what_ << " : histogram '" << a_name << "' differs in bin " << i << " !");
+            }
+          a_aux = &a.get_auxiliaries();
+          b_aux = &b.get_auxiliaries();
+        }
+      else
+        {
+          const mygsl::histogram_2d & a = a_.get_2d(a_name);
+          const mygsl::histogram_2d & b = b_.get_2d(a_name);
+          for (size_t i = 0; i < a.xbins(); ++i)
+            for (size_t j = 0; j < a.ybins(); ++j)
+              {
+                DT_THROW_IF(a.get(i, j) != b.get(i, j), std::logic_error,
+                            what_ << " : histogram '" << a_name << "' differs in bin (" << i << ", " << j << ") !");
+              }
+          a_aux = &a.get_auxiliaries();
+          b_aux = &b.get_auxiliaries();
+        }
+      DT_THROW_IF(a_aux->has_key("weighted") != b_aux->has_key("weighted")
+                  || a_aux->has_key("weight") != b_aux->has_key("weight")
+                  || (a_aux->has_key("weight") && a_aux->fetch_real("weight") != b_aux->fetch_real("weight")),
+                  std::logic_error, what_ << " : histogram '" << a_name << "' has different weights !");
+    }
+  std::vector<std::string> b_names;
+  b_.names(b_names);
+  DT_THROW_IF(b_names.size() != names.size(), std::logic_error, what_ << " : different numbers of histograms !");
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the histogram pool utilities." << std::endl;
+
+    // Same global weights are kept, different ones are applied to the contents
+    check_weight_folding(0.0, 0.0, 1.0, 1.0, 0.0);
+    check_weight_folding(2.0, 2.0, 1.0, 1.0, 2.0);
+    check_weight_folding(0.0, 1.0, 1.0, 1.0, 1.0);
+    check_weight_folding(2.0, 3.0, 2.0, 3.0, -1.0);
+    check_weight_folding(0.0, 3.0, 1.0, 3.0, -1.0);
+    check_weight_folding(2.0, 0.0, 2.0, 1.0, -1.0);
+    check_weight_folding(-1.0, 4.0, 1.0, 4.0, -1.0);
+    check_weight_folding(4.0, -1.0, 4.0, 1.0, -1.0);
+    check_weight_folding(-1.0, -1.0, 1.0, 1.0, -1.0);
+
+    // Same folding for 2D histograms
+    {
+      mygsl::histogram_pool target;
+      mygsl::histogram_pool source;
+      const mygsl::histogram_2d t = add_2d(target, "h2", 1.0, 2.0);
+      const mygsl::histogram_2d s = add_2d(source, "h2", 0.3, 5.0);
+      analysis::merge_histogram_pool(target, source);
+      const mygsl::histogram_2d & merged = target.get_2d("h2");
+      for (size_t i = 0; i < merged.xbins(); ++i)
+        for (size_t j = 0; j < merged.ybins(); ++j)
+          {
+            check_close(merged.get(i, j), 2.0 * t.get(i, j) + 5.0 * s.get(i, j), "2D weighted merge");
+          }
+      DT_THROW_IF(! merged.get_auxiliaries().has_key("weighted"), std::logic_error,
+                  "2D merge of different weights is not tagged 'weighted' !");
+    }
+
+    // Missing histograms and auxiliaries are copied, skipped groups are ignored
+    {
+      mygsl::histogram_pool target;
+      mygsl::histogram_pool source;
+      add_1d(target, "common", 1.0, 0.0).grab_auxiliaries().update_string("category", "signal");
+      mygsl::histogram_1d & s = add_1d(source, "common", 2.0, 0.0);
+      s.grab_auxiliaries().update_string("category", "signal");
+      s.grab_auxiliaries().update("number_of_events", 12);
+      const mygsl::histogram_1d only = add_1d(source, "only_in_source", 3.0, 2.0, "efficiency");
+      add_1d(source, "computed", 4.0, 0.0, "halflife");
+      analysis::merge_histogram_pool(target, source, std::vector<std::string>(1, "halflife"));
+      DT_THROW_IF(! target.get_1d("common").get_auxiliaries().has_key("number_of_events"), std::logic_error,
+                  "Missing auxiliary is not copied !");
+      DT_THROW_IF(! target.has_1d("only_in_source") || target.get_group("only_in_source") != "efficiency"
+                  || target.get_title("only_in_source") != "title of only_in_source", std::logic_error,
+                  "Missing histogram is not copied with its title and group !");
+      check_1d(target.get_1d("only_in_source"), only, 1.0, only, 0.0, 2.0, "copied histogram");
+      DT_THROW_IF(target.has("computed"), std::logic_error, "Histogram of a skipped group is merged !");
+    }
+
+    // Auxiliaries found in both histograms must have the same values
+    {
+      mygsl::histogram_pool target;
+      mygsl::histogram_pool source;
+      add_1d(target, "h", 1.0, 0.0).grab_auxiliaries().update_string("category", "signal");
+      add_1d(source, "h", 1.0, 0.0).grab_auxiliaries().update_string("category", "background");
+      DT_THROW_IF(! merge_throws(target, source), std::logic_error, "Conflicting string auxiliaries are merged !");
+    }
+    {
+      mygsl::histogram_pool target;
+      mygsl::histogram_pool source;
+      add_1d(target, "h", 1.0, 0.0).grab_auxiliaries().update("activity", 2.0);
+      add_1d(source, "h", 1.0, 0.0).grab_auxiliaries().update("activity", 2.5);
+      DT_THROW_IF(! merge_throws(target, source), std::logic_error, "Conflicting real auxiliaries are merged !");
+    }
+    {
+      mygsl::histogram_pool target;
+      mygsl::histogram_pool source;
+      add_1d(target, "h", 1.0, 0.0).grab_auxiliaries().update("activity", 2);
+      add_1d(source, "h", 1.0, 0.0).grab_auxiliaries().update("activity", 2.0);
+      DT_THROW_IF(! merge_throws(target, source), std::logic_error, "Auxiliaries of different types are merged !");
+    }
+    {
+      mygsl::histogram_pool target;
+      mygsl::histogram_pool source;
+      add_1d(target, "h", 1.0, 0.0);
+      add_2d(source, "h", 1.0, 0.0);
+      DT_THROW_IF(! merge_throws(target, source), std::logic_error, "1D and 2D histograms are merged !");
+    }
+
+    // The sum of several pools does not depend on their order
+    std::vector<mygsl::histogram_pool> sources(4);
+    const double weights[] = { 1.5, 0.0, 1.5, -1.0 };
+    for (size_t p = 0; p < sources.size(); ++p)
+      {
+        add_1d(sources[p], "h", 0.1 + 0.37 * p, weights[p]);
+        add_1d(sources[p], "same_weight", 0.3 / (p + 1.0), 2.5);
+        if (p != 2) add_2d(sources[p], "h2", 0.7 / (p + 3.0), weights[(p + 1) % 4]);
+        add_1d(sources[p], "computed", 1.0, 0.0, "halflife");
+      }
+    std::vector<size_t> permutation;
+    for (size_t p = 0; p < sources.size(); ++p) permutation.push_back(p);
+    mygsl::histogram_pool reference;
+    bool first = true;
+    do
+      {
+        std::vector<const mygsl::histogram_pool *> ordered;
+        for (size_t p = 0; p < permutation.size(); ++p) ordered.push_back(&sources[permutation[p]]);
+        mygsl::histogram_pool merged;
+        analysis::merge_histogram_pools(merged, ordered, std::vector<std::string>(1, "halflife"));
+        DT_THROW_IF(merged.has("computed"), std::logic_error, "Histogram of a skipped group is merged !");
+        if (first)
+          {
+            analysis::merge_histogram_pools(reference, ordered, std::vector<std::string>(1, "halflife"));
+            first = false;
+          }
+        check_identical(merged, reference, "merge of permuted pools");
+      }
+    while (std::next_permutation(permutation.begin(), permutation.end()));
+
+    // The merged contents are the weighted sum of the sources
+    const mygsl::histogram_1d & merged_h = reference.get_1d("h");
+    const mygsl::histogram_1d & merged_same = reference.get_1d("same_weight");
+    for (size_t i = 0; i < merged_h.bins(); ++i)
+      {
+        double expected_h = 0.0;
+        double expected_same = 0.0;
+        for (size_t p = 0; p < sources.size(); ++p)
+          {
+            expected_h += (weights[p] > 0.0 ? weights[p] : 1.0) * sources[p].get_1d("h").get(i);
+            expected_same += sources[p].get_1d("same_weight").get(i);
+          }
+        check_close(merged_h.get(i), expected_h, "merged weighted sum");
+        check_close(merged_same.get(i), expected_same, "merged sum of the same weight");
+      }
+    DT_THROW_IF(! merged_h.get_auxiliaries().has_key("weighted"), std::logic_error,
+                "Merged histogram of different weights is not tagged 'weighted' !");
+    check_close(merged_same.get_auxiliaries().fetch_real("weight"), 2.5, "merged global weight");
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
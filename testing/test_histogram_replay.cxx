@@ -0,0 +1,304 @@
+// test_histogram_replay.cxx
+
+// Standard library:
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <sstream>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+#include <datatools/properties.h>
+// - Bayeux/mygsl:
+#include <mygsl/histogram.h>
+#include <mygsl/histogram_pool.h>
+
+// This project:
+#include <snemo/analysis/feature_cache.h>
+#include <snemo/analysis/feature_extraction_module.h>
+#include <snemo/analysis/histogram_replay.h>
+#include <snemo/analysis/plot_conventions.h>
+#include <snemo/analysis/topology_dispatch.h>
+#include <snemo/analysis/weight_rule_table.h>
+
+namespace fc = analysis::feature_columns;
+
+// Columns of the test cache.
+const char * REAL_COLUMNS[] = {
+  fc::ELECTRON_ENERGY, fc::GAMMA_MAX_ENERGY, fc::GAMMA_MID_ENERGY, fc::GAMMA_MIN_ENERGY,
+  fc::TOTAL_ENERGY, fc::ASSOCIATED_ENERGY, fc::VERTEX_Y, fc::VERTEX_Z,
+  fc::CALORIMETER_ENERGY, fc::GENBB_WEIGHT
+};
+const char * INTEGER_COLUMNS[] = {
+  fc::TOPOLOGY, fc::NUMBER_OF_GAMMAS, fc::NUMBER_OF_ELECTRONS, fc::NUMBER_OF_POSITRONS,
+  fc::NUMBER_OF_UNDEFINED, fc::ISOLATED_CALORIMETERS, fc::GENBB_LABEL, fc::VERTEX_ORIGIN,
+  "key.sample", "key.origin"
+};
+const size_t NREALS = sizeof(REAL_COLUMNS) / sizeof(const char *);
+const size_t NINTEGERS = sizeof(INTEGER_COLUMNS) / sizeof(const char *);
+
+// Binning of the energy template.
+const size_t ENERGY_BINS = 50;
+const double ENERGY_MIN = 0.0;
+const double ENERGY_MAX = 5.0;
+
+// Event features of a row.
+struct row_type
+{
+  std::string topology;
+  double      electron_energy;
+  double      total_energy;
+  double      calorimeter_energy;
+  double      genbb_weight;
+  int32_t     nelectrons;
+  int32_t     npositrons;
+  int32_t     isolated;
+  std::string label;
+  std::string origin;
+};
+
+// Energy with missing, out of range and bin edge values.
+double energy_value(size_t row_)
+{
+  switch (row_ % 13)
+    {
+    case 0: return std::numeric_limits<double>::quiet_NaN();
+    case 1: return -0.25;
+    case 2: return ENERGY_MAX;
+    case 3: return 1.0;
+    case 4: return ENERGY_MIN;
+    default: return 0.0371 * (row_ % 139);
+    }
+}
+
+row_type make_row(size_t row_)
+{
+  const char * topologies[] = { "1e", "2e", "1eNg", "" };
+  const char * labels[] = { "Se82.0nubb", "Se82.2nubb", "Bi214_Po214", "Tl208" };
+  const char * origins[] = { "source_strip", "field_wire_surface" };
+  row_type a_row;
+  a_row.topology = topologies[row_ % 4];
+  a_row.electron_energy = energy_value(row_);
+  a_row.total_energy = energy_value(row_ + 7);
+  a_row.calorimeter_energy = energy_value(row_ + 3);
+  a_row.genbb_weight = 0.5 + 0.25 * (row_ % 3);
+  a_row.nelectrons = row_ % 3 == 0 ? 1 : 2;
+  a_row.npositrons = row_ % 5 == 0 ? 1 : 0;
+  a_row.isolated = row_ % 7 == 0 ? 1 : 0;
+  a_row.label = labels[(row_ / 3) % 4];
+  a_row.origin = origins[(row_ / 5) % 2];
+  return a_row;
+}
+
+void write_cache(const std::string & path_, size_t nrows_)
+{
+  analysis::feature_cache_writer writer;
+  for (size_t c = 0; c < NREALS; ++c) writer.add_real_column(REAL_COLUMNS[c]);
+  for (size_t c = 0; c < NINTEGERS; ++c) writer.add_integer_column(INTEGER_COLUMNS[c]);
+  writer.open(path_, 64);
+  const double nan = std::numeric_limits<double>::quiet_NaN();
+  for (size_t r = 0; r < nrows_; ++r)
+    {
+      const row_type a_row = make_row(r);
+      const double reals[] = {
+        a_row.electron_energy, nan, nan, nan, a_row.total_energy, nan, nan, nan,
+        a_row.calorimeter_energy, a_row.genbb_weight
+      };
+      const int32_t integers[] = {
+        a_row.topology.empty() ? -1 : writer.intern(a_row.topology), 1,
+        a_row.nelectrons, a_row.npositrons, 0, a_row.isolated,
+        writer.intern(a_row.label), writer.intern(a_row.origin),
+        writer.intern(a_row.label), writer.intern(a_row.origin)
+      };
+      writer.append_row(reals, integers);
+    }
+  writer.close();
+  return;
+}
+
+// Pool holding the energy template.
+void make_template_pool(mygsl::histogram_pool & pool_)
+{
+  datatools::properties pool_config;
+  pool_.initialize(pool_config);
+  mygsl::histogram_1d & a_template = pool_.add_1d(analysis::plot_conventions::ENERGY_TEMPLATE, "", "__template");
+  a_template.initialize(ENERGY_BINS, ENERGY_MIN, ENERGY_MAX);
+  return;
+}
+
+// Fill the histograms value by value as the universal and halflife limit modules do.
+void fill_directly(mygsl::histogram_pool & pool_, size_t nrows_, bool weighted_fill_)
+{
+  namespace pc = analysis::plot_conventions;
+  analysis::weight_rule_table rules;
+  rules.set_legacy_rules();
+  for (size_t r = 0; r < nrows_; ++r)
+    {
+      const row_type a_row = make_row(r);
+      const std::string key = a_row.label + "_" + a_row.origin + "_";
+      if (a_row.topology == "1e" || a_row.topology == "1eNg")
+        {
+          std::ostringstream name;
+          name << key;
+          pc::append_universal_name(name, analysis::topology_registry::kind_of_id(a_row.topology));
+          mygsl::histogram_1d & h = pc::grab_mimic_1d(pool_, name.str(), pc::UNIVERSAL_GROUP,
+                                                      pc::ENERGY_TEMPLATE, pool_);
+          const double rule_weight = rules.evaluate(a_row.label, a_row.origin);
+          const double energy = a_row.topology == "1e" ? a_row.electron_energy : a_row.total_energy;
+          if (weighted_fill_)
+            {
+              mygsl::histogram_1d & h2 = pc::grab_mimic_1d(pool_, name.str() + pc::SUMW2_SUFFIX,
+                                                           pc::UNIVERSAL_SUMW2_GROUP, pc::ENERGY_TEMPLATE, pool_);
+              h.grab_auxiliaries().update("weighted", true);
+              const double weight = rule_weight * a_row.genbb_weight;
+              if (! std::isnan(energy))
+                {
+                  h.fill(energy, weight);
+                  h2.fill(energy, weight * weight);
+                }
+            }
+          else
+            {
+              h.grab_auxiliaries().update("weight", rule_weight);
+              if (! std::isnan(energy)) h.fill(energy);
+            }
+        }
+      if (a_row.isolated == 0 && a_row.nelectrons == 2)
+        {
+          std::ostringstream name;
+          name << key;
+          pc::append_charge_name(name, a_row.nelectrons, a_row.npositrons, 0);
+          mygsl::histogram_1d & h = pc::grab_mimic_1d(pool_, name.str(), pc::HALFLIFE_GROUP,
+                                                      pc::ENERGY_TEMPLATE, pool_);
+          h.grab_auxiliaries().update("weight", 1.0);
+          h.fill(a_row.calorimeter_energy);
+        }
+    }
+  return;
+}
+
+bool close_to(double a_, double b_)
+{
+  return std::abs(a_ - b_) <= 1e-12 * std::max(std::abs(a_), std::abs(b_));
+}
+
+// Check that the replayed histograms are the directly filled ones.
+void compare_pools(const mygsl::histogram_pool & replayed_, const mygsl::histogram_pool & expected_)
+{
+  std::vector<std::string> names;
+  std::vector<std::string> expected_names;
+  replayed_.names(names);
+  expected_.names(expected_names);
+  DT_THROW_IF(names != expected_names, std::logic_error, "Wrong replayed histograms !");
+  for (size_t k = 0; k < names.size(); ++k)
+    {
+      const std::string & a_name = names[k];
+      const mygsl::histogram_1d & a = replayed_.get_1d(a_name);
+      const mygsl::histogram_1d & b = expected_.get_1d(a_name);
+      DT_THROW_IF(a.bins() != b.bins(), std::logic_error, "Wrong binning of '" << a_name << "' !");
+      for (size_t i = 0; i < a.bins(); ++i)
+        {
+          DT_THROW_IF(! close_to(a.get(i), b.get(i)), std::logic_error,
+                      "Wrong bin " << i << " of '" << a_name << "' : " << a.get(i) << " != " << b.get(i) << " !");
+        }
+      DT_THROW_IF(! close_to(a.underflow(), b.underflow()) || ! close_to(a.overflow(), b.overflow()),
+                  std::logic_error, "Wrong underflow or overflow of '" << a_name << "' !");
+      DT_THROW_IF(a.counts() != b.counts(), std::logic_error,
+                  "Wrong number of entries of '" << a_name << "' : " << a.counts() << " != " << b.counts() << " !");
+      const datatools::properties & a_aux = a.get_auxiliaries();
+      const datatools::properties & b_aux = b.get_auxiliaries();
+      DT_THROW_IF(a_aux.has_key("weighted") != b_aux.has_key("weighted") ||
+                  a_aux.has_key("weight") != b_aux.has_key("weight"), std::logic_error,
+                  "Wrong weight auxiliaries of '" << a_name << "' !");
+      if (b_aux.has_key("weight"))
+        {
+          DT_THROW_IF(a_aux.fetch_real("weight") != b_aux.fetch_real("weight"), std::logic_error,
+                      "Wrong weight of '" << a_name << "' !");
+        }
+    }
+  return;
+}
+
+void replay(const std::string & path_, mygsl::histogram_pool & pool_, bool weighted_fill_, bool keyed_)
+{
+  datatools::properties config;
+  std::vector<std::string> plots;
+  plots.push_back("universal");
+  plots.push_back("halflife");
+  config.store("plots", plots);
+  config.store("number_of_threads", 3);
+  std::vector<std::string> topologies;
+  topologies.push_back("1e");
+  topologies.push_back("1eNg");
+  config.store("universal.topologies", topologies);
+  config.store("universal.weighted_fill", weighted_fill_);
+  if (keyed_)
+    {
+      std::vector<std::string> key_fields;
+      key_fields.push_back("sample");
+      key_fields.push_back("origin");
+      config.store("universal.key_fields", key_fields);
+      config.store("halflife.key_fields", key_fields);
+    }
+  analysis::feature_cache_reader reader;
+  reader.open(path_);
+  analysis::histogram_replay a_replay;
+  a_replay.initialize(config, pool_);
+  a_replay.run(reader);
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::histogram_replay' class." << std::endl;
+    const std::string path = "test_histogram_replay.bin";
+    const size_t nrows = 1000;
+    write_cache(path, nrows);
+
+    // Replayed histograms of the universal and halflife limit modules, with and without weighted fills
+    for (int weighted = 0; weighted < 2; ++weighted)
+      {
+        mygsl::histogram_pool replayed;
+        make_template_pool(replayed);
+        replay(path, replayed, weighted == 1, true);
+        mygsl::histogram_pool expected;
+        make_template_pool(expected);
+        fill_directly(expected, nrows, weighted == 1);
+        compare_pools(replayed, expected);
+      }
+
+    // A single global weight cannot be given to events of different rule weights
+    bool rejected = false;
+    try {
+      mygsl::histogram_pool replayed;
+      make_template_pool(replayed);
+      replay(path, replayed, false, false);
+    }
+    catch (std::logic_error &) {
+      rejected = true;
+    }
+    DT_THROW_IF(! rejected, std::logic_error, "Events of different weights share a global weight !");
+    std::remove(path.c_str());
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
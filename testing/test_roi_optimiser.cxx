@@ -0,0 +1,141 @@
+// test_roi_optimiser.cxx
+
+// Standard library:
+#include <cmath>
+#include <string>
+#include <vector>
+#include <random>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/roi_optimiser.h>
+#include <snemo/analysis/feldman_cousins.h>
+
+// Cumulative table, the value of bin i being the sum over the bins above i.
+std::vector<double> cumulate_above(const std::vector<double> & contents_)
+{
+  std::vector<double> above(contents_.size(), 0.0);
+  double sum = 0.0;
+  for (size_t i = contents_.size(); i-- > 0; )
+    {
+      sum += contents_[i];
+      above[i] = sum;
+    }
+  return above;
+}
+
+// Best window by direct scan of all the windows, ties keep the lowest window.
+analysis::roi_optimiser::window_type scan_windows(const std::vector<double> & signal_above_,
+                                                  const std::vector<double> & background_above_,
+                                                  double factor_)
+{
+  analysis::roi_optimiser::window_type a_best = { 0, 0, 0.0, 0.0, 0.0 };
+  const size_t nbins = signal_above_.size();
+  for (size_t i = 0; i < nbins; ++i)
+    for (size_t j = i + 1; j <= nbins; ++j)
+      {
+        const double signal = signal_above_[i] - (j < nbins ? signal_above_[j] : 0.0);
+        const double background = background_above_[i] - (j < nbins ? background_above_[j] : 0.0);
+        if (! (signal > 0.0)) continue;
+        const double halflife = signal / analysis::feldman_cousins::polynomial_excluded_events(background) * factor_;
+        if (halflife > a_best.halflife)
+          {
+            a_best.first_bin = i;
+            a_best.last_bin = j;
+            a_best.signal_efficiency = signal;
+            a_best.background_counts = background;
+            a_best.halflife = halflife;
+          }
+      }
+  return a_best;
+}
+
+// Check that two windows are the same.
+void check_window(const analysis::roi_optimiser::window_type & window_,
+                  const analysis::roi_optimiser::window_type & expected_,
+                  const std::string & what_)
+{
+  DT_THROW_IF(window_.first_bin != expected_.first_bin || window_.last_bin != expected_.last_bin
+              || window_.halflife != expected_.halflife
+              || window_.signal_efficiency != expected_.signal_efficiency
+              || window_.background_counts != expected_.background_counts, std::logic_error,
+              what_ << " gives window [" << window_.first_bin << ", " << window_.last_bin << ") instead of ["
+              << expected_.first_bin << ", " << expected_.last_bin << ") !");
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::roi_optimiser' class." << std::endl;
+
+    const double factor = 4.2e23;
+    analysis::roi_optimiser optimiser;
+    optimiser.set_halflife_factor(factor);
+    optimiser.set_excluded_events_function([](const double * backgrounds_, size_t size_, double * excluded_)
+      {
+        for (size_t i = 0; i < size_; ++i)
+          excluded_[i] = analysis::feldman_cousins::polynomial_excluded_events(backgrounds_[i]);
+      });
+
+    // Random spectra: a signal peak over a falling background
+    std::mt19937 generator(271828);
+    std::uniform_real_distribution<double> noise(0.5, 1.5);
+    for (size_t trial = 0; trial < 10; ++trial)
+      {
+        const size_t nbins = 20 + 7 * trial;
+        std::vector<double> signal(nbins);
+        std::vector<double> background(nbins);
+        for (size_t i = 0; i < nbins; ++i)
+          {
+            const double d = (i - 0.7 * nbins) / 3.0;
+            signal[i] = 0.01 * noise(generator) * std::exp(-0.5 * d * d);
+            background[i] = 50.0 * noise(generator) * std::exp(-0.2 * i);
+          }
+        const std::vector<double> signal_above = cumulate_above(signal);
+        const std::vector<double> background_above = cumulate_above(background);
+        const analysis::roi_optimiser::window_type expected = scan_windows(signal_above, background_above, factor);
+        DT_THROW_IF(! expected.is_valid(), std::logic_error, "No window found by the direct scan !");
+        for (size_t nthreads = 1; nthreads <= 5; nthreads += 2)
+          {
+            optimiser.set_number_of_threads(nthreads);
+            check_window(optimiser.optimise(signal_above, background_above), expected, "Optimisation");
+          }
+      }
+
+    // Without background the best window is the lowest one holding all the signal
+    const std::vector<double> signal = { 0.0, 0.0, 0.0, 0.1, 0.3, 0.2, 0.0, 0.0 };
+    const std::vector<double> background(signal.size(), 0.0);
+    optimiser.set_number_of_threads(3);
+    const analysis::roi_optimiser::window_type window
+      = optimiser.optimise(cumulate_above(signal), cumulate_above(background));
+    DT_THROW_IF(window.first_bin != 0 || window.last_bin != 6, std::logic_error,
+                "Background free window is [" << window.first_bin << ", " << window.last_bin << ") !");
+
+    // No signal, no window
+    const std::vector<double> nothing(signal.size(), 0.0);
+    DT_THROW_IF(optimiser.optimise(nothing, cumulate_above(background)).is_valid(), std::logic_error,
+                "Window found without signal !");
+    DT_THROW_IF(optimiser.optimise(std::vector<double>(), std::vector<double>()).is_valid(), std::logic_error,
+                "Window found without bins !");
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
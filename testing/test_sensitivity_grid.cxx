@@ -0,0 +1,219 @@
+// test_sensitivity_grid.cxx
+
+// Standard library:
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <iostream>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/feldman_cousins.h>
+#include <snemo/analysis/roi_optimiser.h>
+#include <snemo/analysis/sensitivity_grid.h>
+
+// Number of energy thresholds
+const size_t NBINS = 30;
+
+// Avogadro number and molar mass of the isotope, in the units of the masses
+const double AVOGADRO = 6.02214076e23;
+const double MOLAR_MASS = 0.082;
+
+void check_close(double value_, double expected_, const std::string & what_)
+{
+  DT_THROW_IF(std::abs(value_ - expected_) > 1e-12 * std::abs(expected_), std::logic_error,
+              what_ << " is " << value_ << " instead of " << expected_ << " !");
+  return;
+}
+
+// Signal efficiency above each threshold.
+std::vector<double> signal_above()
+{
+  std::vector<double> signal(NBINS);
+  for (size_t i = 0; i < NBINS; ++i) signal[i] = 0.6 * (1.0 - std::pow(i / double(NBINS), 2));
+  return signal;
+}
+
+// Background counts above each threshold of a component, for the nominal configuration.
+std::vector<double> background_counts(double total_, double slope_)
+{
+  std::vector<double> counts(NBINS);
+  for (size_t i = 0; i < NBINS; ++i) counts[i] = total_ * std::exp(-slope_ * i);
+  return counts;
+}
+
+// Halflife limits of one configuration, computed as the halflife module does from the total background counts.
+void single_configuration(const analysis::feldman_cousins & fc_,
+                          const std::vector<double> & signal_,
+                          const std::vector<double> & counts_,
+                          double factor_,
+                          analysis::sensitivity_grid::result_type & result_)
+{
+  std::vector<double> excluded(counts_.size());
+  fc_.excluded_events(&counts_[0], counts_.size(), &excluded[0]);
+  result_.threshold_bin = 0;
+  result_.threshold_halflife = 0.0;
+  for (size_t i = 0; i < signal_.size(); ++i)
+    {
+      const double halflife = signal_[i] / excluded[i] * factor_;
+      if (halflife > result_.threshold_halflife)
+        {
+          result_.threshold_bin = i;
+          result_.threshold_halflife = halflife;
+        }
+    }
+  analysis::roi_optimiser an_optimiser;
+  an_optimiser.set_excluded_events_function([&fc_](const double * backgrounds_, size_t size_, double * excluded_)
+                                            {
+                                              fc_.excluded_events(backgrounds_, size_, excluded_);
+                                            });
+  an_optimiser.set_halflife_factor(factor_);
+  result_.window = an_optimiser.optimise(signal_, counts_);
+  return;
+}
+
+// Return the limit of the grid point of a configuration.
+const analysis::sensitivity_grid::result_type &
+find_result(const std::vector<analysis::sensitivity_grid::result_type> & results_,
+            double exposure_time_, double isotope_mass_, double background_scale_)
+{
+  for (size_t ip = 0; ip < results_.size(); ++ip)
+    {
+      const analysis::sensitivity_grid::point_type & a_point = results_[ip].point;
+      if (a_point.exposure_time == exposure_time_ && a_point.isotope_mass == isotope_mass_
+          && a_point.background_scale == background_scale_) return results_[ip];
+    }
+  DT_THROW(std::logic_error, "No grid point (" << exposure_time_ << ", " << isotope_mass_
+           << ", " << background_scale_ << ") !");
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::sensitivity_grid' class." << std::endl;
+
+    analysis::feldman_cousins fc;
+    const std::vector<double> signal = signal_above();
+    const double exposure_time = 2.5;
+    const double isotope_mass = 7.0;
+
+    // Background counts of the nominal configuration, split per unit of exposure as in the halflife module
+    const std::vector<double> bb2nu_counts = background_counts(3.0, 0.5);
+    const std::vector<double> isotope_counts = background_counts(0.8, 0.2);
+    const std::vector<double> fixed_counts = background_counts(1.5, 0.3);
+    std::vector<double> counts(NBINS);
+    std::vector<double> bb2nu(NBINS);
+    std::vector<double> isotope(NBINS);
+    std::vector<double> fixed(NBINS);
+    for (size_t i = 0; i < NBINS; ++i)
+      {
+        counts[i] = bb2nu_counts[i] + isotope_counts[i] + fixed_counts[i];
+        bb2nu[i] = bb2nu_counts[i] / (isotope_mass * exposure_time);
+        isotope[i] = isotope_counts[i] / (isotope_mass * exposure_time);
+        fixed[i] = fixed_counts[i] / exposure_time;
+      }
+    const double signal_factor = std::log(2) * AVOGADRO / MOLAR_MASS;
+    const double halflife_factor = std::log(2) * isotope_mass * AVOGADRO * exposure_time / MOLAR_MASS;
+
+    analysis::sensitivity_grid grid;
+    grid.set_number_of_threads(3);
+    grid.set_feldman_cousins(fc);
+    grid.set_signal_factor(signal_factor);
+    grid.set_background_components(bb2nu, isotope, fixed);
+    std::vector<double> exposure_times;
+    exposure_times.push_back(exposure_time);
+    exposure_times.push_back(2.0 * exposure_time);
+    std::vector<double> isotope_masses;
+    isotope_masses.push_back(isotope_mass);
+    isotope_masses.push_back(3.0 * isotope_mass);
+    std::vector<double> background_scales;
+    background_scales.push_back(1.0);
+    background_scales.push_back(4.0);
+    grid.set_grid(exposure_times, isotope_masses, background_scales);
+    DT_THROW_IF(grid.get_points().size() != 8, std::logic_error, "Wrong number of grid points !");
+    std::vector<analysis::sensitivity_grid::result_type> results;
+    grid.evaluate(signal, results);
+    DT_THROW_IF(results.size() != grid.get_points().size(), std::logic_error, "Wrong number of grid results !");
+
+    // The nominal grid point has the limits of the single configuration
+    analysis::sensitivity_grid::result_type expected;
+    single_configuration(fc, signal, counts, halflife_factor, expected);
+    const analysis::sensitivity_grid::result_type & nominal = find_result(results, exposure_time, isotope_mass, 1.0);
+    DT_THROW_IF(nominal.threshold_bin != expected.threshold_bin, std::logic_error,
+                "Nominal threshold bin is " << nominal.threshold_bin << " instead of " << expected.threshold_bin << " !");
+    check_close(nominal.threshold_halflife, expected.threshold_halflife, "Nominal threshold halflife");
+    DT_THROW_IF(! expected.window.is_valid() || nominal.window.first_bin != expected.window.first_bin
+                || nominal.window.last_bin != expected.window.last_bin, std::logic_error,
+                "Nominal energy window is not the single configuration one !");
+    check_close(nominal.window.halflife, expected.window.halflife, "Nominal window halflife");
+    check_close(nominal.window.background_counts, expected.window.background_counts, "Nominal window background");
+
+    // Each grid point has the limits of its own single configuration
+    for (size_t ip = 0; ip < results.size(); ++ip)
+      {
+        const analysis::sensitivity_grid::point_type & a_point = results[ip].point;
+        const double mass_time = a_point.isotope_mass * a_point.exposure_time;
+        std::vector<double> point_counts(NBINS);
+        for (size_t i = 0; i < NBINS; ++i)
+          {
+            point_counts[i] = mass_time * bb2nu[i]
+              + a_point.background_scale * (mass_time * isotope[i] + a_point.exposure_time * fixed[i]);
+          }
+        analysis::sensitivity_grid::result_type point_expected;
+        single_configuration(fc, signal, point_counts, signal_factor * mass_time, point_expected);
+        check_close(results[ip].threshold_halflife, point_expected.threshold_halflife, "Grid point threshold halflife");
+        check_close(results[ip].window.halflife, point_expected.window.halflife, "Grid point window halflife");
+      }
+
+    // More exposure or isotope mass improves the limit, more radioactive background degrades it
+    for (size_t is = 0; is < background_scales.size(); ++is)
+      {
+        const double scale = background_scales[is];
+        const double base = find_result(results, exposure_time, isotope_mass, scale).window.halflife;
+        const double longer = find_result(results, 2.0 * exposure_time, isotope_mass, scale).window.halflife;
+        const double heavier = find_result(results, exposure_time, 3.0 * isotope_mass, scale).window.halflife;
+        DT_THROW_IF(! (longer > base && longer < 2.0 * base), std::logic_error,
+                    "Doubling the exposure time does not improve the limit by less than twice !");
+        DT_THROW_IF(! (heavier > base && heavier < 3.0 * base), std::logic_error,
+                    "Tripling the isotope mass does not improve the limit by less than three times !");
+      }
+    DT_THROW_IF(! (find_result(results, exposure_time, isotope_mass, 4.0).window.halflife < nominal.window.halflife),
+                std::logic_error, "More radioactive background does not degrade the limit !");
+
+    // Without background, the limits scale with the isotope mass and the exposure time
+    const std::vector<double> none(NBINS, 0.0);
+    grid.set_background_components(none, none, none);
+    grid.evaluate(signal, results);
+    const double free_base = find_result(results, exposure_time, isotope_mass, 1.0).threshold_halflife;
+    check_close(find_result(results, 2.0 * exposure_time, isotope_mass, 1.0).threshold_halflife, 2.0 * free_base,
+                "Background free limit of twice the exposure time");
+    check_close(find_result(results, exposure_time, 3.0 * isotope_mass, 4.0).threshold_halflife, 3.0 * free_base,
+                "Background free limit of three times the isotope mass");
+
+    // The bb2nu background does not depend on the radioactive background scale
+    grid.set_background_components(bb2nu, none, none);
+    grid.evaluate(signal, results);
+    check_close(find_result(results, exposure_time, isotope_mass, 4.0).window.halflife,
+                find_result(results, exposure_time, isotope_mass, 1.0).window.halflife,
+                "bb2nu background limit with a background scale");
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}
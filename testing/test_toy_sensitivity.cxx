@@ -0,0 +1,134 @@
+// test_toy_sensitivity.cxx
+
+// Standard library:
+#include <cmath>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <exception>
+#include <stdexcept>
+
+// Third party:
+// - Bayeux/datatools:
+#include <datatools/exception.h>
+
+// This project:
+#include <snemo/analysis/toy_sensitivity.h>
+
+// Check that two bands are identical.
+void check_same(const analysis::toy_sensitivity::band_type & band_,
+                const analysis::toy_sensitivity::band_type & expected_,
+                const std::string & what_)
+{
+  DT_THROW_IF(band_.minus_2sigma != expected_.minus_2sigma || band_.minus_1sigma != expected_.minus_1sigma
+              || band_.median != expected_.median || band_.plus_1sigma != expected_.plus_1sigma
+              || band_.plus_2sigma != expected_.plus_2sigma, std::logic_error,
+              what_ << " changes the bands (median " << band_.median << " instead of " << expected_.median << ") !");
+  return;
+}
+
+int main(/* int argc_, char ** argv_ */)
+{
+  int error_code = EXIT_SUCCESS;
+  try {
+    std::clog << "Test program for the 'analysis::toy_sensitivity' class." << std::endl;
+
+    // The counter-based generator only depends on its key and counter
+    double mean = 0.0;
+    const size_t nuniforms = 100000;
+    for (size_t i = 0; i < nuniforms; ++i)
+      {
+        const double u = analysis::toy_sensitivity::uniform(42, 7, i);
+        DT_THROW_IF(! (u >= 0.0 && u < 1.0), std::logic_error, "Uniform number " << u << " out of [0, 1) !");
+        DT_THROW_IF(u != analysis::toy_sensitivity::uniform(42, 7, i), std::logic_error,
+                    "Uniform number is not reproducible !");
+        mean += u;
+      }
+    mean /= nuniforms;
+    DT_THROW_IF(std::abs(mean - 0.5) > 0.005, std::logic_error, "Mean of the uniform numbers is " << mean << " !");
+    DT_THROW_IF(analysis::toy_sensitivity::uniform(42, 7, 0) == analysis::toy_sensitivity::uniform(42, 8, 0)
+                || analysis::toy_sensitivity::uniform(42, 7, 0) == analysis::toy_sensitivity::uniform(43, 7, 0),
+                std::logic_error, "Streams or seeds share their first number !");
+
+    // Simple upper limit so that the quantiles are those of the Poisson counts
+    const double efficiency = 0.25;
+    const double factor = 1e24;
+    analysis::toy_sensitivity toys;
+    toys.set_number_of_toys(100000);
+    toys.set_seed(20150601);
+    toys.set_halflife_factor(factor);
+    toys.set_upper_limit_function([](size_t observed_, double /* background_ */)
+      {
+        return observed_ + 2.3;
+      });
+
+    // Same bands whatever the number of threads
+    toys.set_number_of_threads(1);
+    const analysis::toy_sensitivity::band_type reference = toys.compute(3, efficiency, 4.0);
+    for (size_t nthreads = 2; nthreads <= 8; nthreads *= 2)
+      {
+        toys.set_number_of_threads(nthreads);
+        check_same(toys.compute(3, efficiency, 4.0), reference, "Number of threads");
+      }
+
+    // With b = 4, P(n >= 5) = 0.371 and P(n >= 4) = 0.567, the median count is 4
+    const double expected_median = efficiency / (4 + 2.3) * factor;
+    DT_THROW_IF(std::abs(reference.median - expected_median) > 1e-9 * expected_median, std::logic_error,
+                "Median halflife is " << reference.median << " instead of " << expected_median << " !");
+    DT_THROW_IF(! (reference.minus_2sigma <= reference.minus_1sigma && reference.minus_1sigma <= reference.median
+                   && reference.median <= reference.plus_1sigma && reference.plus_1sigma <= reference.plus_2sigma),
+                std::logic_error, "Bands are not ordered !");
+
+    // Batch of windows, same bands as one window at a time
+    std::vector<analysis::toy_sensitivity::window_type> windows;
+    for (uint64_t stream = 0; stream < 12; ++stream)
+      {
+        const analysis::toy_sensitivity::window_type a_window = { stream, 0.1 + 0.01 * stream, 0.5 * stream };
+        windows.push_back(a_window);
+      }
+    std::vector<analysis::toy_sensitivity::band_type> bands;
+    toys.set_number_of_threads(3);
+    toys.compute(windows, bands);
+    DT_THROW_IF(bands.size() != windows.size(), std::logic_error, "Wrong number of bands !");
+    toys.set_number_of_threads(1);
+    for (size_t i = 0; i < windows.size(); ++i)
+      {
+        check_same(bands[i], toys.compute(windows[i].stream, windows[i].signal_efficiency,
+                                          windows[i].background_counts), "Batch computation");
+      }
+
+    // Another seed gives other toys
+    toys.set_number_of_toys(1000);
+    const analysis::toy_sensitivity::band_type first_seed = toys.compute(3, efficiency, 30.0);
+    toys.set_seed(20150602);
+    const analysis::toy_sensitivity::band_type second_seed = toys.compute(3, efficiency, 30.0);
+    DT_THROW_IF(first_seed.minus_2sigma == second_seed.minus_2sigma
+                && first_seed.minus_1sigma == second_seed.minus_1sigma
+                && first_seed.median == second_seed.median
+                && first_seed.plus_1sigma == second_seed.plus_1sigma
+                && first_seed.plus_2sigma == second_seed.plus_2sigma,
+                std::logic_error, "Different seeds give the same bands !");
+
+    // Large backgrounds do not underflow
+    toys.set_number_of_toys(10000);
+    const double large = 1e5;
+    const analysis::toy_sensitivity::band_type large_band = toys.compute(5, efficiency, large);
+    const double large_median = efficiency / (large + 2.3) * factor;
+    DT_THROW_IF(! (std::abs(large_band.median - large_median) < 0.01 * large_median), std::logic_error,
+                "Median halflife at b = " << large << " is " << large_band.median << " instead of about "
+                << large_median << " !");
+
+    std::clog << "The end." << std::endl;
+  }
+  catch (std::exception & x) {
+    std::cerr << "error: " << x.what() << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  catch (...) {
+    std::cerr << "error: " << "unexpected error !" << std::endl;
+    error_code = EXIT_FAILURE;
+  }
+  return error_code;
+}